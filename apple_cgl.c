@@ -99,12 +99,15 @@ apple_cgl_init(void)
 
    apple_cgl.choose_pixel_format = sym(h, "CGLChoosePixelFormat");
    apple_cgl.destroy_pixel_format = sym(h, "CGLDestroyPixelFormat");
+   apple_cgl.retain_pixel_format = sym(h, "CGLRetainPixelFormat");
 
    apple_cgl.clear_drawable = sym(h, "CGLClearDrawable");
    apple_cgl.flush_drawable = sym(h, "CGLFlushDrawable");
 
    apple_cgl.create_context = sym(h, "CGLCreateContext");
    apple_cgl.destroy_context = sym(h, "CGLDestroyContext");
+   apple_cgl.retain_context = sym(h, "CGLRetainContext");
+   apple_cgl.release_context = sym(h, "CGLReleaseContext");
 
    apple_cgl.set_current_context = sym(h, "CGLSetCurrentContext");
    apple_cgl.get_current_context = sym(h, "CGLGetCurrentContext");
@@ -118,6 +121,16 @@ apple_cgl_init(void)
    apple_cgl.destroy_pbuffer = sym(h, "CGLDestroyPBuffer");
    apple_cgl.set_pbuffer = sym(h, "CGLSetPBuffer");
 
+   apple_cgl.get_parameter = sym(h, "CGLGetParameter");
+
+   apple_cgl.enable = sym(h, "CGLEnable");
+   apple_cgl.disable = sym(h, "CGLDisable");
+   apple_cgl.is_enabled = sym(h, "CGLIsEnabled");
+
+   apple_cgl.query_renderer_info = sym(h, "CGLQueryRendererInfo");
+   apple_cgl.destroy_renderer_info = sym(h, "CGLDestroyRendererInfo");
+   apple_cgl.describe_renderer = sym(h, "CGLDescribeRenderer");
+
    initialized = true;
 }
 
@@ -45,6 +45,7 @@ struct apple_cgl_api
      CGLError(*choose_pixel_format) (const CGLPixelFormatAttribute * attribs,
                                      CGLPixelFormatObj * pix, GLint * npix);
      CGLError(*destroy_pixel_format) (CGLPixelFormatObj pix);
+     CGLPixelFormatObj(*retain_pixel_format) (CGLPixelFormatObj pix);
 
      CGLError(*clear_drawable) (CGLContextObj ctx);
      CGLError(*flush_drawable) (CGLContextObj ctx);
@@ -52,6 +53,8 @@ struct apple_cgl_api
      CGLError(*create_context) (CGLPixelFormatObj pix, CGLContextObj share,
                                 CGLContextObj * ctx);
      CGLError(*destroy_context) (CGLContextObj pix);
+     CGLContextObj(*retain_context) (CGLContextObj ctx);
+   void (*release_context) (CGLContextObj ctx);
 
      CGLError(*set_current_context) (CGLContextObj ctx);
      CGLContextObj(*get_current_context) (void);
@@ -75,6 +78,35 @@ struct apple_cgl_api
      CGLError(*set_pbuffer) (CGLContextObj ctx,
                              CGLPBufferObj pbuffer,
                              GLenum face, GLint level, GLint screen);
+
+     CGLError(*get_parameter) (CGLContextObj ctx, CGLContextParameter pname,
+                               GLint * params);
+
+     CGLError(*enable) (CGLContextObj ctx, CGLContextEnable pname);
+     CGLError(*disable) (CGLContextObj ctx, CGLContextEnable pname);
+     CGLError(*is_enabled) (CGLContextObj ctx, CGLContextEnable pname,
+                            GLint * enable);
+
+     CGLError(*query_renderer_info) (GLuint display_mask,
+                                     CGLRendererInfoObj * rend,
+                                     GLint * nrend);
+     CGLError(*destroy_renderer_info) (CGLRendererInfoObj rend);
+     CGLError(*describe_renderer) (CGLRendererInfoObj rend, GLint rend_num,
+                                   CGLRendererProperty prop, GLint * value);
+};
+
+/* 
+ * kCGLPFAOpenGLProfile and its values.  These are defined here, because
+ * SDKs older than 10.7 don't have them.  CGL rejects the attribute on
+ * systems without profiles.
+ */
+enum
+{
+   APPLE_CGL_PFA_OPENGL_PROFILE = 99,
+   APPLE_CGL_PROFILE_3_2_CORE = 0x3200,
+   APPLE_CGL_PROFILE_GL4_CORE = 0x4100,
+   /* kCGLRPMajorGLVersion, which is also new in 10.7. */
+   APPLE_CGL_RP_MAJOR_GL_VERSION = 133
 };
 
 extern struct apple_cgl_api apple_cgl;
@@ -33,14 +33,24 @@
 #include <assert.h>
 #include <stdarg.h>
 #include <dlfcn.h>
+#include <pthread.h>
 #include "appledri.h"
 #include "apple_glx.h"
 #include "apple_glx_context.h"
+#include "apple_glx_display.h"
 #include "apple_cgl.h"
+#include "apple_glx_sync.h"
+#include "apple_glx_worker.h"
 #include "apple_xgl_api.h"
 
-static bool initialized = false;
-static int dri_event_base = 0;
+extern struct apple_xgl_api __gl_api;
+
+static pthread_once_t init_once = PTHREAD_ONCE_INIT;
+static pthread_once_t client_id_once = PTHREAD_ONCE_INIT;
+static pthread_once_t libgl_once = PTHREAD_ONCE_INIT;
+static xp_client_id client_id = 0;
+static struct apple_glx_job framework_job;
+int apple_glx_framework_ready = 0;
 
 const GLuint __glXDefaultPixelStore[9] = { 0, 0, 0, 0, 0, 0, 0, 0, 1 };
 
@@ -66,34 +76,118 @@ apple_glx_diagnostic(const char *fmt, ...)
    }
 }
 
+bool
+apple_glx_diagnostic_enabled(void)
+{
+   return diagnostic;
+}
+
 int
-apple_get_dri_event_base(void)
+apple_get_dri_event_base(Display * dpy)
 {
-   if (!initialized) {
+   struct apple_glx_display *gd;
+
+   gd = XAppleDRIGetDisplayData(dpy);
+
+   if (NULL == gd) {
       fprintf(stderr,
               "error: dri_event_base called before apple_init_glx!\n");
       abort();
    }
-   return dri_event_base;
+
+   return gd->dri_event_base;
 }
 
+/*
+ * The surface changed events are queued in the slots of the display by
+ * surface_notify_handler, and processed by 
+ * apple_glx_process_surface_changes.  Each uid occupies at most one slot,
+ * so a burst of events for a surface (such as during an interactive 
+ * resize) is coalesced into one update.  The slots are updated with atomic
+ * operations, so that no locks are taken in the Xlib event path.  If the
+ * slots are full, every surface of the display is updated.
+ */
 static void
-surface_notify_handler(Display * dpy, unsigned int uid, int kind)
+queue_surface_change(struct apple_glx_display *gd, unsigned int uid)
+{
+   int i;
+
+   if (0 == uid) {
+      (void) __sync_lock_test_and_set(&gd->surface_changes_overflow, 1);
+   }
+   else {
+      for (i = 0; i < APPLE_GLX_SURFACE_CHANGE_SLOTS; ++i) {
+         if (uid == gd->surface_changes[i])
+            break;
+
+         if (0 == __sync_val_compare_and_swap(&gd->surface_changes[i], 0,
+                                              uid))
+            break;
+      }
+
+      if (APPLE_GLX_SURFACE_CHANGE_SLOTS == i)
+         (void) __sync_lock_test_and_set(&gd->surface_changes_overflow, 1);
+   }
+
+   /* This publishes the slot, and is a full barrier. */
+   (void) __sync_lock_test_and_set(&gd->surface_changes_pending, 1);
+}
+
+/* 
+ * Mark the contexts of the surfaces that have changed since the last call
+ * as needing an update.  The updates are applied by each context.
+ */
+void
+apple_glx_process_surface_changes(struct apple_glx_display *gd)
 {
+   unsigned int uid;
+   int i, updated = 0;
+
+   if (NULL == gd || !gd->surface_changes_pending)
+      return;
+
+   if (!__sync_bool_compare_and_swap(&gd->surface_changes_pending, 1, 0))
+      return;
+
+   if (__sync_bool_compare_and_swap(&gd->surface_changes_overflow, 1, 0)) {
+      apple_glx_surface_invalidate_all_geometry(gd->dpy);
+      updated += apple_glx_context_all_surfaces_changed(gd->dpy);
+   }
+
+   for (i = 0; i < APPLE_GLX_SURFACE_CHANGE_SLOTS; ++i) {
+      if (0 == gd->surface_changes[i])
+         continue;
+
+      uid = __sync_lock_test_and_set(&gd->surface_changes[i], 0);
+
+      if (uid) {
+         apple_glx_surface_invalidate_geometry(gd->dpy, uid);
+         updated += apple_glx_context_surface_changed(gd->dpy, uid);
+      }
+   }
+
+   apple_glx_diagnostic("%s: surface changes updated %d\n", __func__,
+                        updated);
+}
+
+/* 
+ * The data is the apple_glx_display set by apple_init_glx, so the changed
+ * events don't take the displays lock.
+ */
+static void
+surface_notify_handler(Display * dpy, void *data, unsigned int uid, int kind)
+{
+   struct apple_glx_display *gd = data;
 
    switch (kind) {
    case AppleDRISurfaceNotifyDestroyed:
       apple_glx_diagnostic("%s: surface destroyed %u\n", __func__, uid);
-      apple_glx_surface_destroy(uid);
+      apple_glx_surface_destroy(dpy, uid);
       break;
 
-   case AppleDRISurfaceNotifyChanged:{
-         int updated;
-
-         updated = apple_glx_context_surface_changed(uid, pthread_self());
-
-         apple_glx_diagnostic("surface notify updated %d\n", updated);
-      }
+   case AppleDRISurfaceNotifyChanged:
+      if (gd)
+         queue_surface_change(gd, uid);
       break;
 
    default:
@@ -101,54 +195,121 @@ surface_notify_handler(Display * dpy, unsigned int uid, int kind)
    }
 }
 
+/* Xplugin has one client id for each process. */
+static void
+init_client_id(void)
+{
+   if ((XP_Success != xp_init(XP_IN_BACKGROUND)) ||
+       (Success != xp_get_client_id(&client_id))) {
+      client_id = 0;
+   }
+}
+
 xp_client_id
 apple_glx_get_client_id(void)
 {
-   static xp_client_id id;
+   (void) pthread_once(&client_id_once, init_client_id);
 
-   if (0 == id) {
-      if ((XP_Success != xp_init(XP_IN_BACKGROUND)) ||
-          (Success != xp_get_client_id(&id))) {
-         return 0;
-      }
+   return client_id;
+}
+
+/* The OpenGL framework libGL is only needed by glXGetProcAddress. */
+static void
+init_libgl_handle(void)
+{
+   libgl_handle = dlopen(OPENGL_LIB_PATH, RTLD_LAZY);
+}
+
+/* This dlopens CGL and looks up every GL function, in framework_job. */
+static void
+load_framework(void *arg)
+{
+   (void) arg;
+
+   apple_cgl_init();
+   apple_xgl_init_direct();
+
+   __atomic_store_n(&apple_glx_framework_ready, 1, __ATOMIC_RELEASE);
+
+   apple_glx_diagnostic("%s: loaded the OpenGL framework\n", __func__);
+}
+
+/* 
+ * This initializes the state shared by every Display.  The framework is
+ * loaded by a thread while the displays are initialized, and Xplugin is
+ * initialized by the first surface.
+ */
+static void
+init_process(void)
+{
+   if (getenv("LIBGL_DIAGNOSTIC")) {
+      printf("initializing libGL in %s\n", __func__);
+      diagnostic = true;
    }
 
-   return id;
+   apple_glx_job_start(&framework_job, load_framework, NULL);
+
+   XAppleDRISetSurfaceNotifyHandler(surface_notify_handler);
+}
+
+/* 
+ * Wait for the OpenGL framework to be loaded.  This must be called before
+ * apple_cgl or __gl_api are used, other than through a context, which
+ * waits when it's created.
+ */
+void
+apple_glx_wait_framework(void)
+{
+   if (__atomic_load_n(&apple_glx_framework_ready, __ATOMIC_ACQUIRE))
+      return;
+
+   (void) pthread_once(&init_once, init_process);
+
+   apple_glx_worker_wait(&framework_job);
 }
 
 /* Return true if an error occured. */
 bool
 apple_init_glx(Display * dpy)
 {
+   struct apple_glx_display *gd;
    int eventBase, errorBase;
    int major, minor, patch;
 
+   /* Start loading the framework before the round trips. */
+   (void) pthread_once(&init_once, init_process);
+
    if (!XAppleDRIQueryExtension(dpy, &eventBase, &errorBase))
       return true;
 
    if (!XAppleDRIQueryVersion(dpy, &major, &minor, &patch))
       return true;
 
-   if (initialized)
-      return false;
+   gd = apple_glx_display_get(dpy, eventBase);
 
-   if (getenv("LIBGL_DIAGNOSTIC")) {
-      printf("initializing libGL in %s\n", __func__);
-      diagnostic = true;
-   }
+   if (NULL == gd)
+      return true;
 
-   apple_cgl_init();
-   apple_xgl_init_direct();
-   libgl_handle = dlopen(OPENGL_LIB_PATH, RTLD_LAZY);
-   (void) apple_glx_get_client_id();
+   XAppleDRISetDisplayData(dpy, gd);
 
-   XAppleDRISetSurfaceNotifyHandler(surface_notify_handler);
+   return false;
+}
 
-   /* This should really be per display. */
-   dri_event_base = eventBase;
-   initialized = true;
+/* 
+ * This is called by XCloseDisplay while the connection is still open, and 
+ * destroys the contexts and pbuffers of the display in bulk.
+ */
+void
+apple_glx_close_display(Display * dpy)
+{
+   apple_glx_context_destroy_all(dpy);
+}
 
-   return false;
+/* This is called when dpy is closed. */
+void
+apple_uninit_glx(Display * dpy)
+{
+   apple_glx_display_destroy(dpy);
 }
 
 void
@@ -156,9 +317,130 @@ apple_glx_swap_buffers(void *ptr)
 {
    struct apple_glx_context *ac = ptr;
 
+   if (ac->drawable)
+      apple_glx_sync_swap_begin(ac->drawable);
+
+   apple_glx_swap_begun(ac);
+}
+
+/* 
+ * Swap the drawable of ptr, when apple_glx_sync_swap_begin was already
+ * called for it.
+ */
+void
+apple_glx_swap_begun(void *ptr)
+{
+   struct apple_glx_context *ac = ptr;
+
+   apple_glx_context_apply_surface_changes(ac);
+
+   if (ac->drawable && APPLE_GLX_DRAWABLE_SURFACE == ac->drawable->type
+       && ac->drawable->types.surface.shared) {
+      (void) apple_glx_surface_swap_shared(ac, ac->drawable, NULL);
+      apple_glx_sync_swap_complete(ac->drawable);
+      return;
+   }
+
    /* This may not be needed with CGLFlushDrawable: */
    glFlush();
    apple_cgl.flush_drawable(ac->context_obj);
+
+   if (ac->drawable)
+      apple_glx_sync_swap_complete(ac->drawable);
+}
+
+/* Copy a rectangle of the back buffer to the front buffer with a blit. */
+static void
+copy_back_to_front(GLint x, GLint y, GLint width, GLint height)
+{
+   GLint read_buffer, draw_buffer, read_fbo, draw_fbo, scissor[4];
+   GLboolean scissor_test;
+
+   __gl_api.GetIntegerv(GL_READ_BUFFER, &read_buffer);
+   __gl_api.GetIntegerv(GL_DRAW_BUFFER, &draw_buffer);
+   __gl_api.GetIntegerv(GL_READ_FRAMEBUFFER_BINDING_EXT, &read_fbo);
+   __gl_api.GetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING_EXT, &draw_fbo);
+   __gl_api.GetIntegerv(GL_SCISSOR_BOX, scissor);
+   scissor_test = __gl_api.IsEnabled(GL_SCISSOR_TEST);
+
+   __gl_api.BindFramebufferEXT(GL_READ_FRAMEBUFFER_EXT, 0);
+   __gl_api.BindFramebufferEXT(GL_DRAW_FRAMEBUFFER_EXT, 0);
+   __gl_api.ReadBuffer(GL_BACK);
+   __gl_api.DrawBuffer(GL_FRONT);
+   __gl_api.Enable(GL_SCISSOR_TEST);
+   __gl_api.Scissor(x, y, width, height);
+
+   __gl_api.BlitFramebufferEXT(x, y, x + width, y + height,
+                               x, y, x + width, y + height,
+                               GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+   __gl_api.Scissor(scissor[0], scissor[1], scissor[2], scissor[3]);
+
+   if (!scissor_test)
+      __gl_api.Disable(GL_SCISSOR_TEST);
+
+   __gl_api.DrawBuffer(draw_buffer);
+   __gl_api.ReadBuffer(read_buffer);
+   __gl_api.BindFramebufferEXT(GL_DRAW_FRAMEBUFFER_EXT, draw_fbo);
+   __gl_api.BindFramebufferEXT(GL_READ_FRAMEBUFFER_EXT, read_fbo);
+
+   /* Only the scissored region of the front buffer was touched. */
+   __gl_api.Flush();
+}
+
+/* 
+ * GLX_MESA_copy_sub_buffer: copy a rectangle of the back buffer, with the
+ * origin at the lower left, to the front buffer.  The rest of the front
+ * buffer, and the back buffer, are unchanged.
+ */
+void
+apple_glx_copy_sub_buffer(void *ptr, int x, int y, int width, int height)
+{
+   struct apple_glx_context *ac = ptr;
+   struct apple_glx_drawable *d;
+   struct apple_glx_shared_buffer *sb;
+   xcb_rectangle_t damage;
+   int x1, y1;
+
+   apple_glx_context_apply_surface_changes(ac);
+
+   d = ac->drawable;
+
+   if (NULL == d || APPLE_GLX_DRAWABLE_SURFACE != d->type) {
+      /* Pbuffers and pixmaps are single buffered. */
+      glFlush();
+      return;
+   }
+
+   if (d->types.surface.shared) {
+      /* Clip to the buffer, which is top down. */
+      sb = &d->types.surface.shared_buffer;
+      x1 = x + width < sb->width ? x + width : sb->width;
+      y1 = y + height < sb->height ? y + height : sb->height;
+      x = x < 0 ? 0 : x;
+      y = y < 0 ? 0 : y;
+
+      if (x1 <= x || y1 <= y)
+         return;
+
+      damage.x = x;
+      damage.y = sb->height - y1;
+      damage.width = x1 - x;
+      damage.height = y1 - y;
+
+      glFlush();
+      (void) apple_glx_surface_swap_shared(ac, d, &damage);
+      return;
+   }
+
+   if (NULL == __gl_api.BlitFramebufferEXT) {
+      apple_glx_diagnostic("%s: no EXT_framebuffer_blit, swapping the whole"
+                           " buffer\n", __func__);
+      apple_glx_swap_buffers(ac);
+      return;
+   }
+
+   copy_back_to_front(x, y, width, height);
 }
 
 void *
@@ -193,6 +475,7 @@ apple_glx_get_proc_address(const GLubyte * procname)
 
    if (NULL == s) {
       /* Try the libGL.dylib from the OpenGL.framework. */
+      (void) pthread_once(&libgl_once, init_libgl_handle);
       s = dlsym(libgl_handle, pname);
    }
 
@@ -201,14 +484,80 @@ apple_glx_get_proc_address(const GLubyte * procname)
    return s;
 }
 
+/* 
+ * Wait for the GL commands issued so far by the current CGL context to 
+ * complete.  This uses a GL_APPLE_fence scoped to the context, rather than
+ * draining the whole pipeline with glFinish.  Fence names aren't valid
+ * in other CGL contexts, so the fence is kept with the CGL context.
+ */
+static void
+finish_with_fence(bool * has_fence, GLuint * fence)
+{
+   if (NULL == __gl_api.SetFenceAPPLE || NULL == __gl_api.FinishFenceAPPLE) {
+      glFinish();
+      return;
+   }
+
+   if (!*has_fence) {
+      __gl_api.GenFencesAPPLE(1, fence);
+      *has_fence = true;
+   }
+
+   __gl_api.SetFenceAPPLE(*fence);
+   __gl_api.FinishFenceAPPLE(*fence);
+}
+
+/*
+ * The X server only accesses the memory GL renders to with GLXPixmaps.
+ * Surfaces are composited separately, and pbuffers aren't visible to X, 
+ * so those only need a flush.
+ */
+static bool
+drawable_shared_with_x(struct apple_glx_context *ac)
+{
+   return ac->drawable && APPLE_GLX_DRAWABLE_PIXMAP == ac->drawable->type;
+}
+
 void
-apple_glx_waitx(Display * dpy, void *ptr)
+apple_glx_waitgl(Display * dpy, void *ptr)
 {
-   struct apple_private_context *ac = ptr;
+   struct apple_glx_context *ac = ptr;
+   struct apple_glx_pixmap *p;
+
+   (void) dpy;
+
+   glFlush();
+
+   if (drawable_shared_with_x(ac)) {
+      /* The pixmap renders with its own CGL context. */
+      p = &ac->drawable->types.pixmap;
+      finish_with_fence(&p->has_fence, &p->fence);
+   }
+   else if (ac->mp_engine) {
+      /* 
+       * With the multithreaded engine, the glFlush above only queues the
+       * commands for the engine thread, which may not have submitted them
+       * yet, so wait for them with the fence.
+       */
+      finish_with_fence(&ac->has_fence, &ac->fence);
+   }
+}
 
-   (void) ac;
+void
+apple_glx_waitx(Display * dpy, void *ptr)
+{
+   struct apple_glx_context *ac = ptr;
 
    glFlush();
-   glFinish();
+
+   /* X can't render to a pbuffer, so there is nothing to wait for. */
+   if (NULL == ac->drawable
+       || APPLE_GLX_DRAWABLE_PBUFFER == ac->drawable->type)
+      return;
+
+   /* 
+    * The GL commands made after this are queued for the multithreaded
+    * engine only once XSync returns, so the engine needs no more.
+    */
    XSync(dpy, False);
 }
@@ -39,11 +39,36 @@
 #include <Xplugin.h>
 
 void apple_glx_diagnostic(const char *fmt, ...);
+bool apple_glx_diagnostic_enabled(void);
 xp_client_id apple_glx_get_client_id(void);
 bool apple_init_glx(Display * dpy);
+void apple_glx_wait_framework(void);
+void apple_glx_close_display(Display * dpy);
+void apple_uninit_glx(Display * dpy);
 void apple_glx_swap_buffers(void *ptr);
+void apple_glx_swap_begun(void *ptr);
+void apple_glx_copy_sub_buffer(void *ptr, int x, int y, int width,
+                               int height);
 void *apple_glx_get_proc_address(const GLubyte * procname);
+void apple_glx_waitgl(Display * dpy, void *ptr);
 void apple_glx_waitx(Display * dpy, void *ptr);
-int apple_get_dri_event_base(void);
+struct apple_glx_display;
+
+/* This is set, with a release store, once apple_cgl and __gl_api are loaded. */
+extern int apple_glx_framework_ready;
+
+/* 
+ * This is used by the GL entry points, which may be called before a context
+ * is created, so once the framework is loaded it's a single acquire load.
+ */
+static inline void
+apple_glx_require_framework(void)
+{
+   if (!__atomic_load_n(&apple_glx_framework_ready, __ATOMIC_ACQUIRE))
+      apple_glx_wait_framework();
+}
+
+int apple_get_dri_event_base(Display * dpy);
+void apple_glx_process_surface_changes(struct apple_glx_display *gd);
 
 #endif
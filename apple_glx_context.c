@@ -50,68 +50,291 @@
 
 #include "apple_glx.h"
 #include "apple_glx_context.h"
+#include "apple_glx_display.h"
 #include "appledri.h"
 #include "apple_visual.h"
 #include "apple_cgl.h"
 #include "apple_glx_drawable.h"
-
-static pthread_mutex_t context_lock = PTHREAD_MUTEX_INITIALIZER;
+#include "apple_glx_share_group.h"
+#include "apple_glx_renderer.h"
 
 /*
- * This should be locked on creation and destruction of the 
- * apple_glx_contexts.
+ * The contexts are linked in the list of their display.  The list is 
+ * locked on creation and destruction of the apple_glx_contexts.
+ *
+ * It's also locked when the surface changes are processed, and contexts
+ * are searched for a uid associated with a surface.
  *
- * It's also locked when the surface_notify_handler is searching
- * for a uid associated with a surface.
+ * A context that can be shared with is a member of a share group of the
+ * same display, so this doesn't need to search the list.
  */
-static struct apple_glx_context *context_list = NULL;
+static bool
+is_context_valid(struct apple_glx_display *gd, struct apple_glx_context *ac)
+{
+   return ac->glx_display == gd && NULL != ac->share_group;
+}
 
-/* This guards the context_list above. */
-static void
-lock_context_list(void)
+#ifndef GLXBadProfileARB
+#define GLXBadProfileARB 13
+#endif
+
+/* 
+ * Map the GLX_ARB_create_context attributes onto a CGL OpenGL profile.
+ * *profile is set to 0 for a legacy context.
+ * *renderer_id is set from GLX_RENDERER_ID_MESA, or 0 for the default.
+ * Return true if an error occurred.
+ */
+static bool
+parse_context_attributes(const int *attrib_list, int *profile,
+                         GLint * renderer_id, int *errorptr,
+                         bool * x11errorptr)
 {
-   int err;
+   const struct apple_glx_renderer *renderer;
+   int major = 1, minor = 0, flags = 0;
+   int profile_mask = GLX_CONTEXT_CORE_PROFILE_BIT_ARB;
+   int i;
+
+   *profile = 0;
+   *renderer_id = 0;
+
+   for (i = 0; attrib_list && attrib_list[i] != None; i += 2) {
+      switch (attrib_list[i]) {
+      case GLX_CONTEXT_MAJOR_VERSION_ARB:
+         major = attrib_list[i + 1];
+         break;
+
+      case GLX_CONTEXT_MINOR_VERSION_ARB:
+         minor = attrib_list[i + 1];
+         break;
+
+      case GLX_CONTEXT_FLAGS_ARB:
+         flags = attrib_list[i + 1];
+         break;
+
+      case GLX_CONTEXT_PROFILE_MASK_ARB:
+         profile_mask = attrib_list[i + 1];
+         break;
+
+      case GLX_RENDERER_ID_MESA:
+         /* This is an index of the GLX_MESA_query_renderer renderers. */
+         renderer = apple_glx_renderer_get(attrib_list[i + 1]);
+
+         if (NULL == renderer) {
+            *errorptr = BadValue;
+            *x11errorptr = true;
+            return true;
+         }
 
-   err = pthread_mutex_lock(&context_lock);
+         *renderer_id = renderer->id;
+         break;
 
-   if (err) {
-      fprintf(stderr, "pthread_mutex_lock failure in %s: %d\n",
-              __func__, err);
-      abort();
+      case GLX_RENDER_TYPE:
+         if (GLX_RGBA_TYPE != attrib_list[i + 1]) {
+            *errorptr = BadMatch;
+            *x11errorptr = true;
+            return true;
+         }
+         break;
+
+      default:
+         *errorptr = BadValue;
+         *x11errorptr = true;
+         return true;
+      }
    }
+
+   if (flags & ~(GLX_CONTEXT_DEBUG_BIT_ARB
+                 | GLX_CONTEXT_FORWARD_COMPATIBLE_BIT_ARB)) {
+      *errorptr = BadValue;
+      *x11errorptr = true;
+      return true;
+   }
+
+   /* These aren't versions of OpenGL. */
+   if (major < 1 || (1 == major && minor > 5) || (2 == major && minor > 1)
+       || (3 == major && minor > 3) || (4 == major && minor > 1)
+       || major > 4) {
+      *errorptr = BadMatch;
+      *x11errorptr = true;
+      return true;
+   }
+
+   /* The profile mask is ignored for versions before 3.2. */
+   if ((major > 3 || (3 == major && minor >= 2))
+       && GLX_CONTEXT_CORE_PROFILE_BIT_ARB != profile_mask
+       && GLX_CONTEXT_COMPATIBILITY_PROFILE_BIT_ARB != profile_mask) {
+      *errorptr = GLXBadProfileARB;
+      *x11errorptr = false;
+      return true;
+   }
+
+   /* 
+    * There is no CGL attribute for the debug flag.  It's only a hint, so 
+    * the context is created without the extra checking.
+    */
+   if (flags & GLX_CONTEXT_DEBUG_BIT_ARB)
+      apple_glx_diagnostic("%s: GLX_CONTEXT_DEBUG_BIT_ARB is ignored\n",
+                           __func__);
+
+   if (major < 3)
+      return false;
+
+   /* 
+    * CGL only has forward compatible core profiles for 3.2 and later.
+    * These can't provide the deprecated features of 3.0, or of a
+    * compatibility profile.  They do provide all of 3.1.
+    */
+   if ((3 == major && 0 == minor
+        && !(flags & GLX_CONTEXT_FORWARD_COMPATIBLE_BIT_ARB))
+       || (GLX_CONTEXT_COMPATIBILITY_PROFILE_BIT_ARB == profile_mask
+           && (major > 3 || minor >= 2))) {
+      *errorptr = BadMatch;
+      *x11errorptr = true;
+      return true;
+   }
+
+   if (3 == major && minor <= 2)
+      *profile = APPLE_CGL_PROFILE_3_2_CORE;
+   else
+      *profile = APPLE_CGL_PROFILE_GL4_CORE;
+
+   return false;
 }
 
+static pthread_once_t options_once = PTHREAD_ONCE_INIT;
+static bool mp_engine_enabled = false;
+
 static void
-unlock_context_list(void)
+init_options(void)
+{
+   mp_engine_enabled = (getenv("LIBGL_MP_ENGINE") != NULL);
+}
+
+/* This is called by the workers, so the option is read once. */
+static bool
+mp_engine_requested(void)
 {
-   int err;
+   (void) pthread_once(&options_once, init_options);
 
-   err = pthread_mutex_unlock(&context_lock);
+   return mp_engine_enabled;
+}
 
-   if (err) {
-      fprintf(stderr, "pthread_mutex_unlock failure in %s: %d\n",
-              __func__, err);
-      abort();
+/* 
+ * Enable the multithreaded GL engine of CGL, which runs the driver work of
+ * the context on a second thread.  Not every renderer has it, and the
+ * context is used without it then.
+ */
+static void
+enable_mp_engine(struct apple_glx_context *ac)
+{
+   CGLError error;
+   GLint enabled = 0;
+
+   error = apple_cgl.enable(ac->context_obj, kCGLCEMPEngine);
+
+   if (kCGLNoError == error) {
+      error = apple_cgl.is_enabled(ac->context_obj, kCGLCEMPEngine,
+                                   &enabled);
+
+      if (kCGLNoError != error)
+         (void) apple_cgl.disable(ac->context_obj, kCGLCEMPEngine);
    }
+
+   ac->mp_engine = (kCGLNoError == error && enabled);
+
+   apple_glx_diagnostic("%s: ac %p the multithreaded engine is %s: %s\n",
+                        __func__, (void *) ac,
+                        ac->mp_engine ? "enabled" : "not enabled",
+                        apple_cgl.error_string(error));
 }
 
-static bool
-is_context_valid(struct apple_glx_context *ac)
+/* 
+ * Create the pixel_format_obj and context_obj of ac.  This may run in a
+ * worker.  An error is saved in ac.
+ */
+static void
+create_context_objects(void *arg)
 {
-   struct apple_glx_context *i;
+   struct apple_glx_context *ac = arg;
+   CGLError error;
 
-   lock_context_list();
+   apple_glx_wait_framework();
 
-   for (i = context_list; i; i = i->next) {
-      if (ac == i) {
-         unlock_context_list();
-         return true;
+   if (apple_visual_create_pfobj(&ac->pixel_format_obj, ac->mode,
+                                 &ac->double_buffered, &ac->uses_stereo,
+                                 /*offscreen_bpp */ 0, ac->profile,
+                                 ac->renderer_id)) {
+      /* The config can't be used with the requested version or profile. */
+      ac->create_failed = true;
+      ac->create_errorcode = BadMatch;
+      ac->create_x11error = true;
+   }
+   else {
+      error = apple_cgl.create_context(ac->pixel_format_obj, ac->share_obj,
+                                       &ac->context_obj);
+
+      if (error) {
+         (void) apple_cgl.destroy_pixel_format(ac->pixel_format_obj);
+         ac->pixel_format_obj = NULL;
+         ac->context_obj = NULL;
+         ac->create_failed = true;
+
+         if (kCGLBadMatch == error) {
+            ac->create_errorcode = BadMatch;
+            ac->create_x11error = true;
+         }
+         else {
+            ac->create_errorcode = GLXBadContext;
+            ac->create_x11error = false;
+         }
+
+         if (getenv("LIBGL_DIAGNOSTIC"))
+            fprintf(stderr, "error: %s\n", apple_cgl.error_string(error));
+      }
+      else if (mp_engine_requested()) {
+         enable_mp_engine(ac);
       }
    }
 
-   unlock_context_list();
+   if (ac->share_obj) {
+      apple_cgl.release_context(ac->share_obj);
+      ac->share_obj = NULL;
+   }
+}
 
-   return false;
+/* 
+ * Wait for a pending creation.  Return true if the creation failed.
+ * This may be called by several threads, so pending isn't cleared, and
+ * a completed job returns after checking done under the lock of the pool.
+ */
+static bool
+wait_created(struct apple_glx_context *ac)
+{
+   if (ac->pending)
+      apple_glx_worker_wait(&ac->create_job);
+
+   return ac->create_failed;
+}
+
+bool
+apple_glx_context_wait(void *ptr, int *errorptr, bool * x11errorptr)
+{
+   struct apple_glx_context *ac = ptr;
+
+   if (!wait_created(ac))
+      return false;
+
+   if (ac->create_error_reported) {
+      *errorptr = GLXBadContext;
+      *x11errorptr = false;
+   }
+   else {
+      *errorptr = ac->create_errorcode;
+      *x11errorptr = ac->create_x11error;
+      ac->create_error_reported = true;
+   }
+
+   return true;
 }
 
 /* This creates an apple_private_context struct.  
@@ -119,18 +342,36 @@ is_context_valid(struct apple_glx_context *ac)
  * It's typically called to save the struct in a GLXContext.
  *
  * This is also where the CGLContextObj is created, and the CGLPixelFormatObj.
+ * With LIBGL_ASYNC_CONTEXT they are created by a worker, and the errors of
+ * creating them are returned by apple_glx_context_wait.  A context shared
+ * with must be created first, so this waits for it.
  */
 bool
 apple_glx_create_context(void **ptr, Display * dpy, int screen,
                          const void *mode, void *sharedContext,
+                         const int *attrib_list,
                          int *errorptr, bool * x11errorptr)
 {
+   struct apple_glx_display *gd;
    struct apple_glx_context *ac;
    struct apple_glx_context *sharedac = sharedContext;
-   CGLError error;
+   int profile;
+   GLint renderer_id;
 
    *ptr = NULL;
 
+   if (parse_context_attributes(attrib_list, &profile, &renderer_id,
+                                errorptr, x11errorptr))
+      return true;
+
+   gd = apple_glx_display_find(dpy);
+
+   if (NULL == gd) {
+      *errorptr = GLXBadContext;
+      *x11errorptr = false;
+      return true;
+   }
+
    ac = malloc(sizeof *ac);
 
    if (NULL == ac) {
@@ -139,12 +380,16 @@ apple_glx_create_context(void **ptr, Display * dpy, int screen,
       return true;
    }
 
-   if (sharedac && !is_context_valid(sharedac)) {
+   if (sharedac && (!is_context_valid(gd, sharedac)
+                    || wait_created(sharedac))) {
+      free(ac);
       *errorptr = GLXBadContext;
       *x11errorptr = false;
       return true;
    }
 
+   ac->glx_display = gd;
+   ac->share_group = NULL;
    ac->context_obj = NULL;
    ac->pixel_format_obj = NULL;
    ac->drawable = NULL;
@@ -155,64 +400,95 @@ apple_glx_create_context(void **ptr, Display * dpy, int screen,
    ac->need_update = false;
    ac->is_current = false;
    ac->made_current = false;
+   ac->detached = true;
+   ac->has_fence = false;
+   ac->fence = 0;
+   ac->mp_engine = false;
+   ac->destroy_deferred = false;
    ac->last_surface_window = None;
+   ac->attached_surface = 0;
+   ac->shared_generation = 0;
+   ac->pending = false;
+   ac->create_failed = false;
+   ac->create_error_reported = false;
+   ac->create_errorcode = Success;
+   ac->create_x11error = false;
+   ac->mode = mode;
+   ac->profile = profile;
+   ac->renderer_id = renderer_id;
+   ac->share_obj = NULL;
+
+   if (sharedac)
+      ac->share_obj = apple_cgl.retain_context(sharedac->context_obj);
+
+   if (apple_glx_worker_submit(&ac->create_job, create_context_objects, ac)) {
+      create_context_objects(ac);
+
+      if (ac->create_failed) {
+         *errorptr = ac->create_errorcode;
+         *x11errorptr = ac->create_x11error;
+         free(ac);
+         return true;
+      }
+   }
+   else {
+      ac->pending = true;
+   }
 
-   apple_visual_create_pfobj(&ac->pixel_format_obj, mode,
-                             &ac->double_buffered, &ac->uses_stereo,
-                             /*offscreen */ false);
-
-   error = apple_cgl.create_context(ac->pixel_format_obj,
-                                    sharedac ? sharedac->context_obj : NULL,
-                                    &ac->context_obj);
-
-
-   if (error) {
-      (void) apple_cgl.destroy_pixel_format(ac->pixel_format_obj);
+   if (sharedac) {
+      ac->share_group = sharedac->share_group;
+      apple_glx_share_group_join(ac->share_group);
+   }
+   else {
+      ac->share_group = apple_glx_share_group_create(gd);
 
-      free(ac);
+      if (NULL == ac->share_group) {
+         if (!wait_created(ac)) {
+            (void) apple_cgl.destroy_context(ac->context_obj);
+            (void) apple_cgl.destroy_pixel_format(ac->pixel_format_obj);
+         }
 
-      if (kCGLBadMatch == error) {
-         *errorptr = BadMatch;
+         free(ac);
+         *errorptr = BadAlloc;
          *x11errorptr = true;
+         return true;
       }
-      else {
-         *errorptr = GLXBadContext;
-         *x11errorptr = false;
-      }
-
-      if (getenv("LIBGL_DIAGNOSTIC"))
-         fprintf(stderr, "error: %s\n", apple_cgl.error_string(error));
-
-      return true;
    }
 
    /* The context creation succeeded, so we can link in the new context. */
-   lock_context_list();
+   apple_glx_display_lock_contexts(gd);
 
-   if (context_list)
-      context_list->previous = ac;
+   if (gd->contexts)
+      gd->contexts->previous = ac;
 
    ac->previous = NULL;
-   ac->next = context_list;
-   context_list = ac;
+   ac->next = gd->contexts;
+   gd->contexts = ac;
 
    *ptr = ac;
 
-   apple_glx_diagnostic("%s: ac %p ac->context_obj %p\n",
-                        __func__, (void *) ac, (void *) ac->context_obj);
+   apple_glx_diagnostic("%s: ac %p ac->context_obj %p pending %d\n",
+                        __func__, (void *) ac, (void *) ac->context_obj,
+                        ac->pending);
 
-   unlock_context_list();
+   apple_glx_display_unlock_contexts(gd);
 
    return false;
 }
 
-void
-apple_glx_destroy_context(void **ptr, Display * dpy)
+/* 
+ * The context must already be removed from the list of its display, because
+ * this can cause surface_notify_handler to be called.
+ */
+static void
+destroy_context_objects(struct apple_glx_context *ac)
 {
-   struct apple_glx_context *ac = *ptr;
-
-   if (NULL == ac)
+   if (wait_created(ac)) {
+      /* There are no objects, and it was never current. */
+      apple_glx_share_group_leave(ac->share_group);
+      free(ac);
       return;
+   }
 
    apple_glx_diagnostic("%s: ac %p ac->context_obj %p\n",
                         __func__, (void *) ac, (void *) ac->context_obj);
@@ -226,22 +502,7 @@ apple_glx_destroy_context(void **ptr, Display * dpy)
       }
    }
 
-   /* Remove ac from the context_list as soon as possible. */
-   lock_context_list();
-
-   if (ac->previous) {
-      ac->previous->next = ac->next;
-   }
-   else {
-      context_list = ac->next;
-   }
-
-   if (ac->next) {
-      ac->next->previous = ac->previous;
-   }
-
-   unlock_context_list();
-
+   ac->attached_surface = 0;
 
    if (apple_cgl.clear_drawable(ac->context_obj)) {
       fprintf(stderr, "error: while clearing drawable!\n");
@@ -269,13 +530,184 @@ apple_glx_destroy_context(void **ptr, Display * dpy)
       abort();
    }
 
+   apple_glx_share_group_leave(ac->share_group);
+
    free(ac);
+}
+
+void
+apple_glx_destroy_context(void **ptr, Display * dpy)
+{
+   struct apple_glx_context *ac = *ptr;
+   struct apple_glx_display *gd;
+   bool deferred;
+
+   if (NULL == ac)
+      return;
+
+   gd = ac->glx_display;
+
+   /* Remove ac from the contexts of the display as soon as possible. */
+   apple_glx_display_lock_contexts(gd);
+
+   if (ac->previous) {
+      ac->previous->next = ac->next;
+   }
+   else {
+      gd->contexts = ac->next;
+   }
+
+   if (ac->next) {
+      ac->next->previous = ac->previous;
+   }
+
+   deferred = ac->destroy_deferred;
+
+   apple_glx_display_unlock_contexts(gd);
+
+   destroy_context_objects(ac);
 
    *ptr = NULL;
 
+   /* The Display of a deferred context was closed. */
+   if (deferred) {
+      apple_glx_display_release_context(gd);
+      return;
+   }
+
    apple_glx_garbage_collect_drawables(dpy);
 }
 
+bool
+apple_glx_context_destroy_deferred(void *ptr)
+{
+   struct apple_glx_context *ac = ptr;
+   bool result;
+
+   if (NULL == ac)
+      return false;
+
+   apple_glx_display_lock_contexts(ac->glx_display);
+   result = ac->destroy_deferred;
+   apple_glx_display_unlock_contexts(ac->glx_display);
+
+   return result;
+}
+
+/*
+ * Destroy the contexts of the share group g, and the pbuffers accounted
+ * to it, in one pass over the contexts of the display.  A context that is
+ * current in another thread is still in use, so it's left in the list, 
+ * and destroyed by that thread when it's no longer current.
+ */
+static void
+destroy_share_group(struct apple_glx_display *gd,
+                    struct apple_glx_share_group *g)
+{
+   struct apple_glx_context *ac, *next, *members = NULL;
+
+   apple_glx_display_lock_contexts(gd);
+
+   for (ac = gd->contexts; ac; ac = next) {
+      next = ac->next;
+
+      if (g != ac->share_group || ac->destroy_deferred)
+         continue;
+
+      if (ac->is_current && !pthread_equal(ac->thread_id, pthread_self())) {
+         ac->destroy_deferred = true;
+         apple_glx_display_defer_context(gd);
+         continue;
+      }
+
+      if (ac->previous)
+         ac->previous->next = ac->next;
+      else
+         gd->contexts = ac->next;
+
+      if (ac->next)
+         ac->next->previous = ac->previous;
+
+      ac->previous = NULL;
+      ac->next = members;
+      members = ac;
+   }
+
+   apple_glx_display_unlock_contexts(gd);
+
+   for (ac = members; ac; ac = next) {
+      next = ac->next;
+      destroy_context_objects(ac);
+   }
+
+   apple_glx_pbuffer_destroy_share_group(gd->dpy, g);
+}
+
+/* 
+ * This is called when dpy is closed, and destroys the contexts that 
+ * weren't destroyed by glXDestroyContext, with their share groups.
+ */
+void
+apple_glx_context_destroy_all(Display * dpy)
+{
+   struct apple_glx_display *gd;
+   struct apple_glx_share_group *g, **groups;
+   unsigned int i, count = 0;
+
+   gd = apple_glx_display_find(dpy);
+
+   if (NULL == gd)
+      return;
+
+   apple_glx_display_lock_contexts(gd);
+
+   for (g = gd->share_groups; g; g = g->next)
+      ++count;
+
+   groups = count ? malloc(count * sizeof *groups) : NULL;
+
+   if (NULL == groups) {
+      apple_glx_display_unlock_contexts(gd);
+      return;
+   }
+
+   for (i = 0, g = gd->share_groups; g; g = g->next, ++i) {
+      apple_glx_share_group_reference(g);
+      groups[i] = g;
+   }
+
+   apple_glx_display_unlock_contexts(gd);
+
+   for (i = 0; i < count; ++i) {
+      destroy_share_group(gd, groups[i]);
+      apple_glx_share_group_release(groups[i]);
+   }
+
+   free(groups);
+
+   apple_glx_garbage_collect_drawables(dpy);
+}
+
+void
+apple_glx_context_destroy_remaining(struct apple_glx_display *gd)
+{
+   struct apple_glx_context *ac, *next;
+
+   apple_glx_display_lock_contexts(gd);
+   ac = gd->contexts;
+   gd->contexts = NULL;
+   apple_glx_display_unlock_contexts(gd);
+
+   for (; ac; ac = next) {
+      next = ac->next;
+
+      apple_glx_diagnostic("%s: destroying ac %p\n", __func__, (void *) ac);
+
+      ac->previous = NULL;
+      ac->next = NULL;
+      destroy_context_objects(ac);
+   }
+}
 
 /* Return true if an error occured. */
 bool
@@ -298,12 +730,17 @@ apple_glx_make_current_context(Display * dpy, void *oldptr, void *ptr,
                         (void *) (ac ? ac->context_obj : NULL));
 #endif
 
+   if (ac && wait_created(ac))
+      return true;
+
    /* This a common path for GLUT and other apps, so special case it. */
    if (ac && ac->drawable && ac->drawable->drawable == drawable) {
       same_drawable = true;
 
-      if (ac->is_current)
+      if (ac->is_current) {
+         apple_glx_context_apply_surface_changes(ac);
          return false;
+      }
    }
 
    /* Reset the is_current state of the old context, if non-NULL. */
@@ -311,6 +748,9 @@ apple_glx_make_current_context(Display * dpy, void *oldptr, void *ptr,
       oldac->is_current = false;
 
    if (NULL == ac) {
+      /* This may be called before any context was created. */
+      apple_glx_wait_framework();
+
       /*Clear the current context for this thread. */
       apple_cgl.set_current_context(NULL);
 
@@ -332,22 +772,41 @@ apple_glx_make_current_context(Display * dpy, void *oldptr, void *ptr,
    if (None == drawable) {
       bool error = false;
 
-      /* Clear the current drawable for this context_obj. */
+      /* 
+       * Make the context current without a drawable.  Rendering is then
+       * only possible to framebuffer objects, and no surface, pixmap, or
+       * pbuffer is created for it.
+       */
+      if (ac->is_current && ac->detached && NULL == ac->drawable
+          && ac == oldac)
+         return false;
+
+      if (ac->drawable) {
+         ac->drawable->destroy(ac->drawable);
+         ac->drawable = NULL;
+      }
 
       if (apple_cgl.set_current_context(ac->context_obj))
          error = true;
 
-      if (apple_cgl.clear_drawable(ac->context_obj))
-         error = true;
+      ac->attached_surface = 0;
 
-      if (ac->drawable) {
-         ac->drawable->destroy(ac->drawable);
-         ac->drawable = NULL;
+      /* A context_obj that was never attached has nothing to clear. */
+      if (!ac->detached) {
+         if (apple_cgl.clear_drawable(ac->context_obj))
+            error = true;
+         else
+            ac->detached = true;
       }
 
       /* Invalidate this to prevent surface recreation. */
       ac->last_surface_window = None;
 
+      if (!error) {
+         ac->is_current = true;
+         ac->thread_id = pthread_self();
+      }
+
       apple_glx_diagnostic("%s: drawable is None, error is: %d\n",
                            __func__, error);
 
@@ -361,7 +820,8 @@ apple_glx_make_current_context(Display * dpy, void *oldptr, void *ptr,
    else {
       /* Find the drawable if possible, and retain a reference to it. */
       newagd =
-         apple_glx_drawable_find(drawable, APPLE_GLX_DRAWABLE_REFERENCE);
+         apple_glx_drawable_find(dpy, drawable,
+                                 APPLE_GLX_DRAWABLE_REFERENCE);
    }
 
    /*
@@ -443,6 +903,15 @@ apple_glx_make_current_context(Display * dpy, void *oldptr, void *ptr,
    /* This will be set if the pending_destroy code indicates it should be: */
    ac->last_surface_window = None;
 
+   /* 
+    * A pbuffer replaces the drawable of the context_obj.  A pixmap uses
+    * its own context_obj, so it doesn't affect the attachment.
+    */
+   if (APPLE_GLX_DRAWABLE_PBUFFER == ac->drawable->type)
+      ac->attached_surface = 0;
+
+   ac->detached = false;
+
    switch (ac->drawable->type) {
    case APPLE_GLX_DRAWABLE_PBUFFER:
    case APPLE_GLX_DRAWABLE_SURFACE:
@@ -459,6 +928,8 @@ apple_glx_make_current_context(Display * dpy, void *oldptr, void *ptr,
       abort();
    }
 
+   apple_glx_context_apply_surface_changes(ac);
+
    return false;
 }
 
@@ -489,6 +960,12 @@ apple_glx_copy_context(void *currentptr, void *srcptr, void *destptr,
    src = srcptr;
    dest = destptr;
 
+   if (wait_created(src) || wait_created(dest)) {
+      *errorptr = GLXBadContext;
+      *x11errorptr = false;
+      return true;
+   }
+
    if (src->screen != dest->screen) {
       *errorptr = BadMatch;
       *x11errorptr = true;
@@ -522,37 +999,109 @@ apple_glx_copy_context(void *currentptr, void *srcptr, void *destptr,
 /* 
  * The value returned is the total number of contexts set to update. 
  * It's meant for debugging/introspection.
+ *
+ * The update is applied by apple_glx_context_apply_surface_changes,
+ * at the next make current, glViewport, or swap of each context.
  */
 int
-apple_glx_context_surface_changed(unsigned int uid, pthread_t caller)
+apple_glx_context_surface_changed(Display * dpy, unsigned int uid)
 {
+   struct apple_glx_display *gd;
    struct apple_glx_context *ac;
    int updated = 0;
 
-   lock_context_list();
+   gd = apple_glx_display_find(dpy);
+
+   if (NULL == gd)
+      return 0;
+
+   apple_glx_display_lock_contexts(gd);
 
-   for (ac = context_list; ac; ac = ac->next) {
+   for (ac = gd->contexts; ac; ac = ac->next) {
       if (ac->drawable && APPLE_GLX_DRAWABLE_SURFACE == ac->drawable->type
           && ac->drawable->types.surface.uid == uid) {
+         ac->need_update = true;
+         ac->attached_surface = 0;
+         ++updated;
+      }
+   }
 
-         if (caller == ac->thread_id) {
-            apple_glx_diagnostic("caller is the same thread for uid %u\n",
-                                 uid);
+   apple_glx_display_unlock_contexts(gd);
 
-            xp_update_gl_context(ac->context_obj);
-         }
-         else {
-            ac->need_update = true;
-            ++updated;
-         }
+   return updated;
+}
+
+/* This is used when surface changes couldn't be tracked by uid. */
+int
+apple_glx_context_all_surfaces_changed(Display * dpy)
+{
+   struct apple_glx_display *gd;
+   struct apple_glx_context *ac;
+   int updated = 0;
+
+   gd = apple_glx_display_find(dpy);
+
+   if (NULL == gd)
+      return 0;
+
+   apple_glx_display_lock_contexts(gd);
+
+   for (ac = gd->contexts; ac; ac = ac->next) {
+      if (ac->drawable && APPLE_GLX_DRAWABLE_SURFACE == ac->drawable->type) {
+         ac->need_update = true;
+         ac->attached_surface = 0;
+         ++updated;
       }
    }
 
-   unlock_context_list();
+   apple_glx_display_unlock_contexts(gd);
 
    return updated;
 }
 
+/* 
+ * Forget the attachment of any context to surface_id, because the id may
+ * be reused by Xplugin for a new surface.
+ */
+void
+apple_glx_context_surface_destroyed(Display * dpy, xp_surface_id surface_id)
+{
+   struct apple_glx_display *gd;
+   struct apple_glx_context *ac;
+
+   gd = apple_glx_display_find(dpy);
+
+   if (NULL == gd)
+      return;
+
+   apple_glx_display_lock_contexts(gd);
+
+   for (ac = gd->contexts; ac; ac = ac->next) {
+      if (surface_id == ac->attached_surface)
+         ac->attached_surface = 0;
+   }
+
+   apple_glx_display_unlock_contexts(gd);
+}
+
+void
+apple_glx_context_apply_surface_changes(void *ptr)
+{
+   struct apple_glx_context *ac = ptr;
+
+   apple_glx_process_surface_changes(ac->glx_display);
+
+   if (ac->drawable)
+      (void) apple_glx_surface_attach_shared(ac, ac->drawable);
+
+   if (ac->need_update) {
+      xp_update_gl_context(ac->context_obj);
+      ac->need_update = false;
+
+      apple_glx_diagnostic("%s: updating context %p\n", __func__, ptr);
+   }
+}
+
 void
 apple_glx_context_update(Display * dpy, void *ptr)
 {
@@ -569,16 +1118,12 @@ apple_glx_context_update(Display * dpy, void *ptr)
                            failed ? "YES" : "NO");
    }
 
-   if (ac->need_update) {
-      xp_update_gl_context(ac->context_obj);
-      ac->need_update = false;
-
-      apple_glx_diagnostic("%s: updating context %p\n", __func__, ptr);
-   }
+   apple_glx_context_apply_surface_changes(ac);
 
    if (ac->drawable && APPLE_GLX_DRAWABLE_SURFACE == ac->drawable->type
        && ac->drawable->types.surface.pending_destroy) {
       apple_glx_diagnostic("%s: clearing drawable %p\n", __func__, ptr);
+      ac->attached_surface = 0;
       apple_cgl.clear_drawable(ac->context_obj);
 
       if (ac->drawable) {
@@ -612,5 +1157,9 @@ apple_glx_context_uses_stereo(void *ptr)
 {
    struct apple_glx_context *ac = ptr;
 
+   /* uses_stereo is set by the creation. */
+   if (wait_created(ac))
+      return false;
+
    return ac->uses_stereo;
 }
@@ -39,9 +39,15 @@
 #undef XP_NO_X_HEADERS
 
 #include "apple_glx_drawable.h"
+#include "apple_glx_worker.h"
+
+struct apple_glx_display;
+struct apple_glx_share_group;
 
 struct apple_glx_context
 {
+   struct apple_glx_display *glx_display;
+   struct apple_glx_share_group *share_group;
    CGLContextObj context_obj;
    CGLPixelFormatObj pixel_format_obj;
    struct apple_glx_drawable *drawable;
@@ -52,6 +58,11 @@ struct apple_glx_context
    bool need_update;
    bool is_current;             /* True if the context is current in some thread. */
    bool made_current;           /* True if the context has ever been made current. */
+   bool detached;               /* True if the context_obj has no drawable. */
+   bool has_fence;              /* True if fence has been generated. */
+   GLuint fence;                /* The GL_APPLE_fence of context_obj. */
+   bool mp_engine;              /* True if the multithreaded GL engine is enabled. */
+   bool destroy_deferred;       /* True if the display was closed while current. */
 
    /*
     * last_surface is set by the pending_destroy code handler for a drawable.
@@ -59,14 +70,71 @@ struct apple_glx_context
     * is unmapped and mapped again.
     */
    Window last_surface_window;
+
+   /*
+    * The Xplugin surface the context_obj is attached to, or 0.  This
+    * avoids a redundant xp_attach_gl_context when rebinding.
+    */
+   xp_surface_id attached_surface;
+
+   /* 
+    * The pbuffer_generation of the shared buffer surface attached to the 
+    * context_obj.  Another context may replace the pbuffer on a resize.
+    */
+   unsigned int shared_generation;
+
+   /*
+    * With LIBGL_ASYNC_CONTEXT, the pixel_format_obj and context_obj are
+    * created by a worker from mode, profile, renderer_id and share_obj,
+    * and pending is true.  Every use waits for the create_job, whose done
+    * flag is checked under the lock of the pool, and pending isn't changed
+    * after the context is created.  If the creation failed, the objects 
+    * are NULL and create_errorcode is the error.
+    */
+   struct apple_glx_job create_job;
+   bool pending;
+   bool create_failed;
+   bool create_error_reported;
+   int create_errorcode;
+   bool create_x11error;
+   const void *mode;
+   int profile;
+   GLint renderer_id;
+   CGLContextObj share_obj;
+
    struct apple_glx_context *previous, *next;
 };
 
+/* 
+ * attrib_list is the GLX_ARB_create_context attribute list, or NULL for
+ * a legacy context.
+ */
 bool apple_glx_create_context(void **ptr, Display * dpy, int screen,
                               const void *mode, void *sharedContext,
+                              const int *attrib_list,
                               int *errorptr, bool * x11errorptr);
 void apple_glx_destroy_context(void **ptr, Display * dpy);
 
+/*
+ * Wait for the creation of the context, which may be done by a worker.
+ * Return true if it failed.  The error of the creation is returned the
+ * first time, and GLXBadContext after that.
+ */
+bool apple_glx_context_wait(void *ptr, int *errorptr, bool * x11errorptr);
+void apple_glx_context_destroy_all(Display * dpy);
+
+/* 
+ * Destroy the contexts still linked to gd when its state is freed, which
+ * is after the last deferred context was destroyed.
+ */
+void apple_glx_context_destroy_remaining(struct apple_glx_display *gd);
+
+/* 
+ * Return true if the context was current in another thread when its 
+ * Display was closed, and must be destroyed when it's no longer current.
+ */
+bool apple_glx_context_destroy_deferred(void *ptr);
+
 bool apple_glx_make_current_context(Display * dpy, void *oldptr, void *ptr,
                                     GLXDrawable drawable);
 bool apple_glx_is_current_drawable(Display * dpy, void *ptr,
@@ -76,7 +144,11 @@ bool apple_glx_copy_context(void *currentptr, void *srcptr, void *destptr,
                             unsigned long mask, int *errorptr,
                             bool * x11errorptr);
 
-int apple_glx_context_surface_changed(unsigned int uid, pthread_t caller);
+int apple_glx_context_surface_changed(Display * dpy, unsigned int uid);
+int apple_glx_context_all_surfaces_changed(Display * dpy);
+void apple_glx_context_apply_surface_changes(void *ptr);
+void apple_glx_context_surface_destroyed(Display * dpy,
+                                         xp_surface_id surface_id);
 
 void apple_glx_context_update(Display * dpy, void *ptr);
 
@@ -0,0 +1,335 @@
+/*
+ Copyright (c) 2009 Apple Inc.
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction,
+ including without limitation the rights to use, copy, modify, merge,
+ publish, distribute, sublicense, and/or sell copies of the Software,
+ and to permit persons to whom the Software is furnished to do so,
+ subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT.  IN NO EVENT SHALL THE ABOVE LISTED COPYRIGHT
+ HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ 
+ Except as contained in this notice, the name(s) of the above
+ copyright holders shall not be used in advertising or otherwise to
+ promote the sale, use or other dealings in this Software without
+ prior written authorization.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "apple_glx.h"
+#include "apple_glx_display.h"
+#include "apple_glx_context.h"
+#include "apple_glx_drawable.h"
+#include "apple_glx_share_group.h"
+
+/* 
+ * The list of displays is only written when a Display initializes GLX,
+ * or is closed, so the lookups take a read lock.
+ */
+static pthread_rwlock_t displays_lock = PTHREAD_RWLOCK_INITIALIZER;
+static struct apple_glx_display *displays = NULL;
+
+/* The displays that were closed with deferred contexts. */
+static struct apple_glx_display *closed_displays = NULL;
+
+static void
+read_lock_displays(void)
+{
+   int err;
+
+   err = pthread_rwlock_rdlock(&displays_lock);
+
+   if (err) {
+      fprintf(stderr, "pthread_rwlock_rdlock failure in %s: %d\n",
+              __func__, err);
+      abort();
+   }
+}
+
+static void
+write_lock_displays(void)
+{
+   int err;
+
+   err = pthread_rwlock_wrlock(&displays_lock);
+
+   if (err) {
+      fprintf(stderr, "pthread_rwlock_wrlock failure in %s: %d\n",
+              __func__, err);
+      abort();
+   }
+}
+
+static void
+unlock_displays(void)
+{
+   int err;
+
+   err = pthread_rwlock_unlock(&displays_lock);
+
+   if (err) {
+      fprintf(stderr, "pthread_rwlock_unlock failure in %s: %d\n",
+              __func__, err);
+      abort();
+   }
+}
+
+/* The displays lock must be held when calling this. */
+static struct apple_glx_display *
+find_display(Display * dpy)
+{
+   struct apple_glx_display *gd;
+
+   for (gd = displays; gd; gd = gd->next) {
+      if (dpy == gd->dpy)
+         return gd;
+   }
+
+   return NULL;
+}
+
+struct apple_glx_display *
+apple_glx_display_find(Display * dpy)
+{
+   struct apple_glx_display *gd;
+
+   read_lock_displays();
+   gd = find_display(dpy);
+   unlock_displays();
+
+   return gd;
+}
+
+struct apple_glx_display *
+apple_glx_display_get(Display * dpy, int dri_event_base)
+{
+   struct apple_glx_display *gd;
+   int err;
+
+   write_lock_displays();
+
+   gd = find_display(dpy);
+
+   if (gd) {
+      unlock_displays();
+      return gd;
+   }
+
+   gd = calloc(1, sizeof *gd);
+
+   if (NULL == gd) {
+      unlock_displays();
+      perror("calloc");
+      return NULL;
+   }
+
+   gd->dpy = dpy;
+   gd->dri_event_base = dri_event_base;
+   gd->drawables = NULL;
+   gd->contexts = NULL;
+   gd->share_groups = NULL;
+
+   err = pthread_mutex_init(&gd->drawables_lock, NULL);
+
+   if (err) {
+      fprintf(stderr, "pthread_mutex_init error: %d\n", err);
+      abort();
+   }
+
+   err = pthread_mutex_init(&gd->contexts_lock, NULL);
+
+   if (err) {
+      fprintf(stderr, "pthread_mutex_init error: %d\n", err);
+      abort();
+   }
+
+   gd->next = displays;
+   displays = gd;
+
+   unlock_displays();
+
+   apple_glx_diagnostic("%s: new display state %p for %p\n", __func__,
+                        (void *) gd, (void *) dpy);
+
+   return gd;
+}
+
+/* 
+ * Destroy what is left of gd, and free it.  The contexts were destroyed by
+ * apple_glx_close_display, unless that failed, and the deferred contexts
+ * were destroyed before this is called.
+ */
+static void
+free_display(struct apple_glx_display *gd)
+{
+   apple_glx_context_destroy_remaining(gd);
+
+   /* 
+    * No drawable is bound now.  Destroying them also releases the share
+    * groups of their pbuffers.
+    */
+   apple_glx_drawable_destroy_all(gd);
+
+   /* A group still referenced outlives the state of its display. */
+   apple_glx_share_group_orphan_all(gd);
+
+   apple_glx_diagnostic("%s: freeing display state %p\n", __func__,
+                        (void *) gd);
+
+   (void) pthread_mutex_destroy(&gd->drawables_lock);
+   (void) pthread_mutex_destroy(&gd->contexts_lock);
+
+   free(gd);
+}
+
+void
+apple_glx_display_destroy(Display * dpy)
+{
+   struct apple_glx_display *gd, **prev;
+
+   write_lock_displays();
+
+   for (prev = &displays; *prev; prev = &(*prev)->next) {
+      if (dpy == (*prev)->dpy)
+         break;
+   }
+
+   gd = *prev;
+
+   if (NULL == gd) {
+      unlock_displays();
+      return;
+   }
+
+   *prev = gd->next;
+
+   if (gd->deferred_contexts) {
+      /* The last deferred context to be destroyed frees the state. */
+      gd->closed = true;
+      gd->next = closed_displays;
+      closed_displays = gd;
+
+      apple_glx_diagnostic("%s: display state %p has %u deferred "
+                           "contexts\n", __func__, (void *) gd,
+                           gd->deferred_contexts);
+
+      unlock_displays();
+      return;
+   }
+
+   unlock_displays();
+
+   free_display(gd);
+}
+
+void
+apple_glx_display_defer_context(struct apple_glx_display *gd)
+{
+   write_lock_displays();
+   ++gd->deferred_contexts;
+   unlock_displays();
+}
+
+void
+apple_glx_display_release_context(struct apple_glx_display *gd)
+{
+   struct apple_glx_display **prev;
+
+   write_lock_displays();
+
+   if (--gd->deferred_contexts || !gd->closed) {
+      unlock_displays();
+      return;
+   }
+
+   for (prev = &closed_displays; *prev != gd; prev = &(*prev)->next)
+      ;
+
+   *prev = gd->next;
+
+   unlock_displays();
+
+   free_display(gd);
+}
+
+bool
+apple_glx_display_is_closed(struct apple_glx_display *gd)
+{
+   bool result;
+
+   read_lock_displays();
+   result = gd->closed;
+   unlock_displays();
+
+   return result;
+}
+
+void
+apple_glx_display_lock_drawables(struct apple_glx_display *gd)
+{
+   int err;
+
+   err = pthread_mutex_lock(&gd->drawables_lock);
+
+   if (err) {
+      fprintf(stderr, "pthread_mutex_lock failure in %s: %d\n",
+              __func__, err);
+      abort();
+   }
+}
+
+void
+apple_glx_display_unlock_drawables(struct apple_glx_display *gd)
+{
+   int err;
+
+   err = pthread_mutex_unlock(&gd->drawables_lock);
+
+   if (err) {
+      fprintf(stderr, "pthread_mutex_unlock failure in %s: %d\n",
+              __func__, err);
+      abort();
+   }
+}
+
+void
+apple_glx_display_lock_contexts(struct apple_glx_display *gd)
+{
+   int err;
+
+   err = pthread_mutex_lock(&gd->contexts_lock);
+
+   if (err) {
+      fprintf(stderr, "pthread_mutex_lock failure in %s: %d\n",
+              __func__, err);
+      abort();
+   }
+}
+
+void
+apple_glx_display_unlock_contexts(struct apple_glx_display *gd)
+{
+   int err;
+
+   err = pthread_mutex_unlock(&gd->contexts_lock);
+
+   if (err) {
+      fprintf(stderr, "pthread_mutex_unlock failure in %s: %d\n",
+              __func__, err);
+      abort();
+   }
+}
@@ -0,0 +1,120 @@
+/*
+ Copyright (c) 2009 Apple Inc.
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction,
+ including without limitation the rights to use, copy, modify, merge,
+ publish, distribute, sublicense, and/or sell copies of the Software,
+ and to permit persons to whom the Software is furnished to do so,
+ subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT.  IN NO EVENT SHALL THE ABOVE LISTED COPYRIGHT
+ HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ 
+ Except as contained in this notice, the name(s) of the above
+ copyright holders shall not be used in advertising or otherwise to
+ promote the sale, use or other dealings in this Software without
+ prior written authorization.
+*/
+
+#ifndef APPLE_GLX_DISPLAY_H
+#define APPLE_GLX_DISPLAY_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <X11/Xlib.h>
+#define XP_NO_X_HEADERS
+#include <Xplugin.h>
+#undef XP_NO_X_HEADERS
+
+struct apple_glx_context;
+struct apple_glx_drawable;
+struct apple_glx_share_group;
+
+/*
+ * The surface changed events are queued in these slots by the
+ * surface_notify_handler, and processed by 
+ * apple_glx_process_surface_changes.
+ */
+#define APPLE_GLX_SURFACE_CHANGE_SLOTS 32
+
+/* 
+ * The state for each Display that has initialized GLX.  The drawables and 
+ * contexts of a Display are only linked in its own lists, so that threads
+ * using different Displays don't contend for the same locks.
+ */
+struct apple_glx_display
+{
+   Display *dpy;
+   int dri_event_base;
+
+   /* The lock order is drawables_lock, then the drawable's mutex. */
+   pthread_mutex_t drawables_lock;
+   struct apple_glx_drawable *drawables;
+
+   /* This lock also guards the list of share groups. */
+   pthread_mutex_t contexts_lock;
+   struct apple_glx_context *contexts;
+   struct apple_glx_share_group *share_groups;
+
+   /* 
+    * The contexts that were current in another thread when dpy was 
+    * closed.  The state is kept on a list of closed displays until they
+    * are destroyed.  These are protected by the lock of the list of 
+    * displays, which is taken after contexts_lock.
+    */
+   unsigned int deferred_contexts;
+   bool closed;
+
+   volatile unsigned int surface_changes[APPLE_GLX_SURFACE_CHANGE_SLOTS];
+   volatile int surface_changes_pending;
+   volatile int surface_changes_overflow;
+
+   struct apple_glx_display *next;
+};
+
+/* 
+ * Return the state for dpy, and create it if it doesn't exist.
+ * Returns NULL if an error occurred.
+ */
+struct apple_glx_display *apple_glx_display_get(Display * dpy,
+                                                int dri_event_base);
+
+/* May return NULL if GLX hasn't been initialized for dpy. */
+struct apple_glx_display *apple_glx_display_find(Display * dpy);
+
+/* This is called when dpy is closed. */
+void apple_glx_display_destroy(Display * dpy);
+
+/* 
+ * Account a context that is destroyed after dpy is closed.  The 
+ * contexts_lock of gd must be held.
+ */
+void apple_glx_display_defer_context(struct apple_glx_display *gd);
+
+/* 
+ * This is called after a deferred context was destroyed, and frees the
+ * state of a closed display when it was the last one.
+ */
+void apple_glx_display_release_context(struct apple_glx_display *gd);
+
+/* Return true if the Display of gd was closed, and can't be used. */
+bool apple_glx_display_is_closed(struct apple_glx_display *gd);
+
+void apple_glx_display_lock_drawables(struct apple_glx_display *gd);
+void apple_glx_display_unlock_drawables(struct apple_glx_display *gd);
+
+void apple_glx_display_lock_contexts(struct apple_glx_display *gd);
+void apple_glx_display_unlock_contexts(struct apple_glx_display *gd);
+
+#endif
@@ -34,57 +34,14 @@
 #include <pthread.h>
 #include "apple_glx.h"
 #include "apple_glx_context.h"
+#include "apple_glx_display.h"
 #include "apple_glx_drawable.h"
 #include "appledri.h"
 
-static pthread_mutex_t drawables_lock = PTHREAD_MUTEX_INITIALIZER;
-static struct apple_glx_drawable *drawables_list = NULL;
-
-static void
-lock_drawables_list(void)
-{
-   int err;
-
-   err = pthread_mutex_lock(&drawables_lock);
-
-   if (err) {
-      fprintf(stderr, "pthread_mutex_lock failure in %s: %d\n",
-              __func__, err);
-      abort();
-   }
-}
-
-static void
-unlock_drawables_list(void)
-{
-   int err;
-
-   err = pthread_mutex_unlock(&drawables_lock);
-
-   if (err) {
-      fprintf(stderr, "pthread_mutex_unlock failure in %s: %d\n",
-              __func__, err);
-      abort();
-   }
-}
-
 struct apple_glx_drawable *
 apple_glx_find_drawable(Display * dpy, GLXDrawable drawable)
 {
-   struct apple_glx_drawable *i, *agd = NULL;
-
-   lock_drawables_list();
-
-   for (i = drawables_list; i; i = i->next) {
-      if (i->drawable == drawable) {
-         agd = i;
-         break;
-      }
-   }
-
-   unlock_drawables_list();
-
-   return agd;
+   return apple_glx_drawable_find(dpy, drawable, 0);
 }
 
 static void
@@ -135,6 +92,7 @@ release_drawable(struct apple_glx_drawable *d)
 static bool
 destroy_drawable(struct apple_glx_drawable *d)
 {
+   struct apple_glx_display *gd = d->glx_display;
 
    d->lock(d);
 
@@ -153,13 +111,13 @@ destroy_drawable(struct apple_glx_drawable *d)
        * The item must be at the head of the list, if it
        * has no previous pointer. 
        */
-      drawables_list = d->next;
+      gd->drawables = d->next;
    }
 
    if (d->next)
       d->next->previous = d->previous;
 
-   unlock_drawables_list();
+   apple_glx_display_unlock_drawables(gd);
 
    if (d->callbacks.destroy) {
       /*
@@ -175,7 +133,7 @@ destroy_drawable(struct apple_glx_drawable *d)
    free(d);
 
    /* So that the locks are balanced and the caller correctly unlocks. */
-   lock_drawables_list();
+   apple_glx_display_lock_drawables(gd);
 
    return true;
 }
@@ -203,11 +161,11 @@ destroy_drawable_callback(struct apple_glx_drawable *d)
 
    d->unlock(d);
 
-   lock_drawables_list();
+   apple_glx_display_lock_drawables(d->glx_display);
 
    result = destroy_drawable(d);
 
-   unlock_drawables_list();
+   apple_glx_display_unlock_drawables(d->glx_display);
 
    return result;
 }
@@ -225,15 +183,21 @@ is_pixmap(struct apple_glx_drawable *d)
 }
 
 static void
-common_init(Display * dpy, GLXDrawable drawable, struct apple_glx_drawable *d)
+common_init(struct apple_glx_display *gd, GLXDrawable drawable,
+            struct apple_glx_drawable *d)
 {
    int err;
    pthread_mutexattr_t attr;
 
-   d->display = dpy;
+   d->display = gd->dpy;
+   d->glx_display = gd;
    d->reference_count = 0;
    d->drawable = drawable;
    d->type = -1;
+   d->sbc = 0;
+   d->swaps_pending = 0;
+   d->swap_ust = 0;
+   d->swap_msc = 0;
 
    err = pthread_mutexattr_init(&attr);
 
@@ -274,14 +238,6 @@ common_init(Display * dpy, GLXDrawable drawable, struct apple_glx_drawable *d)
    d->is_pbuffer = is_pbuffer;
    d->is_pixmap = is_pixmap;
 
-   d->width = -1;
-   d->height = -1;
-   d->row_bytes = 0;
-   d->path[0] = '\0';
-   d->fd = -1;
-   d->buffer = NULL;
-   d->buffer_length = 0;
-
    d->previous = NULL;
    d->next = NULL;
 }
@@ -289,17 +245,19 @@ common_init(Display * dpy, GLXDrawable drawable, struct apple_glx_drawable *d)
 static void
 link_tail(struct apple_glx_drawable *agd)
 {
-   lock_drawables_list();
+   struct apple_glx_display *gd = agd->glx_display;
+
+   apple_glx_display_lock_drawables(gd);
 
-   /* Link the new drawable into the global list. */
-   agd->next = drawables_list;
+   /* Link the new drawable into the list of the display. */
+   agd->next = gd->drawables;
 
-   if (drawables_list)
-      drawables_list->previous = agd;
+   if (gd->drawables)
+      gd->drawables->previous = agd;
 
-   drawables_list = agd;
+   gd->drawables = agd;
 
-   unlock_drawables_list();
+   apple_glx_display_unlock_drawables(gd);
 }
 
 /*WARNING: this returns a locked and referenced object. */
@@ -310,8 +268,14 @@ apple_glx_drawable_create(Display * dpy,
                           struct apple_glx_drawable **agdResult,
                           struct apple_glx_drawable_callbacks *callbacks)
 {
+   struct apple_glx_display *gd;
    struct apple_glx_drawable *d;
 
+   gd = apple_glx_display_find(dpy);
+
+   if (NULL == gd)
+      return true;
+
    d = calloc(1, sizeof *d);
 
    if (NULL == d) {
@@ -319,7 +283,7 @@ apple_glx_drawable_create(Display * dpy,
       return true;
    }
 
-   common_init(dpy, drawable, d);
+   common_init(gd, drawable, d);
    d->type = callbacks->type;
    d->callbacks = *callbacks;
 
@@ -350,23 +314,46 @@ error_handler(Display * dpy, XErrorEvent * err)
 void
 apple_glx_garbage_collect_drawables(Display * dpy)
 {
+   struct apple_glx_display *gd;
    struct apple_glx_drawable *d, *dnext;
    Window root;
    int x, y;
    unsigned int width, height, bd, depth;
    int (*old_handler) (Display *, XErrorEvent *);
+   bool unreferenced = false;
+
+   gd = apple_glx_display_find(dpy);
+
+   if (NULL == gd || NULL == gd->drawables)
+      return;
+
+   /* 
+    * Avoid the round trips below if every drawable is referenced, which
+    * is the common case.
+    */
+   apple_glx_display_lock_drawables(gd);
+
+   for (d = gd->drawables; d; d = d->next) {
+      d->lock(d);
+      unreferenced = (0 == d->reference_count);
+      d->unlock(d);
+
+      if (unreferenced)
+         break;
+   }
 
+   apple_glx_display_unlock_drawables(gd);
 
-   if (NULL == drawables_list)
+   if (!unreferenced)
       return;
 
    old_handler = XSetErrorHandler(error_handler);
 
    XSync(dpy, False);
 
-   lock_drawables_list();
+   apple_glx_display_lock_drawables(gd);
 
-   for (d = drawables_list; d;) {
+   for (d = gd->drawables; d;) {
       dnext = d->next;
 
       d->lock(d);
@@ -408,33 +395,90 @@ apple_glx_garbage_collect_drawables(Display * dpy)
 
    XSetErrorHandler(old_handler);
 
-   unlock_drawables_list();
+   apple_glx_display_unlock_drawables(gd);
+}
+
+/* The contexts lock of gd must be held when calling this. */
+static bool
+is_bound_to_context(struct apple_glx_display *gd,
+                    struct apple_glx_drawable *d)
+{
+   struct apple_glx_context *ac;
+
+   for (ac = gd->contexts; ac; ac = ac->next) {
+      if (d == ac->drawable)
+         return true;
+   }
+
+   return false;
+}
+
+void
+apple_glx_drawable_destroy_all(struct apple_glx_display *gd)
+{
+   struct apple_glx_drawable *d, *dnext;
+   bool bound;
+
+   apple_glx_display_lock_drawables(gd);
+
+   for (d = gd->drawables; d; d = dnext) {
+      dnext = d->next;
+
+      apple_glx_display_lock_contexts(gd);
+      bound = is_bound_to_context(gd, d);
+      apple_glx_display_unlock_contexts(gd);
+
+      if (bound)
+         continue;
+
+      /* Nothing can use the drawable after the Display is closed. */
+      d->lock(d);
+      d->reference_count = 0;
+      d->unlock(d);
+
+      (void) destroy_drawable(d);
+   }
+
+   apple_glx_display_unlock_drawables(gd);
 }
 
 unsigned int
-apple_glx_get_drawable_count(void)
+apple_glx_get_drawable_count(Display * dpy)
 {
+   struct apple_glx_display *gd;
    unsigned int result = 0;
    struct apple_glx_drawable *d;
 
-   lock_drawables_list();
+   gd = apple_glx_display_find(dpy);
+
+   if (NULL == gd)
+      return 0;
+
+   apple_glx_display_lock_drawables(gd);
 
-   for (d = drawables_list; d; d = d->next)
+   for (d = gd->drawables; d; d = d->next)
       ++result;
 
-   unlock_drawables_list();
+   apple_glx_display_unlock_drawables(gd);
 
    return result;
 }
 
 struct apple_glx_drawable *
-apple_glx_drawable_find_by_type(GLXDrawable drawable, int type, int flags)
+apple_glx_drawable_find_by_type(Display * dpy, GLXDrawable drawable,
+                                int type, int flags)
 {
+   struct apple_glx_display *gd;
    struct apple_glx_drawable *d;
 
-   lock_drawables_list();
+   gd = apple_glx_display_find(dpy);
 
-   for (d = drawables_list; d; d = d->next) {
+   if (NULL == gd)
+      return NULL;
+
+   apple_glx_display_lock_drawables(gd);
+
+   for (d = gd->drawables; d; d = d->next) {
       if (d->type == type && d->drawable == drawable) {
          if (flags & APPLE_GLX_DRAWABLE_REFERENCE)
             d->reference(d);
@@ -442,25 +486,31 @@ apple_glx_drawable_find_by_type(GLXDrawable drawable, int type, int flags)
          if (flags & APPLE_GLX_DRAWABLE_LOCK)
             d->lock(d);
 
-         unlock_drawables_list();
+         apple_glx_display_unlock_drawables(gd);
 
          return d;
       }
    }
 
-   unlock_drawables_list();
+   apple_glx_display_unlock_drawables(gd);
 
    return NULL;
 }
 
 struct apple_glx_drawable *
-apple_glx_drawable_find(GLXDrawable drawable, int flags)
+apple_glx_drawable_find(Display * dpy, GLXDrawable drawable, int flags)
 {
+   struct apple_glx_display *gd;
    struct apple_glx_drawable *d;
 
-   lock_drawables_list();
+   gd = apple_glx_display_find(dpy);
+
+   if (NULL == gd)
+      return NULL;
 
-   for (d = drawables_list; d; d = d->next) {
+   apple_glx_display_lock_drawables(gd);
+
+   for (d = gd->drawables; d; d = d->next) {
       if (d->drawable == drawable) {
          if (flags & APPLE_GLX_DRAWABLE_REFERENCE)
             d->reference(d);
@@ -468,13 +518,13 @@ apple_glx_drawable_find(GLXDrawable drawable, int flags)
          if (flags & APPLE_GLX_DRAWABLE_LOCK)
             d->lock(d);
 
-         unlock_drawables_list();
+         apple_glx_display_unlock_drawables(gd);
 
          return d;
       }
    }
 
-   unlock_drawables_list();
+   apple_glx_display_unlock_drawables(gd);
 
    return NULL;
 }
@@ -484,11 +534,17 @@ bool
 apple_glx_drawable_destroy_by_type(Display * dpy,
                                    GLXDrawable drawable, int type)
 {
+   struct apple_glx_display *gd;
    struct apple_glx_drawable *d;
 
-   lock_drawables_list();
+   gd = apple_glx_display_find(dpy);
+
+   if (NULL == gd)
+      return false;
+
+   apple_glx_display_lock_drawables(gd);
 
-   for (d = drawables_list; d; d = d->next) {
+   for (d = gd->drawables; d; d = d->next) {
       if (drawable == d->drawable && type == d->type) {
          /*
           * The user has requested that we destroy this resource.
@@ -502,24 +558,30 @@ apple_glx_drawable_destroy_by_type(Display * dpy,
                               __func__, d->reference_count);
 
          destroy_drawable(d);
-         unlock_drawables_list();
+         apple_glx_display_unlock_drawables(gd);
          return true;
       }
    }
 
-   unlock_drawables_list();
+   apple_glx_display_unlock_drawables(gd);
 
    return false;
 }
 
 struct apple_glx_drawable *
-apple_glx_drawable_find_by_uid(unsigned int uid, int flags)
+apple_glx_drawable_find_by_uid(Display * dpy, unsigned int uid, int flags)
 {
+   struct apple_glx_display *gd;
    struct apple_glx_drawable *d;
 
-   lock_drawables_list();
+   gd = apple_glx_display_find(dpy);
+
+   if (NULL == gd)
+      return NULL;
+
+   apple_glx_display_lock_drawables(gd);
 
-   for (d = drawables_list; d; d = d->next) {
+   for (d = gd->drawables; d; d = d->next) {
       /* Only surfaces have a uid. */
       if (APPLE_GLX_DRAWABLE_SURFACE == d->type) {
          if (d->types.surface.uid == uid) {
@@ -529,14 +591,40 @@ apple_glx_drawable_find_by_uid(unsigned int uid, int flags)
             if (flags & APPLE_GLX_DRAWABLE_LOCK)
                d->lock(d);
 
-            unlock_drawables_list();
+            apple_glx_display_unlock_drawables(gd);
 
             return d;
          }
       }
    }
 
-   unlock_drawables_list();
+   apple_glx_display_unlock_drawables(gd);
 
    return NULL;
 }
+
+/* This is used when the surface changes couldn't be tracked by uid. */
+void
+apple_glx_surface_invalidate_all_geometry(Display * dpy)
+{
+   struct apple_glx_display *gd;
+   struct apple_glx_drawable *d;
+
+   gd = apple_glx_display_find(dpy);
+
+   if (NULL == gd)
+      return;
+
+   apple_glx_display_lock_drawables(gd);
+
+   for (d = gd->drawables; d; d = d->next) {
+      if (APPLE_GLX_DRAWABLE_SURFACE == d->type) {
+         d->lock(d);
+         d->types.surface.geometry_valid = false;
+         d->types.surface.geometry_generation++;
+         d->unlock(d);
+      }
+   }
+
+   apple_glx_display_unlock_drawables(gd);
+}
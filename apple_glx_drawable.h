@@ -32,11 +32,13 @@
 #include <pthread.h>
 #include <stdbool.h>
 #include <limits.h>
+#include <stdint.h>
 #include <GL/glx.h>
 #define XP_NO_X_HEADERS
 #include <Xplugin.h>
 #undef XP_NO_X_HEADERS
 #include "apple_glx_context.h"
+#include "apple_glx_shared_buffer.h"
 
 enum
 {
@@ -53,13 +55,42 @@ enum
 };
 
 struct apple_glx_context;
+struct apple_glx_display;
 struct apple_glx_drawable;
+struct apple_glx_share_group;
 
 struct apple_glx_surface
 {
    xp_surface_id surface_id;
    unsigned int uid;
    bool pending_destroy;
+
+   /* 
+    * The cached window geometry.  This is invalidated by the surface
+    * changed notifications, and the generation is incremented, so that
+    * a stale reply isn't cached.
+    */
+   bool geometry_valid;
+   unsigned int geometry_generation;
+   unsigned int width, height;
+
+   /* 
+    * These are used when xp_import_surface runs in the import_thread.
+    * The surface_id is only valid after the thread is joined.
+    */
+   bool importing;
+   pthread_t import_thread;
+   unsigned int key[2];
+   xp_error import_error;
+
+   /* 
+    * In the shared buffer present mode the window renders to pbuffer_obj
+    * rather than an Xplugin surface.  See apple_glx_shared_buffer.h.
+    */
+   bool shared;
+   CGLPBufferObj pbuffer_obj;
+   unsigned int pbuffer_generation;     /* Incremented when replaced. */
+   struct apple_glx_shared_buffer shared_buffer;
 };
 
 struct apple_glx_pbuffer
@@ -69,6 +100,21 @@ struct apple_glx_pbuffer
    GLint fbconfigID;
    CGLPBufferObj buffer_obj;
    unsigned long event_mask;
+
+   /* The share group of the context current at creation, or NULL. */
+   struct apple_glx_share_group *share_group;
+
+   /* 
+    * The buffer_obj of a pbuffer that isn't preserved may be released to
+    * fit the pbuffer budget, and is then NULL until it's made current.
+    * These are protected by the lru_lock in apple_glx_pbuffer.c.
+    */
+   GLenum internal_format;
+   bool preserved;
+   bool clobber_pending;
+   bool destroyed;              /* True after glXDestroyPbuffer. */
+   bool on_lru;
+   struct apple_glx_drawable *lru_previous, *lru_next;
 };
 
 struct apple_glx_pixmap
@@ -78,10 +124,17 @@ struct apple_glx_pixmap
    int width, height, pitch, /*bytes per pixel */ bpp;
    size_t size;
    char path[PATH_MAX];
-   int fd;
-   CGLPixelFormatObj pixel_format_obj;
-   CGLContextObj context_obj;
+   CGLPixelFormatObj pixel_format_obj;  /* May be shared by a batch. */
+   CGLContextObj context_obj;   /* Created when first made current. */
+   bool has_fence;              /* True if fence has been generated. */
+   GLuint fence;                /* The GL_APPLE_fence of context_obj. */
    GLint fbconfigID;
+
+   /* GLX_EXT_texture_from_pixmap */
+   int texture_format;          /* GLX_TEXTURE_FORMAT_*_EXT */
+   int texture_target;          /* GLX_TEXTURE_2D_EXT or _RECTANGLE_EXT */
+   bool bound;                  /* Holds a reference while bound. */
+   GLuint texture;              /* The texture name bound to. */
 };
 
 struct apple_glx_drawable_callbacks
@@ -95,6 +148,7 @@ struct apple_glx_drawable_callbacks
 struct apple_glx_drawable
 {
    Display *display;
+   struct apple_glx_display *glx_display;
    int reference_count;
    GLXDrawable drawable;
    int type;                    /* APPLE_GLX_DRAWABLE_* */
@@ -125,14 +179,17 @@ struct apple_glx_drawable
 
      bool(*is_pixmap) (struct apple_glx_drawable * agd);
 
-/*BEGIN These are used for the mixed mode drawing... */
-   int width, height;
-   int row_bytes;
-   char path[PATH_MAX];
-   int fd;                      /* The file descriptor for this drawable's shared memory. */
-   void *buffer;                /* The memory for the drawable.  Typically shared memory. */
-   size_t buffer_length;
-     /*END*/ struct apple_glx_drawable *previous, *next;
+   /* 
+    * The GLX_OML_sync_control swap buffer count, the UST and MSC of the
+    * last swap, and the swaps begun and not yet complete.  These are
+    * protected by the lock in apple_glx_sync.c.
+    */
+   int64_t sbc;
+   int64_t swap_ust, swap_msc;
+   int swaps_pending;
+
+
+   struct apple_glx_drawable *previous, *next;
 };
 
 struct apple_glx_context;
@@ -157,24 +214,34 @@ bool apple_glx_create_drawable(Display * dpy,
 
 void apple_glx_garbage_collect_drawables(Display * dpy);
 
+/* 
+ * This is called when the Display of gd is closed.  It destroys the
+ * drawables that no context of gd is bound to, including the GLXPixmaps
+ * and GLXPbuffers that the application didn't destroy.
+ */
+void apple_glx_drawable_destroy_all(struct apple_glx_display *gd);
+
 /* 
  * This returns the total number of drawables. 
  * It's mostly intended for debugging and introspection.
  */
-unsigned int apple_glx_get_drawable_count(void);
+unsigned int apple_glx_get_drawable_count(Display * dpy);
 
-struct apple_glx_drawable *apple_glx_drawable_find_by_type(GLXDrawable
+struct apple_glx_drawable *apple_glx_drawable_find_by_type(Display * dpy,
+                                                           GLXDrawable
                                                            drawable, int type,
                                                            int flags);
 
-struct apple_glx_drawable *apple_glx_drawable_find(GLXDrawable drawable,
+struct apple_glx_drawable *apple_glx_drawable_find(Display * dpy,
+                                                   GLXDrawable drawable,
                                                    int flags);
 
 
 bool apple_glx_drawable_destroy_by_type(Display * dpy, GLXDrawable drawable,
                                         int type);
 
-struct apple_glx_drawable *apple_glx_drawable_find_by_uid(unsigned int uid,
+struct apple_glx_drawable *apple_glx_drawable_find_by_uid(Display * dpy,
+                                                          unsigned int uid,
                                                           int flags);
 
 /* Surfaces */
@@ -182,27 +249,66 @@ struct apple_glx_drawable *apple_glx_drawable_find_by_uid(unsigned int uid,
 bool apple_glx_surface_create(Display * dpy, int screen, GLXDrawable drawable,
                               struct apple_glx_drawable **resultptr);
 
-void apple_glx_surface_destroy(unsigned int uid);
+/* 
+ * Start creating the surface for a window before it's made current, if
+ * LIBGL_EAGER_SURFACES is set.  The xp_import_surface is done by another
+ * thread, and make current waits for it.  Returns true if an error occurred.
+ */
+bool apple_glx_surface_create_eager(Display * dpy, int screen,
+                                    GLXDrawable drawable);
+
+void apple_glx_surface_destroy(Display * dpy, unsigned int uid);
+
+/* Returns true if the drawable is a surface, and the attribute is valid. */
+bool apple_glx_surface_query(Display * dpy, GLXDrawable drawable,
+                             int attribute, unsigned int *value);
+
+void apple_glx_surface_invalidate_geometry(Display * dpy, unsigned int uid);
+
+void apple_glx_surface_invalidate_all_geometry(Display * dpy);
+
+/* 
+ * Present a window in the shared buffer mode, limited to the damage, or
+ * the whole window if damage is NULL.  ac must be current to d.
+ * Returns true if d isn't a shared buffer surface, or an error occurred.
+ */
+bool apple_glx_surface_swap_shared(struct apple_glx_context *ac,
+                                   struct apple_glx_drawable *d,
+                                   const xcb_rectangle_t * damage);
+
+/* 
+ * Attach the pbuffer of a shared buffer surface to ac again, if it was
+ * replaced by a resize in another context.  ac must be current to d.
+ * Returns true if an error occurred.
+ */
+bool apple_glx_surface_attach_shared(struct apple_glx_context *ac,
+                                     struct apple_glx_drawable *d);
 
 /* Pbuffers */
 
 /* Returns true if an error occurred. */
 bool apple_glx_pbuffer_create(Display * dpy, GLXFBConfig config,
-                              int width, int height, int *errorcode,
-                              GLXPbuffer * pbuf);
+                              int width, int height, bool preserved,
+                              int *errorcode, GLXPbuffer * pbuf);
 
 /* Returns true if the pbuffer was invalid. */
 bool apple_glx_pbuffer_destroy(Display * dpy, GLXPbuffer pbuf);
 
 /* Returns true if the pbuffer was valid and the attribute. */
-bool apple_glx_pbuffer_query(GLXDrawable d, int attribute,
+bool apple_glx_pbuffer_query(Display * dpy, GLXDrawable d, int attribute,
                              unsigned int *value);
 
 /* Returns true if the GLXDrawable is a valid GLXPbuffer, and the mask is set. */
-bool apple_glx_pbuffer_set_event_mask(GLXDrawable d, unsigned long mask);
+bool apple_glx_pbuffer_set_event_mask(Display * dpy, GLXDrawable d,
+                                      unsigned long mask);
+
+/* Destroy the pbuffers accounted to the share group. */
+void apple_glx_pbuffer_destroy_share_group(Display * dpy,
+                                           struct apple_glx_share_group *g);
 
 /* Returns true if the GLXDrawable is a valid GLXPbuffer, and the *mask is set. */
-bool apple_glx_pbuffer_get_event_mask(GLXDrawable d, unsigned long *mask);
+bool apple_glx_pbuffer_get_event_mask(Display * dpy, GLXDrawable d,
+                                      unsigned long *mask);
 
 
 /* Pixmaps */
@@ -210,14 +316,36 @@ bool apple_glx_pbuffer_get_event_mask(GLXDrawable d, unsigned long *mask);
 /* mode is a __GLcontextModes * */
 /* Returns true if an error occurred. */
 bool apple_glx_pixmap_create(Display * dpy, int screen, Pixmap pixmap,
-                             const void *mode);
+                             const void *mode, const int *attrib_list);
+
+/* 
+ * This creates GLXPixmaps for count pixmaps, waiting for the server once
+ * rather than once per pixmap.  glxpixmaps[i] is set to pixmaps[i], or
+ * None if it wasn't created.
+ * Returns the number of GLXPixmaps created.
+ */
+int apple_glx_pixmap_create_batch(Display * dpy, int screen, int count,
+                                  const Pixmap * pixmaps, const void *mode,
+                                  const int *attrib_list,
+                                  GLXPixmap * glxpixmaps);
 
 /* Returns true if an error occurred. */
 bool apple_glx_pixmap_destroy(Display * dpy, Pixmap pixmap);
 
-bool apple_glx_pixmap_query(GLXPixmap pixmap, int attribute,
+bool apple_glx_pixmap_query(Display * dpy, GLXPixmap pixmap, int attribute,
                             unsigned int *value);
 
+/* 
+ * These bind the pixmap memory to the texture bound to the target of the
+ * pixmap in the current context, without copying it.
+ * Returns true if an error occurred, and sets *errorcode.
+ */
+bool apple_glx_pixmap_bind_tex_image(Display * dpy, GLXPixmap pixmap,
+                                     int buffer, int *errorcode);
+
+bool apple_glx_pixmap_release_tex_image(Display * dpy, GLXPixmap pixmap,
+                                        int buffer, int *errorcode);
+
 
 
 #endif
@@ -28,14 +28,21 @@
 */
 
 #include <stdlib.h>
+#include <string.h>
 #include <pthread.h>
 #include <assert.h>
+#include "glxclient.h"
+#include <X11/extensions/extutil.h>
 #include "apple_glx.h"
 #include "glcontextmodes.h"
 #include "apple_glx_context.h"
+#include "apple_glx_display.h"
 #include "apple_glx_drawable.h"
+#include "apple_glx_share_group.h"
 #include "apple_cgl.h"
 
+extern XExtDisplayInfo *__glXFindDisplay(Display * dpy);
+
 static bool pbuffer_make_current(struct apple_glx_context *ac,
                                  struct apple_glx_drawable *d);
 
@@ -48,6 +55,249 @@ static struct apple_glx_drawable_callbacks callbacks = {
 };
 
 
+/*
+ * The storage of the pbuffers created with GLX_PRESERVED_CONTENTS False
+ * may be released when the resident pbuffers exceed the budget.  These
+ * pbuffers are kept in LRU order, with the most recently used at the 
+ * head.  The storage is released from the tail, and reallocated when the
+ * pbuffer is made current again.
+ *
+ * The lock order is lru_lock, then the drawable's mutex.
+ */
+static pthread_mutex_t lru_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct apple_glx_drawable *lru_head = NULL, *lru_tail = NULL;
+
+/* This is updated with atomic operations. */
+static volatile size_t resident_bytes = 0;
+
+static pthread_once_t budget_once = PTHREAD_ONCE_INIT;
+static size_t budget = 0;
+
+#define DEFAULT_BUDGET_MB 256
+
+/* LIBGL_PBUFFER_BUDGET is the budget in megabytes.  0 disables it. */
+static void
+init_budget(void)
+{
+   const char *s = getenv("LIBGL_PBUFFER_BUDGET");
+   unsigned long mb = DEFAULT_BUDGET_MB;
+
+   if (s)
+      mb = strtoul(s, NULL, 10);
+
+   budget = (size_t) mb * 1024 * 1024;
+}
+
+static void
+lock_lru(void)
+{
+   int err;
+
+   err = pthread_mutex_lock(&lru_lock);
+
+   if (err) {
+      fprintf(stderr, "pthread_mutex_lock failure in %s: %d\n",
+              __func__, err);
+      abort();
+   }
+}
+
+static void
+unlock_lru(void)
+{
+   int err;
+
+   err = pthread_mutex_unlock(&lru_lock);
+
+   if (err) {
+      fprintf(stderr, "pthread_mutex_unlock failure in %s: %d\n",
+              __func__, err);
+      abort();
+   }
+}
+
+/* The CGL pbuffers are RGBA or RGB textures, with 4 bytes per pixel. */
+static size_t
+pbuffer_bytes(struct apple_glx_pbuffer *pbuf)
+{
+   return (size_t) pbuf->width * pbuf->height * 4;
+}
+
+/* The lru_lock must be held when calling these. */
+static void
+lru_unlink(struct apple_glx_drawable *d)
+{
+   struct apple_glx_pbuffer *pbuf = &d->types.pbuffer;
+
+   if (!pbuf->on_lru)
+      return;
+
+   if (pbuf->lru_previous)
+      pbuf->lru_previous->types.pbuffer.lru_next = pbuf->lru_next;
+   else
+      lru_head = pbuf->lru_next;
+
+   if (pbuf->lru_next)
+      pbuf->lru_next->types.pbuffer.lru_previous = pbuf->lru_previous;
+   else
+      lru_tail = pbuf->lru_previous;
+
+   pbuf->lru_previous = NULL;
+   pbuf->lru_next = NULL;
+   pbuf->on_lru = false;
+}
+
+static void
+lru_link_head(struct apple_glx_drawable *d)
+{
+   struct apple_glx_pbuffer *pbuf = &d->types.pbuffer;
+
+   pbuf->lru_previous = NULL;
+   pbuf->lru_next = lru_head;
+
+   if (lru_head)
+      lru_head->types.pbuffer.lru_previous = d;
+   else
+      lru_tail = d;
+
+   lru_head = d;
+   pbuf->on_lru = true;
+}
+
+static CGLError
+allocate_storage(struct apple_glx_pbuffer *pbuf)
+{
+   CGLError err;
+
+   err = apple_cgl.create_pbuffer(pbuf->width, pbuf->height,
+                                  GL_TEXTURE_RECTANGLE_EXT,
+                                  pbuf->internal_format, 0,
+                                  &pbuf->buffer_obj);
+
+   if (kCGLNoError == err)
+      (void) __sync_add_and_fetch(&resident_bytes, pbuffer_bytes(pbuf));
+
+   return err;
+}
+
+static void
+release_storage(struct apple_glx_pbuffer *pbuf)
+{
+   if (NULL == pbuf->buffer_obj)
+      return;
+
+   apple_cgl.destroy_pbuffer(pbuf->buffer_obj);
+   pbuf->buffer_obj = NULL;
+   (void) __sync_sub_and_fetch(&resident_bytes, pbuffer_bytes(pbuf));
+}
+
+static void
+send_clobber_event(Display * dpy, GLXDrawable drawable, int width,
+                   int height)
+{
+   XExtDisplayInfo *info = __glXFindDisplay(dpy);
+   GLXEvent event;
+   GLXPbufferClobberEvent *clobber = &event.glxpbufferclobber;
+
+   if (NULL == info || NULL == info->codes)
+      return;
+
+   memset(&event, 0, sizeof(event));
+
+   /* 
+    * The event_type is in the storage of the type of the XEvent, so it's
+    * the GLX event code for the event to be recognized, rather than 
+    * GLX_DAMAGED.  The storage was released, so the event is a damage.
+    */
+   clobber->event_type = info->codes->first_event + GLX_PbufferClobber;
+   clobber->draw_type = GLX_PBUFFER;
+   clobber->serial = LastKnownRequestProcessed(dpy);
+   clobber->send_event = False;
+   clobber->display = dpy;
+   clobber->drawable = drawable;
+   clobber->buffer_mask = GLX_FRONT_LEFT_BUFFER_BIT;
+   clobber->x = 0;
+   clobber->y = 0;
+   clobber->width = width;
+   clobber->height = height;
+   clobber->count = 0;
+
+   XPutBackEvent(dpy, (XEvent *) & event);
+}
+
+/*
+ * Release the storage of the least recently used pbuffers that aren't 
+ * referenced by a context, until the resident pbuffers fit the budget.
+ *
+ * A clobber event is put in the event queue for a pbuffer of dpy that 
+ * selected GLX_PBUFFER_CLOBBER_MASK.  The event for a pbuffer of another
+ * Display is sent when that pbuffer is made current again, from a thread
+ * using its Display.
+ */
+static void
+enforce_budget(Display * dpy)
+{
+   struct apple_glx_drawable *d;
+   struct apple_glx_pbuffer *pbuf;
+   GLXDrawable drawable;
+   int width, height;
+   bool send;
+
+   (void) pthread_once(&budget_once, init_budget);
+
+   if (0 == budget)
+      return;
+
+   for (;;) {
+      lock_lru();
+
+      if (resident_bytes <= budget) {
+         unlock_lru();
+         return;
+      }
+
+      for (d = lru_tail; d; d = d->types.pbuffer.lru_previous) {
+         d->lock(d);
+
+         /* Only the reference from the creation remains. */
+         if (1 == d->reference_count)
+            break;
+
+         d->unlock(d);
+      }
+
+      if (NULL == d) {
+         unlock_lru();
+         return;
+      }
+
+      pbuf = &d->types.pbuffer;
+
+      release_storage(pbuf);
+      lru_unlink(d);
+
+      send = (pbuf->event_mask & GLX_PBUFFER_CLOBBER_MASK) ? true : false;
+
+      if (send && dpy != d->display) {
+         pbuf->clobber_pending = true;
+         send = false;
+      }
+
+      drawable = d->drawable;
+      width = pbuf->width;
+      height = pbuf->height;
+
+      apple_glx_diagnostic("%s: released the storage of pbuffer 0x%lx\n",
+                           __func__, drawable);
+
+      d->unlock(d);
+      unlock_lru();
+
+      if (send)
+         send_clobber_event(dpy, drawable, width, height);
+   }
+}
+
 /* Return true if an error occurred. */
 bool
 pbuffer_make_current(struct apple_glx_context *ac,
@@ -55,9 +305,41 @@ pbuffer_make_current(struct apple_glx_context *ac,
 {
    struct apple_glx_pbuffer *pbuf = &d->types.pbuffer;
    CGLError cglerr;
+   bool reallocated = false, clobbered = false;
 
    assert(APPLE_GLX_DRAWABLE_PBUFFER == d->type);
 
+   lock_lru();
+
+   if (NULL == pbuf->buffer_obj) {
+      cglerr = allocate_storage(pbuf);
+
+      if (kCGLNoError != cglerr) {
+         unlock_lru();
+         fprintf(stderr, "create_pbuffer: %s\n",
+                 apple_cgl.error_string(cglerr));
+         return true;
+      }
+
+      reallocated = true;
+      clobbered = pbuf->clobber_pending;
+      pbuf->clobber_pending = false;
+   }
+
+   if (!pbuf->preserved && !pbuf->destroyed) {
+      lru_unlink(d);
+      lru_link_head(d);
+   }
+
+   unlock_lru();
+
+   if (clobbered)
+      send_clobber_event(d->display, d->drawable, pbuf->width,
+                         pbuf->height);
+
+   if (reallocated)
+      enforce_budget(d->display);
+
    cglerr = apple_cgl.set_pbuffer(ac->context_obj, pbuf->buffer_obj, 0, 0, 0);
 
    if (kCGLNoError != cglerr) {
@@ -86,14 +368,43 @@ pbuffer_destroy(Display * dpy, struct apple_glx_drawable *d)
    apple_glx_diagnostic("destroying pbuffer for drawable 0x%lx\n",
                         d->drawable);
 
-   apple_cgl.destroy_pbuffer(pbuf->buffer_obj);
-   XFreePixmap(dpy, pbuf->xid);
+   lock_lru();
+   lru_unlink(d);
+   release_storage(pbuf);
+   unlock_lru();
+
+   /* The pixmap of a closed Display was freed with the connection. */
+   if (!apple_glx_display_is_closed(d->glx_display))
+      XFreePixmap(dpy, pbuf->xid);
+
+   if (pbuf->share_group)
+      apple_glx_share_group_remove_pbuffer(pbuf->share_group,
+                                           pbuffer_bytes(pbuf));
 }
 
 /* Return true if an error occurred. */
 bool
 apple_glx_pbuffer_destroy(Display * dpy, GLXPbuffer pbuf)
 {
+   struct apple_glx_drawable *d;
+
+   /*
+    * A pbuffer may still be referenced by a context after it's destroyed
+    * here, so remove it from the LRU, to keep the storage until the 
+    * context releases it.
+    */
+   d = apple_glx_drawable_find_by_type(dpy, pbuf, APPLE_GLX_DRAWABLE_PBUFFER,
+                                       APPLE_GLX_DRAWABLE_REFERENCE);
+
+   if (d) {
+      lock_lru();
+      d->types.pbuffer.destroyed = true;
+      lru_unlink(d);
+      unlock_lru();
+
+      d->release(d);
+   }
+
    return !apple_glx_drawable_destroy_by_type(dpy, pbuf,
                                               APPLE_GLX_DRAWABLE_PBUFFER);
 }
@@ -101,8 +412,8 @@ apple_glx_pbuffer_destroy(Display * dpy, GLXPbuffer pbuf)
 /* Return true if an error occurred. */
 bool
 apple_glx_pbuffer_create(Display * dpy, GLXFBConfig config,
-                         int width, int height, int *errorcode,
-                         GLXPbuffer * result)
+                         int width, int height, bool preserved,
+                         int *errorcode, GLXPbuffer * result)
 {
    struct apple_glx_drawable *d;
    struct apple_glx_pbuffer *pbuf = NULL;
@@ -111,6 +422,9 @@ apple_glx_pbuffer_create(Display * dpy, GLXFBConfig config,
    int screen;
    Pixmap xid;
    __GLcontextModes *modes = (__GLcontextModes *) config;
+   GLXContext gc;
+
+   apple_glx_wait_framework();
 
    root = DefaultRootWindow(dpy);
    screen = DefaultScreen(dpy);
@@ -139,10 +453,16 @@ apple_glx_pbuffer_create(Display * dpy, GLXFBConfig config,
    pbuf->xid = xid;
    pbuf->width = width;
    pbuf->height = height;
+   pbuf->internal_format = (modes->alphaBits > 0) ? GL_RGBA : GL_RGB;
+   pbuf->preserved = preserved;
+   pbuf->clobber_pending = false;
+   pbuf->destroyed = false;
+   pbuf->on_lru = false;
+   pbuf->lru_previous = NULL;
+   pbuf->lru_next = NULL;
+   pbuf->share_group = NULL;
 
-   err = apple_cgl.create_pbuffer(width, height, GL_TEXTURE_RECTANGLE_EXT,
-                                  (modes->alphaBits > 0) ? GL_RGBA : GL_RGB,
-                                  0, &pbuf->buffer_obj);
+   err = allocate_storage(pbuf);
 
    if (kCGLNoError != err) {
       d->unlock(d);
@@ -155,10 +475,29 @@ apple_glx_pbuffer_create(Display * dpy, GLXFBConfig config,
 
    pbuf->event_mask = 0;
 
+   /* Account the pbuffer to the share group of the current context. */
+   gc = __glXGetCurrentContext();
+
+   if (gc && gc->apple && dpy == gc->currentDpy) {
+      struct apple_glx_context *ac = gc->apple;
+
+      pbuf->share_group = ac->share_group;
+      apple_glx_share_group_add_pbuffer(pbuf->share_group,
+                                        pbuffer_bytes(pbuf));
+   }
+
    *result = pbuf->xid;
 
    d->unlock(d);
 
+   if (!preserved) {
+      lock_lru();
+      lru_link_head(d);
+      unlock_lru();
+   }
+
+   enforce_budget(dpy);
+
    return false;
 }
 
@@ -241,13 +580,14 @@ get_max_size(int *widthresult, int *heightresult)
 }
 
 bool
-apple_glx_pbuffer_query(GLXPbuffer p, int attr, unsigned int *value)
+apple_glx_pbuffer_query(Display * dpy, GLXPbuffer p, int attr,
+                        unsigned int *value)
 {
    bool result = false;
    struct apple_glx_drawable *d;
    struct apple_glx_pbuffer *pbuf;
 
-   d = apple_glx_drawable_find_by_type(p, APPLE_GLX_DRAWABLE_PBUFFER,
+   d = apple_glx_drawable_find_by_type(dpy, p, APPLE_GLX_DRAWABLE_PBUFFER,
                                        APPLE_GLX_DRAWABLE_LOCK);
 
    if (d) {
@@ -265,7 +605,7 @@ apple_glx_pbuffer_query(GLXPbuffer p, int attr, unsigned int *value)
          break;
 
       case GLX_PRESERVED_CONTENTS:
-         *value = true;
+         *value = pbuf->preserved;
          result = true;
          break;
 
@@ -295,12 +635,14 @@ apple_glx_pbuffer_query(GLXPbuffer p, int attr, unsigned int *value)
 }
 
 bool
-apple_glx_pbuffer_set_event_mask(GLXDrawable drawable, unsigned long mask)
+apple_glx_pbuffer_set_event_mask(Display * dpy, GLXDrawable drawable,
+                                 unsigned long mask)
 {
    struct apple_glx_drawable *d;
    bool result = false;
 
-   d = apple_glx_drawable_find_by_type(drawable, APPLE_GLX_DRAWABLE_PBUFFER,
+   d = apple_glx_drawable_find_by_type(dpy, drawable,
+                                       APPLE_GLX_DRAWABLE_PBUFFER,
                                        APPLE_GLX_DRAWABLE_LOCK);
 
    if (d) {
@@ -313,12 +655,14 @@ apple_glx_pbuffer_set_event_mask(GLXDrawable drawable, unsigned long mask)
 }
 
 bool
-apple_glx_pbuffer_get_event_mask(GLXDrawable drawable, unsigned long *mask)
+apple_glx_pbuffer_get_event_mask(Display * dpy, GLXDrawable drawable,
+                                 unsigned long *mask)
 {
    struct apple_glx_drawable *d;
    bool result = false;
 
-   d = apple_glx_drawable_find_by_type(drawable, APPLE_GLX_DRAWABLE_PBUFFER,
+   d = apple_glx_drawable_find_by_type(dpy, drawable,
+                                       APPLE_GLX_DRAWABLE_PBUFFER,
                                        APPLE_GLX_DRAWABLE_LOCK);
    if (d) {
       *mask = d->types.pbuffer.event_mask;
@@ -328,3 +672,45 @@ apple_glx_pbuffer_get_event_mask(GLXDrawable drawable, unsigned long *mask)
 
    return result;
 }
+
+void
+apple_glx_pbuffer_destroy_share_group(Display * dpy,
+                                      struct apple_glx_share_group *g)
+{
+   struct apple_glx_display *gd;
+   struct apple_glx_drawable *d;
+   GLXPbuffer *xids;
+   unsigned int i, count = 0;
+
+   gd = apple_glx_display_find(dpy);
+
+   if (NULL == gd)
+      return;
+
+   apple_glx_display_lock_drawables(gd);
+
+   for (d = gd->drawables; d; d = d->next) {
+      if (APPLE_GLX_DRAWABLE_PBUFFER == d->type
+          && g == d->types.pbuffer.share_group)
+         ++count;
+   }
+
+   xids = count ? malloc(count * sizeof *xids) : NULL;
+
+   for (i = 0, d = gd->drawables; xids && d; d = d->next) {
+      if (APPLE_GLX_DRAWABLE_PBUFFER == d->type
+          && g == d->types.pbuffer.share_group)
+         xids[i++] = d->drawable;
+   }
+
+   apple_glx_display_unlock_drawables(gd);
+
+   if (NULL == xids)
+      return;
+
+   /* This takes the drawables lock, so it's done after the search. */
+   for (i = 0; i < count; ++i)
+      (void) apple_glx_pbuffer_destroy(dpy, xids[i]);
+
+   free(xids);
+}
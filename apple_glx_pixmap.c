@@ -38,9 +38,13 @@
 #include "apple_glx.h"
 #include "apple_cgl.h"
 #include "apple_visual.h"
+#include "apple_glx_display.h"
 #include "apple_glx_drawable.h"
 #include "appledri.h"
 #include "glcontextmodes.h"
+#include "apple_xgl_api.h"
+
+extern struct apple_xgl_api __gl_api;
 
 static bool pixmap_make_current(struct apple_glx_context *ac,
                                 struct apple_glx_drawable *d);
@@ -62,6 +66,22 @@ pixmap_make_current(struct apple_glx_context *ac,
 
    assert(APPLE_GLX_DRAWABLE_PIXMAP == d->type);
 
+   /* 
+    * The context is created the first time the pixmap is made current,
+    * because most pixmaps are only ever bound to textures or copied.
+    */
+   if (NULL == p->context_obj) {
+      cglerr = apple_cgl.create_context(p->pixel_format_obj, NULL,
+                                        &p->context_obj);
+
+      if (kCGLNoError != cglerr) {
+         fprintf(stderr, "create context: %s\n",
+                 apple_cgl.error_string(cglerr));
+         p->context_obj = NULL;
+         return true;
+      }
+   }
+
    cglerr = apple_cgl.set_current_context(p->context_obj);
 
    if (kCGLNoError != cglerr) {
@@ -99,15 +119,13 @@ pixmap_destroy(Display * dpy, struct apple_glx_drawable *d)
    if (p->context_obj)
       (void) apple_cgl.destroy_context(p->context_obj);
 
-   XAppleDRIDestroyPixmap(dpy, p->xpixmap);
+   if (!apple_glx_display_is_closed(d->glx_display))
+      XAppleDRIDestroyPixmap(dpy, p->xpixmap);
 
    if (p->buffer) {
       if (munmap(p->buffer, p->size))
          perror("munmap");
 
-      if (-1 == close(p->fd))
-         perror("close");
-
       if (shm_unlink(p->path))
          perror("shm_unlink");
    }
@@ -115,67 +133,201 @@ pixmap_destroy(Display * dpy, struct apple_glx_drawable *d)
    apple_glx_diagnostic("destroyed pixmap buffer for: 0x%lx\n", d->drawable);
 }
 
-/* Return true if an error occurred. */
-bool
-apple_glx_pixmap_create(Display * dpy, int screen, Pixmap pixmap,
-                        const void *mode)
+static bool
+is_power_of_two(int n)
+{
+   return n > 0 && 0 == (n & (n - 1));
+}
+
+/* 
+ * Parse the GLX_EXT_texture_from_pixmap attributes given to glXCreatePixmap.
+ * Return true if an attribute is invalid for the config.
+ */
+static bool
+parse_texture_attributes(struct apple_glx_pixmap *p,
+                         const __GLcontextModes * cmodes,
+                         const int *attrib_list)
+{
+   int i;
+   bool target_given = false;
+
+   p->texture_format = GLX_TEXTURE_FORMAT_NONE_EXT;
+   p->texture_target = GLX_TEXTURE_2D_EXT;
+
+   for (i = 0; attrib_list && attrib_list[i] != None; i += 2) {
+      switch (attrib_list[i]) {
+      case GLX_TEXTURE_FORMAT_EXT:
+         p->texture_format = attrib_list[i + 1];
+         break;
+
+      case GLX_TEXTURE_TARGET_EXT:
+         p->texture_target = attrib_list[i + 1];
+         target_given = true;
+         break;
+
+      case GLX_MIPMAP_TEXTURE_EXT:
+         /* The pixmap memory is a single level. */
+         if (attrib_list[i + 1])
+            return true;
+         break;
+      }
+   }
+
+   switch (p->texture_format) {
+   case GLX_TEXTURE_FORMAT_NONE_EXT:
+      return false;
+
+   case GLX_TEXTURE_FORMAT_RGB_EXT:
+      if (!cmodes->bindToTextureRgb)
+         return true;
+      break;
+
+   case GLX_TEXTURE_FORMAT_RGBA_EXT:
+      if (!cmodes->bindToTextureRgba)
+         return true;
+      break;
+
+   default:
+      return true;
+   }
+
+   if (!target_given && !(is_power_of_two(p->width)
+                          && is_power_of_two(p->height)))
+      p->texture_target = GLX_TEXTURE_RECTANGLE_EXT;
+
+   switch (p->texture_target) {
+   case GLX_TEXTURE_2D_EXT:
+      return !(cmodes->bindToTextureTargets & GLX_TEXTURE_2D_BIT_EXT);
+
+   case GLX_TEXTURE_RECTANGLE_EXT:
+      return !(cmodes->bindToTextureTargets & GLX_TEXTURE_RECTANGLE_BIT_EXT);
+   }
+
+   return true;
+}
+
+/* 
+ * Map the shared memory of the pixmap.  The mapping holds the memory, so
+ * the descriptor is closed at once, rather than keeping one open for
+ * every pixmap.  Return true if an error occurred.
+ */
+static bool
+pixmap_map(struct apple_glx_pixmap *p)
+{
+   void *buffer;
+   int fd;
+
+   fd = shm_open(p->path, O_RDWR, 0);
+
+   if (fd < 0) {
+      perror("shm_open");
+      return true;
+   }
+
+   buffer = mmap(NULL, p->size, PROT_READ | PROT_WRITE,
+                 MAP_FILE | MAP_SHARED, fd, 0);
+
+   if (-1 == close(fd))
+      perror("close");
+
+   if (MAP_FAILED == buffer) {
+      perror("mmap");
+      return true;
+   }
+
+   p->buffer = buffer;
+
+   return false;
+}
+
+/* 
+ * Start creating a pixmap drawable.  The drawable is returned locked and
+ * referenced, or NULL if an error occurred.
+ */
+static struct apple_glx_drawable *
+pixmap_begin(Display * dpy, int screen, Pixmap pixmap)
 {
    struct apple_glx_drawable *d;
    struct apple_glx_pixmap *p;
-   bool double_buffered;
-   bool uses_stereo;
-   CGLError error;
-   const __GLcontextModes *cmodes = mode;
 
    if (apple_glx_drawable_create(dpy, screen, pixmap, &d, &callbacks))
-      return true;
-
-   /* d is locked and referenced at this point. */
+      return NULL;
 
    p = &d->types.pixmap;
 
    p->xpixmap = pixmap;
    p->buffer = NULL;
+   p->bound = false;
+   p->texture = 0;
+   p->has_fence = false;
+   p->fence = 0;
+
+   return d;
+}
 
-   if (!XAppleDRICreatePixmap(dpy, screen, pixmap,
-                              &p->width, &p->height, &p->pitch, &p->bpp,
-                              &p->size, p->path, PATH_MAX)) {
+/* 
+ * Finish creating the pixmap drawable d from the reply to its
+ * XAppleDRISendCreatePixmap request.  pfobjs caches a pixel format for
+ * each bytes per pixel value of the mode, and is shared by the pixmaps
+ * of a batch.  The pixmap retains its pixel format, so the caller
+ * destroys the cached ones when it is done.
+ * d is unlocked, and destroyed if an error occurred.
+ * Return true if an error occurred.
+ */
+static bool
+pixmap_finish(Display * dpy, struct apple_glx_drawable *d,
+              XAppleDRICookie cookie, const void *mode,
+              const int *attrib_list, CGLPixelFormatObj pfobjs[5])
+{
+   struct apple_glx_pixmap *p = &d->types.pixmap;
+   bool double_buffered;
+   bool uses_stereo;
+   const __GLcontextModes *cmodes = mode;
+
+   if (!XAppleDRICreatePixmapReply(dpy, cookie,
+                                   &p->width, &p->height, &p->pitch, &p->bpp,
+                                   &p->size, p->path, PATH_MAX)) {
       d->unlock(d);
       d->destroy(d);
       return true;
    }
 
-   p->fd = shm_open(p->path, O_RDWR, 0);
-
-   if (p->fd < 0) {
-      perror("shm_open");
+   /* 
+    * CGL can render offscreen to 16 and 32 bits per pixel.  Anything else
+    * would be rendered with the wrong layout.
+    */
+   if (2 != p->bpp && 4 != p->bpp) {
+      apple_glx_diagnostic("unsupported pixmap bytes per pixel: %d\n",
+                           p->bpp);
       d->unlock(d);
       d->destroy(d);
       return true;
    }
 
-   p->buffer = mmap(NULL, p->size, PROT_READ | PROT_WRITE,
-                    MAP_FILE | MAP_SHARED, p->fd, 0);
-
-   if (MAP_FAILED == p->buffer) {
-      perror("mmap");
+   if (parse_texture_attributes(p, cmodes, attrib_list)) {
       d->unlock(d);
       d->destroy(d);
       return true;
    }
 
-   apple_visual_create_pfobj(&p->pixel_format_obj, mode, &double_buffered,
-                             &uses_stereo, /*offscreen */ true);
-
-   error = apple_cgl.create_context(p->pixel_format_obj, NULL,
-                                    &p->context_obj);
+   if (pixmap_map(p)) {
+      d->unlock(d);
+      d->destroy(d);
+      return true;
+   }
 
-   if (kCGLNoError != error) {
+   if (NULL == pfobjs[p->bpp]
+       && apple_visual_create_pfobj(&pfobjs[p->bpp], mode,
+                                    &double_buffered, &uses_stereo,
+                                    p->bpp * 8, /*profile */ 0,
+                                    /*renderer_id */ 0)) {
+      pfobjs[p->bpp] = NULL;
       d->unlock(d);
       d->destroy(d);
       return true;
    }
 
+   p->pixel_format_obj = apple_cgl.retain_pixel_format(pfobjs[p->bpp]);
    p->fbconfigID = cmodes->fbconfigID;
 
    d->unlock(d);
@@ -185,14 +337,108 @@ apple_glx_pixmap_create(Display * dpy, int screen, Pixmap pixmap,
    return false;
 }
 
+static void
+destroy_pfobjs(CGLPixelFormatObj pfobjs[5])
+{
+   int i;
+
+   for (i = 0; i < 5; ++i)
+      if (pfobjs[i])
+         (void) apple_cgl.destroy_pixel_format(pfobjs[i]);
+}
+
+/* Return true if an error occurred. */
 bool
-apple_glx_pixmap_query(GLXPixmap pixmap, int attr, unsigned int *value)
+apple_glx_pixmap_create(Display * dpy, int screen, Pixmap pixmap,
+                        const void *mode, const int *attrib_list)
+{
+   struct apple_glx_drawable *d;
+   XAppleDRICookie cookie;
+   CGLPixelFormatObj pfobjs[5] = { NULL };
+   bool result;
+
+   d = pixmap_begin(dpy, screen, pixmap);
+
+   if (NULL == d)
+      return true;
+
+   cookie = XAppleDRISendCreatePixmap(dpy, screen, pixmap);
+
+   /* The reply is waited for by pixmap_finish. */
+   apple_glx_wait_framework();
+
+   result = pixmap_finish(dpy, d, cookie, mode, attrib_list, pfobjs);
+
+   destroy_pfobjs(pfobjs);
+
+   return result;
+}
+
+int
+apple_glx_pixmap_create_batch(Display * dpy, int screen, int count,
+                              const Pixmap * pixmaps, const void *mode,
+                              const int *attrib_list, GLXPixmap * glxpixmaps)
+{
+   struct apple_glx_drawable **drawables;
+   XAppleDRICookie *cookies;
+   CGLPixelFormatObj pfobjs[5] = { NULL };
+   int i, created = 0;
+
+   drawables = malloc(count * sizeof(*drawables));
+   cookies = malloc(count * sizeof(*cookies));
+
+   if (NULL == drawables || NULL == cookies) {
+      free(drawables);
+      free(cookies);
+
+      for (i = 0; i < count; ++i)
+         glxpixmaps[i] = None;
+
+      return 0;
+   }
+
+   /* Send every request before waiting for the first reply. */
+   for (i = 0; i < count; ++i) {
+      drawables[i] = pixmap_begin(dpy, screen, pixmaps[i]);
+
+      if (drawables[i])
+         cookies[i] = XAppleDRISendCreatePixmap(dpy, screen, pixmaps[i]);
+   }
+
+   apple_glx_wait_framework();
+
+   for (i = 0; i < count; ++i) {
+      if (drawables[i]
+          && !pixmap_finish(dpy, drawables[i], cookies[i], mode,
+                            attrib_list, pfobjs)) {
+         glxpixmaps[i] = pixmaps[i];
+         ++created;
+      }
+      else {
+         glxpixmaps[i] = None;
+      }
+   }
+
+   destroy_pfobjs(pfobjs);
+   free(drawables);
+   free(cookies);
+
+   apple_glx_diagnostic("created %d of %d pixmaps in a batch\n", created,
+                        count);
+
+   return created;
+}
+
+bool
+apple_glx_pixmap_query(Display * dpy, GLXPixmap pixmap, int attr,
+                       unsigned int *value)
 {
    struct apple_glx_drawable *d;
    struct apple_glx_pixmap *p;
    bool result = false;
 
-   d = apple_glx_drawable_find_by_type(pixmap, APPLE_GLX_DRAWABLE_PIXMAP,
+   d = apple_glx_drawable_find_by_type(dpy, pixmap,
+                                       APPLE_GLX_DRAWABLE_PIXMAP,
                                        APPLE_GLX_DRAWABLE_LOCK);
 
    if (d) {
@@ -213,6 +459,21 @@ apple_glx_pixmap_query(GLXPixmap pixmap, int attr, unsigned int *value)
          *value = p->fbconfigID;
          result = true;
          break;
+
+      case GLX_TEXTURE_FORMAT_EXT:
+         *value = p->texture_format;
+         result = true;
+         break;
+
+      case GLX_TEXTURE_TARGET_EXT:
+         *value = p->texture_target;
+         result = true;
+         break;
+
+      case GLX_MIPMAP_TEXTURE_EXT:
+         *value = False;
+         result = true;
+         break;
       }
 
       d->unlock(d);
@@ -228,3 +489,189 @@ apple_glx_pixmap_destroy(Display * dpy, GLXPixmap pixmap)
    return !apple_glx_drawable_destroy_by_type(dpy, pixmap,
                                               APPLE_GLX_DRAWABLE_PIXMAP);
 }
+
+static GLenum
+texture_target(struct apple_glx_pixmap *p)
+{
+   return (GLX_TEXTURE_RECTANGLE_EXT == p->texture_target) ?
+      GL_TEXTURE_RECTANGLE_ARB : GL_TEXTURE_2D;
+}
+
+static GLenum
+texture_binding(struct apple_glx_pixmap *p)
+{
+   return (GLX_TEXTURE_RECTANGLE_EXT == p->texture_target) ?
+      GL_TEXTURE_BINDING_RECTANGLE_ARB : GL_TEXTURE_BINDING_2D;
+}
+
+static GLint
+texture_internal_format(struct apple_glx_pixmap *p)
+{
+   return (GLX_TEXTURE_FORMAT_RGBA_EXT == p->texture_format) ?
+      GL_RGBA : GL_RGB;
+}
+
+/* 
+ * Return 0 if the pixmap depth can't be textured from directly.  The 16 bit
+ * pixmaps are x1-5-5-5 rather than 5-6-5: that is the layout of the 15 bit
+ * visuals of the X server, and the only 16 bit layout CGL renders
+ * offscreen, so it is the layout the pixmap memory holds.
+ */
+static GLenum
+texture_type(struct apple_glx_pixmap *p)
+{
+   switch (p->bpp) {
+   case 4:
+      return GL_UNSIGNED_INT_8_8_8_8_REV;
+
+   case 2:
+      return GL_UNSIGNED_SHORT_1_5_5_5_REV;
+   }
+
+   return 0;
+}
+
+/* 
+ * Find the pixmap for a bind or release, and validate the request.
+ * The drawable is returned locked.
+ */
+static struct apple_glx_drawable *
+find_texture_pixmap(Display * dpy, GLXPixmap pixmap, int buffer,
+                    int *errorcode)
+{
+   struct apple_glx_drawable *d;
+   struct apple_glx_pixmap *p;
+
+   d = apple_glx_drawable_find_by_type(dpy, pixmap,
+                                       APPLE_GLX_DRAWABLE_PIXMAP,
+                                       APPLE_GLX_DRAWABLE_LOCK);
+
+   if (NULL == d) {
+      *errorcode = GLXBadPixmap;
+      return NULL;
+   }
+
+   p = &d->types.pixmap;
+
+   if (GLX_TEXTURE_FORMAT_NONE_EXT == p->texture_format
+       || 0 == texture_type(p)) {
+      d->unlock(d);
+      *errorcode = BadMatch;
+      return NULL;
+   }
+
+   if (GLX_FRONT_LEFT_EXT != buffer) {
+      d->unlock(d);
+      *errorcode = BadValue;
+      return NULL;
+   }
+
+   return d;
+}
+
+bool
+apple_glx_pixmap_bind_tex_image(Display * dpy, GLXPixmap pixmap,
+                                int buffer, int *errorcode)
+{
+   struct apple_glx_drawable *d;
+   struct apple_glx_pixmap *p;
+   GLenum target;
+   GLint name;
+
+   /* 
+    * X rendering into the pixmap issued before the bind must land in
+    * the shared memory before the GL reads from it.
+    */
+   XSync(dpy, False);
+
+   d = find_texture_pixmap(dpy, pixmap, buffer, errorcode);
+
+   if (NULL == d)
+      return true;
+
+   p = &d->types.pixmap;
+   target = texture_target(p);
+
+   /* 
+    * Texture straight from the shared memory: client storage keeps the
+    * framework from making a copy, and the shared storage hint maps the
+    * pages for the GPU rather than caching them in VRAM.
+    */
+   __gl_api.PushClientAttrib(GL_CLIENT_PIXEL_STORE_BIT);
+   __gl_api.PixelStorei(GL_UNPACK_CLIENT_STORAGE_APPLE, GL_TRUE);
+   __gl_api.PixelStorei(GL_UNPACK_ALIGNMENT, 1);
+   __gl_api.PixelStorei(GL_UNPACK_ROW_LENGTH, p->pitch / p->bpp);
+   __gl_api.PixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+   __gl_api.PixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+   __gl_api.PixelStorei(GL_UNPACK_SWAP_BYTES, GL_FALSE);
+
+   if (__gl_api.TextureRangeAPPLE)
+      __gl_api.TextureRangeAPPLE(target, p->size, p->buffer);
+
+   __gl_api.TexParameteri(target, GL_TEXTURE_STORAGE_HINT_APPLE,
+                          GL_STORAGE_SHARED_APPLE);
+   __gl_api.TexImage2D(target, 0, texture_internal_format(p),
+                       p->width, p->height, 0, GL_BGRA, texture_type(p),
+                       p->buffer);
+   __gl_api.PopClientAttrib();
+
+   __gl_api.GetIntegerv(texture_binding(p), &name);
+   p->texture = name;
+
+   /* Keep the memory mapped while the GL may read from it. */
+   if (!p->bound) {
+      p->bound = true;
+      d->reference(d);
+   }
+
+   d->unlock(d);
+
+   apple_glx_diagnostic("bound pixmap 0x%lx to texture %u\n",
+                        d->drawable, p->texture);
+
+   return false;
+}
+
+bool
+apple_glx_pixmap_release_tex_image(Display * dpy, GLXPixmap pixmap,
+                                   int buffer, int *errorcode)
+{
+   struct apple_glx_drawable *d;
+   struct apple_glx_pixmap *p;
+   GLenum target;
+   GLint previous;
+
+   d = find_texture_pixmap(dpy, pixmap, buffer, errorcode);
+
+   if (NULL == d)
+      return true;
+
+   p = &d->types.pixmap;
+
+   if (!p->bound) {
+      d->unlock(d);
+      return false;
+   }
+
+   target = texture_target(p);
+
+   /* 
+    * Respecify the texture as empty, so the framework drops its pointer
+    * to the pixmap memory before it may be unmapped.
+    */
+   __gl_api.GetIntegerv(texture_binding(p), &previous);
+   __gl_api.BindTexture(target, p->texture);
+   __gl_api.TexImage2D(target, 0, texture_internal_format(p), 0, 0, 0,
+                       GL_BGRA, texture_type(p), NULL);
+   __gl_api.BindTexture(target, previous);
+
+   p->bound = false;
+   p->texture = 0;
+
+   d->unlock(d);
+
+   /* Drop the reference from the bind. */
+   d->destroy(d);
+
+   return false;
+}
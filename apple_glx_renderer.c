@@ -0,0 +1,380 @@
+/*
+ Copyright (c) 2009 Apple Inc.
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction,
+ including without limitation the rights to use, copy, modify, merge,
+ publish, distribute, sublicense, and/or sell copies of the Software,
+ and to permit persons to whom the Software is furnished to do so,
+ subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT.  IN NO EVENT SHALL THE ABOVE LISTED COPYRIGHT
+ HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ 
+ Except as contained in this notice, the name(s) of the above
+ copyright holders shall not be used in advertising or otherwise to
+ promote the sale, use or other dealings in this Software without
+ prior written authorization.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <GL/glx.h>
+#include <GL/glxext.h>
+#include <OpenGL/OpenGL.h>
+#include "apple_glx.h"
+#include "apple_cgl.h"
+#include "apple_glx_renderer.h"
+
+enum
+{
+   MAX_RENDERERS = 16
+};
+
+/* The bits of a CGL renderer ID that identify the vendor. */
+#define RENDERER_VENDOR_MASK 0x000ff000
+
+static pthread_once_t renderers_once = PTHREAD_ONCE_INIT;
+static struct apple_glx_renderer renderers[MAX_RENDERERS];
+static int renderer_count = 0;
+static GLint default_id = 0;
+
+/* 1 prefers more video memory, -1 prefers less, and 0 has no preference. */
+static int preference = 0;
+
+static void
+describe_vendor(struct apple_glx_renderer *r)
+{
+   switch (r->id & RENDERER_VENDOR_MASK) {
+   case 0x00020000:
+      r->vendor = "Apple Inc.";
+      r->vendor_id = 0x106b;
+      r->unified_memory = true;
+      break;
+
+   case 0x00021000:
+      r->vendor = "ATI Technologies Inc.";
+      r->vendor_id = 0x1002;
+      break;
+
+   case 0x00022000:
+      r->vendor = "NVIDIA Corporation";
+      r->vendor_id = 0x10de;
+      break;
+
+   case 0x00024000:
+      r->vendor = "Intel Inc.";
+      r->vendor_id = 0x8086;
+      r->unified_memory = true;
+      break;
+
+   default:
+      r->vendor = "Unknown";
+      r->vendor_id = 0xffffffff;
+      break;
+   }
+
+   snprintf(r->device, sizeof(r->device), "CGL renderer 0x%08x",
+            (unsigned int) r->id);
+}
+
+static GLint
+describe(CGLRendererInfoObj info, GLint i, CGLRendererProperty prop,
+         GLint fallback)
+{
+   GLint value;
+
+   if (apple_cgl.describe_renderer(info, i, prop, &value))
+      return fallback;
+
+   return value;
+}
+
+/* Return true if a should be listed before b. */
+static bool
+renderer_precedes(const struct apple_glx_renderer *a,
+                  const struct apple_glx_renderer *b)
+{
+   if (a->accelerated != b->accelerated)
+      return a->accelerated;
+
+   if (preference > 0 && a->video_memory != b->video_memory)
+      return a->video_memory > b->video_memory;
+
+   if (preference < 0 && a->video_memory != b->video_memory)
+      return a->video_memory < b->video_memory;
+
+   if (a->online != b->online)
+      return a->online;
+
+   return false;
+}
+
+/* 
+ * This is an insertion sort, so renderers that are equally preferred
+ * keep the order CGL returned them in.
+ */
+static void
+sort_renderers(void)
+{
+   struct apple_glx_renderer r;
+   int i, j;
+
+   for (i = 1; i < renderer_count; ++i) {
+      r = renderers[i];
+
+      for (j = i; j > 0 && renderer_precedes(&r, &renderers[j - 1]); --j)
+         renderers[j] = renderers[j - 1];
+
+      renderers[j] = r;
+   }
+}
+
+static void
+init_renderers(void)
+{
+   CGLRendererInfoObj info;
+   GLint n, i, j, id;
+   const char *s;
+   struct apple_glx_renderer *r;
+
+   apple_glx_wait_framework();
+
+   if (apple_cgl.query_renderer_info(0xffffffff, &info, &n)) {
+      apple_glx_diagnostic("CGLQueryRendererInfo failed\n");
+      return;
+   }
+
+   for (i = 0; i < n && renderer_count < MAX_RENDERERS; ++i) {
+      id = describe(info, i, kCGLRPRendererID, 0);
+
+      /* A renderer is listed once for each display it can drive. */
+      for (j = 0; j < renderer_count; ++j)
+         if (renderers[j].id == id)
+            break;
+
+      if (j < renderer_count) {
+         renderers[j].online |= describe(info, i, kCGLRPOnline, 0);
+         continue;
+      }
+
+      r = &renderers[renderer_count++];
+      memset(r, 0, sizeof(*r));
+      r->id = id;
+      r->accelerated = describe(info, i, kCGLRPAccelerated, 0);
+      r->online = describe(info, i, kCGLRPOnline, 1);
+      r->video_memory = describe(info, i, kCGLRPVideoMemory, 0) >> 20;
+      r->major_gl_version = describe(info, i, APPLE_CGL_RP_MAJOR_GL_VERSION,
+                                     2);
+      describe_vendor(r);
+   }
+
+   (void) apple_cgl.destroy_renderer_info(info);
+
+   s = getenv("LIBGL_GPU_PREFERENCE");
+
+   if (s && !strcmp(s, "high-performance"))
+      preference = 1;
+   else if (s && !strcmp(s, "low-power"))
+      preference = -1;
+   else if (s)
+      fprintf(stderr, "warning: unknown LIBGL_GPU_PREFERENCE: %s\n", s);
+
+   sort_renderers();
+
+   if (preference && renderer_count > 0 && renderers[0].accelerated)
+      default_id = renderers[0].id;
+
+   s = getenv("LIBGL_RENDERER_ID");
+
+   if (s) {
+      struct apple_glx_renderer pinned;
+
+      id = strtol(s, NULL, 0);
+
+      for (i = 0; i < renderer_count; ++i)
+         if (renderers[i].id == id)
+            break;
+
+      if (i < renderer_count) {
+         /* Move the pinned renderer to the front. */
+         pinned = renderers[i];
+         memmove(renderers + 1, renderers, i * sizeof(*renderers));
+         renderers[0] = pinned;
+         default_id = id;
+      }
+      else {
+         fprintf(stderr, "warning: LIBGL_RENDERER_ID 0x%x isn't a "
+                 "renderer of this system\n", (unsigned int) id);
+      }
+   }
+
+   for (i = 0; i < renderer_count; ++i)
+      apple_glx_diagnostic("renderer %d: id 0x%x %s accelerated %d "
+                           "online %d video memory %u MB\n", (int) i,
+                           (unsigned int) renderers[i].id,
+                           renderers[i].vendor, renderers[i].accelerated,
+                           renderers[i].online, renderers[i].video_memory);
+}
+
+static void
+init(void)
+{
+   int err = pthread_once(&renderers_once, init_renderers);
+
+   if (err) {
+      fprintf(stderr, "pthread_once failure in %s: %d\n", __func__, err);
+      abort();
+   }
+}
+
+int
+apple_glx_renderer_count(void)
+{
+   init();
+
+   return renderer_count;
+}
+
+const struct apple_glx_renderer *
+apple_glx_renderer_get(int index)
+{
+   init();
+
+   if (index < 0 || index >= renderer_count)
+      return NULL;
+
+   return &renderers[index];
+}
+
+const struct apple_glx_renderer *
+apple_glx_renderer_current(void)
+{
+   CGLContextObj ctx;
+   GLint id, i;
+
+   init();
+
+   ctx = apple_cgl.get_current_context();
+
+   if (NULL == ctx || apple_cgl.get_parameter(ctx, kCGLCPCurrentRendererID,
+                                              &id))
+      return NULL;
+
+   for (i = 0; i < renderer_count; ++i)
+      if (renderers[i].id == id)
+         return &renderers[i];
+
+   return NULL;
+}
+
+GLint
+apple_glx_renderer_default_id(void)
+{
+   init();
+
+   return default_id;
+}
+
+bool
+apple_glx_renderer_query_integer(const struct apple_glx_renderer *r,
+                                 int attribute, unsigned int *value)
+{
+   GLint major, minor;
+
+   switch (attribute) {
+   case GLX_RENDERER_VENDOR_ID_MESA:
+      value[0] = r->vendor_id;
+      return true;
+
+   case GLX_RENDERER_DEVICE_ID_MESA:
+      /* CGL doesn't report the PCI device. */
+      value[0] = 0xffffffff;
+      return true;
+
+   case GLX_RENDERER_VERSION_MESA:
+      /* 
+       * CGL doesn't report a version for each renderer.  The renderers 
+       * are part of the OpenGL framework, so the CGL version stands in.
+       */
+      apple_cgl.get_version(&major, &minor);
+      value[0] = major;
+      value[1] = minor;
+      value[2] = 0;
+      return true;
+
+   case GLX_RENDERER_ACCELERATED_MESA:
+      value[0] = r->accelerated;
+      return true;
+
+   case GLX_RENDERER_VIDEO_MEMORY_MESA:
+      value[0] = r->video_memory;
+      return true;
+
+   case GLX_RENDERER_UNIFIED_MEMORY_ARCHITECTURE_MESA:
+      value[0] = r->unified_memory;
+      return true;
+
+   case GLX_RENDERER_PREFERRED_PROFILE_MESA:
+      value[0] = (r->major_gl_version >= 3) ?
+         GLX_CONTEXT_CORE_PROFILE_BIT_ARB :
+         GLX_CONTEXT_COMPATIBILITY_PROFILE_BIT_ARB;
+      return true;
+
+   case GLX_RENDERER_OPENGL_CORE_PROFILE_VERSION_MESA:
+      /* These are the versions of the CGL core profiles. */
+      if (r->major_gl_version >= 4) {
+         value[0] = 4;
+         value[1] = 1;
+      }
+      else if (r->major_gl_version == 3) {
+         value[0] = 3;
+         value[1] = 2;
+      }
+      else {
+         value[0] = 0;
+         value[1] = 0;
+      }
+      return true;
+
+   case GLX_RENDERER_OPENGL_COMPATIBILITY_PROFILE_VERSION_MESA:
+      value[0] = 2;
+      value[1] = 1;
+      return true;
+
+   case GLX_RENDERER_OPENGL_ES_PROFILE_VERSION_MESA:
+   case GLX_RENDERER_OPENGL_ES2_PROFILE_VERSION_MESA:
+      value[0] = 0;
+      value[1] = 0;
+      return true;
+   }
+
+   return false;
+}
+
+const char *
+apple_glx_renderer_query_string(const struct apple_glx_renderer *r,
+                                int attribute)
+{
+   switch (attribute) {
+   case GLX_RENDERER_VENDOR_ID_MESA:
+      return r->vendor;
+
+   case GLX_RENDERER_DEVICE_ID_MESA:
+      return r->device;
+   }
+
+   return NULL;
+}
@@ -0,0 +1,80 @@
+/*
+ Copyright (c) 2009 Apple Inc.
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction,
+ including without limitation the rights to use, copy, modify, merge,
+ publish, distribute, sublicense, and/or sell copies of the Software,
+ and to permit persons to whom the Software is furnished to do so,
+ subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT.  IN NO EVENT SHALL THE ABOVE LISTED COPYRIGHT
+ HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ 
+ Except as contained in this notice, the name(s) of the above
+ copyright holders shall not be used in advertising or otherwise to
+ promote the sale, use or other dealings in this Software without
+ prior written authorization.
+*/
+
+#ifndef APPLE_GLX_RENDERER_H
+#define APPLE_GLX_RENDERER_H
+
+#include <stdbool.h>
+#include <GL/gl.h>
+
+/* A CGL renderer, as described by CGLDescribeRenderer. */
+struct apple_glx_renderer
+{
+   GLint id;                    /* kCGLRPRendererID */
+   bool accelerated;
+   bool online;                 /* Attached to a display. */
+   bool unified_memory;
+   unsigned int vendor_id;      /* PCI vendor, or 0xffffffff. */
+   unsigned int video_memory;   /* In megabytes. */
+   GLint major_gl_version;
+   const char *vendor;
+   char device[32];
+};
+
+/* 
+ * The renderers are listed in order of preference, so renderer 0 is used
+ * by default.  The order can be changed with LIBGL_GPU_PREFERENCE set to
+ * "high-performance" or "low-power", and LIBGL_RENDERER_ID pins a CGL
+ * renderer ID.
+ */
+int apple_glx_renderer_count(void);
+
+/* Returns NULL if the index is out of range. */
+const struct apple_glx_renderer *apple_glx_renderer_get(int index);
+
+/* Returns the renderer of the current CGL context, or NULL. */
+const struct apple_glx_renderer *apple_glx_renderer_current(void);
+
+/* 
+ * Returns the CGL renderer ID new contexts should be pinned to, or 0 if
+ * CGL should choose.
+ */
+GLint apple_glx_renderer_default_id(void);
+
+/* 
+ * These implement GLX_MESA_query_renderer.
+ * The integer query returns true if the attribute is valid.
+ */
+bool apple_glx_renderer_query_integer(const struct apple_glx_renderer *r,
+                                      int attribute, unsigned int *value);
+
+const char *apple_glx_renderer_query_string(const struct apple_glx_renderer
+                                            *r, int attribute);
+
+#endif
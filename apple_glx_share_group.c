@@ -0,0 +1,426 @@
+/*
+ Copyright (c) 2009 Apple Inc.
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction,
+ including without limitation the rights to use, copy, modify, merge,
+ publish, distribute, sublicense, and/or sell copies of the Software,
+ and to permit persons to whom the Software is furnished to do so,
+ subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT.  IN NO EVENT SHALL THE ABOVE LISTED COPYRIGHT
+ HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ 
+ Except as contained in this notice, the name(s) of the above
+ copyright holders shall not be used in advertising or otherwise to
+ promote the sale, use or other dealings in this Software without
+ prior written authorization.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "apple_glx.h"
+#include "apple_glx_display.h"
+#include "apple_glx_share_group.h"
+
+static void
+lock_group(struct apple_glx_share_group *g)
+{
+   int err;
+
+   err = pthread_mutex_lock(&g->mutex);
+
+   if (err) {
+      fprintf(stderr, "pthread_mutex_lock failure in %s: %d\n",
+              __func__, err);
+      abort();
+   }
+}
+
+static void
+unlock_group(struct apple_glx_share_group *g)
+{
+   int err;
+
+   err = pthread_mutex_unlock(&g->mutex);
+
+   if (err) {
+      fprintf(stderr, "pthread_mutex_unlock failure in %s: %d\n",
+              __func__, err);
+      abort();
+   }
+}
+
+struct apple_glx_share_group *
+apple_glx_share_group_create(struct apple_glx_display *gd)
+{
+   struct apple_glx_share_group *g;
+   int err;
+
+   g = calloc(1, sizeof *g);
+
+   if (NULL == g) {
+      perror("calloc");
+      return NULL;
+   }
+
+   err = pthread_mutex_init(&g->mutex, NULL);
+
+   if (err) {
+      fprintf(stderr, "pthread_mutex_init error: %d\n", err);
+      abort();
+   }
+
+   g->glx_display = gd;
+   g->reference_count = 1;
+   g->contexts = 1;
+
+   apple_glx_display_lock_contexts(gd);
+
+   g->previous = NULL;
+   g->next = gd->share_groups;
+
+   if (gd->share_groups)
+      gd->share_groups->previous = g;
+
+   gd->share_groups = g;
+
+   apple_glx_display_unlock_contexts(gd);
+
+   apple_glx_diagnostic("%s: new share group %p\n", __func__, (void *) g);
+
+   return g;
+}
+
+static void
+destroy_group(struct apple_glx_share_group *g)
+{
+   struct apple_glx_display *gd;
+   struct apple_glx_texture_record *r, *rnext;
+   struct apple_glx_list_range *l, *lnext;
+   int i;
+
+   lock_group(g);
+   gd = g->glx_display;
+   unlock_group(g);
+
+   /* An orphaned group isn't linked to the state of a display. */
+   if (gd) {
+      apple_glx_display_lock_contexts(gd);
+
+      if (g->previous)
+         g->previous->next = g->next;
+      else
+         gd->share_groups = g->next;
+
+      if (g->next)
+         g->next->previous = g->previous;
+
+      apple_glx_display_unlock_contexts(gd);
+   }
+
+   apple_glx_share_group_report(g);
+
+   for (i = 0; i < APPLE_GLX_SHARE_GROUP_BUCKETS; ++i) {
+      for (r = g->texture_records[i]; r; r = rnext) {
+         rnext = r->next;
+         free(r);
+      }
+   }
+
+   for (l = g->list_ranges; l; l = lnext) {
+      lnext = l->next;
+      free(l);
+   }
+
+   (void) pthread_mutex_destroy(&g->mutex);
+
+   free(g);
+}
+
+void
+apple_glx_share_group_reference(struct apple_glx_share_group *g)
+{
+   lock_group(g);
+   g->reference_count++;
+   unlock_group(g);
+}
+
+void
+apple_glx_share_group_release(struct apple_glx_share_group *g)
+{
+   bool destroy;
+
+   lock_group(g);
+   destroy = (0 == --g->reference_count);
+   unlock_group(g);
+
+   if (destroy)
+      destroy_group(g);
+}
+
+void
+apple_glx_share_group_orphan_all(struct apple_glx_display *gd)
+{
+   struct apple_glx_share_group *g, *next;
+
+   apple_glx_display_lock_contexts(gd);
+
+   for (g = gd->share_groups; g; g = next) {
+      next = g->next;
+
+      apple_glx_diagnostic("%s: orphaned share group %p\n", __func__,
+                           (void *) g);
+
+      lock_group(g);
+      g->glx_display = NULL;
+      g->previous = NULL;
+      g->next = NULL;
+      unlock_group(g);
+   }
+
+   gd->share_groups = NULL;
+
+   apple_glx_display_unlock_contexts(gd);
+}
+
+void
+apple_glx_share_group_join(struct apple_glx_share_group *g)
+{
+   lock_group(g);
+   g->reference_count++;
+   g->contexts++;
+   unlock_group(g);
+}
+
+void
+apple_glx_share_group_leave(struct apple_glx_share_group *g)
+{
+   lock_group(g);
+   g->contexts--;
+   unlock_group(g);
+
+   apple_glx_share_group_release(g);
+}
+
+void
+apple_glx_share_group_add_pbuffer(struct apple_glx_share_group *g,
+                                  size_t bytes)
+{
+   lock_group(g);
+   g->reference_count++;
+   g->pbuffers++;
+   g->pbuffer_bytes += bytes;
+   unlock_group(g);
+}
+
+void
+apple_glx_share_group_remove_pbuffer(struct apple_glx_share_group *g,
+                                     size_t bytes)
+{
+   lock_group(g);
+   g->pbuffers--;
+   g->pbuffer_bytes -= bytes;
+   unlock_group(g);
+
+   apple_glx_share_group_release(g);
+}
+
+static unsigned int
+bucket(GLuint name)
+{
+   return name % APPLE_GLX_SHARE_GROUP_BUCKETS;
+}
+
+/* 
+ * The image of each level (or cube map face) of a texture replaces the
+ * previous image, so the bytes are recorded by name, target and level.
+ */
+void
+apple_glx_share_group_texture_image(struct apple_glx_share_group *g,
+                                    GLuint name, GLenum target,
+                                    GLint level, size_t bytes)
+{
+   struct apple_glx_texture_record *r;
+   unsigned int b = bucket(name);
+
+   lock_group(g);
+
+   for (r = g->texture_records[b]; r; r = r->next) {
+      if (name == r->name && target == r->target && level == r->level)
+         break;
+   }
+
+   if (NULL == r) {
+      r = malloc(sizeof *r);
+
+      if (NULL == r) {
+         unlock_group(g);
+         return;
+      }
+
+      r->name = name;
+      r->target = target;
+      r->level = level;
+      r->bytes = 0;
+      r->next = g->texture_records[b];
+      g->texture_records[b] = r;
+
+      if (0 == level)
+         g->textures++;
+   }
+
+   g->texture_bytes -= r->bytes;
+   g->texture_bytes += bytes;
+   r->bytes = bytes;
+
+   unlock_group(g);
+}
+
+void
+apple_glx_share_group_delete_textures(struct apple_glx_share_group *g,
+                                      GLsizei n, const GLuint * names)
+{
+   struct apple_glx_texture_record *r, **prev;
+   GLsizei i;
+
+   lock_group(g);
+
+   for (i = 0; i < n; ++i) {
+      /* Texture 0 is the default texture, and isn't deleted. */
+      if (0 == names[i])
+         continue;
+
+      prev = &g->texture_records[bucket(names[i])];
+
+      while ((r = *prev)) {
+         if (names[i] != r->name) {
+            prev = &r->next;
+            continue;
+         }
+
+         if (0 == r->level)
+            g->textures--;
+
+         g->texture_bytes -= r->bytes;
+         *prev = r->next;
+         free(r);
+      }
+   }
+
+   unlock_group(g);
+}
+
+void
+apple_glx_share_group_gen_lists(struct apple_glx_share_group *g,
+                                GLuint first, GLsizei range)
+{
+   struct apple_glx_list_range *r;
+
+   r = malloc(sizeof *r);
+
+   if (NULL == r) {
+      perror("malloc");
+      return;
+   }
+
+   r->first = first;
+   r->count = range;
+
+   lock_group(g);
+
+   r->next = g->list_ranges;
+   g->list_ranges = r;
+   g->display_lists += range;
+
+   unlock_group(g);
+}
+
+/* 
+ * Remove the names of [first, first + range) from each range generated.
+ * A range that only loses names in its middle is split in two.
+ */
+void
+apple_glx_share_group_delete_lists(struct apple_glx_share_group *g,
+                                   GLuint first, GLsizei range)
+{
+   struct apple_glx_list_range *r, *tail, **prev;
+   GLuint last = first + range, r_last, start, end;
+
+   lock_group(g);
+
+   prev = &g->list_ranges;
+
+   while ((r = *prev)) {
+      r_last = r->first + r->count;
+      start = (first > r->first) ? first : r->first;
+      end = (last < r_last) ? last : r_last;
+
+      if (start >= end) {
+         prev = &r->next;
+         continue;
+      }
+
+      g->display_lists -= end - start;
+
+      if (start > r->first && end < r_last) {
+         tail = malloc(sizeof *tail);
+
+         /* Without the tail, its lists are no longer counted. */
+         if (NULL == tail) {
+            g->display_lists -= r_last - end;
+         }
+         else {
+            tail->first = end;
+            tail->count = r_last - end;
+            tail->next = r->next;
+            r->next = tail;
+         }
+
+         r->count = start - r->first;
+         prev = &r->next;
+      }
+      else if (start > r->first) {
+         r->count = start - r->first;
+         prev = &r->next;
+      }
+      else if (end < r_last) {
+         r->first = end;
+         r->count = r_last - end;
+         prev = &r->next;
+      }
+      else {
+         *prev = r->next;
+         free(r);
+      }
+   }
+
+   unlock_group(g);
+}
+
+void
+apple_glx_share_group_report(struct apple_glx_share_group *g)
+{
+   lock_group(g);
+
+   apple_glx_diagnostic("share group %p: %u contexts, "
+                        "%u textures (%lu bytes), "
+                        "%u pbuffers (%lu bytes), %u display lists\n",
+                        (void *) g, g->contexts, g->textures,
+                        (unsigned long) g->texture_bytes, g->pbuffers,
+                        (unsigned long) g->pbuffer_bytes,
+                        g->display_lists);
+
+   unlock_group(g);
+}
@@ -0,0 +1,139 @@
+/*
+ Copyright (c) 2009 Apple Inc.
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction,
+ including without limitation the rights to use, copy, modify, merge,
+ publish, distribute, sublicense, and/or sell copies of the Software,
+ and to permit persons to whom the Software is furnished to do so,
+ subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT.  IN NO EVENT SHALL THE ABOVE LISTED COPYRIGHT
+ HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ 
+ Except as contained in this notice, the name(s) of the above
+ copyright holders shall not be used in advertising or otherwise to
+ promote the sale, use or other dealings in this Software without
+ prior written authorization.
+*/
+
+#ifndef APPLE_GLX_SHARE_GROUP_H
+#define APPLE_GLX_SHARE_GROUP_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <GL/gl.h>
+#include <X11/Xlib.h>
+
+struct apple_glx_display;
+
+struct apple_glx_texture_record
+{
+   GLuint name;
+   GLenum target;
+   GLint level;
+   size_t bytes;
+   struct apple_glx_texture_record *next;
+};
+
+/* A range of display lists returned by glGenLists. */
+struct apple_glx_list_range
+{
+   GLuint first;
+   GLsizei count;
+   struct apple_glx_list_range *next;
+};
+
+#define APPLE_GLX_SHARE_GROUP_BUCKETS 64
+
+/* 
+ * The contexts that share objects, and the memory accounted to them.
+ * The group is created with the first context, and each member context
+ * and each pbuffer of the group holds a reference.
+ */
+struct apple_glx_share_group
+{
+   struct apple_glx_display *glx_display;
+
+   /* This protects the reference count and the accounting below. */
+   pthread_mutex_t mutex;
+   int reference_count;
+
+   unsigned int contexts;
+
+   unsigned int textures;
+   size_t texture_bytes;
+
+   unsigned int pbuffers;
+   size_t pbuffer_bytes;
+
+   unsigned int display_lists;
+   struct apple_glx_list_range *list_ranges;
+
+   struct apple_glx_texture_record *texture_records
+      [APPLE_GLX_SHARE_GROUP_BUCKETS];
+
+   /* These are protected by the contexts lock of the display. */
+   struct apple_glx_share_group *previous, *next;
+};
+
+/* 
+ * Create a group for a new context that doesn't share.  The context is
+ * the first member.  Returns NULL if an error occurred.
+ */
+struct apple_glx_share_group *apple_glx_share_group_create(struct
+                                                           apple_glx_display
+                                                           *gd);
+
+void apple_glx_share_group_reference(struct apple_glx_share_group *g);
+
+/* This destroys the group when the last reference is released. */
+void apple_glx_share_group_release(struct apple_glx_share_group *g);
+
+/* 
+ * Unlink the groups still referenced when the state of gd is freed.  They
+ * are destroyed by the release of their last reference, as before.
+ */
+void apple_glx_share_group_orphan_all(struct apple_glx_display *gd);
+
+/* These add and remove a member context with its reference. */
+void apple_glx_share_group_join(struct apple_glx_share_group *g);
+void apple_glx_share_group_leave(struct apple_glx_share_group *g);
+
+/* These add and remove a pbuffer with its reference. */
+void apple_glx_share_group_add_pbuffer(struct apple_glx_share_group *g,
+                                       size_t bytes);
+void apple_glx_share_group_remove_pbuffer(struct apple_glx_share_group *g,
+                                          size_t bytes);
+
+void apple_glx_share_group_texture_image(struct apple_glx_share_group *g,
+                                         GLuint name, GLenum target,
+                                         GLint level, size_t bytes);
+
+void apple_glx_share_group_delete_textures(struct apple_glx_share_group *g,
+                                           GLsizei n, const GLuint * names);
+
+/* 
+ * These account the display lists generated, so that the names deleted
+ * which were never generated aren't counted.
+ */
+void apple_glx_share_group_gen_lists(struct apple_glx_share_group *g,
+                                     GLuint first, GLsizei range);
+void apple_glx_share_group_delete_lists(struct apple_glx_share_group *g,
+                                        GLuint first, GLsizei range);
+
+/* This reports the accounting with apple_glx_diagnostic. */
+void apple_glx_share_group_report(struct apple_glx_share_group *g);
+
+#endif
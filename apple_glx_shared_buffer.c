@@ -0,0 +1,276 @@
+/*
+ Copyright (c) 2009 Apple Inc.
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction,
+ including without limitation the rights to use, copy, modify, merge,
+ publish, distribute, sublicense, and/or sell copies of the Software,
+ and to permit persons to whom the Software is furnished to do so,
+ subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT.  IN NO EVENT SHALL THE ABOVE LISTED COPYRIGHT
+ HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ 
+ Except as contained in this notice, the name(s) of the above
+ copyright holders shall not be used in advertising or otherwise to
+ promote the sale, use or other dealings in this Software without
+ prior written authorization.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "appledri_xcb.h"
+#include "apple_glx_shared_buffer.h"
+
+/* Return true if an error occurred. */
+static bool
+map_buffer(struct apple_glx_shared_buffer *sb)
+{
+   xcb_appledri_create_shared_buffer_reply_t *r;
+   void *buffer;
+   size_t length;
+   int fd;
+
+   r = xcb_appledri_create_shared_buffer_reply(sb->connection,
+      xcb_appledri_create_shared_buffer_unchecked(sb->connection, sb->screen,
+                                                  sb->drawable, 1), NULL);
+
+   if (NULL == r || 0 == r->string_length
+       || r->string_length > sizeof(sb->path) || 0 == r->width
+       || 0 == r->height) {
+      free(r);
+      return true;
+   }
+
+   memcpy(sb->path, xcb_appledri_create_shared_buffer_path(r),
+          r->string_length);
+   sb->path[r->string_length - 1] = '\0';
+   sb->width = r->width;
+   sb->height = r->height;
+   sb->row_bytes = sb->width * 4;
+   free(r);
+
+   length = (size_t) sb->row_bytes * sb->height * 2;
+
+   fd = shm_open(sb->path, O_RDWR, 0);
+
+   if (fd < 0) {
+      perror("shm_open");
+      return true;
+   }
+
+   buffer = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_FILE | MAP_SHARED,
+                 fd, 0);
+
+   /* The mapping holds the memory. */
+   if (-1 == close(fd))
+      perror("close");
+
+   if (MAP_FAILED == buffer) {
+      perror("mmap");
+      return true;
+   }
+
+   sb->buffer = buffer;
+   sb->buffer_length = length;
+   sb->back = 0;
+   sb->presented[0] = false;
+   sb->presented[1] = false;
+
+   return false;
+}
+
+static void
+unmap_buffer(struct apple_glx_shared_buffer *sb)
+{
+   if (NULL == sb->buffer)
+      return;
+
+   if (munmap(sb->buffer, sb->buffer_length))
+      perror("munmap");
+
+   if (shm_unlink(sb->path))
+      perror("shm_unlink");
+
+   sb->buffer = NULL;
+   sb->buffer_length = 0;
+}
+
+bool
+apple_glx_shared_buffer_create(struct apple_glx_shared_buffer *sb,
+                               xcb_connection_t * c, int screen,
+                               xcb_drawable_t drawable)
+{
+   sb->connection = c;
+   sb->screen = screen;
+   sb->drawable = drawable;
+   sb->buffer = NULL;
+   sb->buffer_length = 0;
+   sb->geometry_pending = false;
+
+   return map_buffer(sb);
+}
+
+void
+apple_glx_shared_buffer_destroy(struct apple_glx_shared_buffer *sb)
+{
+   if (sb->geometry_pending) {
+      xcb_discard_reply(sb->connection, sb->geometry_cookie.sequence);
+      sb->geometry_pending = false;
+   }
+
+   unmap_buffer(sb);
+}
+
+static bool
+is_empty(const xcb_rectangle_t * r)
+{
+   return 0 == r->width || 0 == r->height;
+}
+
+/* Clip r to the width and height of the buffer. */
+static xcb_rectangle_t
+clip(struct apple_glx_shared_buffer *sb, const xcb_rectangle_t * r)
+{
+   xcb_rectangle_t result = { 0, 0, 0, 0 };
+   int x1 = r->x, y1 = r->y;
+   int x2 = x1 + r->width, y2 = y1 + r->height;
+
+   if (x1 < 0)
+      x1 = 0;
+
+   if (y1 < 0)
+      y1 = 0;
+
+   if (x2 > sb->width)
+      x2 = sb->width;
+
+   if (y2 > sb->height)
+      y2 = sb->height;
+
+   if (x1 < x2 && y1 < y2) {
+      result.x = x1;
+      result.y = y1;
+      result.width = x2 - x1;
+      result.height = y2 - y1;
+   }
+
+   return result;
+}
+
+/* Return true if the window was resized since the last swap. */
+static bool
+window_resized(struct apple_glx_shared_buffer *sb)
+{
+   xcb_get_geometry_reply_t *geometry;
+   bool resized = false;
+
+   if (!sb->geometry_pending)
+      return false;
+
+   sb->geometry_pending = false;
+
+   geometry = xcb_get_geometry_reply(sb->connection, sb->geometry_cookie,
+                                     NULL);
+
+   if (geometry) {
+      resized = (geometry->width != sb->width
+                 || geometry->height != sb->height);
+      free(geometry);
+   }
+
+   return resized;
+}
+
+/* Copy rect of the front image to the back image. */
+static void
+copy_front(struct apple_glx_shared_buffer *sb, const xcb_rectangle_t * rect)
+{
+   size_t image_length = (size_t) sb->row_bytes * sb->height;
+   size_t offset = (size_t) rect->y * sb->row_bytes + rect->x * 4;
+   char *back = (char *) sb->buffer + sb->back * image_length + offset;
+   char *front = (char *) sb->buffer + !sb->back * image_length + offset;
+   int y;
+
+   for (y = 0; y < rect->height; ++y) {
+      memcpy(back, front, (size_t) rect->width * 4);
+      back += sb->row_bytes;
+      front += sb->row_bytes;
+   }
+}
+
+bool
+apple_glx_shared_buffer_swap(struct apple_glx_shared_buffer *sb,
+                             const xcb_rectangle_t * damage,
+                             apple_glx_shared_buffer_copy_func copy,
+                             void *closure, bool * resized)
+{
+   xcb_rectangle_t full = { 0, 0, 0, 0 };
+   xcb_rectangle_t clipped;
+   size_t image_length;
+
+   *resized = false;
+
+   if (NULL == sb->buffer)
+      return true;
+
+   full.width = sb->width;
+   full.height = sb->height;
+   clipped = damage ? clip(sb, damage) : full;
+
+   /* 
+    * Bring the back image up to date with the front image, so that only
+    * the damage has to be copied from the GL.
+    */
+   if (sb->presented[sb->back])
+      copy_front(sb, &sb->previous_damage);
+   else if (sb->presented[!sb->back])
+      copy_front(sb, &full);
+   else
+      clipped = full;
+
+   if (!is_empty(&clipped)) {
+      image_length = (size_t) sb->row_bytes * sb->height;
+      copy(closure, (char *) sb->buffer + sb->back * image_length,
+           sb->row_bytes, sb->height, &clipped);
+   }
+
+   xcb_appledri_swap_buffers(sb->connection, sb->screen, sb->drawable);
+
+   sb->presented[sb->back] = true;
+   sb->previous_damage = clipped;
+   sb->back = !sb->back;
+
+   if (window_resized(sb)) {
+      unmap_buffer(sb);
+
+      if (map_buffer(sb))
+         return true;
+
+      *resized = true;
+   }
+
+   /* The reply is collected by the next swap. */
+   sb->geometry_cookie = xcb_get_geometry_unchecked(sb->connection,
+                                                    sb->drawable);
+   sb->geometry_pending = true;
+
+   xcb_flush(sb->connection);
+
+   return false;
+}
@@ -0,0 +1,114 @@
+/*
+ Copyright (c) 2009 Apple Inc.
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction,
+ including without limitation the rights to use, copy, modify, merge,
+ publish, distribute, sublicense, and/or sell copies of the Software,
+ and to permit persons to whom the Software is furnished to do so,
+ subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT.  IN NO EVENT SHALL THE ABOVE LISTED COPYRIGHT
+ HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ 
+ Except as contained in this notice, the name(s) of the above
+ copyright holders shall not be used in advertising or otherwise to
+ promote the sale, use or other dealings in this Software without
+ prior written authorization.
+*/
+
+#ifndef APPLE_GLX_SHARED_BUFFER_H
+#define APPLE_GLX_SHARED_BUFFER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <limits.h>
+#include <xcb/xcb.h>
+
+/*
+ * The shared buffer present mode.
+ *
+ * When LIBGL_SHARED_BUFFER is set, a window renders to a pbuffer rather
+ * than an Xplugin surface, and each swap copies the result into shared
+ * memory created by the AppleDRI CreateSharedBuffer request.  The server
+ * then puts it in the window with the SwapBuffers request, in order with
+ * the X drawing of the client.
+ *
+ * The buffer is double buffered: the shared memory holds two images of
+ * row_bytes * height bytes, one after the other.  Each swap presents the
+ * back image, and the other one becomes the back image.
+ *
+ * A swap may be limited to a damaged rectangle, as by
+ * glXCopySubBufferMESA.  The back image is first brought up to date by
+ * copying what the last swap changed from the front image, so only the
+ * damage is copied from the GL, and the rest of the window is unchanged.
+ * An image is copied in full from the GL when nothing was presented yet.
+ *
+ * The size of the window is requested at each swap, and the reply is
+ * collected at the next swap, so a resize never waits for the server.
+ * The buffer is recreated at the new size after the swap that notices it.
+ *
+ * These only use the XCB connection, and the caller must know that the
+ * AppleDRI extension is present.
+ */
+
+struct apple_glx_shared_buffer
+{
+   xcb_connection_t *connection;
+   int screen;
+   xcb_drawable_t drawable;
+
+   int width, height;
+   int row_bytes;
+   char path[PATH_MAX];
+   void *buffer;                /* Both images. */
+   size_t buffer_length;
+
+   int back;                    /* The image rendered to: 0 or 1. */
+   bool presented[2];
+   xcb_rectangle_t previous_damage;
+
+   bool geometry_pending;
+   xcb_get_geometry_cookie_t geometry_cookie;
+};
+
+/* 
+ * This copies the rectangle of the rendered image to the same rectangle
+ * of the back image at dest.  The rectangle is in X coordinates, with the
+ * origin at the top left.
+ */
+typedef void (*apple_glx_shared_buffer_copy_func) (void *closure,
+                                                   void *dest,
+                                                   int row_bytes, int height,
+                                                   const xcb_rectangle_t *
+                                                   rect);
+
+/* Return true if an error occurred. */
+bool apple_glx_shared_buffer_create(struct apple_glx_shared_buffer *sb,
+                                    xcb_connection_t * c, int screen,
+                                    xcb_drawable_t drawable);
+
+void apple_glx_shared_buffer_destroy(struct apple_glx_shared_buffer *sb);
+
+/* 
+ * Copy the damage of the swap with copy, and present the back image.
+ * A NULL damage is the whole window.  *resized is set if the buffer was
+ * recreated at a new size for the next swap.
+ * Return true if an error occurred.
+ */
+bool apple_glx_shared_buffer_swap(struct apple_glx_shared_buffer *sb,
+                                  const xcb_rectangle_t * damage,
+                                  apple_glx_shared_buffer_copy_func copy,
+                                  void *closure, bool * resized);
+
+#endif
@@ -27,10 +27,19 @@
  prior written authorization.
 */
 #include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <X11/Xlib-xcb.h>
 #include "glxclient.h"
 #include "apple_glx.h"
+#include "apple_cgl.h"
 #include "appledri.h"
+#include "apple_glx_display.h"
 #include "apple_glx_drawable.h"
+#include "apple_xgl_api.h"
+
+extern struct apple_xgl_api __gl_api;
 
 static bool surface_make_current(struct apple_glx_context *ac,
                                  struct apple_glx_drawable *d);
@@ -44,19 +53,229 @@ static struct apple_glx_drawable_callbacks callbacks = {
    .destroy = surface_destroy
 };
 
+static pthread_once_t options_once = PTHREAD_ONCE_INIT;
+static bool eager_enabled = false;
+static bool shared_enabled = false;
+
+static void
+init_options(void)
+{
+   eager_enabled = (getenv("LIBGL_EAGER_SURFACES") != NULL);
+   shared_enabled = (getenv("LIBGL_SHARED_BUFFER") != NULL);
+}
+
+/* 
+ * The caller must hold a reference to d.  The geometry is only requested
+ * from the server if the cached geometry has been invalidated.
+ */
 static void
-update_viewport_and_scissor(Display * dpy, GLXDrawable drawable)
+get_geometry(struct apple_glx_drawable *d, unsigned int *width,
+             unsigned int *height)
 {
+   struct apple_glx_surface *s = &d->types.surface;
+   unsigned int generation, bd, depth;
    Window root;
    int x, y;
-   unsigned int width = 0, height = 0, bd, depth;
 
-   XGetGeometry(dpy, drawable, &root, &x, &y, &width, &height, &bd, &depth);
+   d->lock(d);
+
+   if (s->geometry_valid) {
+      *width = s->width;
+      *height = s->height;
+      d->unlock(d);
+      return;
+   }
+
+   generation = s->geometry_generation;
+
+   d->unlock(d);
+
+   *width = 0;
+   *height = 0;
+
+   if (!XGetGeometry(d->display, d->drawable, &root, &x, &y, width, height,
+                     &bd, &depth))
+      return;
+
+   d->lock(d);
+
+   if (generation == s->geometry_generation) {
+      s->width = *width;
+      s->height = *height;
+      s->geometry_valid = true;
+   }
+
+   d->unlock(d);
+}
+
+static void
+update_viewport_and_scissor(struct apple_glx_drawable *d)
+{
+   unsigned int width, height;
+
+   get_geometry(d, &width, &height);
 
    glViewport(0, 0, width, height);
    glScissor(0, 0, width, height);
 }
 
+static void *
+import_thread(void *arg)
+{
+   struct apple_glx_surface *s = arg;
+
+   s->import_error = xp_import_surface(s->key, &s->surface_id);
+
+   return NULL;
+}
+
+/* 
+ * Wait for an xp_import_surface in progress, if any.
+ * Return true if the surface couldn't be imported.
+ */
+static bool
+finish_import(struct apple_glx_drawable *d)
+{
+   struct apple_glx_surface *s = &d->types.surface;
+   bool failed;
+   int err;
+
+   d->lock(d);
+
+   if (s->importing) {
+      err = pthread_join(s->import_thread, NULL);
+
+      if (err) {
+         fprintf(stderr, "pthread_join error: %d\n", err);
+         abort();
+      }
+
+      s->importing = false;
+
+      if (s->import_error) {
+         fprintf(stderr, "error: xp_import_surface returned: %d\n",
+                 s->import_error);
+      }
+      else {
+         apple_glx_diagnostic("%s: imported surface %u for drawable 0x%lx\n",
+                              __func__, s->surface_id, d->drawable);
+      }
+   }
+
+   failed = (s->import_error != 0);
+
+   d->unlock(d);
+
+   return failed;
+}
+
+static bool
+shared_buffers(void)
+{
+   pthread_once(&options_once, init_options);
+
+   return shared_enabled;
+}
+
+/* Return true if an error occurred. */
+static bool
+create_shared_pbuffer(struct apple_glx_surface *s)
+{
+   CGLError err;
+
+   err = apple_cgl.create_pbuffer(s->shared_buffer.width,
+                                  s->shared_buffer.height,
+                                  GL_TEXTURE_RECTANGLE_EXT, GL_RGBA, 0,
+                                  &s->pbuffer_obj);
+
+   if (kCGLNoError != err) {
+      fprintf(stderr, "create_pbuffer: %s\n", apple_cgl.error_string(err));
+      s->pbuffer_obj = NULL;
+      return true;
+   }
+
+   s->width = s->shared_buffer.width;
+   s->height = s->shared_buffer.height;
+   s->geometry_valid = true;
+   s->geometry_generation++;
+   s->pbuffer_generation++;
+
+   return false;
+}
+
+/* Return true if an error occurred.  The lock of d must be held. */
+static bool
+attach_shared_pbuffer(struct apple_glx_context *ac,
+                      struct apple_glx_surface *s)
+{
+   CGLError err;
+
+   err = apple_cgl.set_pbuffer(ac->context_obj, s->pbuffer_obj, 0, 0, 0);
+
+   if (kCGLNoError != err) {
+      fprintf(stderr, "set_pbuffer: %s\n", apple_cgl.error_string(err));
+      return true;
+   }
+
+   ac->shared_generation = s->pbuffer_generation;
+
+   return false;
+}
+
+/* Return true if an error occurred. */
+static bool
+create_shared(Display * dpy, int screen, struct apple_glx_drawable *d)
+{
+   struct apple_glx_surface *s = &d->types.surface;
+
+   if (apple_glx_shared_buffer_create(&s->shared_buffer,
+                                      XGetXCBConnection(dpy), screen,
+                                      d->drawable))
+      return true;
+
+   if (create_shared_pbuffer(s)) {
+      apple_glx_shared_buffer_destroy(&s->shared_buffer);
+      return true;
+   }
+
+   s->shared = true;
+
+   apple_glx_diagnostic("%s: created a %dx%d shared buffer for drawable "
+                        "0x%lx\n", __func__, s->width, s->height,
+                        d->drawable);
+
+   return false;
+}
+
+static bool
+shared_make_current(struct apple_glx_context *ac,
+                    struct apple_glx_drawable *d)
+{
+   struct apple_glx_surface *s = &d->types.surface;
+   unsigned int width, height;
+   bool error;
+
+   /* The pbuffer replaces the surface attached to the context_obj. */
+   ac->attached_surface = 0;
+
+   d->lock(d);
+   error = attach_shared_pbuffer(ac, s);
+   width = s->width;
+   height = s->height;
+   d->unlock(d);
+
+   if (error)
+      return true;
+
+   if (!ac->made_current) {
+      glViewport(0, 0, width, height);
+      glScissor(0, 0, width, height);
+      ac->made_current = true;
+   }
+
+   return false;
+}
+
 static bool
 surface_make_current(struct apple_glx_context *ac,
                      struct apple_glx_drawable *d)
@@ -66,14 +285,26 @@ surface_make_current(struct apple_glx_context *ac,
 
    assert(APPLE_GLX_DRAWABLE_SURFACE == d->type);
 
+   if (s->shared)
+      return shared_make_current(ac, d);
+
+   if (finish_import(d))
+      return true;
+
    apple_glx_diagnostic("%s: ac->context_obj %p s->surface_id %u\n",
                         __func__, (void *) ac->context_obj, s->surface_id);
 
-   error = xp_attach_gl_context(ac->context_obj, s->surface_id);
+   if (ac->attached_surface != s->surface_id) {
+      error = xp_attach_gl_context(ac->context_obj, s->surface_id);
 
-   if (error) {
-      fprintf(stderr, "error: xp_attach_gl_context returned: %d\n", error);
-      return true;
+      if (error) {
+         ac->attached_surface = 0;
+         fprintf(stderr, "error: xp_attach_gl_context returned: %d\n",
+                 error);
+         return true;
+      }
+
+      ac->attached_surface = s->surface_id;
    }
 
 
@@ -82,8 +313,7 @@ surface_make_current(struct apple_glx_context *ac,
        * The first time a new context is made current the glViewport
        * and glScissor should be updated.
        */
-      update_viewport_and_scissor(ac->drawable->display,
-                                  ac->drawable->drawable);
+      update_viewport_and_scissor(d);
       ac->made_current = true;
    }
 
@@ -97,20 +327,38 @@ surface_destroy(Display * dpy, struct apple_glx_drawable *d)
 {
    struct apple_glx_surface *s = &d->types.surface;
 
+   if (s->shared) {
+      if (s->pbuffer_obj)
+         (void) apple_cgl.destroy_pbuffer(s->pbuffer_obj);
+
+      apple_glx_shared_buffer_destroy(&s->shared_buffer);
+
+      apple_glx_diagnostic("%s: destroyed the shared buffer for drawable "
+                           "0x%lx\n", __func__, d->drawable);
+      return;
+   }
+
    apple_glx_diagnostic("%s: s->surface_id %u\n", __func__, s->surface_id);
 
-   xp_error error = xp_destroy_surface(s->surface_id);
+   if (!finish_import(d)) {
+      xp_error error;
+
+      apple_glx_context_surface_destroyed(d->display, s->surface_id);
+
+      error = xp_destroy_surface(s->surface_id);
 
-   if (error) {
-      fprintf(stderr, "xp_destroy_surface error: %d\n", (int) error);
+      if (error) {
+         fprintf(stderr, "xp_destroy_surface error: %d\n", (int) error);
+      }
    }
 
    /* 
     * Check if this surface destroy came from the surface being destroyed
     * on the server.  If s->pending_destroy is true, then it did, and 
-    * we don't want to try to destroy the surface on the server.
+    * we don't want to try to destroy the surface on the server.  The
+    * surfaces of a closed Display were destroyed with the connection.
     */
-   if (!s->pending_destroy) {
+   if (!s->pending_destroy && !apple_glx_display_is_closed(d->glx_display)) {
       /*
        * Warning: this causes other routines to be called (potentially)
        * from surface_notify_handler.  It's probably best to not have
@@ -125,14 +373,20 @@ surface_destroy(Display * dpy, struct apple_glx_drawable *d)
    }
 }
 
-/* Return true if an error occured. */
+/* 
+ * Return true if an error occured.
+ * If async is true, the xp_import_surface is done by the import_thread.
+ */
 static bool
-create_surface(Display * dpy, int screen, struct apple_glx_drawable *d)
+create_surface(Display * dpy, int screen, struct apple_glx_drawable *d,
+               bool async)
 {
    struct apple_glx_surface *s = &d->types.surface;
-   unsigned int key[2];
    xp_client_id id;
+   Bool geometry_valid;
+   int err;
 
+   /* Xplugin is initialized by the first surface. */
    id = apple_glx_get_client_id();
    if (0 == id)
       return true;
@@ -140,14 +394,42 @@ create_surface(Display * dpy, int screen, struct apple_glx_drawable *d)
    assert(None != d->drawable);
 
    s->pending_destroy = false;
+   s->geometry_valid = false;
+   s->geometry_generation = 0;
+   s->importing = false;
+   s->import_error = 0;
+   s->shared = false;
+   s->pbuffer_obj = NULL;
+   s->pbuffer_generation = 0;
+
+   if (shared_buffers())
+      return create_shared(dpy, screen, d);
+
+   if (XAppleDRICreateSurfaceWithGeometry(dpy, screen, d->drawable, id,
+                                          s->key, &s->uid, &s->width,
+                                          &s->height, &geometry_valid)) {
+      s->geometry_valid = geometry_valid;
+
+      if (async) {
+         err = pthread_create(&s->import_thread, NULL, import_thread, s);
+
+         if (0 == err) {
+            s->importing = true;
+
+            apple_glx_diagnostic("%s: importing a surface for drawable 0x%lx"
+                                 " with uid %u\n", __func__, d->drawable,
+                                 s->uid);
+            return false;
+         }
+
+         /* Fall back to importing in this thread. */
+      }
 
-   if (XAppleDRICreateSurface(dpy, screen, d->drawable, id, key, &s->uid)) {
-      xp_error error;
-
-      error = xp_import_surface(key, &s->surface_id);
+      s->import_error = xp_import_surface(s->key, &s->surface_id);
 
-      if (error) {
-         fprintf(stderr, "error: xp_import_surface returned: %d\n", error);
+      if (s->import_error) {
+         fprintf(stderr, "error: xp_import_surface returned: %d\n",
+                 s->import_error);
          return true;
       }
 
@@ -173,7 +455,7 @@ apple_glx_surface_create(Display * dpy, int screen,
 
    /* apple_glx_drawable_create creates a locked and referenced object. */
 
-   if (create_surface(dpy, screen, d)) {
+   if (create_surface(dpy, screen, d, false)) {
       d->unlock(d);
       d->destroy(d);
       return true;
@@ -186,6 +468,47 @@ apple_glx_surface_create(Display * dpy, int screen,
    return false;
 }
 
+static bool
+eager_surfaces(void)
+{
+   (void) pthread_once(&options_once, init_options);
+
+   return eager_enabled;
+}
+
+bool
+apple_glx_surface_create_eager(Display * dpy, int screen,
+                               GLXDrawable drawable)
+{
+   struct apple_glx_drawable *d;
+
+   if (!eager_surfaces())
+      return false;
+
+   d = apple_glx_drawable_find(dpy, drawable, 0);
+
+   if (d)
+      return false;             /* A drawable already exists. */
+
+   if (apple_glx_drawable_create(dpy, screen, drawable, &d, &callbacks))
+      return true;
+
+   /* 
+    * The reference from apple_glx_drawable_create is kept, just like the 
+    * extra reference make current keeps for a new surface.  It's released
+    * when the server destroys the surface (see apple_glx_surface_destroy).
+    */
+   if (create_surface(dpy, screen, d, true)) {
+      d->unlock(d);
+      d->destroy(d);
+      return true;
+   }
+
+   d->unlock(d);
+
+   return false;
+}
+
 /*
  * All surfaces are reference counted, and surfaces are only created
  * when the window is made current.  When all contexts no longer reference
@@ -197,11 +520,11 @@ apple_glx_surface_create(Display * dpy, int screen,
  * apple_glx_context_update.
  */
 void
-apple_glx_surface_destroy(unsigned int uid)
+apple_glx_surface_destroy(Display * dpy, unsigned int uid)
 {
    struct apple_glx_drawable *d;
 
-   d = apple_glx_drawable_find_by_uid(uid, APPLE_GLX_DRAWABLE_REFERENCE
+   d = apple_glx_drawable_find_by_uid(dpy, uid, APPLE_GLX_DRAWABLE_REFERENCE
                                       | APPLE_GLX_DRAWABLE_LOCK);
 
    if (d) {
@@ -222,3 +545,162 @@ apple_glx_surface_destroy(unsigned int uid)
       d->unlock(d);
    }
 }
+
+bool
+apple_glx_surface_query(Display * dpy, GLXDrawable drawable, int attribute,
+                        unsigned int *value)
+{
+   struct apple_glx_drawable *d;
+   unsigned int width, height;
+   bool result = false;
+
+   if (GLX_WIDTH != attribute && GLX_HEIGHT != attribute)
+      return false;
+
+   /* Invalidate the geometry of any surfaces changed since the last call. */
+   apple_glx_process_surface_changes(apple_glx_display_find(dpy));
+
+   d = apple_glx_drawable_find_by_type(dpy, drawable,
+                                       APPLE_GLX_DRAWABLE_SURFACE,
+                                       APPLE_GLX_DRAWABLE_REFERENCE);
+
+   if (d) {
+      get_geometry(d, &width, &height);
+
+      *value = (GLX_WIDTH == attribute) ? width : height;
+      result = true;
+
+      /* Release the reference from the find. */
+      d->destroy(d);
+   }
+
+   return result;
+}
+
+void
+apple_glx_surface_invalidate_geometry(Display * dpy, unsigned int uid)
+{
+   struct apple_glx_drawable *d;
+
+   d = apple_glx_drawable_find_by_uid(dpy, uid, APPLE_GLX_DRAWABLE_LOCK);
+
+   if (d) {
+      d->types.surface.geometry_valid = false;
+      d->types.surface.geometry_generation++;
+      d->unlock(d);
+   }
+}
+
+/* 
+ * Copy rect of the pbuffer of the current context to dest, which has the
+ * rows of the X image from the top down.  glReadPixels to client memory
+ * returns after the pixels are written, even with the multithreaded engine,
+ * so dest can be used right away.
+ */
+static void
+read_back(void *closure, void *dest, int row_bytes, int height,
+          const xcb_rectangle_t * rect)
+{
+   size_t length = (size_t) rect->width * 4;
+   char *first, *last, *row;
+
+   (void) closure;
+
+   first = (char *) dest + (size_t) rect->y * row_bytes + rect->x * 4;
+
+   __gl_api.PushClientAttrib(GL_CLIENT_PIXEL_STORE_BIT);
+   __gl_api.PixelStorei(GL_PACK_ROW_LENGTH, row_bytes / 4);
+   __gl_api.PixelStorei(GL_PACK_ALIGNMENT, 4);
+   __gl_api.PixelStorei(GL_PACK_SKIP_PIXELS, 0);
+   __gl_api.PixelStorei(GL_PACK_SKIP_ROWS, 0);
+   __gl_api.PixelStorei(GL_PACK_SWAP_BYTES, GL_FALSE);
+   __gl_api.ReadPixels(rect->x, height - rect->y - rect->height, rect->width,
+                       rect->height, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV,
+                       first);
+   __gl_api.PopClientAttrib();
+
+   /* The GL rows are from the bottom up, so flip them in place. */
+   row = malloc(length);
+
+   if (NULL == row) {
+      perror("malloc");
+      return;
+   }
+
+   last = first + (size_t) (rect->height - 1) * row_bytes;
+
+   for (; first < last; first += row_bytes, last -= row_bytes) {
+      memcpy(row, first, length);
+      memcpy(first, last, length);
+      memcpy(last, row, length);
+   }
+
+   free(row);
+}
+
+bool
+apple_glx_surface_swap_shared(struct apple_glx_context *ac,
+                              struct apple_glx_drawable *d,
+                              const xcb_rectangle_t * damage)
+{
+   struct apple_glx_surface *s = &d->types.surface;
+   bool resized, error = false;
+
+   if (APPLE_GLX_DRAWABLE_SURFACE != d->type || !s->shared)
+      return true;
+
+   d->lock(d);
+
+   /* Another context may have replaced the pbuffer this reads back. */
+   if (ac->shared_generation != s->pbuffer_generation
+       && attach_shared_pbuffer(ac, s)) {
+      d->unlock(d);
+      return true;
+   }
+
+   if (apple_glx_shared_buffer_swap(&s->shared_buffer, damage, read_back,
+                                    NULL, &resized)) {
+      d->unlock(d);
+      return true;
+   }
+
+   if (resized) {
+      /* 
+       * The contents are lost, and the next swap copies everything.  The
+       * other contexts attach the new pbuffer when they see the
+       * generation change.
+       */
+      (void) apple_cgl.destroy_pbuffer(s->pbuffer_obj);
+
+      if (create_shared_pbuffer(s) || attach_shared_pbuffer(ac, s))
+         error = true;
+
+      apple_glx_diagnostic("%s: resized the shared buffer of drawable 0x%lx"
+                           " to %dx%d\n", __func__, d->drawable, s->width,
+                           s->height);
+   }
+
+   d->unlock(d);
+
+   return error;
+}
+
+bool
+apple_glx_surface_attach_shared(struct apple_glx_context *ac,
+                                struct apple_glx_drawable *d)
+{
+   struct apple_glx_surface *s = &d->types.surface;
+   bool error = false;
+
+   if (APPLE_GLX_DRAWABLE_SURFACE != d->type || !s->shared)
+      return false;
+
+   d->lock(d);
+
+   if (s->pbuffer_obj && ac->shared_generation != s->pbuffer_generation)
+      error = attach_shared_pbuffer(ac, s);
+
+   d->unlock(d);
+
+   return error;
+}
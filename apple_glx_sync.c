@@ -0,0 +1,399 @@
+/*
+ Copyright (c) 2009 Apple Inc.
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction,
+ including without limitation the rights to use, copy, modify, merge,
+ publish, distribute, sublicense, and/or sell copies of the Software,
+ and to permit persons to whom the Software is furnished to do so,
+ subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT.  IN NO EVENT SHALL THE ABOVE LISTED COPYRIGHT
+ HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ 
+ Except as contained in this notice, the name(s) of the above
+ copyright holders shall not be used in advertising or otherwise to
+ promote the sale, use or other dealings in this Software without
+ prior written authorization.
+*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include "glxclient.h"
+#include "apple_glx.h"
+#include "apple_glx_context.h"
+#include "apple_glx_drawable.h"
+#include "apple_glx_sync.h"
+
+/* The refresh rate used if LIBGL_MSC_RATE isn't set. */
+#define DEFAULT_MSC_RATE 60
+
+static pthread_once_t rate_once = PTHREAD_ONCE_INIT;
+static int32_t rate_numerator = DEFAULT_MSC_RATE;
+static int32_t rate_denominator = 1;
+
+/* 
+ * This guards the sbc, swap_ust, swap_msc, and swaps_pending of every
+ * drawable.
+ * The sbc_cond is signaled whenever a swap completes.
+ */
+static pthread_mutex_t sbc_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sbc_cond = PTHREAD_COND_INITIALIZER;
+
+static void
+lock_sbc(void)
+{
+   int err;
+
+   err = pthread_mutex_lock(&sbc_lock);
+
+   if (err) {
+      fprintf(stderr, "pthread_mutex_lock failure in %s: %d\n",
+              __func__, err);
+      abort();
+   }
+}
+
+static void
+unlock_sbc(void)
+{
+   int err;
+
+   err = pthread_mutex_unlock(&sbc_lock);
+
+   if (err) {
+      fprintf(stderr, "pthread_mutex_unlock failure in %s: %d\n",
+              __func__, err);
+      abort();
+   }
+}
+
+static void
+init_rate(void)
+{
+   const char *s = getenv("LIBGL_MSC_RATE");
+   long n, d = 1;
+   char *end;
+
+   if (NULL == s)
+      return;
+
+   n = strtol(s, &end, 10);
+
+   if ('/' == *end)
+      d = strtol(end + 1, &end, 10);
+
+   if (n <= 0 || d <= 0 || '\0' != *end) {
+      fprintf(stderr, "warning: invalid LIBGL_MSC_RATE: %s\n", s);
+      return;
+   }
+
+   rate_numerator = n;
+   rate_denominator = d;
+
+   apple_glx_diagnostic("%s: MSC rate is %d/%d\n", __func__,
+                        rate_numerator, rate_denominator);
+}
+
+bool
+apple_glx_get_msc_rate(int32_t * numerator, int32_t * denominator)
+{
+   (void) pthread_once(&rate_once, init_rate);
+
+   *numerator = rate_numerator;
+   *denominator = rate_denominator;
+
+   return true;
+}
+
+static int64_t
+ust_to_msc(int64_t ust)
+{
+   int32_t n, d;
+
+   apple_glx_get_msc_rate(&n, &d);
+
+   return (ust * n) / ((int64_t) d * 1000000);
+}
+
+/* Return the first UST that is within the msc. */
+static int64_t
+msc_to_ust(int64_t msc)
+{
+   int32_t n, d;
+   int64_t us;
+
+   apple_glx_get_msc_rate(&n, &d);
+
+   us = msc * d * 1000000;
+
+   return (us + n - 1) / n;
+}
+
+/* Return true if successful. */
+static bool
+get_ust_msc(int64_t * ust, int64_t * msc)
+{
+   if (__glXGetUST(ust))
+      return false;
+
+   *msc = ust_to_msc(*ust);
+
+   return true;
+}
+
+static void
+sleep_until(int64_t target_ust)
+{
+   struct timespec ts;
+   int64_t ust, delta;
+
+   while (0 == __glXGetUST(&ust) && ust < target_ust) {
+      delta = target_ust - ust;
+      ts.tv_sec = delta / 1000000;
+      ts.tv_nsec = (delta % 1000000) * 1000;
+
+      /* If this is interrupted the loop recomputes the delta. */
+      (void) nanosleep(&ts, NULL);
+   }
+}
+
+/* 
+ * This implements the target_msc, divisor, and remainder rules shared by
+ * glXSwapBuffersMscOML and glXWaitForMscOML.
+ */
+static int64_t
+compute_target_msc(int64_t current, int64_t target_msc, int64_t divisor,
+                   int64_t remainder)
+{
+   int64_t next;
+
+   if (current < target_msc)
+      return target_msc;
+
+   if (0 == divisor)
+      return current;
+
+   next = current - (current % divisor) + remainder;
+
+   if (next < current)
+      next += divisor;
+
+   return next;
+}
+
+static bool
+valid_msc_arguments(int64_t target_msc, int64_t divisor, int64_t remainder)
+{
+   if (target_msc < 0 || divisor < 0 || remainder < 0)
+      return false;
+
+   if (divisor > 0 && remainder >= divisor)
+      return false;
+
+   return true;
+}
+
+/* A drawable that hasn't been made current hasn't been swapped. */
+static int64_t
+get_sbc(Display * dpy, GLXDrawable drawable)
+{
+   struct apple_glx_drawable *d;
+   int64_t sbc = 0;
+
+   d = apple_glx_drawable_find(dpy, drawable, APPLE_GLX_DRAWABLE_LOCK);
+
+   if (d) {
+      lock_sbc();
+      sbc = d->sbc;
+      unlock_sbc();
+
+      d->unlock(d);
+   }
+
+   return sbc;
+}
+
+void
+apple_glx_sync_swap_begin(struct apple_glx_drawable *d)
+{
+   lock_sbc();
+   d->swaps_pending++;
+   unlock_sbc();
+}
+
+void
+apple_glx_sync_swap_complete(struct apple_glx_drawable *d)
+{
+   int64_t ust, msc;
+
+   if (!get_ust_msc(&ust, &msc))
+      ust = msc = 0;
+
+   lock_sbc();
+
+   d->sbc++;
+   d->swaps_pending--;
+   d->swap_ust = ust;
+   d->swap_msc = msc;
+
+   pthread_cond_broadcast(&sbc_cond);
+
+   unlock_sbc();
+}
+
+bool
+apple_glx_get_sync_values(Display * dpy, GLXDrawable drawable,
+                          int64_t * ust, int64_t * msc, int64_t * sbc)
+{
+   if (!get_ust_msc(ust, msc))
+      return false;
+
+   *sbc = get_sbc(dpy, drawable);
+
+   return true;
+}
+
+bool
+apple_glx_wait_for_msc(Display * dpy, GLXDrawable drawable,
+                       int64_t target_msc, int64_t divisor,
+                       int64_t remainder, int64_t * ust,
+                       int64_t * msc, int64_t * sbc)
+{
+   int64_t now_ust, now_msc, target;
+
+   if (!valid_msc_arguments(target_msc, divisor, remainder))
+      return false;
+
+   if (!get_ust_msc(&now_ust, &now_msc))
+      return false;
+
+   target = compute_target_msc(now_msc, target_msc, divisor, remainder);
+
+   if (target > now_msc)
+      sleep_until(msc_to_ust(target));
+
+   if (!get_ust_msc(ust, msc))
+      return false;
+
+   *sbc = get_sbc(dpy, drawable);
+
+   return true;
+}
+
+bool
+apple_glx_wait_for_sbc(Display * dpy, GLXDrawable drawable,
+                       int64_t target_sbc, int64_t * ust,
+                       int64_t * msc, int64_t * sbc)
+{
+   struct apple_glx_drawable *d;
+   int err;
+
+   if (target_sbc < 0)
+      return false;
+
+   /* Hold a reference, so that the drawable isn't freed while we wait. */
+   d = apple_glx_drawable_find(dpy, drawable, APPLE_GLX_DRAWABLE_REFERENCE);
+
+   if (NULL == d) {
+      /* 
+       * The drawable has never been made current, so it has never been
+       * swapped, and a swap can't be pending.
+       */
+      if (target_sbc > 0)
+         return false;
+
+      *sbc = 0;
+      return get_ust_msc(ust, msc);
+   }
+
+   lock_sbc();
+
+   while (d->sbc < target_sbc) {
+      /* 
+       * The swaps are issued synchronously, so only the swaps pending in
+       * other threads can reach target_sbc.  Without them this would
+       * never return.
+       */
+      if (d->sbc + d->swaps_pending < target_sbc) {
+         unlock_sbc();
+         d->destroy(d);
+         return false;
+      }
+
+      err = pthread_cond_wait(&sbc_cond, &sbc_lock);
+
+      if (err) {
+         fprintf(stderr, "pthread_cond_wait failure in %s: %d\n",
+                 __func__, err);
+         abort();
+      }
+   }
+
+   *sbc = d->sbc;
+
+   if (target_sbc > 0) {
+      *ust = d->swap_ust;
+      *msc = d->swap_msc;
+   }
+
+   unlock_sbc();
+
+   /* Release the reference from the find. */
+   d->destroy(d);
+
+   if (0 == target_sbc)
+      return get_ust_msc(ust, msc);
+
+   return true;
+}
+
+int64_t
+apple_glx_swap_buffers_msc(void *ptr, int64_t target_msc, int64_t divisor,
+                           int64_t remainder)
+{
+   struct apple_glx_context *ac = ptr;
+   int64_t ust, msc, target, sbc;
+
+   /* 
+    * The OML_sync_control spec says this should "generate a GLX_BAD_VALUE
+    * error", but it also says that it returns -1 for invalid arguments.
+    */
+   if (!valid_msc_arguments(target_msc, divisor, remainder))
+      return -1;
+
+   if (NULL == ac->drawable)
+      return -1;
+
+   if (!get_ust_msc(&ust, &msc))
+      return -1;
+
+   target = compute_target_msc(msc, target_msc, divisor, remainder);
+
+   /* The swap is pending while this waits for the target. */
+   apple_glx_sync_swap_begin(ac->drawable);
+
+   if (target > msc)
+      sleep_until(msc_to_ust(target));
+
+   apple_glx_swap_begun(ac);
+
+   lock_sbc();
+   sbc = ac->drawable->sbc;
+   unlock_sbc();
+
+   return sbc;
+}
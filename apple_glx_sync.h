@@ -0,0 +1,78 @@
+/*
+ Copyright (c) 2009 Apple Inc.
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction,
+ including without limitation the rights to use, copy, modify, merge,
+ publish, distribute, sublicense, and/or sell copies of the Software,
+ and to permit persons to whom the Software is furnished to do so,
+ subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT.  IN NO EVENT SHALL THE ABOVE LISTED COPYRIGHT
+ HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ 
+ Except as contained in this notice, the name(s) of the above
+ copyright holders shall not be used in advertising or otherwise to
+ promote the sale, use or other dealings in this Software without
+ prior written authorization.
+*/
+
+#ifndef APPLE_GLX_SYNC_H
+#define APPLE_GLX_SYNC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <X11/Xlib.h>
+#include <GL/glx.h>
+
+struct apple_glx_drawable;
+
+/*
+ * GLX_OML_sync_control support.
+ *
+ * The UST is from __glXGetUST().  The MSC is derived from the UST and
+ * the refresh rate, which may be overridden with LIBGL_MSC_RATE set to
+ * "hz" or "numerator/denominator" (for example "60000/1001").
+ * The SBC is counted per drawable by apple_glx_swap_buffers().
+ */
+
+bool apple_glx_get_msc_rate(int32_t * numerator, int32_t * denominator);
+
+/* These return true on success, like the OML functions. */
+bool apple_glx_get_sync_values(Display * dpy, GLXDrawable drawable,
+                               int64_t * ust, int64_t * msc, int64_t * sbc);
+
+bool apple_glx_wait_for_msc(Display * dpy, GLXDrawable drawable,
+                            int64_t target_msc, int64_t divisor,
+                            int64_t remainder, int64_t * ust,
+                            int64_t * msc, int64_t * sbc);
+
+bool apple_glx_wait_for_sbc(Display * dpy, GLXDrawable drawable,
+                            int64_t target_sbc, int64_t * ust,
+                            int64_t * msc, int64_t * sbc);
+
+/* 
+ * This waits for the MSC specified, and then swaps the current drawable
+ * of the context ptr.  It returns the SBC the swap will have, or -1.
+ */
+int64_t apple_glx_swap_buffers_msc(void *ptr, int64_t target_msc,
+                                   int64_t divisor, int64_t remainder);
+
+/* 
+ * These are called before a swap of d is issued, and after it has been
+ * issued.  A swap is pending in between.
+ */
+void apple_glx_sync_swap_begin(struct apple_glx_drawable *d);
+void apple_glx_sync_swap_complete(struct apple_glx_drawable *d);
+
+#endif
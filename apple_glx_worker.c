@@ -0,0 +1,262 @@
+/*
+ Copyright (c) 2009 Apple Inc.
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction,
+ including without limitation the rights to use, copy, modify, merge,
+ publish, distribute, sublicense, and/or sell copies of the Software,
+ and to permit persons to whom the Software is furnished to do so,
+ subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT.  IN NO EVENT SHALL THE ABOVE LISTED COPYRIGHT
+ HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ 
+ Except as contained in this notice, the name(s) of the above
+ copyright holders shall not be used in advertising or otherwise to
+ promote the sale, use or other dealings in this Software without
+ prior written authorization.
+*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "apple_glx.h"
+#include "apple_glx_worker.h"
+
+#define MAX_WORKERS 8
+
+static pthread_once_t options_once = PTHREAD_ONCE_INIT;
+static int worker_count = 0;    /* 0 is synchronous. */
+
+/* 
+ * The mutex protects the queue and the done flags of the jobs.  The
+ * queue_cond is signaled when a job is queued, and the done_cond is
+ * broadcast when a job is done.
+ */
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t done_cond = PTHREAD_COND_INITIALIZER;
+static struct apple_glx_job *head = NULL, *tail = NULL;
+static int workers_started = 0;
+
+static void
+init_options(void)
+{
+   const char *s;
+   char *end;
+   long n;
+
+   s = getenv("LIBGL_ASYNC_CONTEXT");
+
+   if (s) {
+      n = strtol(s, &end, 10);
+
+      if (n < 1 || '\0' != *end) {
+         fprintf(stderr, "warning: invalid LIBGL_ASYNC_CONTEXT: %s\n", s);
+      }
+      else {
+         if (n > MAX_WORKERS)
+            n = MAX_WORKERS;
+
+         worker_count = n;
+      }
+   }
+
+   apple_glx_diagnostic("%s: workers %d\n", __func__, worker_count);
+}
+
+int
+apple_glx_worker_count(void)
+{
+   (void) pthread_once(&options_once, init_options);
+
+   return worker_count;
+}
+
+static void
+lock_pool(void)
+{
+   int err;
+
+   err = pthread_mutex_lock(&pool_mutex);
+
+   if (err) {
+      fprintf(stderr, "pthread_mutex_lock failure in %s: %d\n",
+              __func__, err);
+      abort();
+   }
+}
+
+static void
+unlock_pool(void)
+{
+   int err;
+
+   err = pthread_mutex_unlock(&pool_mutex);
+
+   if (err) {
+      fprintf(stderr, "pthread_mutex_unlock failure in %s: %d\n",
+              __func__, err);
+      abort();
+   }
+}
+
+static void *
+worker_thread(void *arg)
+{
+   struct apple_glx_job *job;
+
+   (void) arg;
+
+   lock_pool();
+
+   for (;;) {
+      while (NULL == head)
+         pthread_cond_wait(&queue_cond, &pool_mutex);
+
+      job = head;
+      head = job->next;
+
+      if (NULL == head)
+         tail = NULL;
+
+      unlock_pool();
+
+      job->run(job->arg);
+
+      lock_pool();
+      job->done = true;
+      pthread_cond_broadcast(&done_cond);
+   }
+
+   return NULL;
+}
+
+/* 
+ * Start another worker, if fewer than requested were started.
+ * The pool is locked.
+ */
+static bool
+start_worker(void)
+{
+   pthread_attr_t attr;
+   pthread_t thread;
+   int err;
+
+   if (workers_started >= worker_count)
+      return false;
+
+   pthread_attr_init(&attr);
+   pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+   err = pthread_create(&thread, &attr, worker_thread, NULL);
+   pthread_attr_destroy(&attr);
+
+   if (err) {
+      fprintf(stderr, "pthread_create failure in %s: %d\n", __func__, err);
+      return true;
+   }
+
+   ++workers_started;
+
+   return false;
+}
+
+bool
+apple_glx_worker_submit(struct apple_glx_job *job,
+                        void (*run) (void *arg), void *arg)
+{
+   if (0 == apple_glx_worker_count())
+      return true;
+
+   job->run = run;
+   job->arg = arg;
+   job->done = false;
+   job->next = NULL;
+
+   lock_pool();
+
+   /* A worker is started for each job until there are enough. */
+   if (start_worker() && 0 == workers_started) {
+      unlock_pool();
+      return true;
+   }
+
+   if (tail)
+      tail->next = job;
+   else
+      head = job;
+
+   tail = job;
+
+   pthread_cond_signal(&queue_cond);
+   unlock_pool();
+
+   return false;
+}
+
+static void
+finish_job(struct apple_glx_job *job)
+{
+   lock_pool();
+   job->done = true;
+   pthread_cond_broadcast(&done_cond);
+   unlock_pool();
+}
+
+static void *
+job_thread(void *arg)
+{
+   struct apple_glx_job *job = arg;
+
+   job->run(job->arg);
+   finish_job(job);
+
+   return NULL;
+}
+
+void
+apple_glx_job_start(struct apple_glx_job *job,
+                    void (*run) (void *arg), void *arg)
+{
+   pthread_attr_t attr;
+   pthread_t thread;
+   int err;
+
+   job->run = run;
+   job->arg = arg;
+   job->done = false;
+   job->next = NULL;
+
+   pthread_attr_init(&attr);
+   pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+   err = pthread_create(&thread, &attr, job_thread, job);
+   pthread_attr_destroy(&attr);
+
+   if (err) {
+      fprintf(stderr, "pthread_create failure in %s: %d\n", __func__, err);
+      run(arg);
+      finish_job(job);
+   }
+}
+
+void
+apple_glx_worker_wait(struct apple_glx_job *job)
+{
+   lock_pool();
+
+   while (!job->done)
+      pthread_cond_wait(&done_cond, &pool_mutex);
+
+   unlock_pool();
+}
@@ -0,0 +1,74 @@
+/*
+ Copyright (c) 2009 Apple Inc.
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction,
+ including without limitation the rights to use, copy, modify, merge,
+ publish, distribute, sublicense, and/or sell copies of the Software,
+ and to permit persons to whom the Software is furnished to do so,
+ subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT.  IN NO EVENT SHALL THE ABOVE LISTED COPYRIGHT
+ HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ 
+ Except as contained in this notice, the name(s) of the above
+ copyright holders shall not be used in advertising or otherwise to
+ promote the sale, use or other dealings in this Software without
+ prior written authorization.
+*/
+
+#ifndef APPLE_GLX_WORKER_H
+#define APPLE_GLX_WORKER_H
+
+#include <stdbool.h>
+
+/*
+ * A pool of worker threads for expensive work that the application
+ * doesn't need to wait for right away, such as creating CGL contexts.
+ *
+ * LIBGL_ASYNC_CONTEXT is set to the number of workers (1 to 8).  When it
+ * isn't set, apple_glx_worker_count() is 0 and callers do the work
+ * synchronously.  The workers are started when the first job is
+ * submitted, and take the jobs in the order they were submitted.
+ */
+
+struct apple_glx_job
+{
+   void (*run) (void *arg);
+   void *arg;
+   bool done;                   /* Protected by the lock of the pool. */
+   struct apple_glx_job *next;
+};
+
+int apple_glx_worker_count(void);
+
+/* 
+ * Queue run(arg) to a worker.  The job must stay valid until
+ * apple_glx_worker_wait() returns.  Return true if no worker could be
+ * started, in which case the caller should run the job itself.
+ */
+bool apple_glx_worker_submit(struct apple_glx_job *job,
+                             void (*run) (void *arg), void *arg);
+
+/* 
+ * Run run(arg) on a thread of its own, whether or not there is a pool.
+ * This is for work done once, such as loading the OpenGL framework.  If
+ * no thread can be started, the job is run before this returns.
+ */
+void apple_glx_job_start(struct apple_glx_job *job,
+                         void (*run) (void *arg), void *arg);
+
+/* Wait for a submitted or started job to complete. */
+void apple_glx_worker_wait(struct apple_glx_job *job);
+
+#endif
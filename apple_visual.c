@@ -38,6 +38,7 @@
 #include "apple_cgl.h"
 #include "apple_visual.h"
 #include "apple_glx.h"
+#include "apple_glx_renderer.h"
 #include "glcontextmodes.h"
 
 enum
@@ -46,10 +47,11 @@ enum
 };
 
 /*mode is a __GlcontextModes*/
-void
+bool
 apple_visual_create_pfobj(CGLPixelFormatObj * pfobj, const void *mode,
                           bool * double_buffered, bool * uses_stereo,
-                          bool offscreen)
+                          int offscreen_bpp, int profile,
+                          GLint renderer_id)
 {
    CGLPixelFormatAttribute attr[MAX_ATTR];
    const __GLcontextModes *c = mode;
@@ -57,13 +59,16 @@ apple_visual_create_pfobj(CGLPixelFormatObj * pfobj, const void *mode,
    GLint vsref = 0;
    CGLError error = 0;
 
-   if (offscreen) {
+   /* Offscreen formats are always rendered by the software renderer. */
+   if (0 == renderer_id && !offscreen_bpp)
+      renderer_id = apple_glx_renderer_default_id();
+
+   if (offscreen_bpp) {
       apple_glx_diagnostic
-         ("offscreen rendering enabled.  Using kCGLPFAOffScreen\n");
+         ("offscreen rendering enabled.  Using kCGLPFAOffScreen with %d "
+          "bits per pixel\n", offscreen_bpp);
 
       attr[numattr++] = kCGLPFAOffScreen;
-      attr[numattr++] = kCGLPFAColorSize;
-      attr[numattr++] = 32;
    }
    else if (getenv("LIBGL_ALWAYS_SOFTWARE") != NULL) {
       apple_glx_diagnostic
@@ -71,12 +76,27 @@ apple_visual_create_pfobj(CGLPixelFormatObj * pfobj, const void *mode,
       attr[numattr++] = kCGLPFARendererID;
       attr[numattr++] = kCGLRendererGenericFloatID;
    }
-   else if (getenv("LIBGL_ALLOW_SOFTWARE") != NULL) {
-      apple_glx_diagnostic
-         ("Software rendering is not being excluded.  Not using kCGLPFAAccelerated.\n");
-   }
    else {
-      attr[numattr++] = kCGLPFAAccelerated;
+      if (renderer_id) {
+         apple_glx_diagnostic("Using the renderer with ID 0x%x.\n",
+                              (unsigned int) renderer_id);
+         /* 
+          * This only narrows the choice, so a software renderer is still
+          * excluded below.  The renderer may be a GPU that isn't driving
+          * a display.
+          */
+         attr[numattr++] = kCGLPFARendererID;
+         attr[numattr++] = renderer_id;
+         attr[numattr++] = kCGLPFAAllowOfflineRenderers;
+      }
+
+      if (getenv("LIBGL_ALLOW_SOFTWARE") != NULL) {
+         apple_glx_diagnostic
+            ("Software rendering is not being excluded.  Not using kCGLPFAAccelerated.\n");
+      }
+      else {
+         attr[numattr++] = kCGLPFAAccelerated;
+      }
    }
 
    /* 
@@ -86,6 +106,11 @@ apple_visual_create_pfobj(CGLPixelFormatObj * pfobj, const void *mode,
     */
    attr[numattr++] = kCGLPFAClosestPolicy;
 
+   if (profile) {
+      attr[numattr++] = APPLE_CGL_PFA_OPENGL_PROFILE;
+      attr[numattr++] = profile;
+   }
+
    if (c->stereoMode) {
       attr[numattr++] = kCGLPFAStereo;
       *uses_stereo = true;
@@ -102,10 +127,23 @@ apple_visual_create_pfobj(CGLPixelFormatObj * pfobj, const void *mode,
       *double_buffered = false;
    }
 
-   attr[numattr++] = kCGLPFAColorSize;
-   attr[numattr++] = c->redBits + c->greenBits + c->blueBits;
-   attr[numattr++] = kCGLPFAAlphaSize;
-   attr[numattr++] = c->alphaBits;
+   if (offscreen_bpp) {
+      /* 
+       * The format must match the layout of the pixmap memory, or CGL
+       * renders past the end of each row.  CGL renders 16 bits offscreen
+       * as x1-5-5-5, so a 16 bit pixmap has no room for alpha.
+       */
+      attr[numattr++] = kCGLPFAColorSize;
+      attr[numattr++] = offscreen_bpp;
+      attr[numattr++] = kCGLPFAAlphaSize;
+      attr[numattr++] = (16 == offscreen_bpp) ? 0 : c->alphaBits;
+   }
+   else {
+      attr[numattr++] = kCGLPFAColorSize;
+      attr[numattr++] = c->redBits + c->greenBits + c->blueBits;
+      attr[numattr++] = kCGLPFAAlphaSize;
+      attr[numattr++] = c->alphaBits;
+   }
 
    if ((c->accumRedBits + c->accumGreenBits + c->accumBlueBits) > 0) {
       attr[numattr++] = kCGLPFAAccumSize;
@@ -137,8 +175,16 @@ apple_visual_create_pfobj(CGLPixelFormatObj * pfobj, const void *mode,
 
    error = apple_cgl.choose_pixel_format(attr, pfobj, &vsref);
 
-   if (error) {
-      fprintf(stderr, "error: %s\n", apple_cgl.error_string(error));
-      abort();
+   /* 
+    * The caller reports the failure, because a profile or renderer that
+    * the system doesn't support is an expected error.
+    */
+   if (error || NULL == *pfobj) {
+      apple_glx_diagnostic("%s: unable to choose a pixel format: %s\n",
+                           __func__, apple_cgl.error_string(error));
+      *pfobj = NULL;
+      return true;
    }
+
+   return false;
 }
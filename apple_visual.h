@@ -32,10 +32,22 @@
 
 #include <stdbool.h>
 #include <OpenGL/CGLTypes.h>
+#include <OpenGL/gl.h>
 
 /* mode is expected to be of type __GLcontextModes. */
-void apple_visual_create_pfobj(CGLPixelFormatObj * pfobj, const void *mode,
+/* 
+ * offscreen_bpp is the bits per pixel of the memory an offscreen (pixmap)
+ * context renders to, or 0 for an onscreen format.
+ *
+ * profile is an APPLE_CGL_PROFILE_* value, or 0 for the default.
+ *
+ * renderer_id is a CGL renderer ID to use, or 0 for the default renderer.
+ *
+ * Returns true if an error occurred.
+ */
+bool apple_visual_create_pfobj(CGLPixelFormatObj * pfobj, const void *mode,
                                bool * double_buffered, bool * uses_stereo,
-                               bool offscreen);
+                               int offscreen_bpp, int profile,
+                               GLint renderer_id);
 
 #endif
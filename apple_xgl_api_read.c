@@ -37,6 +37,7 @@
 #include "apple_xgl_api_read.h"
 #include "apple_xgl_api.h"
 #include "apple_cgl.h"
+#include "apple_glx.h"
 #include "apple_glx_context.h"
 
 extern struct apple_xgl_api __gl_api;
@@ -101,6 +102,8 @@ glReadPixels(GLint x, GLint y, GLsizei width, GLsizei height,
 {
    struct apple_xgl_saved_state saved;
 
+   apple_glx_require_framework();
+
    SetRead(&saved);
 
    __gl_api.ReadPixels(x, y, width, height, format, type, pixels);
@@ -113,6 +116,8 @@ glCopyPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum type)
 {
    struct apple_xgl_saved_state saved;
 
+   apple_glx_require_framework();
+
    SetRead(&saved);
 
    __gl_api.CopyPixels(x, y, width, height, type);
@@ -126,6 +131,8 @@ glCopyColorTable(GLenum target, GLenum internalformat, GLint x, GLint y,
 {
    struct apple_xgl_saved_state saved;
 
+   apple_glx_require_framework();
+
    SetRead(&saved);
 
    __gl_api.CopyColorTable(target, internalformat, x, y, width);
@@ -0,0 +1,153 @@
+/*
+ Copyright (c) 2009 Apple Inc.
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction,
+ including without limitation the rights to use, copy, modify, merge,
+ publish, distribute, sublicense, and/or sell copies of the Software,
+ and to permit persons to whom the Software is furnished to do so,
+ subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT.  IN NO EVENT SHALL THE ABOVE LISTED COPYRIGHT
+ HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ 
+ Except as contained in this notice, the name(s) of the above
+ copyright holders shall not be used in advertising or otherwise to
+ promote the sale, use or other dealings in this Software without
+ prior written authorization.
+*/
+
+/*
+ * These entry points account the objects created by the current context
+ * to its share group.  The sizes are estimates based on the format and 
+ * type of the image, because the internal format chosen by the renderer
+ * isn't known.
+ */
+#include "apple_glx.h"
+#include "apple_glx_context.h"
+#include "apple_glx_share_group.h"
+#include "apple_xgl_api.h"
+#include "apple_xgl_api_share.h"
+
+extern struct apple_xgl_api __gl_api;
+
+static struct apple_glx_share_group *
+current_share_group(void)
+{
+   GLXContext gc = __glXGetCurrentContext();
+   struct apple_glx_context *ac;
+
+   if (NULL == gc || NULL == gc->apple)
+      return NULL;
+
+   ac = gc->apple;
+
+   return ac->share_group;
+}
+
+/* Return the binding query for target, or 0 for proxies. */
+static GLenum
+texture_binding(GLenum target)
+{
+   switch (target) {
+   case GL_TEXTURE_2D:
+      return GL_TEXTURE_BINDING_2D;
+
+   case GL_TEXTURE_RECTANGLE_ARB:
+      return GL_TEXTURE_BINDING_RECTANGLE_ARB;
+
+   case GL_TEXTURE_CUBE_MAP_POSITIVE_X:
+   case GL_TEXTURE_CUBE_MAP_NEGATIVE_X:
+   case GL_TEXTURE_CUBE_MAP_POSITIVE_Y:
+   case GL_TEXTURE_CUBE_MAP_NEGATIVE_Y:
+   case GL_TEXTURE_CUBE_MAP_POSITIVE_Z:
+   case GL_TEXTURE_CUBE_MAP_NEGATIVE_Z:
+      return GL_TEXTURE_BINDING_CUBE_MAP;
+   }
+
+   return 0;
+}
+
+void
+glTexImage2D(GLenum target, GLint level, GLint internalformat,
+             GLsizei width, GLsizei height, GLint border,
+             GLenum format, GLenum type, const GLvoid * pixels)
+{
+   struct apple_glx_share_group *g;
+   GLenum binding;
+   GLint name = 0;
+
+   apple_glx_require_framework();
+
+   __gl_api.TexImage2D(target, level, internalformat, width, height,
+                       border, format, type, pixels);
+
+   g = current_share_group();
+   binding = texture_binding(target);
+
+   /* 
+    * The texture name is queried from the renderer after each upload,
+    * which waits for the commands already issued, so this is only done
+    * when the diagnostics that report the totals are enabled.
+    */
+   if (NULL == g || 0 == binding || !apple_glx_diagnostic_enabled())
+      return;
+
+   __gl_api.GetIntegerv(binding, &name);
+
+   apple_glx_share_group_texture_image(g, name, target, level,
+                                       __glImageSize(width, height, 1,
+                                                     format, type, target));
+}
+
+void
+glDeleteTextures(GLsizei n, const GLuint * textures)
+{
+   struct apple_glx_share_group *g = current_share_group();
+
+   apple_glx_require_framework();
+
+   if (g && n > 0)
+      apple_glx_share_group_delete_textures(g, n, textures);
+
+   __gl_api.DeleteTextures(n, textures);
+}
+
+GLuint
+glGenLists(GLsizei range)
+{
+   struct apple_glx_share_group *g = current_share_group();
+   GLuint list;
+
+   apple_glx_require_framework();
+
+   list = __gl_api.GenLists(range);
+
+   if (g && list)
+      apple_glx_share_group_gen_lists(g, list, range);
+
+   return list;
+}
+
+void
+glDeleteLists(GLuint list, GLsizei range)
+{
+   struct apple_glx_share_group *g = current_share_group();
+
+   apple_glx_require_framework();
+
+   if (g && range > 0)
+      apple_glx_share_group_delete_lists(g, list, range);
+
+   __gl_api.DeleteLists(list, range);
+}
@@ -30,6 +30,7 @@
 #include <stdbool.h>
 #include "apple_xgl_api_stereo.h"
 #include "apple_xgl_api.h"
+#include "apple_glx.h"
 #include "apple_glx_context.h"
 
 extern struct apple_xgl_api __gl_api;
@@ -42,6 +43,8 @@ glDrawBuffer(GLenum mode)
 {
    GLXContext gc = glXGetCurrentContext();
 
+   apple_glx_require_framework();
+
    if (gc && apple_glx_context_uses_stereo(gc->apple)) {
       GLenum buf[2];
       GLsizei n = 0;
@@ -77,6 +80,8 @@ glDrawBuffers(GLsizei n, const GLenum * bufs)
 {
    GLXContext gc = glXGetCurrentContext();
 
+   apple_glx_require_framework();
+
    if (gc && apple_glx_context_uses_stereo(gc->apple)) {
       GLenum newbuf[n + 2];
       GLsizei i, outi = 0;
@@ -26,6 +26,7 @@
  promote the sale, use or other dealings in this Software without
  prior written authorization.
 */
+#include "apple_glx.h"
 #include "apple_glx_context.h"
 #include "apple_xgl_api.h"
 #include "apple_xgl_api_viewport.h"
@@ -38,6 +39,8 @@ glViewport(GLint x, GLint y, GLsizei width, GLsizei height)
    GLXContext gc = __glXGetCurrentContext();
    Display *dpy = glXGetCurrentDisplay();
 
+   apple_glx_require_framework();
+
    if (gc && gc->apple)
       apple_glx_context_update(dpy, gc->apple);
 
@@ -41,10 +41,14 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define NEED_EVENTS
 #define NEED_REPLIES
 #include <X11/Xlibint.h>
+#include <X11/Xlib-xcb.h>
 #include "appledristr.h"
+#include "appledri_xcb.h"
 #include <X11/extensions/Xext.h>
 #include <X11/extensions/extutil.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 static XExtensionInfo _appledri_info_data;
 static XExtensionInfo *appledri_info = &_appledri_info_data;
@@ -105,7 +109,8 @@ wire_to_event(Display *dpy, XEvent *re, xEvent *event)
    case AppleDRISurfaceNotify:
       sevent = (xAppleDRINotifyEvent *) event;
       if (surface_notify_handler != NULL) {
-         (*surface_notify_handler) (dpy, (unsigned int) sevent->arg,
+         (*surface_notify_handler) (dpy, (void *) info->data,
+                                    (unsigned int) sevent->arg,
                                     (int) sevent->kind);
       }
       return False;
@@ -147,6 +152,26 @@ XAppleDRIQueryExtension(dpy, event_basep, error_basep)
    }
 }
 
+/* 
+ * The data of a display is passed to the surface notify handler, so that
+ * the handler doesn't have to look up its own state for each event.
+ */
+void
+XAppleDRISetDisplayData(Display * dpy, void *data)
+{
+   XExtDisplayInfo *info = find_display(dpy);
+
+   info->data = (XPointer) data;
+}
+
+void *
+XAppleDRIGetDisplayData(Display * dpy)
+{
+   XExtDisplayInfo *info = find_display(dpy);
+
+   return (void *) info->data;
+}
+
 Bool
 XAppleDRIQueryVersion(dpy, majorVersion, minorVersion, patchVersion)
      Display *dpy;
@@ -243,6 +268,53 @@ XAppleDRIAuthConnection(dpy, screen, magic)
    return True;
 }
 
+XAppleDRICookie
+XAppleDRISendCreateSurface(Display * dpy, int screen, Drawable drawable,
+                           unsigned int client_id)
+{
+   XExtDisplayInfo *info = find_display(dpy);
+   XAppleDRICookie cookie = { 0 };
+
+   TRACE("SendCreateSurface...");
+   AppleDRICheckExtension(dpy, info, cookie);
+
+   cookie.sequence =
+      xcb_appledri_create_surface_unchecked(XGetXCBConnection(dpy), screen,
+                                            drawable, client_id).sequence;
+   TRACE("SendCreateSurface... return");
+   return cookie;
+}
+
+Bool
+XAppleDRICreateSurfaceReply(Display * dpy, XAppleDRICookie cookie,
+                            unsigned int key[2], unsigned int *uid)
+{
+   xcb_appledri_create_surface_cookie_t xcookie;
+   xcb_appledri_create_surface_reply_t *rep;
+
+   TRACE("CreateSurfaceReply...");
+
+   if (!cookie.sequence)
+      return False;
+
+   xcookie.sequence = cookie.sequence;
+   rep = xcb_appledri_create_surface_reply(XGetXCBConnection(dpy), xcookie,
+                                           NULL);
+
+   if (!rep || !rep->key_0) {
+      free(rep);
+      TRACE("CreateSurfaceReply... return False");
+      return False;
+   }
+
+   key[0] = rep->key_0;
+   key[1] = rep->key_1;
+   *uid = rep->uid;
+   free(rep);
+   TRACE("CreateSurfaceReply... return True");
+   return True;
+}
+
 Bool
 XAppleDRICreateSurface(dpy, screen, drawable, client_id, key, uid)
      Display *dpy;
@@ -251,35 +323,62 @@ XAppleDRICreateSurface(dpy, screen, drawable, client_id, key, uid)
      unsigned int client_id;
      unsigned int *key;
      unsigned int *uid;
+{
+   return XAppleDRICreateSurfaceReply(dpy,
+                                      XAppleDRISendCreateSurface(dpy, screen,
+                                                                 drawable,
+                                                                 client_id),
+                                      key, uid);
+}
+
+/*
+ * This is XAppleDRICreateSurface with a GetGeometry request for the 
+ * drawable sent ahead of it, so that both replies arrive in the same 
+ * round trip.  *geometry_valid is set to False if the geometry reply
+ * wasn't received.
+ */
+Bool
+XAppleDRICreateSurfaceWithGeometry(dpy, screen, drawable, client_id, key, uid,
+                                   width, height, geometry_valid)
+     Display *dpy;
+     int screen;
+     Drawable drawable;
+     unsigned int client_id;
+     unsigned int *key;
+     unsigned int *uid;
+     unsigned int *width;
+     unsigned int *height;
+     Bool *geometry_valid;
 {
    XExtDisplayInfo *info = find_display(dpy);
-   xAppleDRICreateSurfaceReply rep;
-   xAppleDRICreateSurfaceReq *req;
+   xcb_connection_t *c;
+   xcb_get_geometry_cookie_t geometry_cookie;
+   xcb_get_geometry_reply_t *geometry;
+   XAppleDRICookie cookie;
+   Bool ret;
 
-   TRACE("CreateSurface...");
+   TRACE("CreateSurfaceWithGeometry...");
    AppleDRICheckExtension(dpy, info, False);
 
-   LockDisplay(dpy);
-   GetReq(AppleDRICreateSurface, req);
-   req->reqType = info->codes->major_opcode;
-   req->driReqType = X_AppleDRICreateSurface;
-   req->screen = screen;
-   req->drawable = drawable;
-   req->client_id = client_id;
-   rep.key_0 = rep.key_1 = rep.uid = 0;
-   if (!_XReply(dpy, (xReply *) & rep, 0, xFalse) || !rep.key_0) {
-      UnlockDisplay(dpy);
-      SyncHandle();
-      TRACE("CreateSurface... return False");
-      return False;
+   *geometry_valid = False;
+
+   c = XGetXCBConnection(dpy);
+   /* An error for the geometry is reported by the Xlib error handler. */
+   geometry_cookie = xcb_get_geometry_unchecked(c, drawable);
+   cookie = XAppleDRISendCreateSurface(dpy, screen, drawable, client_id);
+
+   geometry = xcb_get_geometry_reply(c, geometry_cookie, NULL);
+   if (geometry) {
+      *width = geometry->width;
+      *height = geometry->height;
+      *geometry_valid = True;
+      free(geometry);
    }
-   key[0] = rep.key_0;
-   key[1] = rep.key_1;
-   *uid = rep.uid;
-   UnlockDisplay(dpy);
-   SyncHandle();
-   TRACE("CreateSurface... return True");
-   return True;
+
+   ret = XAppleDRICreateSurfaceReply(dpy, cookie, key, uid);
+   TRACE(ret ? "CreateSurfaceWithGeometry... return True"
+         : "CreateSurfaceWithGeometry... return False");
+   return ret;
 }
 
 Bool
@@ -289,145 +388,132 @@ XAppleDRIDestroySurface(dpy, screen, drawable)
      Drawable drawable;
 {
    XExtDisplayInfo *info = find_display(dpy);
-   xAppleDRIDestroySurfaceReq *req;
 
    TRACE("DestroySurface...");
    AppleDRICheckExtension(dpy, info, False);
 
-   LockDisplay(dpy);
-   GetReq(AppleDRIDestroySurface, req);
-   req->reqType = info->codes->major_opcode;
-   req->driReqType = X_AppleDRIDestroySurface;
-   req->screen = screen;
-   req->drawable = drawable;
-   UnlockDisplay(dpy);
-   SyncHandle();
+   xcb_appledri_destroy_surface(XGetXCBConnection(dpy), screen, drawable);
    TRACE("DestroySurface... return True");
    return True;
 }
 
+/*
+ * This fails if the buffer couldn't be created, or its path doesn't fit in
+ * pathlen.
+ */
 Bool
 XAppleDRICreateSharedBuffer(Display * dpy, int screen, Drawable drawable,
                             Bool doubleSwap, char *path, size_t pathlen,
                             int *width, int *height)
 {
    XExtDisplayInfo *info = find_display(dpy);
-   xAppleDRICreateSharedBufferReq *req;
-   xAppleDRICreateSharedBufferReply rep;
+   xcb_connection_t *c;
+   xcb_appledri_create_shared_buffer_reply_t *rep;
 
+   TRACE("CreateSharedBuffer...");
    AppleDRICheckExtension(dpy, info, False);
 
-   LockDisplay(dpy);
-   GetReq(AppleDRICreateSharedBuffer, req);
-   req->reqType = info->codes->major_opcode;
-   req->driReqType = X_AppleDRICreateSharedBuffer;
-   req->screen = screen;
-   req->drawable = drawable;
-   req->doubleSwap = doubleSwap;
-
+   c = XGetXCBConnection(dpy);
+   rep = xcb_appledri_create_shared_buffer_reply(c,
+      xcb_appledri_create_shared_buffer_unchecked(c, screen, drawable,
+                                                  doubleSwap), NULL);
 
-   if (!_XReply(dpy, (xReply *) & rep, 0, xFalse)) {
-      puts("REPLY ERROR");
-
-      UnlockDisplay(dpy);
-      SyncHandle();
+   if (!rep || 0 == rep->string_length || rep->string_length > pathlen) {
+      free(rep);
+      TRACE("CreateSharedBuffer... return False");
       return False;
    }
 
-   printf("rep.stringLength %d\n", (int) rep.stringLength);
-
-   if (rep.stringLength > 0 && rep.stringLength <= pathlen) {
-      _XReadPad(dpy, path, rep.stringLength);
-
-      printf("path: %s\n", path);
-
-      *width = rep.width;
-      *height = rep.height;
-
-      UnlockDisplay(dpy);
-      SyncHandle();
-      return True;
-   }
-
-   UnlockDisplay(dpy);
-   SyncHandle();
-
-   return False;
+   memcpy(path, xcb_appledri_create_shared_buffer_path(rep),
+          rep->string_length);
+   /* The path should include the terminator, but don't rely on it. */
+   path[rep->string_length - 1] = '\0';
+   *width = rep->width;
+   *height = rep->height;
+   free(rep);
+   TRACE("CreateSharedBuffer... return True");
+   return True;
 }
 
 Bool
 XAppleDRISwapBuffers(Display * dpy, int screen, Drawable drawable)
 {
    XExtDisplayInfo *info = find_display(dpy);
-   xAppleDRISwapBuffersReq *req;
 
    AppleDRICheckExtension(dpy, info, False);
 
-   LockDisplay(dpy);
-   GetReq(AppleDRISwapBuffers, req);
-   req->reqType = info->codes->major_opcode;
-   req->driReqType = X_AppleDRISwapBuffers;
-   req->screen = screen;
-   req->drawable = drawable;
-   UnlockDisplay(dpy);
-   SyncHandle();
-
+   xcb_appledri_swap_buffers(XGetXCBConnection(dpy), screen, drawable);
    return True;
 }
 
-Bool
-XAppleDRICreatePixmap(Display * dpy, int screen, Drawable drawable,
-                      int *width, int *height, int *pitch, int *bpp,
-                      size_t * size, char *bufname, size_t bufnamesize)
+XAppleDRICookie
+XAppleDRISendCreatePixmap(Display * dpy, int screen, Drawable drawable)
 {
    XExtDisplayInfo *info = find_display(dpy);
-   xAppleDRICreatePixmapReq *req;
-   xAppleDRICreatePixmapReply rep;
-
-   AppleDRICheckExtension(dpy, info, False);
+   XAppleDRICookie cookie = { 0 };
 
-   LockDisplay(dpy);
-   GetReq(AppleDRICreatePixmap, req);
-   req->reqType = info->codes->major_opcode;
-   req->driReqType = X_AppleDRICreatePixmap;
-   req->screen = screen;
-   req->drawable = drawable;
+   AppleDRICheckExtension(dpy, info, cookie);
 
-   if (!_XReply(dpy, (xReply *) & rep, 0, xFalse)) {
-      UnlockDisplay(dpy);
-      SyncHandle();
-      return False;
-   }
+   cookie.sequence =
+      xcb_appledri_create_pixmap_unchecked(XGetXCBConnection(dpy), screen,
+                                           drawable).sequence;
+   return cookie;
+}
 
-   /*
-      printf("rep.stringLength %d\n", (int) rep.stringLength);
-    */
+/*
+ * This fails if the pixmap couldn't be shared, or the name of its buffer
+ * doesn't fit in bufnamesize.
+ */
+Bool
+XAppleDRICreatePixmapReply(Display * dpy, XAppleDRICookie cookie,
+                           int *width, int *height, int *pitch, int *bpp,
+                           size_t * size, char *bufname, size_t bufnamesize)
+{
+   xcb_appledri_create_pixmap_cookie_t xcookie;
+   xcb_appledri_create_pixmap_reply_t *rep;
 
-   if (rep.stringLength > 0 && rep.stringLength <= bufnamesize) {
-      _XReadPad(dpy, bufname, rep.stringLength);
+   if (!cookie.sequence)
+      return False;
 
-      printf("path: %s\n", bufname);
+   xcookie.sequence = cookie.sequence;
+   rep = xcb_appledri_create_pixmap_reply(XGetXCBConnection(dpy), xcookie,
+                                          NULL);
 
-      *width = rep.width;
-      *height = rep.height;
-      *pitch = rep.pitch;
-      *bpp = rep.bpp;
-      *size = rep.size;
+   if (!rep)
+      return False;
 
-      UnlockDisplay(dpy);
-      SyncHandle();
-      return True;
-   }
-   else if (rep.stringLength > 0) {
-      _XEatData(dpy, rep.stringLength);
+   if (rep->string_length == 0 || rep->string_length > bufnamesize) {
+      free(rep);
+      return False;
    }
 
-   UnlockDisplay(dpy);
-   SyncHandle();
+   memcpy(bufname, xcb_appledri_create_pixmap_bufname(rep),
+          rep->string_length);
+   /* The name should include the terminator, but don't rely on it. */
+   bufname[rep->string_length - 1] = '\0';
+
+   *width = rep->width;
+   *height = rep->height;
+   *pitch = rep->pitch;
+   *bpp = rep->bpp;
+   *size = rep->size;
 
+   free(rep);
    return True;
 }
 
+Bool
+XAppleDRICreatePixmap(Display * dpy, int screen, Drawable drawable,
+                      int *width, int *height, int *pitch, int *bpp,
+                      size_t * size, char *bufname, size_t bufnamesize)
+{
+   return XAppleDRICreatePixmapReply(dpy,
+                                     XAppleDRISendCreatePixmap(dpy, screen,
+                                                               drawable),
+                                     width, height, pitch, bpp, size,
+                                     bufname, bufnamesize);
+}
+
 /* 
  * Call it a drawable, because we really don't know what it is
  * until it reaches the server, and we should keep that in mind.
@@ -436,17 +522,9 @@ Bool
 XAppleDRIDestroyPixmap(Display * dpy, Pixmap drawable)
 {
    XExtDisplayInfo *info = find_display(dpy);
-   xAppleDRIDestroyPixmapReq *req;
 
    AppleDRICheckExtension(dpy, info, False);
 
-   LockDisplay(dpy);
-   GetReq(AppleDRIDestroyPixmap, req);
-   req->reqType = info->codes->major_opcode;
-   req->driReqType = X_AppleDRIDestroyPixmap;
-   req->drawable = drawable;
-   UnlockDisplay(dpy);
-   SyncHandle();
-
+   xcb_appledri_destroy_pixmap(XGetXCBConnection(dpy), drawable);
    return True;
 }
@@ -95,14 +95,47 @@ Bool XAppleDRIQueryDirectRenderingCapable(Display * dpy, int screen,
                                           Bool * isCapable);
 
 void *XAppleDRISetSurfaceNotifyHandler(void (*fun) (Display * dpy,
+                                                    void *data,
                                                     unsigned uid, int kind));
 
+void XAppleDRISetDisplayData(Display * dpy, void *data);
+
+void *XAppleDRIGetDisplayData(Display * dpy);
+
 Bool XAppleDRIAuthConnection(Display * dpy, int screen, unsigned int magic);
 
+/*
+ * The create requests are split into sending the request, which returns
+ * a cookie, and waiting for the reply to the cookie.  Many requests may be
+ * sent before their replies are collected, so they cost one round trip.
+ * A request that couldn't be sent has a cookie with a sequence of 0, and
+ * its reply fails.  Errors are reported by the Xlib error handler.
+ */
+typedef struct
+{
+   unsigned int sequence;
+} XAppleDRICookie;
+
+XAppleDRICookie XAppleDRISendCreateSurface(Display * dpy, int screen,
+                                           Drawable drawable,
+                                           unsigned int client_id);
+
+Bool XAppleDRICreateSurfaceReply(Display * dpy, XAppleDRICookie cookie,
+                                 unsigned int key[2], unsigned int *uid);
+
 Bool XAppleDRICreateSurface(Display * dpy, int screen, Drawable drawable,
                             unsigned int client_id, unsigned int key[2],
                             unsigned int *uid);
 
+Bool XAppleDRICreateSurfaceWithGeometry(Display * dpy, int screen,
+                                        Drawable drawable,
+                                        unsigned int client_id,
+                                        unsigned int key[2],
+                                        unsigned int *uid,
+                                        unsigned int *width,
+                                        unsigned int *height,
+                                        Bool * geometry_valid);
+
 Bool XAppleDRIDestroySurface(Display * dpy, int screen, Drawable drawable);
 
 Bool XAppleDRISynchronizeSurfaces(Display * dpy);
@@ -117,6 +150,14 @@ Bool XAppleDRICreatePixmap(Display * dpy, int screen, Drawable drawable,
                            int *width, int *height, int *pitch, int *bpp,
                            size_t * size, char *bufname, size_t bufnamesize);
 
+XAppleDRICookie XAppleDRISendCreatePixmap(Display * dpy, int screen,
+                                          Drawable drawable);
+
+Bool XAppleDRICreatePixmapReply(Display * dpy, XAppleDRICookie cookie,
+                                int *width, int *height, int *pitch,
+                                int *bpp, size_t * size, char *bufname,
+                                size_t bufnamesize);
+
 Bool XAppleDRIDestroyPixmap(Display * dpy, Pixmap pixmap);
 
 _XFUNCPROTOEND
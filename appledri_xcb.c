@@ -0,0 +1,302 @@
+/*
+ Copyright (c) 2009 Apple Inc.
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction,
+ including without limitation the rights to use, copy, modify, merge,
+ publish, distribute, sublicense, and/or sell copies of the Software,
+ and to permit persons to whom the Software is furnished to do so,
+ subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT.  IN NO EVENT SHALL THE ABOVE LISTED COPYRIGHT
+ HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ 
+ Except as contained in this notice, the name(s) of the above
+ copyright holders shall not be used in advertising or otherwise to
+ promote the sale, use or other dealings in this Software without
+ prior written authorization.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <xcb/xcb.h>
+#include <xcb/xcbext.h>
+#include <X11/Xproto.h>
+#include "appledristr.h"
+#include "appledri_xcb.h"
+
+xcb_extension_t xcb_appledri_id = { APPLEDRINAME, 0 };
+
+/*
+ * Send a request from appledristr.h.  XCB fills in the major opcode and
+ * the length, and returns the sequence number.
+ */
+static unsigned int
+send_request(xcb_connection_t * c, int flags, void *req, size_t size,
+             int opcode, int isvoid)
+{
+   /* XCB uses the two iovecs before the request. */
+   struct iovec parts[4];
+   xcb_protocol_request_t protocol;
+
+   protocol.count = 2;
+   protocol.ext = &xcb_appledri_id;
+   protocol.opcode = opcode;
+   protocol.isvoid = isvoid;
+
+   parts[2].iov_base = req;
+   parts[2].iov_len = size;
+   parts[3].iov_base = NULL;
+   parts[3].iov_len = -size & 3;
+
+   return xcb_send_request(c, flags, parts + 2, &protocol);
+}
+
+static xcb_appledri_query_version_cookie_t
+query_version(xcb_connection_t * c, int flags)
+{
+   xcb_appledri_query_version_cookie_t cookie;
+   xAppleDRIQueryVersionReq req;
+
+   memset(&req, 0, sizeof(req));
+
+   cookie.sequence = send_request(c, flags, &req, sz_xAppleDRIQueryVersionReq,
+                                  X_AppleDRIQueryVersion, 0);
+
+   return cookie;
+}
+
+xcb_appledri_query_version_cookie_t
+xcb_appledri_query_version(xcb_connection_t * c)
+{
+   return query_version(c, XCB_REQUEST_CHECKED);
+}
+
+xcb_appledri_query_version_cookie_t
+xcb_appledri_query_version_unchecked(xcb_connection_t * c)
+{
+   return query_version(c, 0);
+}
+
+xcb_appledri_query_version_reply_t *
+xcb_appledri_query_version_reply(xcb_connection_t * c,
+                                 xcb_appledri_query_version_cookie_t cookie,
+                                 xcb_generic_error_t ** e)
+{
+   return xcb_wait_for_reply(c, cookie.sequence, e);
+}
+
+static xcb_appledri_create_surface_cookie_t
+create_surface(xcb_connection_t * c, int flags, uint32_t screen,
+               uint32_t drawable, uint32_t client_id)
+{
+   xcb_appledri_create_surface_cookie_t cookie;
+   xAppleDRICreateSurfaceReq req;
+
+   memset(&req, 0, sizeof(req));
+   req.screen = screen;
+   req.drawable = drawable;
+   req.client_id = client_id;
+
+   cookie.sequence = send_request(c, flags, &req,
+                                  sz_xAppleDRICreateSurfaceReq,
+                                  X_AppleDRICreateSurface, 0);
+
+   return cookie;
+}
+
+xcb_appledri_create_surface_cookie_t
+xcb_appledri_create_surface(xcb_connection_t * c, uint32_t screen,
+                            uint32_t drawable, uint32_t client_id)
+{
+   return create_surface(c, XCB_REQUEST_CHECKED, screen, drawable, client_id);
+}
+
+xcb_appledri_create_surface_cookie_t
+xcb_appledri_create_surface_unchecked(xcb_connection_t * c, uint32_t screen,
+                                      uint32_t drawable, uint32_t client_id)
+{
+   return create_surface(c, 0, screen, drawable, client_id);
+}
+
+xcb_appledri_create_surface_reply_t *
+xcb_appledri_create_surface_reply(xcb_connection_t * c,
+                                  xcb_appledri_create_surface_cookie_t
+                                  cookie, xcb_generic_error_t ** e)
+{
+   return xcb_wait_for_reply(c, cookie.sequence, e);
+}
+
+xcb_void_cookie_t
+xcb_appledri_destroy_surface(xcb_connection_t * c, uint32_t screen,
+                             uint32_t drawable)
+{
+   xcb_void_cookie_t cookie;
+   xAppleDRIDestroySurfaceReq req;
+
+   memset(&req, 0, sizeof(req));
+   req.screen = screen;
+   req.drawable = drawable;
+
+   cookie.sequence = send_request(c, 0, &req, sz_xAppleDRIDestroySurfaceReq,
+                                  X_AppleDRIDestroySurface, 1);
+
+   return cookie;
+}
+
+static xcb_appledri_create_shared_buffer_cookie_t
+create_shared_buffer(xcb_connection_t * c, int flags, uint32_t screen,
+                     uint32_t drawable, uint8_t double_swap)
+{
+   xcb_appledri_create_shared_buffer_cookie_t cookie;
+   xAppleDRICreateSharedBufferReq req;
+
+   memset(&req, 0, sizeof(req));
+   req.screen = screen;
+   req.drawable = drawable;
+   req.doubleSwap = double_swap;
+
+   cookie.sequence = send_request(c, flags, &req,
+                                  sz_xAppleDRICreateSharedBufferReq,
+                                  X_AppleDRICreateSharedBuffer, 0);
+
+   return cookie;
+}
+
+xcb_appledri_create_shared_buffer_cookie_t
+xcb_appledri_create_shared_buffer(xcb_connection_t * c, uint32_t screen,
+                                  uint32_t drawable, uint8_t double_swap)
+{
+   return create_shared_buffer(c, XCB_REQUEST_CHECKED, screen, drawable,
+                               double_swap);
+}
+
+xcb_appledri_create_shared_buffer_cookie_t
+xcb_appledri_create_shared_buffer_unchecked(xcb_connection_t * c,
+                                            uint32_t screen,
+                                            uint32_t drawable,
+                                            uint8_t double_swap)
+{
+   return create_shared_buffer(c, 0, screen, drawable, double_swap);
+}
+
+xcb_appledri_create_shared_buffer_reply_t *
+xcb_appledri_create_shared_buffer_reply(xcb_connection_t * c,
+                                        xcb_appledri_create_shared_buffer_cookie_t
+                                        cookie, xcb_generic_error_t ** e)
+{
+   xcb_appledri_create_shared_buffer_reply_t *r;
+
+   r = xcb_wait_for_reply(c, cookie.sequence, e);
+
+   /* Don't trust a string that is longer than the reply. */
+   if (r && r->string_length > r->length * 4)
+      r->string_length = 0;
+
+   return r;
+}
+
+const char *
+xcb_appledri_create_shared_buffer_path(const
+                                       xcb_appledri_create_shared_buffer_reply_t
+                                       * r)
+{
+   return (const char *) (r + 1);
+}
+
+xcb_void_cookie_t
+xcb_appledri_swap_buffers(xcb_connection_t * c, uint32_t screen,
+                          uint32_t drawable)
+{
+   xcb_void_cookie_t cookie;
+   xAppleDRISwapBuffersReq req;
+
+   memset(&req, 0, sizeof(req));
+   req.screen = screen;
+   req.drawable = drawable;
+
+   cookie.sequence = send_request(c, 0, &req, sz_xAppleDRISwapBuffersReq,
+                                  X_AppleDRISwapBuffers, 1);
+
+   return cookie;
+}
+
+static xcb_appledri_create_pixmap_cookie_t
+create_pixmap(xcb_connection_t * c, int flags, uint32_t screen,
+              uint32_t drawable)
+{
+   xcb_appledri_create_pixmap_cookie_t cookie;
+   xAppleDRICreatePixmapReq req;
+
+   memset(&req, 0, sizeof(req));
+   req.screen = screen;
+   req.drawable = drawable;
+
+   cookie.sequence = send_request(c, flags, &req, sz_xAppleDRICreatePixmapReq,
+                                  X_AppleDRICreatePixmap, 0);
+
+   return cookie;
+}
+
+xcb_appledri_create_pixmap_cookie_t
+xcb_appledri_create_pixmap(xcb_connection_t * c, uint32_t screen,
+                           uint32_t drawable)
+{
+   return create_pixmap(c, XCB_REQUEST_CHECKED, screen, drawable);
+}
+
+xcb_appledri_create_pixmap_cookie_t
+xcb_appledri_create_pixmap_unchecked(xcb_connection_t * c, uint32_t screen,
+                                     uint32_t drawable)
+{
+   return create_pixmap(c, 0, screen, drawable);
+}
+
+xcb_appledri_create_pixmap_reply_t *
+xcb_appledri_create_pixmap_reply(xcb_connection_t * c,
+                                 xcb_appledri_create_pixmap_cookie_t cookie,
+                                 xcb_generic_error_t ** e)
+{
+   xcb_appledri_create_pixmap_reply_t *r;
+
+   r = xcb_wait_for_reply(c, cookie.sequence, e);
+
+   /* Don't trust a string that is longer than the reply. */
+   if (r && r->string_length > r->length * 4)
+      r->string_length = 0;
+
+   return r;
+}
+
+const char *
+xcb_appledri_create_pixmap_bufname(const xcb_appledri_create_pixmap_reply_t
+                                   * r)
+{
+   return (const char *) (r + 1);
+}
+
+xcb_void_cookie_t
+xcb_appledri_destroy_pixmap(xcb_connection_t * c, uint32_t drawable)
+{
+   xcb_void_cookie_t cookie;
+   xAppleDRIDestroyPixmapReq req;
+
+   memset(&req, 0, sizeof(req));
+   req.drawable = drawable;
+
+   cookie.sequence = send_request(c, 0, &req, sz_xAppleDRIDestroyPixmapReq,
+                                  X_AppleDRIDestroyPixmap, 1);
+
+   return cookie;
+}
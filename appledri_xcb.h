@@ -0,0 +1,205 @@
+/*
+ Copyright (c) 2009 Apple Inc.
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation files
+ (the "Software"), to deal in the Software without restriction,
+ including without limitation the rights to use, copy, modify, merge,
+ publish, distribute, sublicense, and/or sell copies of the Software,
+ and to permit persons to whom the Software is furnished to do so,
+ subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT.  IN NO EVENT SHALL THE ABOVE LISTED COPYRIGHT
+ HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ 
+ Except as contained in this notice, the name(s) of the above
+ copyright holders shall not be used in advertising or otherwise to
+ promote the sale, use or other dealings in this Software without
+ prior written authorization.
+*/
+
+#ifndef APPLEDRI_XCB_H
+#define APPLEDRI_XCB_H
+
+#include <xcb/xcb.h>
+
+/*
+ * An XCB client for the AppleDRI protocol in appledristr.h.
+ *
+ * Each request is sent without waiting, and returns a cookie.  The reply
+ * is collected later with the matching _reply function, so many requests
+ * may be in flight in one round trip.  The replies are malloced, and must
+ * be freed by the caller.
+ *
+ * The caller must check that the extension is present before sending a
+ * request, because XCB closes the connection if it isn't.
+ */
+
+extern xcb_extension_t xcb_appledri_id;
+
+typedef struct
+{
+   unsigned int sequence;
+} xcb_appledri_query_version_cookie_t;
+
+typedef struct
+{
+   uint8_t response_type;
+   uint8_t pad0;
+   uint16_t sequence;
+   uint32_t length;
+   uint16_t major_version;
+   uint16_t minor_version;
+   uint32_t patch_version;
+   uint8_t pad1[16];
+} xcb_appledri_query_version_reply_t;
+
+typedef struct
+{
+   unsigned int sequence;
+} xcb_appledri_create_surface_cookie_t;
+
+typedef struct
+{
+   uint8_t response_type;
+   uint8_t pad0;
+   uint16_t sequence;
+   uint32_t length;
+   uint32_t key_0;
+   uint32_t key_1;
+   uint32_t uid;
+   uint8_t pad1[12];
+} xcb_appledri_create_surface_reply_t;
+
+typedef struct
+{
+   unsigned int sequence;
+} xcb_appledri_create_pixmap_cookie_t;
+
+typedef struct
+{
+   uint8_t response_type;
+   uint8_t pad0;
+   uint16_t sequence;
+   uint32_t length;
+   uint32_t width;
+   uint32_t height;
+   uint32_t pitch;
+   uint32_t bpp;
+   uint32_t size;
+   uint32_t string_length;
+} xcb_appledri_create_pixmap_reply_t;
+
+typedef struct
+{
+   unsigned int sequence;
+} xcb_appledri_create_shared_buffer_cookie_t;
+
+typedef struct
+{
+   uint8_t response_type;
+   uint8_t pad0;
+   uint16_t sequence;
+   uint32_t length;
+   uint32_t string_length;
+   uint32_t width;
+   uint32_t height;
+   uint8_t pad1[12];
+} xcb_appledri_create_shared_buffer_reply_t;
+
+/*
+ * The requests with replies report an error through the e argument of the
+ * _reply function, and the _unchecked requests report it as an event, so
+ * that Xlib passes it to the error handler.  The requests without replies
+ * report errors as events.
+ */
+
+xcb_appledri_query_version_cookie_t
+xcb_appledri_query_version(xcb_connection_t * c);
+
+xcb_appledri_query_version_cookie_t
+xcb_appledri_query_version_unchecked(xcb_connection_t * c);
+
+xcb_appledri_query_version_reply_t *
+xcb_appledri_query_version_reply(xcb_connection_t * c,
+                                 xcb_appledri_query_version_cookie_t cookie,
+                                 xcb_generic_error_t ** e);
+
+xcb_appledri_create_surface_cookie_t
+xcb_appledri_create_surface(xcb_connection_t * c, uint32_t screen,
+                            uint32_t drawable, uint32_t client_id);
+
+xcb_appledri_create_surface_cookie_t
+xcb_appledri_create_surface_unchecked(xcb_connection_t * c, uint32_t screen,
+                                      uint32_t drawable, uint32_t client_id);
+
+xcb_appledri_create_surface_reply_t *
+xcb_appledri_create_surface_reply(xcb_connection_t * c,
+                                  xcb_appledri_create_surface_cookie_t
+                                  cookie, xcb_generic_error_t ** e);
+
+xcb_void_cookie_t
+xcb_appledri_destroy_surface(xcb_connection_t * c, uint32_t screen,
+                             uint32_t drawable);
+
+xcb_appledri_create_shared_buffer_cookie_t
+xcb_appledri_create_shared_buffer(xcb_connection_t * c, uint32_t screen,
+                                  uint32_t drawable, uint8_t double_swap);
+
+xcb_appledri_create_shared_buffer_cookie_t
+xcb_appledri_create_shared_buffer_unchecked(xcb_connection_t * c,
+                                            uint32_t screen,
+                                            uint32_t drawable,
+                                            uint8_t double_swap);
+
+xcb_appledri_create_shared_buffer_reply_t *
+xcb_appledri_create_shared_buffer_reply(xcb_connection_t * c,
+                                        xcb_appledri_create_shared_buffer_cookie_t
+                                        cookie, xcb_generic_error_t ** e);
+
+/* 
+ * The name of the shared memory of the window, which is not terminated.
+ * Its length is string_length, and is 0 if the buffer couldn't be created.
+ */
+const char *xcb_appledri_create_shared_buffer_path(const
+                                                   xcb_appledri_create_shared_buffer_reply_t
+                                                   * r);
+
+xcb_void_cookie_t
+xcb_appledri_swap_buffers(xcb_connection_t * c, uint32_t screen,
+                          uint32_t drawable);
+
+xcb_appledri_create_pixmap_cookie_t
+xcb_appledri_create_pixmap(xcb_connection_t * c, uint32_t screen,
+                           uint32_t drawable);
+
+xcb_appledri_create_pixmap_cookie_t
+xcb_appledri_create_pixmap_unchecked(xcb_connection_t * c, uint32_t screen,
+                                     uint32_t drawable);
+
+xcb_appledri_create_pixmap_reply_t *
+xcb_appledri_create_pixmap_reply(xcb_connection_t * c,
+                                 xcb_appledri_create_pixmap_cookie_t cookie,
+                                 xcb_generic_error_t ** e);
+
+/* 
+ * The name of the shared memory of the pixmap, which is not terminated.
+ * Its length is string_length, and is 0 if the pixmap couldn't be shared.
+ */
+const char *xcb_appledri_create_pixmap_bufname(const
+                                               xcb_appledri_create_pixmap_reply_t
+                                               * r);
+
+xcb_void_cookie_t
+xcb_appledri_destroy_pixmap(xcb_connection_t * c, uint32_t drawable);
+
+#endif
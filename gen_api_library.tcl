@@ -118,6 +118,7 @@ proc main {argc argv} {
 #include <dlfcn.h>
 #include "glxclient.h"
 #include "apple_xgl_api.h"
+#include "apple_glx.h"
 #include "apple_glx_context.h"
     }
 
@@ -133,6 +134,10 @@ proc main {argc argv} {
     
     #This is excluded to work with surface updates.
     lappend exclude Viewport
+
+    #These are accounted to the share group of the context.
+    #See also: apple_xgl_api_share.c.
+    lappend exclude TexImage2D DeleteTextures GenLists DeleteLists
     
     foreach f $sorted {
 	if {$f in $exclude} {
@@ -176,7 +181,9 @@ proc main {argc argv} {
 	    set alias [dict get $attr alias_for]
 	    set body "[set return] gl[set alias]([set callvars]);"
 	} else {
-	    set body "[set return]__gl_api.[set f]([set callvars]);"
+	    #The framework may still be loading when no context is current.
+	    set body "apple_glx_require_framework();\n\t"
+	    append body "[set return]__gl_api.[set f]([set callvars]);"
 	}
 
         puts $fd "GLAPI [dict get $attr return] APIENTRY gl[set f]([set pstr]) \{\n\t$body\n\}"
@@ -72,6 +72,26 @@ proc main {argc argv} {
     #Extensions
     lappend glxlist glXGetProcAddressARB
 
+    #GLX_OML_sync_control
+    lappend glxlist glXGetSyncValuesOML glXGetMscRateOML \
+	glXSwapBuffersMscOML glXWaitForMscOML glXWaitForSbcOML
+
+    #GLX_ARB_create_context
+    lappend glxlist glXCreateContextAttribsARB
+
+    #GLX_MESA_query_renderer
+    lappend glxlist glXQueryRendererIntegerMESA glXQueryRendererStringMESA \
+	glXQueryCurrentRendererIntegerMESA glXQueryCurrentRendererStringMESA
+
+    #GLX_EXT_texture_from_pixmap
+    lappend glxlist glXBindTexImageEXT glXReleaseTexImageEXT
+
+    #GLX_APPLE_pixmap_batch
+    lappend glxlist glXCreatePixmapsAPPLE glXDestroyPixmapsAPPLE
+
+    #GLX_MESA_copy_sub_buffer
+    lappend glxlist glXCopySubBufferMESA
+
     #Old extensions we don't support and never really have, but need for
     #symbol compatibility.  See also: glx_empty.c
     lappend glxlist glXSwapIntervalSGI glXSwapIntervalMESA \
@@ -80,11 +100,9 @@ proc main {argc argv} {
 	glXQueryFrameTrackingMESA glXGetVideoSyncSGI \
 	glXWaitVideoSyncSGI glXJoinSwapGroupSGIX \
 	glXBindSwapBarrierSGIX glXQueryMaxSwapBarriersSGIX \
-	glXGetSyncValuesOML glXSwapBuffersMscOML \
-	glXWaitForMscOML glXWaitForSbcOML \
 	glXAllocateMemoryMESA glXFreeMemoryMESA \
 	glXGetMemoryOffsetMESA glXReleaseBuffersMESA \
-	glXCreateGLXPixmapMESA glXCopySubBufferMESA \
+	glXCreateGLXPixmapMESA \
 	glXQueryGLXPbufferSGIX glXCreateGLXPbufferSGIX \
 	glXDestroyGLXPbufferSGIX glXSelectEventSGIX \
 	glXGetSelectedEventSGIX 
@@ -130,67 +130,6 @@ glXQueryMaxSwapBarriersSGIX(Display * dpy, int screen, int *max)
 }
 
 
-/*
-** GLX_OML_sync_control
-*/
-Bool
-glXGetSyncValuesOML(Display * dpy, GLXDrawable drawable,
-                    int64_t * ust, int64_t * msc, int64_t * sbc)
-{
-   (void) dpy;
-   (void) drawable;
-   (void) ust;
-   (void) msc;
-   (void) sbc;
-   return False;
-}
-
-int64_t
-glXSwapBuffersMscOML(Display * dpy, GLXDrawable drawable,
-                     int64_t target_msc, int64_t divisor, int64_t remainder)
-{
-   (void) dpy;
-   (void) drawable;
-   (void) target_msc;
-   (void) divisor;
-   (void) remainder;
-   return 0;
-}
-
-
-Bool
-glXWaitForMscOML(Display * dpy, GLXDrawable drawable,
-                 int64_t target_msc, int64_t divisor,
-                 int64_t remainder, int64_t * ust,
-                 int64_t * msc, int64_t * sbc)
-{
-   (void) dpy;
-   (void) drawable;
-   (void) target_msc;
-   (void) divisor;
-   (void) remainder;
-   (void) ust;
-   (void) msc;
-   (void) sbc;
-   return False;
-}
-
-
-Bool
-glXWaitForSbcOML(Display * dpy, GLXDrawable drawable,
-                 int64_t target_sbc, int64_t * ust,
-                 int64_t * msc, int64_t * sbc)
-{
-   (void) dpy;
-   (void) drawable;
-   (void) target_sbc;
-   (void) ust;
-   (void) msc;
-   (void) sbc;
-   return False;
-}
-
-
 /**
  * GLX_MESA_allocate_memory
  */
@@ -258,22 +197,6 @@ glXCreateGLXPixmapMESA(Display * dpy, XVisualInfo * visual,
 }
 
 
-/**
- * GLX_MESA_copy_sub_buffer
- */
-void
-glXCopySubBufferMESA(Display * dpy, GLXDrawable drawable,
-                     int x, int y, int width, int height)
-{
-   (void) dpy;
-   (void) drawable;
-   (void) x;
-   (void) y;
-   (void) width;
-   (void) height;
-}
-
-
 PUBLIC int
 glXQueryGLXPbufferSGIX(Display * dpy, GLXDrawable drawable,
                        int attribute, unsigned int *value)
@@ -588,6 +588,7 @@ glXCreatePbuffer(Display * dpy, GLXFBConfig config, const int *attrib_list)
 #ifdef GLX_USE_APPLEGL
    GLXPbuffer result;
    int errorcode;
+   bool preserved = true;
 #endif
 
    width = 0;
@@ -614,7 +615,11 @@ glXCreatePbuffer(Display * dpy, GLXFBConfig config, const int *attrib_list)
          break;
 
       case GLX_PRESERVED_CONTENTS:
-         /* The contents are always preserved with AppleSGLX with CGL. */
+         /* 
+          * The storage of a pbuffer that isn't preserved may be released
+          * to fit the pbuffer budget (see apple_glx_pbuffer.c).
+          */
+         preserved = attrib_list[i + 1] ? true : false;
          ++i;
          break;
 
@@ -623,8 +628,8 @@ glXCreatePbuffer(Display * dpy, GLXFBConfig config, const int *attrib_list)
       }
    }
 
-   if (apple_glx_pbuffer_create(dpy, config, width, height, &errorcode,
-                                &result)) {
+   if (apple_glx_pbuffer_create(dpy, config, width, height, preserved,
+                                &errorcode, &result)) {
       /* 
        * apple_glx_pbuffer_create only sets the errorcode to core X11
        * errors. 
@@ -682,10 +687,13 @@ glXQueryDrawable(Display * dpy, GLXDrawable drawable,
    int x, y;
    unsigned int width, height, bd, depth;
 
-   if (apple_glx_pixmap_query(drawable, attribute, value))
+   if (apple_glx_pixmap_query(dpy, drawable, attribute, value))
+      return;                   /*done */
+
+   if (apple_glx_pbuffer_query(dpy, drawable, attribute, value))
       return;                   /*done */
 
-   if (apple_glx_pbuffer_query(drawable, attribute, value))
+   if (apple_glx_surface_query(dpy, drawable, attribute, value))
       return;                   /*done */
 
    /*
@@ -738,7 +746,7 @@ glXSelectEvent(Display * dpy, GLXDrawable drawable, unsigned long mask)
 #ifdef GLX_USE_APPLEGL
    XWindowAttributes xwattr;
 
-   if (apple_glx_pbuffer_set_event_mask(drawable, mask))
+   if (apple_glx_pbuffer_set_event_mask(dpy, drawable, mask))
       return;                   /*done */
 
    /* 
@@ -771,7 +779,7 @@ glXGetSelectedEvent(Display * dpy, GLXDrawable drawable, unsigned long *mask)
 #ifdef GLX_USE_APPLEGL
    XWindowAttributes xwattr;
 
-   if (apple_glx_pbuffer_get_event_mask(drawable, mask))
+   if (apple_glx_pbuffer_get_event_mask(dpy, drawable, mask))
       return;                   /*done */
 
    /* 
@@ -811,7 +819,8 @@ glXCreatePixmap(Display * dpy, GLXFBConfig config, Pixmap pixmap,
 #ifdef GLX_USE_APPLEGL
    const __GLcontextModes *modes = (const __GLcontextModes *) config;
 
-   if (apple_glx_pixmap_create(dpy, modes->screen, pixmap, modes))
+   if (apple_glx_pixmap_create(dpy, modes->screen, pixmap, modes,
+                               attrib_list))
       return None;
 
    return pixmap;
@@ -849,6 +858,11 @@ glXCreateWindow(Display * dpy, GLXFBConfig config, Window win,
 
    XFree(visinfo);
 
+   /* This is optional, so an error here is left for make current. */
+   (void) apple_glx_surface_create_eager(dpy,
+                                         ((__GLcontextModes *) config)->
+                                         screen, win);
+
    return win;
 #else
    return CreateDrawable(dpy, (__GLcontextModes *) config,
@@ -879,6 +893,51 @@ glXDestroyWindow(Display * dpy, GLXWindow win)
 #endif
 }
 
+#ifdef GLX_USE_APPLEGL
+/*
+** GLX_APPLE_pixmap_batch
+*/
+PUBLIC int
+glXCreatePixmapsAPPLE(Display * dpy, GLXFBConfig config, int count,
+                      const Pixmap * pixmaps, const int *attrib_list,
+                      GLXPixmap * glxpixmaps)
+{
+   const __GLcontextModes *modes = (const __GLcontextModes *) config;
+
+   if (NULL == modes) {
+      __glXSendError(dpy, GLXBadFBConfig, 0, X_GLXCreatePixmap, false);
+      return 0;
+   }
+
+   if (count < 0) {
+      __glXSendError(dpy, BadValue, count, X_GLXCreatePixmap, true);
+      return 0;
+   }
+
+   if (0 == count)
+      return 0;
+
+   return apple_glx_pixmap_create_batch(dpy, modes->screen, count, pixmaps,
+                                        modes, attrib_list, glxpixmaps);
+}
+
+
+PUBLIC void
+glXDestroyPixmapsAPPLE(Display * dpy, int count, const GLXPixmap * glxpixmaps)
+{
+   int i;
+
+   /* 
+    * The AppleDRI destroy requests have no reply, so these don't wait for
+    * the server.
+    */
+   for (i = 0; i < count; ++i)
+      if (apple_glx_pixmap_destroy(dpy, glxpixmaps[i]))
+         __glXSendError(dpy, GLXBadPixmap, glxpixmaps[i], X_GLXDestroyPixmap,
+                        false);
+}
+#endif
+
 #ifndef GLX_USE_APPLEGL
 PUBLIC
 GLX_ALIAS_VOID(glXDestroyGLXPbufferSGIX,
@@ -751,6 +751,13 @@ extern void __glEmptyImage(__GLXcontext *, GLint, GLint, GLint, GLint, GLenum,
 extern void __glXInitVertexArrayState(__GLXcontext *);
 extern void __glXFreeVertexArrayState(__GLXcontext *);
 
+/*
+** Allocate the protocol buffer and client state of a context the first
+** time an indirect path needs them, and get the client state.
+*/
+extern GLboolean __glXAllocateIndirectState(__GLXcontext *);
+extern __GLXattribute *__glXGetClientState(__GLXcontext *);
+
 /*
 ** Inform the Server of the major and minor numbers and of the client
 ** libraries extension string.
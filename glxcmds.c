@@ -37,7 +37,13 @@
 #ifdef GLX_USE_APPLEGL
 #include "apple_glx_context.h"
 #include "apple_glx.h"
+#include "apple_glx_sync.h"
+#include "apple_glx_renderer.h"
 #include "glx_error.h"
+#include <time.h>
+#ifdef __APPLE__
+#include <mach/mach_time.h>
+#endif
 #else
 #include "glapi.h"
 #endif
@@ -102,9 +108,11 @@ GarbageCollectDRIDrawables(Display * dpy, __GLXscreenConfigs * sc)
          XGetWindowAttributes(dpy, draw, &xwa); /* dummy request */
          if (!windowExistsFlag) {
             /* Destroy the local drawable data, if the drawable no
-               longer exists in the Xserver */
-            (*pdraw->destroyDrawable) (pdraw);
+               longer exists in the Xserver.  Remove it from the table
+               first, so other threads can't find it after it's
+               destroyed. */
             __glxHashDelete(sc->drawHash, draw);
+            (*pdraw->destroyDrawable) (pdraw);
          }
       } while (__glxHashNext(sc->drawHash, &draw, (void *) &pdraw) == 1);
    }
@@ -249,47 +257,32 @@ ValidateGLXFBConfig(Display * dpy, GLXFBConfig config)
 
 
 /**
- * \todo It should be possible to move the allocate of \c client_state_private
- * later in the function for direct-rendering contexts.  Direct-rendering
- * contexts don't need to track client state, so they don't need that memory
- * at all.
+ * Allocate the GLX protocol buffer and the client state of \c gc.  These are
+ * only used by indirect rendering, so under \c GLX_USE_APPLEGL they are not
+ * allocated with the context, but the first time an indirect path needs
+ * them.  Nothing is done if they are already allocated.
+ *
+ * \returns \c GL_TRUE on success, or \c GL_FALSE if out of memory.
  *
  * \todo Eliminate \c __glXInitVertexArrayState.  Replace it with a new
  * function called \c __glXAllocateClientState that allocates the memory and
  * does all the initialization (including the pixel pack / unpack).
  */
-static GLXContext
-AllocateGLXContext(Display * dpy)
+_X_HIDDEN GLboolean
+__glXAllocateIndirectState(__GLXcontext * gc)
 {
-   GLXContext gc;
    int bufSize;
-   CARD8 opcode;
    __GLXattribute *state;
 
-   if (!dpy)
-      return NULL;
-
-   opcode = __glXSetupForCommand(dpy);
-   if (!opcode) {
-      return NULL;
-   }
-
-   /* Allocate our context record */
-   gc = (GLXContext) Xmalloc(sizeof(struct __GLXcontextRec));
-   if (!gc) {
-      /* Out of memory */
-      return NULL;
-   }
-   memset(gc, 0, sizeof(struct __GLXcontextRec));
+   if (gc->buf)
+      return GL_TRUE;
 
    state = Xmalloc(sizeof(struct __GLXattributeRec));
    if (state == NULL) {
       /* Out of memory */
-      Xfree(gc);
-      return NULL;
+      return GL_FALSE;
    }
-   gc->client_state_private = state;
-   memset(gc->client_state_private, 0, sizeof(struct __GLXattributeRec));
+   memset(state, 0, sizeof(struct __GLXattributeRec));
    state->NoDrawArraysProtocol = (getenv("LIBGL_NO_DRAWARRAYS") != NULL);
 
    /*
@@ -299,33 +292,20 @@ AllocateGLXContext(Display * dpy)
     ** packet for the GLXRenderReq header.
     */
 
-   bufSize = (XMaxRequestSize(dpy) * 4) - sz_xGLXRenderReq;
+   bufSize = (XMaxRequestSize(gc->createDpy) * 4) - sz_xGLXRenderReq;
    gc->buf = (GLubyte *) Xmalloc(bufSize);
    if (!gc->buf) {
-      Xfree(gc->client_state_private);
-      Xfree(gc);
-      return NULL;
+      Xfree(state);
+      return GL_FALSE;
    }
    gc->bufSize = bufSize;
 
-   /* Fill in the new context */
-   gc->renderMode = GL_RENDER;
-
    state->storePack.alignment = 4;
    state->storeUnpack.alignment = 4;
+   gc->client_state_private = state;
 
-   gc->attributes.stackPointer = &gc->attributes.stack[0];
-
-   /*
-    ** PERFORMANCE NOTE: A mode dependent fill image can speed things up.
-    ** Other code uses the fastImageUnpack bit, but it is never set
-    ** to GL_TRUE.
-    */
-   gc->fastImageUnpack = GL_FALSE;
-   gc->fillImage = __glFillImage;
    gc->pc = gc->buf;
    gc->bufEnd = gc->buf + bufSize;
-   gc->isDirect = GL_FALSE;
    if (__glXDebug) {
       /*
        ** Set limit register so that there will be one command per packet
@@ -335,8 +315,6 @@ AllocateGLXContext(Display * dpy)
    else {
       gc->limit = gc->buf + bufSize - __GLX_BUFFER_LIMIT_SIZE;
    }
-   gc->createDpy = dpy;
-   gc->majorOpcode = opcode;
 
    /*
     ** Constrain the maximum drawing command size allowed to be
@@ -351,10 +329,84 @@ AllocateGLXContext(Display * dpy)
       bufSize = __GLX_MAX_RENDER_CMD_SIZE;
    }
    gc->maxSmallRenderCommandSize = bufSize;
-   
+
+   return GL_TRUE;
+}
+
+/**
+ * Get the client state of \c gc, allocating it if an indirect path needs
+ * it for the first time.
+ *
+ * \returns The client state, or \c NULL if out of memory.
+ */
+_X_HIDDEN __GLXattribute *
+__glXGetClientState(__GLXcontext * gc)
+{
+   if (!__glXAllocateIndirectState(gc))
+      return NULL;
+
+   return gc->client_state_private;
+}
+
+static GLXContext
+AllocateGLXContext(Display * dpy)
+{
+   GLXContext gc;
+   CARD8 opcode;
+
+   if (!dpy)
+      return NULL;
+
+   opcode = __glXSetupForCommand(dpy);
+   if (!opcode) {
+      return NULL;
+   }
+
+   /* Allocate our context record */
+   gc = (GLXContext) Xmalloc(sizeof(struct __GLXcontextRec));
+   if (!gc) {
+      /* Out of memory */
+      return NULL;
+   }
+   memset(gc, 0, sizeof(struct __GLXcontextRec));
+
+   /* Fill in the new context */
+   gc->renderMode = GL_RENDER;
+
+   gc->attributes.stackPointer = &gc->attributes.stack[0];
+
+   /*
+    ** PERFORMANCE NOTE: A mode dependent fill image can speed things up.
+    ** Other code uses the fastImageUnpack bit, but it is never set
+    ** to GL_TRUE.
+    */
+   gc->fastImageUnpack = GL_FALSE;
+   gc->fillImage = __glFillImage;
+   gc->isDirect = GL_FALSE;
+   gc->createDpy = dpy;
+   gc->majorOpcode = opcode;
+
 #ifdef GLX_USE_APPLEGL
+   /*
+    ** The GL commands go straight to CGL, so the protocol buffer and the
+    ** client state are left for __glXAllocateIndirectState.  With pc and
+    ** buf both NULL, __glXFlushRenderBuffer has nothing to send.
+    */
    gc->apple = NULL;
    gc->do_destroy = False;   
+
+   apple_glx_diagnostic("context %p: %u bytes allocated, the %u byte GLX "
+                        "protocol buffer and %u byte client state are "
+                        "deferred\n", (void *) gc,
+                        (unsigned int) sizeof(struct __GLXcontextRec),
+                        (unsigned int) ((XMaxRequestSize(dpy) * 4)
+                                        - sz_xGLXRenderReq),
+                        (unsigned int) sizeof(struct __GLXattributeRec));
+#else
+   if (!__glXAllocateIndirectState(gc)) {
+      Xfree(gc);
+      return NULL;
+   }
 #endif
 
    return gc;
@@ -368,6 +420,7 @@ AllocateGLXContext(Display * dpy)
  * \param use_glx_1_3  For FBConfigs, should GLX 1.3 protocol or
  *                     SGIX_fbconfig protocol be used?
  * \param renderType   For FBConfigs, what is the rendering type?
+ * \param attrib_list  GLX_ARB_create_context attributes, or NULL.
  */
 
 static GLXContext
@@ -375,7 +428,7 @@ CreateContext(Display * dpy, XVisualInfo * vis,
               const __GLcontextModes * const fbconfig,
               GLXContext shareList,
               Bool allowDirect, GLXContextID contextID,
-              Bool use_glx_1_3, int renderType)
+              Bool use_glx_1_3, int renderType, const int *attrib_list)
 {
    GLXContext gc;
 #if defined(GLX_DIRECT_RENDERING) || defined(GLX_USE_APPLEGL)
@@ -529,7 +582,7 @@ CreateContext(Display * dpy, XVisualInfo * vis,
    
    if(apple_glx_create_context(&gc->apple, dpy, screen, mode, 
                                shareList ? shareList->apple : NULL,
-                               &errorcode, &x11error)) {
+                               attrib_list, &errorcode, &x11error)) {
       __glXSendError(dpy, errorcode, 0, X_GLXCreateContext, x11error);
       __glXFreeContext(gc);
       return NULL;
@@ -549,7 +602,7 @@ glXCreateContext(Display * dpy, XVisualInfo * vis,
                  GLXContext shareList, Bool allowDirect)
 {
    return CreateContext(dpy, vis, NULL, shareList, allowDirect, None,
-                        False, 0);
+                        False, 0, NULL);
 }
 
 _X_HIDDEN void
@@ -566,8 +619,10 @@ __glXFreeContext(__GLXcontext * gc)
 #ifndef GLX_USE_APPLEGL
    __glFreeAttributeState(gc);
 #endif
-   XFree((char *) gc->buf);
-   Xfree((char *) gc->client_state_private);
+   if (gc->buf)
+      XFree((char *) gc->buf);
+   if (gc->client_state_private)
+      Xfree((char *) gc->client_state_private);
    XFree((char *) gc);
 
 }
@@ -719,7 +774,7 @@ glXWaitGL(void)
    /* Flush any pending commands out */
    __glXFlushRenderBuffer(gc, gc->pc);
 #ifdef GLX_USE_APPLEGL
-   glFinish();
+   apple_glx_waitgl(dpy, gc->apple);
 #else
 #ifdef GLX_DIRECT_RENDERING
    if (gc->driContext) {
@@ -854,6 +909,12 @@ glXCopyContext(Display * dpy, GLXContext source,
    int errorcode;
    bool x11error;
 
+   if(apple_glx_context_wait(source->apple, &errorcode, &x11error)
+      || apple_glx_context_wait(dest->apple, &errorcode, &x11error)) {
+      __glXSendError(dpy, errorcode, 0, X_GLXCopyContext, x11error);
+      return;
+   }
+
    if(apple_glx_copy_context(gc->apple, source->apple, dest->apple,
                              mask, &errorcode, &x11error)) {
       __glXSendError(dpy, errorcode, 0, X_GLXCopyContext, x11error);
@@ -994,7 +1055,7 @@ glXCreateGLXPixmap(Display * dpy, XVisualInfo * vis, Pixmap pixmap)
 
    modes = _gl_context_modes_find_visual(psc->visuals, vis->visualid);
    
-   if(apple_glx_pixmap_create(dpy, vis->screen, pixmap, modes))
+   if(apple_glx_pixmap_create(dpy, vis->screen, pixmap, modes, NULL))
       return None;
    
    return pixmap;
@@ -1837,7 +1898,15 @@ static int __glXQueryContextInfo(Display * dpy, GLXContext ctx)
 PUBLIC int
 glXQueryContext(Display * dpy, GLXContext ctx, int attribute, int *value)
 {
-#ifndef GLX_USE_APPLEGL
+#ifdef GLX_USE_APPLEGL
+   int errorcode;
+   bool x11error;
+
+   if (apple_glx_context_wait(ctx->apple, &errorcode, &x11error)) {
+      __glXSendError(dpy, errorcode, 0, X_GLXQueryContext, x11error);
+      return GLX_BAD_CONTEXT;
+   }
+#else
    int retVal;
 
    /* get the information from the server if we don't have it already */
@@ -1901,7 +1970,8 @@ glXImportContextEXT(Display * dpy, GLXContextID contextID)
       return NULL;
    }
 
-   ctx = CreateContext(dpy, NULL, NULL, NULL, False, contextID, False, 0);
+   ctx = CreateContext(dpy, NULL, NULL, NULL, False, contextID, False, 0,
+                       NULL);
    if (NULL != ctx) {
       if (Success != __glXQueryContextInfo(dpy, ctx)) {
          return NULL;
@@ -1952,9 +2022,28 @@ glXCreateNewContext(Display * dpy, GLXFBConfig config,
                     int renderType, GLXContext shareList, Bool allowDirect)
 {
    return CreateContext(dpy, NULL, (__GLcontextModes *) config, shareList,
-                        allowDirect, None, True, renderType);
+                        allowDirect, None, True, renderType, NULL);
 }
 
+#ifdef GLX_USE_APPLEGL
+/*
+** GLX_ARB_create_context
+*/
+PUBLIC GLXContext
+glXCreateContextAttribsARB(Display * dpy, GLXFBConfig config,
+                           GLXContext shareList, Bool allowDirect,
+                           const int *attrib_list)
+{
+   if (NULL == config) {
+      __glXSendError(dpy, GLXBadFBConfig, 0, X_GLXCreateNewContext, false);
+      return NULL;
+   }
+
+   return CreateContext(dpy, NULL, (__GLcontextModes *) config, shareList,
+                        allowDirect, None, True, GLX_RGBA_TYPE, attrib_list);
+}
+#endif
+
 
 PUBLIC GLXDrawable
 glXGetCurrentReadDrawable(void)
@@ -2360,7 +2449,8 @@ glXCreateGLXPixmapWithConfigSGIX(Display * dpy,
       return None;
    }
 #ifdef GLX_USE_APPLEGL
-   if(apple_glx_pixmap_create(dpy, fbconfig->screen, pixmap, fbconfig))
+   if(apple_glx_pixmap_create(dpy, fbconfig->screen, pixmap, fbconfig,
+                              NULL))
       return None;
    return pixmap;
 #else
@@ -2412,7 +2502,7 @@ glXCreateContextWithConfigSGIX(Display * dpy,
    if ((psc != NULL)
        && __glXExtensionBitIsEnabled(psc, SGIX_fbconfig_bit)) {
       gc = CreateContext(dpy, NULL, (__GLcontextModes *) config, shareList,
-                         allowDirect, None, False, renderType);
+                         allowDirect, None, False, renderType, NULL);
    }
 
    return gc;
@@ -3026,6 +3116,188 @@ __glXReleaseTexImageEXT(Display * dpy, GLXDrawable drawable, int buffer)
 
 /*@}*/
 
+#else /* GLX_USE_APPLEGL */
+
+/*
+** GLX_OML_sync_control
+*/
+PUBLIC Bool
+glXGetSyncValuesOML(Display * dpy, GLXDrawable drawable,
+                    int64_t * ust, int64_t * msc, int64_t * sbc)
+{
+   return apple_glx_get_sync_values(dpy, drawable, ust, msc, sbc);
+}
+
+PUBLIC Bool
+glXGetMscRateOML(Display * dpy, GLXDrawable drawable,
+                 int32_t * numerator, int32_t * denominator)
+{
+   (void) dpy;
+   (void) drawable;
+
+   return apple_glx_get_msc_rate(numerator, denominator);
+}
+
+PUBLIC int64_t
+glXSwapBuffersMscOML(Display * dpy, GLXDrawable drawable,
+                     int64_t target_msc, int64_t divisor, int64_t remainder)
+{
+   GLXContext gc = __glXGetCurrentContext();
+
+   if (gc && apple_glx_is_current_drawable(dpy, gc->apple, drawable)) {
+      return apple_glx_swap_buffers_msc(gc->apple, target_msc,
+                                        divisor, remainder);
+   }
+
+   __glXSendError(dpy, GLXBadCurrentWindow, 0, X_GLXSwapBuffers, false);
+   return -1;
+}
+
+PUBLIC Bool
+glXWaitForMscOML(Display * dpy, GLXDrawable drawable,
+                 int64_t target_msc, int64_t divisor,
+                 int64_t remainder, int64_t * ust,
+                 int64_t * msc, int64_t * sbc)
+{
+   return apple_glx_wait_for_msc(dpy, drawable, target_msc, divisor,
+                                 remainder, ust, msc, sbc);
+}
+
+PUBLIC Bool
+glXWaitForSbcOML(Display * dpy, GLXDrawable drawable,
+                 int64_t target_sbc, int64_t * ust,
+                 int64_t * msc, int64_t * sbc)
+{
+   return apple_glx_wait_for_sbc(dpy, drawable, target_sbc, ust, msc, sbc);
+}
+
+/*
+** GLX_MESA_copy_sub_buffer
+*/
+PUBLIC void
+glXCopySubBufferMESA(Display * dpy, GLXDrawable drawable,
+                     int x, int y, int width, int height)
+{
+   GLXContext gc = __glXGetCurrentContext();
+
+   if (width < 0 || height < 0) {
+      __glXSendError(dpy, BadValue, 0, X_GLXVendorPrivate, true);
+      return;
+   }
+
+   if (gc && apple_glx_is_current_drawable(dpy, gc->apple, drawable)) {
+      apple_glx_copy_sub_buffer(gc->apple, x, y, width, height);
+      return;
+   }
+
+   __glXSendError(dpy, GLXBadCurrentWindow, 0, X_GLXVendorPrivate, false);
+}
+
+/*
+** GLX_MESA_query_renderer
+*/
+static const struct apple_glx_renderer *
+GetRenderer(Display * dpy, int screen, int renderer)
+{
+   if (NULL == dpy || screen < 0 || screen >= ScreenCount(dpy))
+      return NULL;
+
+   /* Every screen is driven by the same renderers. */
+   return apple_glx_renderer_get(renderer);
+}
+
+PUBLIC Bool
+glXQueryRendererIntegerMESA(Display * dpy, int screen, int renderer,
+                            int attribute, unsigned int *value)
+{
+   const struct apple_glx_renderer *r = GetRenderer(dpy, screen, renderer);
+
+   if (NULL == r)
+      return False;
+
+   return apple_glx_renderer_query_integer(r, attribute, value);
+}
+
+PUBLIC const char *
+glXQueryRendererStringMESA(Display * dpy, int screen, int renderer,
+                           int attribute)
+{
+   const struct apple_glx_renderer *r = GetRenderer(dpy, screen, renderer);
+
+   if (NULL == r)
+      return NULL;
+
+   return apple_glx_renderer_query_string(r, attribute);
+}
+
+PUBLIC Bool
+glXQueryCurrentRendererIntegerMESA(int attribute, unsigned int *value)
+{
+   GLXContext gc = __glXGetCurrentContext();
+   const struct apple_glx_renderer *r;
+
+   if (NULL == gc || NULL == gc->apple)
+      return False;
+
+   r = apple_glx_renderer_current();
+
+   if (NULL == r)
+      return False;
+
+   return apple_glx_renderer_query_integer(r, attribute, value);
+}
+
+PUBLIC const char *
+glXQueryCurrentRendererStringMESA(int attribute)
+{
+   GLXContext gc = __glXGetCurrentContext();
+   const struct apple_glx_renderer *r;
+
+   if (NULL == gc || NULL == gc->apple)
+      return NULL;
+
+   r = apple_glx_renderer_current();
+
+   if (NULL == r)
+      return NULL;
+
+   return apple_glx_renderer_query_string(r, attribute);
+}
+
+/*
+** GLX_EXT_texture_from_pixmap
+*/
+PUBLIC void
+glXBindTexImageEXT(Display * dpy, GLXDrawable drawable, int buffer,
+                   const int *attrib_list)
+{
+   GLXContext gc = __glXGetCurrentContext();
+   int errorcode;
+
+   (void) attrib_list;
+
+   if (NULL == gc || NULL == gc->apple)
+      return;
+
+   if (apple_glx_pixmap_bind_tex_image(dpy, drawable, buffer, &errorcode))
+      __glXSendError(dpy, errorcode, drawable, X_GLXVendorPrivate,
+                     errorcode != GLXBadPixmap);
+}
+
+PUBLIC void
+glXReleaseTexImageEXT(Display * dpy, GLXDrawable drawable, int buffer)
+{
+   GLXContext gc = __glXGetCurrentContext();
+   int errorcode;
+
+   if (NULL == gc || NULL == gc->apple)
+      return;
+
+   if (apple_glx_pixmap_release_tex_image(dpy, drawable, buffer, &errorcode))
+      __glXSendError(dpy, errorcode, drawable, X_GLXVendorPrivate,
+                     errorcode != GLXBadPixmap);
+}
+
 #endif /* GLX_USE_APPLEGL */
 
 /**
@@ -3269,11 +3541,14 @@ PUBLIC void (*glXGetProcAddress(const GLubyte * procName)) (void)
 #endif /* __GNUC__ */
 
 
-#ifdef GLX_DIRECT_RENDERING
+#if defined(GLX_DIRECT_RENDERING) || defined(GLX_USE_APPLEGL)
 /**
  * Get the unadjusted system time (UST).  Currently, the UST is measured in
- * microseconds since Epoc.  The actual resolution of the UST may vary from
- * system to system, and the units may vary from release to release.
+ * microseconds.  With \c GLX_USE_APPLEGL the UST is from a monotonic clock
+ * with an unspecified starting point, so that it isn't affected by changes
+ * to the time of day.  Otherwise it is measured since the Epoc.  The actual
+ * resolution of the UST may vary from system to system, and the units may
+ * vary from release to release.
  * Drivers should not call this function directly.  They should instead use
  * \c glXGetProcAddress to obtain a pointer to the function.
  *
@@ -3284,9 +3559,54 @@ PUBLIC void (*glXGetProcAddress(const GLubyte * procName)) (void)
  *
  * \since Internal API version 20030317.
  */
+#if defined(GLX_USE_APPLEGL) && defined(__APPLE__)
+static pthread_once_t timebase_once = PTHREAD_ONCE_INIT;
+static mach_timebase_info_data_t timebase;
+
+static void
+init_timebase(void)
+{
+   if (mach_timebase_info(&timebase))
+      timebase.denom = 0;
+}
+#endif
+
 _X_HIDDEN int
 __glXGetUST(int64_t * ust)
 {
+#ifdef GLX_USE_APPLEGL
+#ifdef __APPLE__
+   uint64_t t;
+
+   if (ust == NULL) {
+      return -EFAULT;
+   }
+
+   (void) pthread_once(&timebase_once, init_timebase);
+
+   if (0 == timebase.denom)
+      return -EINVAL;
+
+   t = mach_absolute_time();
+   ust[0] = (int64_t) ((t / 1000) * timebase.numer / timebase.denom
+                       + ((t % 1000) * timebase.numer / timebase.denom) / 1000);
+   return 0;
+#else
+   struct timespec ts;
+
+   if (ust == NULL) {
+      return -EFAULT;
+   }
+
+   if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0) {
+      ust[0] = ((int64_t) ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+      return 0;
+   }
+   else {
+      return -errno;
+   }
+#endif
+#else
    struct timeval tv;
 
    if (ust == NULL) {
@@ -3300,5 +3620,6 @@ __glXGetUST(int64_t * ust)
    else {
       return -errno;
    }
+#endif
 }
-#endif /* GLX_DIRECT_RENDERING */
+#endif /* GLX_DIRECT_RENDERING || GLX_USE_APPLEGL */
@@ -43,6 +43,7 @@
 
 #include "apple_glx.h"
 #include "apple_glx_context.h"
+#include "glx_error.h"
 #else
 #include "glapi.h"
 #include "indirect_init.h"
@@ -307,12 +308,19 @@ FetchDRIDrawable(Display * dpy, GLXDrawable glxDrawable, GLXContext gc)
 
    pdraw = psc->driScreen->createDrawable(psc, glxDrawable,
                                           glxDrawable, gc->mode);
-   if (__glxHashInsert(psc->drawHash, glxDrawable, pdraw)) {
+   switch (__glxHashInsert(psc->drawHash, glxDrawable, pdraw)) {
+   case 0:
+      return pdraw;
+   case 1:
+      /* Another thread created the drawable first, so use that one. */
+      (*pdraw->destroyDrawable) (pdraw);
+      if (__glxHashLookup(psc->drawHash, glxDrawable, (void *) &pdraw) == 0)
+         return pdraw;
+      return NULL;
+   default:
       (*pdraw->destroyDrawable) (pdraw);
       return NULL;
    }
-
-   return pdraw;
 }
 #endif /* GLX_DIRECT_RENDERING */
 
@@ -344,9 +352,18 @@ MakeContextCurrent(Display * dpy, GLXDrawable draw,
 {
    const GLXContext oldGC = __glXGetCurrentContext();
 #ifdef GLX_USE_APPLEGL
-   bool error = apple_glx_make_current_context(dpy, 
-                   (oldGC && oldGC != &dummyContext) ? oldGC->apple : NULL, 
-                   gc ? gc->apple : NULL, draw);
+   int errorcode;
+   bool x11error, error;
+
+   /* A context created by a worker reports its creation error here. */
+   if(gc && apple_glx_context_wait(gc->apple, &errorcode, &x11error)) {
+      __glXSendError(dpy, errorcode, 0, X_GLXMakeCurrent, x11error);
+      return GL_FALSE;
+   }
+
+   error = apple_glx_make_current_context(dpy, 
+              (oldGC && oldGC != &dummyContext) ? oldGC->apple : NULL, 
+              gc ? gc->apple : NULL, draw);
    
    apple_glx_diagnostic("%s: error %s\n", __func__, error ? "YES" : "NO");
    if(error)
@@ -482,6 +499,12 @@ MakeContextCurrent(Display * dpy, GLXDrawable draw,
             /* glXDestroyContext uses the same global lock. */
             glXDestroyContext(dpy, oldGC);
             __glXLock();
+         }
+         else if(apple_glx_context_destroy_deferred(oldGC->apple)) {
+            /* The Display of the context was closed while it was current. */
+            __glXUnlock();
+            apple_glx_destroy_context(&oldGC->apple, dpy);
+            __glXLock();
 #else
          if (oldGC->xid == None) {
             /* We are switching away from a context that was
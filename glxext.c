@@ -104,6 +104,10 @@ __glXCloseDisplay(Display * dpy, XExtCodes * codes)
       __glXFreeContext(gc);
    }
 
+#ifdef GLX_USE_APPLEGL
+   apple_glx_close_display(dpy);
+#endif
+
    return XextRemoveDisplay(__glXExtensionInfo, dpy);
 }
 
@@ -220,6 +224,10 @@ __glXFreeDisplayPrivate(XExtData * extension)
    priv->dri2Display = NULL;
 #endif
 
+#ifdef GLX_USE_APPLEGL
+   apple_uninit_glx(priv->dpy);
+#endif
+
    Xfree((char *) priv);
    return 0;
 }
@@ -473,6 +481,17 @@ __glXInitializeVisualConfigFromTags(__GLcontextModes * config, int count,
          /* We ignore this tag.  See the comment above this function. */
          ++bp;
          break;
+      case GLX_BIND_TO_TEXTURE_RGB_EXT:
+      case GLX_BIND_TO_TEXTURE_RGBA_EXT:
+      case GLX_BIND_TO_MIPMAP_TEXTURE_EXT:
+      case GLX_BIND_TO_TEXTURE_TARGETS_EXT:
+      case GLX_Y_INVERTED_EXT:
+         /* 
+          * The server doesn't bind pixmaps for us.  These are set from
+          * what the client supports below.
+          */
+         ++bp;
+         break;
 #else
       case GLX_BIND_TO_TEXTURE_RGB_EXT:
          config->bindToTextureRgb = *bp++;
@@ -512,6 +531,29 @@ __glXInitializeVisualConfigFromTags(__GLcontextModes * config, int count,
                                config->accumAlphaBits) > 0);
    config->haveDepthBuffer = (config->depthBits > 0);
    config->haveStencilBuffer = (config->stencilBits > 0);
+
+#ifdef GLX_USE_APPLEGL
+   /* 
+    * GLX_EXT_texture_from_pixmap is implemented by texturing from the 
+    * pixmap memory directly, so only a single level is available, and
+    * the first row in memory is the top of the pixmap.
+    */
+   if ((config->drawableType & GLX_PIXMAP_BIT) && config->rgbMode) {
+      config->bindToTextureRgb = GL_TRUE;
+      config->bindToTextureRgba = (config->alphaBits > 0);
+      config->bindToMipmapTexture = GL_FALSE;
+      config->bindToTextureTargets = GLX_TEXTURE_2D_BIT_EXT
+         | GLX_TEXTURE_RECTANGLE_BIT_EXT;
+      config->yInverted = GL_TRUE;
+   }
+   else {
+      config->bindToTextureRgb = GL_FALSE;
+      config->bindToTextureRgba = GL_FALSE;
+      config->bindToMipmapTexture = GL_FALSE;
+      config->bindToTextureTargets = 0;
+      config->yInverted = GL_FALSE;
+   }
+#endif
 }
 
 static __GLcontextModes *
@@ -682,7 +724,10 @@ AllocAndFetchScreenConfigs(Display * dpy, __GLXdisplayPrivate * priv)
 #ifdef GLX_DIRECT_RENDERING
       psc->scr = i;
       psc->dpy = dpy;
-      psc->drawHash = __glxHashCreate();
+      /* The drawables are looked up by every thread rendering on the
+       * screen, so they shouldn't serialize on the table.
+       */
+      psc->drawHash = __glxHashCreateConcurrent();
       if (psc->drawHash == NULL)
          continue;
 
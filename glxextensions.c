@@ -74,9 +74,21 @@ struct extension_info
 
 /* *INDENT-OFF* */
 static const struct extension_info known_glx_extensions[] = {
+#ifdef GLX_USE_APPLEGL
+   { GLX(ARB_create_context),          VER(0,0), Y, N, Y, N },
+   { GLX(ARB_create_context_profile),  VER(0,0), Y, N, Y, N },
+#else
+   { GLX(ARB_create_context),          VER(0,0), N, N, N, N },
+   { GLX(ARB_create_context_profile),  VER(0,0), N, N, N, N },
+#endif
    { GLX(ARB_get_proc_address),        VER(1,4), Y, N, Y, N },
    { GLX(ARB_multisample),             VER(1,4), Y, Y, N, N },
    { GLX(ARB_render_texture),          VER(0,0), N, N, N, N },
+#ifdef GLX_USE_APPLEGL
+   { GLX(APPLE_pixmap_batch),          VER(0,0), Y, N, Y, N },
+#else
+   { GLX(APPLE_pixmap_batch),          VER(0,0), N, N, N, N },
+#endif
    { GLX(ATI_pixel_format_float),      VER(0,0), N, N, N, N },
 #ifdef GLX_USE_APPLEGL
    { GLX(EXT_import_context),          VER(0,0), N, N, N, N },
@@ -89,13 +101,18 @@ static const struct extension_info known_glx_extensions[] = {
 #ifdef GLX_USE_APPLEGL
    { GLX(MESA_agp_offset),             VER(0,0), N, N, N, N }, /* Deprecated */
    { GLX(MESA_allocate_memory),        VER(0,0), N, N, N, N },
-   { GLX(MESA_copy_sub_buffer),        VER(0,0), N, N, N, N },
+   { GLX(MESA_copy_sub_buffer),        VER(0,0), Y, N, Y, N },
 #else
    { GLX(MESA_agp_offset),             VER(0,0), N, N, N, Y }, /* Deprecated */
    { GLX(MESA_allocate_memory),        VER(0,0), Y, N, N, Y },
    { GLX(MESA_copy_sub_buffer),        VER(0,0), Y, N, N, N },
 #endif
    { GLX(MESA_pixmap_colormap),        VER(0,0), N, N, N, N }, /* Deprecated */
+#ifdef GLX_USE_APPLEGL
+   { GLX(MESA_query_renderer),         VER(0,0), Y, N, Y, N },
+#else
+   { GLX(MESA_query_renderer),         VER(0,0), N, N, N, N },
+#endif
    { GLX(MESA_release_buffers),        VER(0,0), N, N, N, N }, /* Deprecated */
 #ifdef GLX_USE_APPLEGL
    { GLX(MESA_swap_control),           VER(0,0), N, N, N, N },
@@ -110,7 +127,7 @@ static const struct extension_info known_glx_extensions[] = {
 #ifdef GLX_USE_APPLEGL
    { GLX(NV_vertex_array_range),       VER(0,0), N, N, N, N }, /* Deprecated */
    { GLX(OML_swap_method),             VER(0,0), N, N, N, N },
-   { GLX(OML_sync_control),            VER(0,0), N, N, N, N },
+   { GLX(OML_sync_control),            VER(0,0), Y, N, Y, N },
    { GLX(SGI_make_current_read),       VER(1,3), N, N, N, N },
    { GLX(SGI_swap_control),            VER(0,0), N, N, N, N },
    { GLX(SGI_video_sync),              VER(0,0), N, N, N, N },
@@ -139,7 +156,7 @@ static const struct extension_info known_glx_extensions[] = {
    { GLX(SGIX_swap_group),             VER(0,0), N, N, N, N },
 #ifdef GLX_USE_APPLEGL
    { GLX(SGIX_visual_select_group),    VER(0,0), Y, Y, N, N },
-   { GLX(EXT_texture_from_pixmap),     VER(0,0), Y, N, N, N },
+   { GLX(EXT_texture_from_pixmap),     VER(0,0), Y, N, Y, N },
 #else
    { GLX(SGIX_visual_select_group),    VER(0,0), Y, Y, N, N },
    { GLX(EXT_texture_from_pixmap),     VER(0,0), Y, N, N, N },
@@ -34,8 +34,11 @@
 enum
 {
    ARB_get_proc_address_bit = 0,
+   ARB_create_context_bit,
+   ARB_create_context_profile_bit,
    ARB_multisample_bit,
    ARB_render_texture_bit,
+   APPLE_pixmap_batch_bit,
    ATI_pixel_format_float_bit,
    EXT_visual_info_bit,
    EXT_visual_rating_bit,
@@ -43,6 +46,7 @@ enum
    MESA_agp_offset_bit,
    MESA_allocate_memory_bit,    /* Replaces MESA_agp_offset & NV_vertex_array_range */
    MESA_copy_sub_buffer_bit,
+   MESA_query_renderer_bit,
    MESA_depth_float_bit,
    MESA_pixmap_colormap_bit,
    MESA_release_buffers_bit,
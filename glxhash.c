@@ -29,9 +29,9 @@
  *
  * DESCRIPTION
  *
- * This file contains a straightforward implementation of a fixed-sized
+ * This file contains a straightforward implementation of a dynamic
  * hash table using self-organizing linked lists [Knuth73, pp. 398-399] for
- * collision resolution.  There are two potentially interesting things
+ * collision resolution.  There are three potentially interesting things
  * about this implementation:
  *
  * 1) The table is power-of-two sized.  Prime sized tables are more
@@ -42,19 +42,32 @@
  * 2) The hash computation uses a table of random integers [Hanson97,
  * pp. 39-41].
  *
+ * 3) The table grows by linear hashing [Larson88].  When the load factor
+ * is exceeded, one bucket, the one at the split pointer, is split into
+ * itself and a new bucket at the end of the table, so the expansion cost
+ * is distributed over the insertions, and there is never a rehash of the
+ * whole table.  The buckets are kept in fixed size segments, found through
+ * a directory, so growing the table doesn't move the existing buckets.
+ *
  * FUTURE ENHANCEMENTS
  *
- * With a table size of 512, the current implementation is sufficient for a
- * few hundred keys.  Since this is well above the expected size of the
- * tables for which this implementation was designed, the implementation of
- * dynamic hash tables was postponed until the need arises.  A common (and
- * naive) approach to dynamic hash table implementation simply creates a
- * new hash table when necessary, rehashes all the data into the new table,
- * and destroys the old table.  The approach in [Larson88] is superior in
- * two ways: 1) only a portion of the table is expanded when needed,
- * distributing the expansion cost over several insertions, and 2) portions
- * of the table can be locked, enabling a scalable thread-safe
- * implementation.
+ * The table doesn't shrink when keys are deleted.  The tables this was
+ * designed for rarely shrink much, and merging buckets would only need the
+ * reverse of a split.
+ *
+ * CONCURRENCY
+ *
+ * A table from __glxHashCreate must be serialized by its callers, since
+ * even a lookup reorganizes a list.  A table from __glxHashCreateConcurrent
+ * may be used by several threads at once, by locking portions of the
+ * table [Larson88].  Its lookups don't reorganize the lists, and take a
+ * reader lock on one of several stripes of buckets, so readers never
+ * contend with each other, and writers only with the readers of the same
+ * stripe.  Splitting a bucket takes the whole table for writing, which is
+ * rare.  The statistics and iteration state are kept for each thread, and
+ * iteration copies each bucket before visiting it, so it's safe to delete
+ * the keys that have been visited, even while other threads change the
+ * table.
  *
  * REFERENCES
  *
@@ -73,18 +86,24 @@
 #include "glxhash.h"
 #include <X11/Xfuncproto.h>
 
+#ifndef HASH_MAIN
 #define HASH_MAIN 0
+#endif
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 
 #define HASH_MAGIC 0xdeadbeef
 #define HASH_DEBUG 0
-#define HASH_SIZE  512          /* Good for about 100 entries */
-                                /* If you change this value, you probably
-                                   have to change the HashHash hashing
-                                   function! */
+#define HASH_MIN_SIZE 512       /* The initial number of buckets */
+#define HASH_MAX_LOAD 2         /* Split a bucket above this many keys
+                                   per bucket */
+#define SEGMENT_SHIFT 8
+#define SEGMENT_SIZE  (1 << SEGMENT_SHIFT)   /* Buckets per segment */
+#define SEGMENT_MASK  (SEGMENT_SIZE - 1)
+#define HASH_STRIPES  16        /* Bucket locks in a concurrent table */
 
 #define HASH_ALLOC malloc
 #define HASH_FREE  free
@@ -111,50 +130,259 @@ typedef struct __glxHashBucket
    struct __glxHashBucket *next;
 } __glxHashBucket, *__glxHashBucketPtr;
 
-typedef struct __glxHashTable *__glxHashTablePtr;
-struct __glxHashTable
+/* The statistics and iteration state of a thread.  A concurrent table has
+   one of these for each thread that uses it, and other tables have one. */
+
+typedef struct __glxHashThread
 {
-   unsigned long magic;
    unsigned long hits;          /* At top of linked list */
    unsigned long partials;      /* Not at top of linked list */
    unsigned long misses;        /* Not in table */
-   __glxHashBucketPtr buckets[HASH_SIZE];
-   int p0;
-   __glxHashBucketPtr p1;
+   unsigned long p0;            /* The next bucket to visit */
+   __glxHashBucketPtr p1;       /* The next entry to return */
+   __glxHashBucketPtr snapshot; /* A copy of the bucket being visited */
+   unsigned long snapshot_size;
+   struct __glxHashThread *next;
+} __glxHashThread;
+
+typedef struct __glxHashTable *__glxHashTablePtr;
+struct __glxHashTable
+{
+   unsigned long magic;
+   __glxHashBucketPtr **segments;       /* The directory */
+   unsigned long nsegments;     /* Allocated directory entries */
+   unsigned long maxp;          /* Buckets at the start of this round */
+   unsigned long p;             /* The next bucket to split */
+   unsigned long entries;
+   int concurrent;
+   __glxHashThread thread;      /* Used if the table isn't concurrent */
+
+   /* These are only used by a concurrent table. */
+   pthread_key_t thread_key;
+   pthread_mutex_t threads_lock;
+   __glxHashThread *threads;
+   pthread_rwlock_t resize_lock;        /* Write locked to split */
+   pthread_rwlock_t stripes[HASH_STRIPES];
 };
 
+#define HASH_BUCKETS(table) ((table)->maxp + (table)->p)
+#define HASH_HEAD(table, i) \
+   (&(table)->segments[(i) >> SEGMENT_SHIFT][(i) & SEGMENT_MASK])
+#define HASH_STRIPE(table, i) (&(table)->stripes[(i) & (HASH_STRIPES - 1)])
+
+static unsigned long scatter[256];
+static pthread_once_t scatter_once = PTHREAD_ONCE_INIT;
+
+static void
+HashInitScatter(void)
+{
+   HASH_RANDOM_DECL;
+   int i;
+
+   HASH_RANDOM_INIT(37);
+   for (i = 0; i < 256; i++)
+      scatter[i] = HASH_RANDOM;
+   HASH_RANDOM_DESTROY;
+}
+
 static unsigned long
 HashHash(unsigned long key)
 {
    unsigned long hash = 0;
    unsigned long tmp = key;
-   static int init = 0;
-   static unsigned long scatter[256];
-   int i;
 
-   if (!init) {
-      HASH_RANDOM_DECL;
-      HASH_RANDOM_INIT(37);
-      for (i = 0; i < 256; i++)
-         scatter[i] = HASH_RANDOM;
-      HASH_RANDOM_DESTROY;
-      ++init;
-   }
+   pthread_once(&scatter_once, HashInitScatter);
 
    while (tmp) {
       hash = (hash << 1) + scatter[tmp & 0xff];
       tmp >>= 8;
    }
 
-   hash %= HASH_SIZE;
 #if HASH_DEBUG
-   printf("Hash(%d) = %d\n", key, hash);
+   printf("Hash(%lu) = %lu\n", key, hash);
 #endif
    return hash;
 }
 
-_X_HIDDEN __glxHashTable *
-__glxHashCreate(void)
+/* The locks of a concurrent table.  A reader or writer holds the resize
+   lock for reading, so that the bucket of a key can't change, and then the
+   lock of the stripe of buckets that the key is in. */
+
+static void
+HashLock(__glxHashTablePtr table, pthread_rwlock_t * lock, int write)
+{
+   int err;
+
+   if (!table->concurrent)
+      return;
+
+   if (write)
+      err = pthread_rwlock_wrlock(lock);
+   else
+      err = pthread_rwlock_rdlock(lock);
+
+   if (err) {
+      fprintf(stderr, "pthread_rwlock lock failure in %s: %d\n",
+              __func__, err);
+      abort();
+   }
+}
+
+static void
+HashUnlock(__glxHashTablePtr table, pthread_rwlock_t * lock)
+{
+   int err;
+
+   if (!table->concurrent)
+      return;
+
+   err = pthread_rwlock_unlock(lock);
+
+   if (err) {
+      fprintf(stderr, "pthread_rwlock_unlock failure in %s: %d\n",
+              __func__, err);
+      abort();
+   }
+}
+
+/* Return the state of the calling thread, or NULL if it can't be
+   allocated. */
+
+static __glxHashThread *
+HashThread(__glxHashTablePtr table)
+{
+   __glxHashThread *thread;
+   int err;
+
+   if (!table->concurrent)
+      return &table->thread;
+
+   thread = pthread_getspecific(table->thread_key);
+   if (thread)
+      return thread;
+
+   thread = calloc(1, sizeof(*thread));
+   if (!thread)
+      return NULL;
+
+   if (pthread_setspecific(table->thread_key, thread)) {
+      free(thread);
+      return NULL;
+   }
+
+   err = pthread_mutex_lock(&table->threads_lock);
+   if (err) {
+      fprintf(stderr, "pthread_mutex_lock failure in %s: %d\n",
+              __func__, err);
+      abort();
+   }
+
+   /* The table frees the state of every thread when it's destroyed. */
+   thread->next = table->threads;
+   table->threads = thread;
+
+   err = pthread_mutex_unlock(&table->threads_lock);
+   if (err) {
+      fprintf(stderr, "pthread_mutex_unlock failure in %s: %d\n",
+              __func__, err);
+      abort();
+   }
+
+   return thread;
+}
+
+/* Return the bucket for a hash.  The buckets before the split pointer
+   have been split this round, so they use one more bit of the hash. */
+
+static unsigned long
+HashAddress(__glxHashTablePtr table, unsigned long hash)
+{
+   unsigned long h = hash & (table->maxp - 1);
+
+   if (h < table->p)
+      h = hash & ((table->maxp << 1) - 1);
+   return h;
+}
+
+/* Add a segment for the buckets starting at index n.
+   Return 0 on success, and -1 on failure. */
+
+static int
+HashAddSegment(__glxHashTablePtr table, unsigned long n)
+{
+   unsigned long s = n >> SEGMENT_SHIFT;
+   __glxHashBucketPtr **segments;
+
+   if (s >= table->nsegments) {
+      segments = realloc(table->segments,
+                         sizeof(*segments) * table->nsegments * 2);
+      if (!segments)
+         return -1;
+      memset(segments + table->nsegments, 0,
+             sizeof(*segments) * table->nsegments);
+      table->segments = segments;
+      table->nsegments *= 2;
+   }
+
+   table->segments[s] = calloc(SEGMENT_SIZE, sizeof(__glxHashBucketPtr));
+   if (!table->segments[s])
+      return -1;
+   return 0;
+}
+
+/* Split the bucket at the split pointer, moving the keys that now hash
+   to the new bucket at the end of the table.  A concurrent table must
+   have the resize lock held for writing. */
+
+static void
+HashSplit(__glxHashTablePtr table)
+{
+   unsigned long n = HASH_BUCKETS(table);
+   __glxHashBucketPtr *old;
+   __glxHashBucketPtr *new;
+   __glxHashBucketPtr bucket;
+   __glxHashBucketPtr next;
+
+   if (!(n & SEGMENT_MASK) && HashAddSegment(table, n))
+      return;                   /* Keep the longer chains */
+
+   old = HASH_HEAD(table, table->p);
+   new = HASH_HEAD(table, n);
+   bucket = *old;
+   *old = NULL;
+
+   for (; bucket; bucket = next) {
+      next = bucket->next;
+      if ((HashHash(bucket->key) & ((table->maxp << 1) - 1)) == n) {
+         bucket->next = *new;
+         *new = bucket;
+      }
+      else {
+         bucket->next = *old;
+         *old = bucket;
+      }
+   }
+
+   if (++table->p == table->maxp) {
+      table->maxp <<= 1;
+      table->p = 0;
+   }
+}
+
+/* Split a bucket if the table is over the load factor.  The count of
+   entries only changes with the resize lock held for reading. */
+
+static void
+HashGrow(__glxHashTablePtr table)
+{
+   HashLock(table, &table->resize_lock, 1);
+   if (table->entries > HASH_BUCKETS(table) * HASH_MAX_LOAD)
+      HashSplit(table);
+   HashUnlock(table, &table->resize_lock);
+}
+
+static __glxHashTablePtr
+HashCreate(int concurrent)
 {
    __glxHashTablePtr table;
    int i;
@@ -162,68 +390,152 @@ __glxHashCreate(void)
    table = HASH_ALLOC(sizeof(*table));
    if (!table)
       return NULL;
+   memset(table, 0, sizeof(*table));
    table->magic = HASH_MAGIC;
-   table->hits = 0;
-   table->partials = 0;
-   table->misses = 0;
+   table->maxp = HASH_MIN_SIZE;
+   table->p = 0;
+   table->entries = 0;
+   table->concurrent = concurrent;
+
+   if (concurrent) {
+      if (pthread_key_create(&table->thread_key, NULL)) {
+         HASH_FREE(table);
+         return NULL;
+      }
+
+      if (pthread_mutex_init(&table->threads_lock, NULL)
+          || pthread_rwlock_init(&table->resize_lock, NULL)) {
+         fprintf(stderr, "unable to initialize a glxhash lock\n");
+         abort();
+      }
 
-   for (i = 0; i < HASH_SIZE; i++)
-      table->buckets[i] = NULL;
+      for (i = 0; i < HASH_STRIPES; i++) {
+         if (pthread_rwlock_init(&table->stripes[i], NULL)) {
+            fprintf(stderr, "unable to initialize a glxhash lock\n");
+            abort();
+         }
+      }
+   }
+
+   table->nsegments = HASH_MIN_SIZE / SEGMENT_SIZE;
+   table->segments = calloc(table->nsegments, sizeof(*table->segments));
+   if (!table->segments) {
+      __glxHashDestroy(table);
+      return NULL;
+   }
+
+   for (i = 0; i < HASH_MIN_SIZE; i += SEGMENT_SIZE) {
+      if (HashAddSegment(table, i)) {
+         __glxHashDestroy(table);
+         return NULL;
+      }
+   }
    return table;
 }
 
+_X_HIDDEN __glxHashTable *
+__glxHashCreate(void)
+{
+   return HashCreate(0);
+}
+
+/* Create a table that may be used by several threads at once.  Lookups
+   don't reorganize the lists, so they only read the table, and readers of
+   different buckets don't contend.  The statistics and iteration state
+   are kept for each thread. */
+
+_X_HIDDEN __glxHashTable *
+__glxHashCreateConcurrent(void)
+{
+   return HashCreate(1);
+}
+
 _X_HIDDEN int
 __glxHashDestroy(__glxHashTable * t)
 {
    __glxHashTablePtr table = (__glxHashTablePtr) t;
    __glxHashBucketPtr bucket;
    __glxHashBucketPtr next;
-   int i;
+   __glxHashThread *thread;
+   unsigned long i;
 
    if (table->magic != HASH_MAGIC)
       return -1;                /* Bad magic */
 
-   for (i = 0; i < HASH_SIZE; i++) {
-      for (bucket = table->buckets[i]; bucket;) {
-         next = bucket->next;
-         HASH_FREE(bucket);
-         bucket = next;
+   for (i = 0; table->segments && i < table->nsegments
+        && table->segments[i]; i++) {
+      if (i << SEGMENT_SHIFT < HASH_BUCKETS(table)) {
+         unsigned long j;
+
+         for (j = 0; j < SEGMENT_SIZE; j++) {
+            for (bucket = table->segments[i][j]; bucket;) {
+               next = bucket->next;
+               HASH_FREE(bucket);
+               bucket = next;
+            }
+         }
       }
+      free(table->segments[i]);
    }
+   free(table->segments);
+
+   if (table->concurrent) {
+      while (table->threads) {
+         thread = table->threads;
+         table->threads = thread->next;
+         free(thread->snapshot);
+         free(thread);
+      }
+
+      pthread_key_delete(table->thread_key);
+      pthread_mutex_destroy(&table->threads_lock);
+      pthread_rwlock_destroy(&table->resize_lock);
+      for (i = 0; i < HASH_STRIPES; i++)
+         pthread_rwlock_destroy(&table->stripes[i]);
+   }
+
+   table->magic = 0;
    HASH_FREE(table);
    return 0;
 }
 
-/* Find the bucket and organize the list so that this bucket is at the
-   top. */
+/* Find the bucket for key in the list at hash, and return it and the
+   link that points to it.  In a table that isn't concurrent, organize the
+   list so that this bucket is at the top.  The caller holds the locks. */
 
 static __glxHashBucketPtr
-HashFind(__glxHashTablePtr table, unsigned long key, unsigned long *h)
+HashFind(__glxHashTablePtr table, unsigned long hash, unsigned long key,
+         __glxHashBucketPtr ** link)
 {
-   unsigned long hash = HashHash(key);
-   __glxHashBucketPtr prev = NULL;
+   __glxHashThread *thread = HashThread(table);
+   __glxHashBucketPtr *head = HASH_HEAD(table, hash);
+   __glxHashBucketPtr *prev = head;
    __glxHashBucketPtr bucket;
 
-   if (h)
-      *h = hash;
-
-   for (bucket = table->buckets[hash]; bucket; bucket = bucket->next) {
+   for (bucket = *head; bucket; bucket = bucket->next) {
       if (bucket->key == key) {
-         if (prev) {
-            /* Organize */
-            prev->next = bucket->next;
-            bucket->next = table->buckets[hash];
-            table->buckets[hash] = bucket;
-            ++table->partials;
+         if (prev != head) {
+            if (!table->concurrent) {
+               /* Organize */
+               *prev = bucket->next;
+               bucket->next = *head;
+               *head = bucket;
+               prev = head;
+            }
+            if (thread)
+               ++thread->partials;
          }
-         else {
-            ++table->hits;
+         else if (thread) {
+            ++thread->hits;
          }
+         if (link)
+            *link = prev;
          return bucket;
       }
-      prev = bucket;
+      prev = &bucket->next;
    }
-   ++table->misses;
+   if (thread)
+      ++thread->misses;
    return NULL;
 }
 
@@ -232,14 +544,24 @@ __glxHashLookup(__glxHashTable * t, unsigned long key, void **value)
 {
    __glxHashTablePtr table = (__glxHashTablePtr) t;
    __glxHashBucketPtr bucket;
+   unsigned long hash;
 
    if (!table || table->magic != HASH_MAGIC)
       return -1;                /* Bad magic */
 
-   bucket = HashFind(table, key, NULL);
+   HashLock(table, &table->resize_lock, 0);
+   hash = HashAddress(table, HashHash(key));
+   HashLock(table, HASH_STRIPE(table, hash), 0);
+
+   bucket = HashFind(table, hash, key, NULL);
+   if (bucket)
+      *value = bucket->value;
+
+   HashUnlock(table, HASH_STRIPE(table, hash));
+   HashUnlock(table, &table->resize_lock);
+
    if (!bucket)
       return 1;                 /* Not found */
-   *value = bucket->value;
    return 0;                    /* Found */
 }
 
@@ -249,24 +571,45 @@ __glxHashInsert(__glxHashTable * t, unsigned long key, void *value)
    __glxHashTablePtr table = (__glxHashTablePtr) t;
    __glxHashBucketPtr bucket;
    unsigned long hash;
+   int ret = 0;
+   int grow = 0;
 
    if (table->magic != HASH_MAGIC)
       return -1;                /* Bad magic */
 
-   if (HashFind(table, key, &hash))
-      return 1;                 /* Already in table */
+   HashLock(table, &table->resize_lock, 0);
+   hash = HashAddress(table, HashHash(key));
+   HashLock(table, HASH_STRIPE(table, hash), 1);
 
-   bucket = HASH_ALLOC(sizeof(*bucket));
-   if (!bucket)
-      return -1;                /* Error */
-   bucket->key = key;
-   bucket->value = value;
-   bucket->next = table->buckets[hash];
-   table->buckets[hash] = bucket;
+   if (HashFind(table, hash, key, NULL)) {
+      ret = 1;                  /* Already in table */
+   }
+   else {
+      bucket = HASH_ALLOC(sizeof(*bucket));
+      if (bucket) {
+         bucket->key = key;
+         bucket->value = value;
+         bucket->next = *HASH_HEAD(table, hash);
+         *HASH_HEAD(table, hash) = bucket;
 #if HASH_DEBUG
-   printf("Inserted %d at %d/%p\n", key, hash, bucket);
+         printf("Inserted %lu at %lu/%p\n", key, hash, bucket);
 #endif
-   return 0;                    /* Added to table */
+      }
+      else {
+         ret = -1;              /* Error */
+      }
+   }
+
+   if (ret == 0)
+      grow = __sync_add_and_fetch(&table->entries, 1)
+         > HASH_BUCKETS(table) * HASH_MAX_LOAD;
+
+   HashUnlock(table, HASH_STRIPE(table, hash));
+   HashUnlock(table, &table->resize_lock);
+
+   if (grow)
+      HashGrow(table);
+   return ret;                  /* Added to table */
 }
 
 _X_HIDDEN int
@@ -275,52 +618,135 @@ __glxHashDelete(__glxHashTable * t, unsigned long key)
    __glxHashTablePtr table = (__glxHashTablePtr) t;
    unsigned long hash;
    __glxHashBucketPtr bucket;
+   __glxHashBucketPtr *link;
 
    if (table->magic != HASH_MAGIC)
       return -1;                /* Bad magic */
 
-   bucket = HashFind(table, key, &hash);
+   HashLock(table, &table->resize_lock, 0);
+   hash = HashAddress(table, HashHash(key));
+   HashLock(table, HASH_STRIPE(table, hash), 1);
+
+   bucket = HashFind(table, hash, key, &link);
+   if (bucket) {
+      *link = bucket->next;
+      (void) __sync_sub_and_fetch(&table->entries, 1);
+   }
+
+   HashUnlock(table, HASH_STRIPE(table, hash));
+   HashUnlock(table, &table->resize_lock);
 
    if (!bucket)
       return 1;                 /* Not found */
 
-   table->buckets[hash] = bucket->next;
    HASH_FREE(bucket);
    return 0;
 }
 
+/* Copy the list at hash for a thread to iterate over, so that the table
+   may be changed while the thread visits the keys.  The caller holds the
+   resize lock.  Return 0 on success, and -1 on failure. */
+
+static int
+HashSnapshot(__glxHashTablePtr table, __glxHashThread * thread,
+             unsigned long hash)
+{
+   __glxHashBucketPtr bucket;
+   __glxHashBucketPtr snapshot;
+   unsigned long count = 0;
+   int ret = 0;
+
+   HashLock(table, HASH_STRIPE(table, hash), 0);
+
+   for (bucket = *HASH_HEAD(table, hash); bucket; bucket = bucket->next)
+      ++count;
+
+   if (count > thread->snapshot_size) {
+      snapshot = realloc(thread->snapshot, sizeof(*snapshot) * count);
+      if (snapshot) {
+         thread->snapshot = snapshot;
+         thread->snapshot_size = count;
+      }
+      else {
+         ret = -1;
+      }
+   }
+
+   thread->p1 = NULL;
+   if (ret == 0 && count) {
+      snapshot = thread->snapshot;
+      for (bucket = *HASH_HEAD(table, hash); bucket; bucket = bucket->next) {
+         snapshot->key = bucket->key;
+         snapshot->value = bucket->value;
+         snapshot->next = --count ? snapshot + 1 : NULL;
+         ++snapshot;
+      }
+      thread->p1 = thread->snapshot;
+   }
+
+   HashUnlock(table, HASH_STRIPE(table, hash));
+   return ret;
+}
+
+/* Iteration over a concurrent table visits each key that is in the table
+   for the whole iteration at least once.  A key may be visited twice if
+   another thread splits its bucket during the iteration.  The keys that
+   have been visited may be deleted. */
+
 _X_HIDDEN int
 __glxHashNext(__glxHashTable * t, unsigned long *key, void **value)
 {
    __glxHashTablePtr table = (__glxHashTablePtr) t;
+   __glxHashThread *thread = HashThread(table);
+   int ret = 0;
 
-   while (table->p0 < HASH_SIZE) {
-      if (table->p1) {
-         *key = table->p1->key;
-         *value = table->p1->value;
-         table->p1 = table->p1->next;
+   if (!thread)
+      return -1;                /* Error */
+
+   for (;;) {
+      if (thread->p1) {
+         *key = thread->p1->key;
+         *value = thread->p1->value;
+         thread->p1 = thread->p1->next;
          return 1;
       }
-      table->p1 = table->buckets[table->p0];
-      ++table->p0;
+
+      HashLock(table, &table->resize_lock, 0);
+      if (thread->p0 >= HASH_BUCKETS(table))
+         ret = 1;
+      else if (table->concurrent)
+         ret = HashSnapshot(table, thread, thread->p0) ? -1 : 0;
+      else
+         thread->p1 = *HASH_HEAD(table, thread->p0);
+      HashUnlock(table, &table->resize_lock);
+
+      if (ret)
+         return ret < 0 ? -1 : 0;
+      ++thread->p0;
    }
-   return 0;
 }
 
 _X_HIDDEN int
 __glxHashFirst(__glxHashTable * t, unsigned long *key, void **value)
 {
    __glxHashTablePtr table = (__glxHashTablePtr) t;
+   __glxHashThread *thread;
 
    if (table->magic != HASH_MAGIC)
       return -1;                /* Bad magic */
 
-   table->p0 = 0;
-   table->p1 = table->buckets[0];
+   thread = HashThread(table);
+   if (!thread)
+      return -1;                /* Error */
+
+   thread->p0 = 0;
+   thread->p1 = NULL;
    return __glxHashNext(table, key, value);
 }
 
 #if HASH_MAIN
+#include <sys/time.h>
+
 #define DIST_LIMIT 10
 static int dist[DIST_LIMIT];
 
@@ -355,19 +781,30 @@ update_dist(int count)
 static void
 compute_dist(__glxHashTablePtr table)
 {
-   int i;
+   unsigned long i;
+   unsigned long hits, partials, misses;
    __glxHashBucketPtr bucket;
+   __glxHashThread *thread;
+
+   hits = table->thread.hits;
+   partials = table->thread.partials;
+   misses = table->thread.misses;
+   for (thread = table->threads; thread; thread = thread->next) {
+      hits += thread->hits;
+      partials += thread->partials;
+      misses += thread->misses;
+   }
 
-   printf("Hits = %ld, partials = %ld, misses = %ld\n",
-          table->hits, table->partials, table->misses);
+   printf("Hits = %ld, partials = %ld, misses = %ld, buckets = %lu\n",
+          hits, partials, misses, HASH_BUCKETS(table));
    clear_dist();
-   for (i = 0; i < HASH_SIZE; i++) {
-      bucket = table->buckets[i];
+   for (i = 0; i < HASH_BUCKETS(table); i++) {
+      bucket = *HASH_HEAD(table, i);
       update_dist(count_entries(bucket));
    }
    for (i = 0; i < DIST_LIMIT; i++) {
       if (i != DIST_LIMIT - 1)
-         printf("%5d %10d\n", i, dist[i]);
+         printf("%5lu %10d\n", i, dist[i]);
       else
          printf("other %10d\n", dist[i]);
    }
@@ -377,7 +814,7 @@ static void
 check_table(__glxHashTablePtr table, unsigned long key, unsigned long value)
 {
    unsigned long retval = 0;
-   int retcode = __glxHashLookup(table, key, &retval);
+   int retcode = __glxHashLookup(table, key, (void **) &retval);
 
    switch (retcode) {
    case -1:
@@ -401,16 +838,176 @@ check_table(__glxHashTablePtr table, unsigned long key, unsigned long value)
    }
 }
 
+/* Check that iteration visits every key once. */
+
+static void
+check_iteration(__glxHashTablePtr table, unsigned long count)
+{
+   unsigned long key, seen = 0, sum = 0;
+   void *value;
+
+   if (__glxHashFirst(table, &key, &value) == 1) {
+      do {
+         ++seen;
+         sum += (unsigned long) value;
+      } while (__glxHashNext(table, &key, &value) == 1);
+   }
+
+   if (seen != count || sum != count * (count - 1) / 2)
+      printf("Bad iteration: saw %lu of %lu keys\n", seen, count);
+}
+
+static double
+now(void)
+{
+   struct timeval tv;
+
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec * 1e9 + tv.tv_usec * 1e3;
+}
+
+/* Time inserting, looking up, and deleting count keys that are spaced
+   like X resource IDs. */
+
+static void
+benchmark(unsigned long count, int concurrent)
+{
+   __glxHashTablePtr table;
+   unsigned long i;
+   double start, insert, lookup, delete;
+   void *value;
+
+   table = concurrent ? __glxHashCreateConcurrent() : __glxHashCreate();
+
+   start = now();
+   for (i = 0; i < count; i++)
+      __glxHashInsert(table, 0x200000 + i * 3, (void *) i);
+   insert = now() - start;
+
+   check_iteration(table, count);
+
+   start = now();
+   for (i = 0; i < count; i++)
+      __glxHashLookup(table, 0x200000 + ((i * 7919) % count) * 3, &value);
+   lookup = now() - start;
+
+   start = now();
+   for (i = 0; i < count; i++)
+      __glxHashDelete(table, 0x200000 + i * 3);
+   delete = now() - start;
+
+   printf("%8lu keys %8lu buckets: insert %7.1f ns, lookup %7.1f ns, "
+          "delete %7.1f ns\n", count, HASH_BUCKETS(table),
+          insert / count, lookup / count, delete / count);
+   __glxHashDestroy(table);
+}
+
+#define THREAD_KEYS    10000
+#define THREAD_LOOKUPS 1000000
+
+static __glxHashTablePtr thread_table;
+static pthread_mutex_t thread_table_lock = PTHREAD_MUTEX_INITIALIZER;
+static int thread_writing;
+
+/* Look up the keys, which map to themselves.  A table that isn't
+   concurrent is serialized by a lock, as its callers must. */
+
+static void *
+lookup_thread(void *arg)
+{
+   unsigned long i, key, bad = 0;
+   void *value;
+   int ret;
+
+   for (i = 0; i < THREAD_LOOKUPS; i++) {
+      key = 1 + (i * 7919 + (unsigned long) arg) % THREAD_KEYS;
+      if (!thread_table->concurrent)
+         pthread_mutex_lock(&thread_table_lock);
+      ret = __glxHashLookup(thread_table, key, &value);
+      if (!thread_table->concurrent)
+         pthread_mutex_unlock(&thread_table_lock);
+      if (ret != 0 || (unsigned long) value != key)
+         ++bad;
+   }
+
+   if (bad)
+      printf("Bad concurrent lookups: %lu\n", bad);
+   return NULL;
+}
+
+/* Insert, sweep, and delete other keys while the lookups run. */
+
+static void *
+write_thread(void *arg)
+{
+   unsigned long i, key, base = THREAD_KEYS * 2;
+   void *value;
+
+   while (__sync_fetch_and_add(&thread_writing, 0)) {
+      for (i = 0; i < 1000; i++)
+         __glxHashInsert(thread_table, base + i, (void *) (base + i));
+
+      if (__glxHashFirst(thread_table, &key, &value) == 1) {
+         do {
+            if (key >= base)
+               __glxHashDelete(thread_table, key);
+         } while (__glxHashNext(thread_table, &key, &value) == 1);
+      }
+   }
+   return NULL;
+}
+
+/* Time the lookups of nthreads threads, while another thread changes
+   the table if it's concurrent. */
+
+static void
+thread_benchmark(int nthreads, int concurrent)
+{
+   pthread_t threads[8], writer;
+   unsigned long i;
+   double start;
+   int j;
+
+   thread_table = concurrent ? __glxHashCreateConcurrent() : __glxHashCreate();
+   for (i = 1; i <= THREAD_KEYS; i++)
+      __glxHashInsert(thread_table, i, (void *) i);
+
+   (void) __sync_lock_test_and_set(&thread_writing, concurrent);
+   if (concurrent)
+      pthread_create(&writer, NULL, write_thread, NULL);
+
+   start = now();
+   for (j = 0; j < nthreads; j++)
+      pthread_create(&threads[j], NULL, lookup_thread,
+                     (void *) (unsigned long) j);
+   for (j = 0; j < nthreads; j++)
+      pthread_join(threads[j], NULL);
+
+   printf("%d threads %s: %7.1f ns per lookup\n", nthreads,
+          concurrent ? "concurrent with a writer" : "serialized              ",
+          (now() - start) / (THREAD_LOOKUPS * (double) nthreads));
+
+   if (concurrent) {
+      (void) __sync_lock_test_and_set(&thread_writing, 0);
+      pthread_join(writer, NULL);
+   }
+
+   if (concurrent)
+      compute_dist(thread_table);
+   __glxHashDestroy(thread_table);
+}
+
 int
 main(void)
 {
    __glxHashTablePtr table;
+   unsigned long count;
    int i;
 
    printf("\n***** 256 consecutive integers ****\n");
    table = __glxHashCreate();
    for (i = 0; i < 256; i++)
-      __glxHashInsert(table, i, i);
+      __glxHashInsert(table, i, (void *) (unsigned long) i);
    for (i = 0; i < 256; i++)
       check_table(table, i, i);
    for (i = 256; i >= 0; i--)
@@ -421,7 +1018,7 @@ main(void)
    printf("\n***** 1024 consecutive integers ****\n");
    table = __glxHashCreate();
    for (i = 0; i < 1024; i++)
-      __glxHashInsert(table, i, i);
+      __glxHashInsert(table, i, (void *) (unsigned long) i);
    for (i = 0; i < 1024; i++)
       check_table(table, i, i);
    for (i = 1024; i >= 0; i--)
@@ -432,7 +1029,7 @@ main(void)
    printf("\n***** 1024 consecutive page addresses (4k pages) ****\n");
    table = __glxHashCreate();
    for (i = 0; i < 1024; i++)
-      __glxHashInsert(table, i * 4096, i);
+      __glxHashInsert(table, i * 4096, (void *) (unsigned long) i);
    for (i = 0; i < 1024; i++)
       check_table(table, i * 4096, i);
    for (i = 1024; i >= 0; i--)
@@ -444,7 +1041,7 @@ main(void)
    table = __glxHashCreate();
    srandom(0xbeefbeef);
    for (i = 0; i < 1024; i++)
-      __glxHashInsert(table, random(), i);
+      __glxHashInsert(table, random(), (void *) (unsigned long) i);
    srandom(0xbeefbeef);
    for (i = 0; i < 1024; i++)
       check_table(table, random(), i);
@@ -458,7 +1055,7 @@ main(void)
    table = __glxHashCreate();
    srandom(0xbeefbeef);
    for (i = 0; i < 5000; i++)
-      __glxHashInsert(table, random(), i);
+      __glxHashInsert(table, random(), (void *) (unsigned long) i);
    srandom(0xbeefbeef);
    for (i = 0; i < 5000; i++)
       check_table(table, random(), i);
@@ -466,8 +1063,35 @@ main(void)
    for (i = 0; i < 5000; i++)
       check_table(table, random(), i);
    compute_dist(table);
+   check_iteration(table, 5000);
    __glxHashDestroy(table);
 
+   printf("\n***** 5000 random integers, concurrent ****\n");
+   table = __glxHashCreateConcurrent();
+   srandom(0xbeefbeef);
+   for (i = 0; i < 5000; i++)
+      __glxHashInsert(table, random(), (void *) (unsigned long) i);
+   srandom(0xbeefbeef);
+   for (i = 0; i < 5000; i++)
+      check_table(table, random(), i);
+   compute_dist(table);
+   check_iteration(table, 5000);
+   __glxHashDestroy(table);
+
+   printf("\n***** Benchmark ****\n");
+   for (count = 10; count <= 1000000; count *= 10)
+      benchmark(count, 0);
+
+   printf("\n***** Benchmark, concurrent ****\n");
+   for (count = 10; count <= 1000000; count *= 10)
+      benchmark(count, 1);
+
+   printf("\n***** Threads ****\n");
+   for (i = 1; i <= 8; i *= 2) {
+      thread_benchmark(i, 0);
+      thread_benchmark(i, 1);
+   }
+
    return 0;
 }
 #endif
@@ -6,6 +6,7 @@ typedef struct __glxHashTable __glxHashTable;
 
 /* Hash table routines */
 extern __glxHashTable *__glxHashCreate(void);
+extern __glxHashTable *__glxHashCreateConcurrent(void);
 extern int __glxHashDestroy(__glxHashTable * t);
 extern int __glxHashLookup(__glxHashTable * t, unsigned long key,
                            void **value);
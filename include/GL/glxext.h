@@ -396,6 +396,24 @@ extern "C" {
 #ifndef GLX_NV_copy_image
 #endif
 
+#ifndef GLX_MESA_query_renderer
+#define GLX_RENDERER_VENDOR_ID_MESA        0x8183
+#define GLX_RENDERER_DEVICE_ID_MESA        0x8184
+#define GLX_RENDERER_VERSION_MESA          0x8185
+#define GLX_RENDERER_ACCELERATED_MESA      0x8186
+#define GLX_RENDERER_VIDEO_MEMORY_MESA     0x8187
+#define GLX_RENDERER_UNIFIED_MEMORY_ARCHITECTURE_MESA 0x8188
+#define GLX_RENDERER_PREFERRED_PROFILE_MESA 0x8189
+#define GLX_RENDERER_OPENGL_CORE_PROFILE_VERSION_MESA 0x818A
+#define GLX_RENDERER_OPENGL_COMPATIBILITY_PROFILE_VERSION_MESA 0x818B
+#define GLX_RENDERER_OPENGL_ES_PROFILE_VERSION_MESA 0x818C
+#define GLX_RENDERER_OPENGL_ES2_PROFILE_VERSION_MESA 0x818D
+#define GLX_RENDERER_ID_MESA               0x818E
+#endif
+
+#ifndef GLX_APPLE_pixmap_batch
+#endif
+
 
 /*************************************************************/
 
@@ -925,6 +943,30 @@ extern void glXCopyImageSubDataNV (Display *, GLXContext, GLuint, GLenum, GLint,
 typedef void ( * PFNGLXCOPYIMAGESUBDATANVPROC) (Display *dpy, GLXContext srcCtx, GLuint srcName, GLenum srcTarget, GLint srcLevel, GLint srcX, GLint srcY, GLint srcZ, GLXContext dstCtx, GLuint dstName, GLenum dstTarget, GLint dstLevel, GLint dstX, GLint dstY, GLint dstZ, GLsizei width, GLsizei height, GLsizei depth);
 #endif
 
+#ifndef GLX_MESA_query_renderer
+#define GLX_MESA_query_renderer 1
+#ifdef GLX_GLXEXT_PROTOTYPES
+extern Bool glXQueryCurrentRendererIntegerMESA (int, unsigned int *);
+extern const char *glXQueryCurrentRendererStringMESA (int);
+extern Bool glXQueryRendererIntegerMESA (Display *, int, int, int, unsigned int *);
+extern const char *glXQueryRendererStringMESA (Display *, int, int, int);
+#endif /* GLX_GLXEXT_PROTOTYPES */
+typedef Bool ( * PFNGLXQUERYCURRENTRENDERERINTEGERMESAPROC) (int attribute, unsigned int *value);
+typedef const char *( * PFNGLXQUERYCURRENTRENDERERSTRINGMESAPROC) (int attribute);
+typedef Bool ( * PFNGLXQUERYRENDERERINTEGERMESAPROC) (Display *dpy, int screen, int renderer, int attribute, unsigned int *value);
+typedef const char *( * PFNGLXQUERYRENDERERSTRINGMESAPROC) (Display *dpy, int screen, int renderer, int attribute);
+#endif
+
+#ifndef GLX_APPLE_pixmap_batch
+#define GLX_APPLE_pixmap_batch 1
+#ifdef GLX_GLXEXT_PROTOTYPES
+extern int glXCreatePixmapsAPPLE (Display *, GLXFBConfig, int, const Pixmap *, const int *, GLXPixmap *);
+extern void glXDestroyPixmapsAPPLE (Display *, int, const GLXPixmap *);
+#endif /* GLX_GLXEXT_PROTOTYPES */
+typedef int ( * PFNGLXCREATEPIXMAPSAPPLEPROC) (Display *dpy, GLXFBConfig config, int count, const Pixmap *pixmaps, const int *attrib_list, GLXPixmap *glxpixmaps);
+typedef void ( * PFNGLXDESTROYPIXMAPSAPPLEPROC) (Display *dpy, int count, const GLXPixmap *glxpixmaps);
+#endif
+
 
 #ifdef __cplusplus
 }
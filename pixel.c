@@ -83,17 +83,24 @@ static void
 FillBitmap(__GLXcontext * gc, GLint width, GLint height,
            GLenum format, const GLvoid * userdata, GLubyte * destImage)
 {
-   const __GLXattribute *state = gc->client_state_private;
-   GLint rowLength = state->storeUnpack.rowLength;
-   GLint alignment = state->storeUnpack.alignment;
-   GLint skipPixels = state->storeUnpack.skipPixels;
-   GLint skipRows = state->storeUnpack.skipRows;
-   GLint lsbFirst = state->storeUnpack.lsbFirst;
+   const __GLXattribute *state = __glXGetClientState(gc);
+   GLint rowLength, alignment, skipPixels, skipRows, lsbFirst;
    GLint elementsLeft, bitOffset, currentByte, nextByte, highBitMask;
    GLint lowBitMask, i;
    GLint components, groupsPerRow, rowSize, padding, elementsPerRow;
    const GLubyte *start, *iter;
 
+   if (NULL == state) {
+      __glXSetError(gc, GL_OUT_OF_MEMORY);
+      return;
+   }
+
+   rowLength = state->storeUnpack.rowLength;
+   alignment = state->storeUnpack.alignment;
+   skipPixels = state->storeUnpack.skipPixels;
+   skipRows = state->storeUnpack.skipRows;
+   lsbFirst = state->storeUnpack.lsbFirst;
+
    if (rowLength > 0) {
       groupsPerRow = rowLength;
    }
@@ -165,19 +172,27 @@ __glFillImage(__GLXcontext * gc, GLint dim, GLint width, GLint height,
               GLint depth, GLenum format, GLenum type,
               const GLvoid * userdata, GLubyte * newimage, GLubyte * modes)
 {
-   const __GLXattribute *state = gc->client_state_private;
-   GLint rowLength = state->storeUnpack.rowLength;
-   GLint imageHeight = state->storeUnpack.imageHeight;
-   GLint alignment = state->storeUnpack.alignment;
-   GLint skipPixels = state->storeUnpack.skipPixels;
-   GLint skipRows = state->storeUnpack.skipRows;
-   GLint skipImages = state->storeUnpack.skipImages;
-   GLint swapBytes = state->storeUnpack.swapEndian;
+   const __GLXattribute *state = __glXGetClientState(gc);
+   GLint rowLength, imageHeight, alignment, skipPixels, skipRows, skipImages;
+   GLint swapBytes;
    GLint components, elementSize, rowSize, padding, groupsPerRow, groupSize;
    GLint elementsPerRow, imageSize, rowsPerImage, h, i, j, k;
    const GLubyte *start, *iter, *itera, *iterb, *iterc;
    GLubyte *iter2;
 
+   if (NULL == state) {
+      __glXSetError(gc, GL_OUT_OF_MEMORY);
+      return;
+   }
+
+   rowLength = state->storeUnpack.rowLength;
+   imageHeight = state->storeUnpack.imageHeight;
+   alignment = state->storeUnpack.alignment;
+   skipPixels = state->storeUnpack.skipPixels;
+   skipRows = state->storeUnpack.skipRows;
+   skipImages = state->storeUnpack.skipImages;
+   swapBytes = state->storeUnpack.swapEndian;
+
    if (type == GL_BITMAP) {
       FillBitmap(gc, width, height, format, userdata, newimage);
    }
@@ -271,12 +286,8 @@ static void
 EmptyBitmap(__GLXcontext * gc, GLint width, GLint height,
             GLenum format, const GLubyte * sourceImage, GLvoid * userdata)
 {
-   const __GLXattribute *state = gc->client_state_private;
-   GLint rowLength = state->storePack.rowLength;
-   GLint alignment = state->storePack.alignment;
-   GLint skipPixels = state->storePack.skipPixels;
-   GLint skipRows = state->storePack.skipRows;
-   GLint lsbFirst = state->storePack.lsbFirst;
+   const __GLXattribute *state = __glXGetClientState(gc);
+   GLint rowLength, alignment, skipPixels, skipRows, lsbFirst;
    GLint components, groupsPerRow, rowSize, padding, elementsPerRow;
    GLint sourceRowSize, sourcePadding, sourceSkip;
    GLubyte *start, *iter;
@@ -284,6 +295,17 @@ EmptyBitmap(__GLXcontext * gc, GLint width, GLint height,
    GLint writeMask, i;
    GLubyte writeByte;
 
+   if (NULL == state) {
+      __glXSetError(gc, GL_OUT_OF_MEMORY);
+      return;
+   }
+
+   rowLength = state->storePack.rowLength;
+   alignment = state->storePack.alignment;
+   skipPixels = state->storePack.skipPixels;
+   skipRows = state->storePack.skipRows;
+   lsbFirst = state->storePack.lsbFirst;
+
    components = __glElementsPerGroup(format, GL_BITMAP);
    if (rowLength > 0) {
       groupsPerRow = rowLength;
@@ -392,18 +414,25 @@ __glEmptyImage(__GLXcontext * gc, GLint dim, GLint width, GLint height,
                GLint depth, GLenum format, GLenum type,
                const GLubyte * sourceImage, GLvoid * userdata)
 {
-   const __GLXattribute *state = gc->client_state_private;
-   GLint rowLength = state->storePack.rowLength;
-   GLint imageHeight = state->storePack.imageHeight;
-   GLint alignment = state->storePack.alignment;
-   GLint skipPixels = state->storePack.skipPixels;
-   GLint skipRows = state->storePack.skipRows;
-   GLint skipImages = state->storePack.skipImages;
+   const __GLXattribute *state = __glXGetClientState(gc);
+   GLint rowLength, imageHeight, alignment, skipPixels, skipRows, skipImages;
    GLint components, elementSize, rowSize, padding, groupsPerRow, groupSize;
    GLint elementsPerRow, sourceRowSize, sourcePadding, h, i;
    GLint imageSize, rowsPerImage;
    GLubyte *start, *iter, *itera;
 
+   if (NULL == state) {
+      __glXSetError(gc, GL_OUT_OF_MEMORY);
+      return;
+   }
+
+   rowLength = state->storePack.rowLength;
+   imageHeight = state->storePack.imageHeight;
+   alignment = state->storePack.alignment;
+   skipPixels = state->storePack.skipPixels;
+   skipRows = state->storePack.skipRows;
+   skipImages = state->storePack.skipImages;
+
    if (type == GL_BITMAP) {
       EmptyBitmap(gc, width, height, format, sourceImage, userdata);
    }
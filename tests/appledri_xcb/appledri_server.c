@@ -0,0 +1,482 @@
+/*
+ * A stand-in X server for the AppleDRI protocol.  See appledri_server.h.
+ *
+ * The client and server are in the same process, so everything is in the
+ * host byte order.
+ */
+#include <X11/Xproto.h>
+#include "appledristr.h"
+#include "appledri_server.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define APPLEDRI_OPCODE 128
+#define APPLEDRI_FIRST_EVENT 64
+#define APPLEDRI_FIRST_ERROR 128
+
+#define BUFFER_SIZE 65536
+
+struct appledri_server {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    int fd;
+    unsigned int latency;
+    unsigned int sequence;
+    unsigned int next_uid;
+    struct appledri_server_counts counts;
+    unsigned int width, height;
+    /* The shared buffer, mapped by the server too, and its front image. */
+    uint32_t *shared;
+    size_t shared_length;
+    unsigned int shared_width, shared_height;
+    int front;
+    unsigned char in[BUFFER_SIZE];
+    size_t inlen;
+    unsigned char out[BUFFER_SIZE];
+    size_t outlen;
+};
+
+static int write_all(int fd, const void *data, size_t len) {
+    const unsigned char *p = data;
+    ssize_t n;
+
+    while(len > 0) {
+	n = write(fd, p, len);
+
+	if(n <= 0)
+	    return -1;
+
+	p += n;
+	len -= n;
+    }
+
+    return 0;
+}
+
+static int read_all(int fd, void *data, size_t len) {
+    unsigned char *p = data;
+    ssize_t n;
+
+    while(len > 0) {
+	n = read(fd, p, len);
+
+	if(n <= 0)
+	    return -1;
+
+	p += n;
+	len -= n;
+    }
+
+    return 0;
+}
+
+static void flush_output(struct appledri_server *s) {
+    if(s->outlen) {
+	write_all(s->fd, s->out, s->outlen);
+	s->outlen = 0;
+    }
+}
+
+static void queue_output(struct appledri_server *s, const void *data,
+			 size_t len) {
+    if(s->outlen + len > sizeof(s->out))
+	flush_output(s);
+
+    memcpy(s->out + s->outlen, data, len);
+    s->outlen += len;
+}
+
+/* Queue a 32 byte reply with extra bytes of data after it. */
+static void reply(struct appledri_server *s, unsigned char *rep,
+		  const void *extra, size_t extralen) {
+    static const unsigned char pad[4];
+    xGenericReply *generic = (xGenericReply *)rep;
+
+    generic->type = X_Reply;
+    generic->sequenceNumber = s->sequence & 0xffff;
+    generic->length = (extralen + 3) / 4;
+
+    queue_output(s, rep, sizeof(xGenericReply));
+
+    if(extralen) {
+	queue_output(s, extra, extralen);
+	queue_output(s, pad, -extralen & 3);
+    }
+}
+
+static void error(struct appledri_server *s, int code, uint32_t value,
+		  int major, int minor) {
+    xError err;
+
+    memset(&err, 0, sizeof(err));
+    err.type = X_Error;
+    err.errorCode = code;
+    err.sequenceNumber = s->sequence & 0xffff;
+    err.resourceID = value;
+    err.minorCode = minor;
+    err.majorCode = major;
+
+    queue_output(s, &err, sizeof(err));
+    ++s->counts.errors;
+}
+
+static int setup(struct appledri_server *s) {
+    static const char vendor[] = "AppleDRI stand-in";
+    xConnClientPrefix prefix;
+    xConnSetupPrefix setup_prefix;
+    xConnSetup setup;
+    unsigned char auth[1024];
+    unsigned char pad[4] = { 0 };
+    size_t authlen, vendorlen = sizeof(vendor) - 1;
+
+    if(read_all(s->fd, &prefix, sizeof(prefix)))
+	return -1;
+
+    authlen = ((prefix.nbytesAuthProto + 3) & ~3)
+	+ ((prefix.nbytesAuthString + 3) & ~3);
+
+    if(authlen > sizeof(auth) || read_all(s->fd, auth, authlen))
+	return -1;
+
+    memset(&setup, 0, sizeof(setup));
+    setup.release = 1;
+    setup.ridBase = 0x00200000;
+    setup.ridMask = 0x001fffff;
+    setup.nbytesVendor = vendorlen;
+    setup.maxRequestSize = 0xffff;
+    setup.numRoots = 0;
+    setup.numFormats = 0;
+    setup.minKeyCode = 8;
+    setup.maxKeyCode = 255;
+
+    memset(&setup_prefix, 0, sizeof(setup_prefix));
+    setup_prefix.success = 1;
+    setup_prefix.majorVersion = X_PROTOCOL;
+    setup_prefix.minorVersion = X_PROTOCOL_REVISION;
+    setup_prefix.length = (sizeof(setup) + vendorlen + 3) / 4;
+
+    if(write_all(s->fd, &setup_prefix, sizeof(setup_prefix))
+       || write_all(s->fd, &setup, sizeof(setup))
+       || write_all(s->fd, vendor, vendorlen)
+       || write_all(s->fd, pad, -vendorlen & 3))
+	return -1;
+
+    return 0;
+}
+
+static void handle_appledri(struct appledri_server *s,
+			    const unsigned char *req) {
+    unsigned char rep[32];
+    char name[64];
+    int minor = req[1];
+
+    memset(rep, 0, sizeof(rep));
+
+    switch(minor) {
+    case X_AppleDRIQueryVersion: {
+	xAppleDRIQueryVersionReply *r = (xAppleDRIQueryVersionReply *)rep;
+
+	r->majorVersion = APPLE_DRI_MAJOR_VERSION;
+	r->minorVersion = APPLE_DRI_MINOR_VERSION;
+	r->patchVersion = APPLE_DRI_PATCH_VERSION;
+	reply(s, rep, NULL, 0);
+	break;
+    }
+
+    case X_AppleDRICreateSurface: {
+	const xAppleDRICreateSurfaceReq *q = (const void *)req;
+	xAppleDRICreateSurfaceReply *r = (xAppleDRICreateSurfaceReply *)rep;
+
+	if(0 == q->drawable) {
+	    error(s, BadDrawable, q->drawable, APPLEDRI_OPCODE, minor);
+	    break;
+	}
+
+	/* The key is the drawable, so the client can check it. */
+	r->key_0 = q->drawable;
+	r->key_1 = q->client_id;
+	r->uid = ++s->next_uid;
+	++s->counts.surfaces_created;
+	reply(s, rep, NULL, 0);
+	break;
+    }
+
+    case X_AppleDRIDestroySurface:
+	++s->counts.surfaces_destroyed;
+	break;
+
+    case X_AppleDRICreateSharedBuffer: {
+	const xAppleDRICreateSharedBufferReq *q = (const void *)req;
+	xAppleDRICreateSharedBufferReply *r =
+	    (xAppleDRICreateSharedBufferReply *)rep;
+	int fd;
+
+	if(0 == q->drawable) {
+	    error(s, BadDrawable, q->drawable, APPLEDRI_OPCODE, minor);
+	    break;
+	}
+
+	if(s->shared)
+	    munmap(s->shared, s->shared_length);
+
+	s->shared = NULL;
+	snprintf(name, sizeof(name), "/appledri-shared-%d-%x", (int)getpid(),
+		 (unsigned int)q->drawable);
+	s->shared_width = s->width;
+	s->shared_height = s->height;
+	s->shared_length = (size_t)s->width * s->height * 4
+	    * (q->doubleSwap ? 2 : 1);
+	s->front = -1;
+
+	/* The client unlinks the old name. */
+	fd = shm_open(name, O_RDWR | O_CREAT, 0600);
+
+	if(fd >= 0 && 0 == ftruncate(fd, s->shared_length)) {
+	    s->shared = mmap(NULL, s->shared_length, PROT_READ | PROT_WRITE,
+			     MAP_SHARED, fd, 0);
+
+	    if(MAP_FAILED == s->shared)
+		s->shared = NULL;
+	}
+
+	if(fd >= 0)
+	    close(fd);
+
+	if(s->shared) {
+	    r->stringLength = strlen(name) + 1;
+	    r->width = s->shared_width;
+	    r->height = s->shared_height;
+	    ++s->counts.shared_buffers_created;
+	    reply(s, rep, name, r->stringLength);
+	} else {
+	    reply(s, rep, NULL, 0);
+	}
+	break;
+    }
+
+    case X_AppleDRISwapBuffers:
+	/* Present the other image, as the client rendered to it. */
+	s->front = (s->front + 1) % 2;
+	++s->counts.swaps;
+	break;
+
+    case X_AppleDRICreatePixmap: {
+	const xAppleDRICreatePixmapReq *q = (const void *)req;
+	xAppleDRICreatePixmapReply *r = (xAppleDRICreatePixmapReply *)rep;
+
+	if(0 == q->drawable) {
+	    error(s, BadDrawable, q->drawable, APPLEDRI_OPCODE, minor);
+	    break;
+	}
+
+	snprintf(name, sizeof(name), "/appledri-pixmap-%x",
+		 (unsigned int)q->drawable);
+	r->width = 64;
+	r->height = 32;
+	r->pitch = 256;
+	r->bpp = 32;
+	r->size = r->pitch * r->height;
+	r->stringLength = strlen(name) + 1;
+	++s->counts.pixmaps_created;
+	reply(s, rep, name, r->stringLength);
+	break;
+    }
+
+    case X_AppleDRIDestroyPixmap:
+	++s->counts.pixmaps_destroyed;
+	break;
+
+    default:
+	error(s, BadRequest, 0, APPLEDRI_OPCODE, minor);
+	break;
+    }
+}
+
+static void handle_request(struct appledri_server *s,
+			   const unsigned char *req, size_t len) {
+    unsigned char rep[32];
+    char name[256];
+
+    ++s->sequence;
+    ++s->counts.requests;
+
+    memset(rep, 0, sizeof(rep));
+
+    switch(req[0]) {
+    case X_QueryExtension: {
+	const xQueryExtensionReq *q = (const void *)req;
+	xQueryExtensionReply *r = (xQueryExtensionReply *)rep;
+	size_t n = q->nbytes < sizeof(name) - 1 ? q->nbytes : sizeof(name) - 1;
+
+	memcpy(name, req + sizeof(*q), n);
+	name[n] = '\0';
+
+	if(!strcmp(name, APPLEDRINAME)) {
+	    r->present = xTrue;
+	    r->major_opcode = APPLEDRI_OPCODE;
+	    r->first_event = APPLEDRI_FIRST_EVENT;
+	    r->first_error = APPLEDRI_FIRST_ERROR;
+	}
+
+	reply(s, rep, NULL, 0);
+	break;
+    }
+
+    case X_GetGeometry: {
+	xGetGeometryReply *r = (xGetGeometryReply *)rep;
+
+	r->depth = 24;
+	r->width = s->width;
+	r->height = s->height;
+	reply(s, rep, NULL, 0);
+	break;
+    }
+
+    case X_GetInputFocus:
+	/* XCB uses this to synchronize. */
+	reply(s, rep, NULL, 0);
+	break;
+
+    case APPLEDRI_OPCODE:
+	handle_appledri(s, req);
+	break;
+
+    default:
+	error(s, BadRequest, 0, req[0], 0);
+	break;
+    }
+}
+
+static void *serve(void *arg) {
+    struct appledri_server *s = arg;
+    const unsigned char *p;
+    size_t len;
+    ssize_t n;
+
+    if(setup(s))
+	return NULL;
+
+    for(;;) {
+	n = read(s->fd, s->in + s->inlen, sizeof(s->in) - s->inlen);
+
+	if(n <= 0)
+	    break;
+
+	if(s->latency)
+	    usleep(s->latency);
+
+	pthread_mutex_lock(&s->lock);
+	++s->counts.reads;
+	s->inlen += n;
+	p = s->in;
+
+	/* Handle every complete request that was read. */
+	while(s->in + s->inlen - p >= 4) {
+	    len = ((const xReq *)p)->length * 4;
+
+	    if(len < 4 || len > sizeof(s->in)) {
+		fprintf(stderr, "appledri_server: bad request length\n");
+		pthread_mutex_unlock(&s->lock);
+		return NULL;
+	    }
+
+	    if(s->in + s->inlen - p < (ssize_t)len)
+		break;
+
+	    handle_request(s, p, len);
+	    p += len;
+	}
+
+	s->inlen -= p - s->in;
+	memmove(s->in, p, s->inlen);
+	flush_output(s);
+	pthread_mutex_unlock(&s->lock);
+    }
+
+    return NULL;
+}
+
+struct appledri_server *appledri_server_start(unsigned int latency,
+					      int *client_fd) {
+    struct appledri_server *s;
+    int fds[2];
+
+    s = calloc(1, sizeof(*s));
+
+    if(NULL == s)
+	return NULL;
+
+    if(socketpair(AF_UNIX, SOCK_STREAM, 0, fds)) {
+	free(s);
+	return NULL;
+    }
+
+    s->fd = fds[1];
+    s->latency = latency;
+    s->width = 64;
+    s->height = 32;
+    pthread_mutex_init(&s->lock, NULL);
+
+    if(pthread_create(&s->thread, NULL, serve, s)) {
+	close(fds[0]);
+	close(fds[1]);
+	free(s);
+	return NULL;
+    }
+
+    *client_fd = fds[0];
+
+    return s;
+}
+
+struct appledri_server_counts appledri_server_counts(struct appledri_server *s) {
+    struct appledri_server_counts counts;
+
+    pthread_mutex_lock(&s->lock);
+    counts = s->counts;
+    pthread_mutex_unlock(&s->lock);
+
+    return counts;
+}
+
+void appledri_server_resize(struct appledri_server *s, unsigned int width,
+			    unsigned int height) {
+    pthread_mutex_lock(&s->lock);
+    s->width = width;
+    s->height = height;
+    pthread_mutex_unlock(&s->lock);
+}
+
+unsigned int appledri_server_presented_pixel(struct appledri_server *s,
+					     unsigned int x, unsigned int y) {
+    unsigned int pixel = 0;
+
+    pthread_mutex_lock(&s->lock);
+
+    if(s->shared && s->front >= 0 && x < s->shared_width
+       && y < s->shared_height)
+	pixel = s->shared[(size_t)s->front * s->shared_width * s->shared_height
+			  + (size_t)y * s->shared_width + x];
+
+    pthread_mutex_unlock(&s->lock);
+
+    return pixel;
+}
+
+void appledri_server_stop(struct appledri_server *s) {
+    pthread_join(s->thread, NULL);
+
+    if(s->shared)
+	munmap(s->shared, s->shared_length);
+
+    close(s->fd);
+    pthread_mutex_destroy(&s->lock);
+    free(s);
+}
@@ -0,0 +1,52 @@
+/*
+ * A stand-in X server that implements just enough of the core protocol
+ * for XCB to connect, and the AppleDRI requests from appledristr.h.  It
+ * serves one connection from a thread, so the AppleDRI client can be
+ * tested without XQuartz.
+ */
+#ifndef APPLEDRI_SERVER_H
+#define APPLEDRI_SERVER_H
+
+struct appledri_server_counts {
+    unsigned int reads;
+    unsigned int requests;
+    unsigned int surfaces_created;
+    unsigned int surfaces_destroyed;
+    unsigned int pixmaps_created;
+    unsigned int pixmaps_destroyed;
+    unsigned int swaps;
+    unsigned int shared_buffers_created;
+    unsigned int errors;
+};
+
+struct appledri_server;
+
+/*
+ * Start serving a new connection, and return the fd of the client end.
+ * The server waits latency microseconds before it handles each read, to
+ * simulate the round trip to a real server.
+ */
+struct appledri_server *appledri_server_start(unsigned int latency,
+					      int *client_fd);
+
+/* Return a copy of the counts so far. */
+struct appledri_server_counts appledri_server_counts(struct appledri_server *s);
+
+/*
+ * Set the size of the window that GetGeometry replies with, and that the
+ * next shared buffer is created with.  The default is 64x32.
+ */
+void appledri_server_resize(struct appledri_server *s, unsigned int width,
+			    unsigned int height);
+
+/*
+ * Return the pixel at x, y of the image of the shared buffer presented by
+ * the last SwapBuffers, or 0 if there is none.
+ */
+unsigned int appledri_server_presented_pixel(struct appledri_server *s,
+					     unsigned int x, unsigned int y);
+
+/* Wait for the client to disconnect, and free the server. */
+void appledri_server_stop(struct appledri_server *s);
+
+#endif
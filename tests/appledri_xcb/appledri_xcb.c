@@ -0,0 +1,195 @@
+/*
+ * This tests the XCB AppleDRI client against a stand-in server: the
+ * replies of single and pipelined requests, errors, and the requests
+ * without replies.  It also compares the time of creating surfaces one
+ * round trip at a time with sending them all before collecting the
+ * replies, with a simulated round trip latency.
+ */
+#include <xcb/xcb.h>
+#include "appledri_xcb.h"
+#include "appledri_server.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#define BATCH 256
+#define TIMED 200
+#define LATENCY 200		/* microseconds */
+
+static int failures = 0;
+
+#define CHECK(cond) do {						\
+	if(!(cond)) {							\
+	    fprintf(stderr, "%s:%d: FAILED: %s\n", __FILE__, __LINE__,	\
+		    #cond);						\
+	    ++failures;							\
+	}								\
+    } while(0)
+
+static double now(void) {
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+
+    return tv.tv_sec * 1000000.0 + tv.tv_usec;
+}
+
+static xcb_connection_t *connect_server(struct appledri_server **server,
+					unsigned int latency) {
+    xcb_connection_t *c;
+    const xcb_query_extension_reply_t *ext;
+    int fd;
+
+    *server = appledri_server_start(latency, &fd);
+
+    if(NULL == *server) {
+	fprintf(stderr, "error: unable to start the stand-in server!\n");
+	exit(EXIT_FAILURE);
+    }
+
+    c = xcb_connect_to_fd(fd, NULL);
+
+    if(xcb_connection_has_error(c)) {
+	fprintf(stderr, "error: unable to connect to the stand-in server!\n");
+	exit(EXIT_FAILURE);
+    }
+
+    ext = xcb_get_extension_data(c, &xcb_appledri_id);
+
+    if(NULL == ext || !ext->present) {
+	fprintf(stderr, "error: the AppleDRI extension isn't present!\n");
+	exit(EXIT_FAILURE);
+    }
+
+    return c;
+}
+
+static void test_requests(void) {
+    struct appledri_server *server;
+    struct appledri_server_counts counts;
+    xcb_connection_t *c;
+    xcb_appledri_query_version_reply_t *version;
+    xcb_appledri_create_surface_cookie_t cookies[BATCH];
+    xcb_appledri_create_surface_reply_t *surface;
+    xcb_appledri_create_pixmap_reply_t *pixmap;
+    xcb_generic_error_t *e = NULL;
+    xcb_generic_event_t *event;
+    char name[64];
+    int i;
+
+    c = connect_server(&server, 0);
+
+    version = xcb_appledri_query_version_reply(c,
+	xcb_appledri_query_version(c), NULL);
+    CHECK(version && version->major_version == 1);
+    free(version);
+
+    /* Pipeline a batch of creates, then collect the replies. */
+    for(i = 0; i < BATCH; ++i)
+	cookies[i] = xcb_appledri_create_surface(c, 0, 0x400000 + i, 7);
+
+    for(i = 0; i < BATCH; ++i) {
+	surface = xcb_appledri_create_surface_reply(c, cookies[i], &e);
+	CHECK(surface && surface->key_0 == 0x400000 + i
+	      && surface->key_1 == 7 && surface->uid == i + 1);
+	free(surface);
+    }
+
+    /* A checked error is returned with the reply. */
+    surface = xcb_appledri_create_surface_reply(c,
+	xcb_appledri_create_surface(c, 0, 0, 7), &e);
+    CHECK(NULL == surface && e && e->error_code == XCB_DRAWABLE);
+    free(e);
+
+    /* An unchecked error is an event. */
+    e = NULL;
+    surface = xcb_appledri_create_surface_reply(c,
+	xcb_appledri_create_surface_unchecked(c, 0, 0, 7), &e);
+    CHECK(NULL == surface && NULL == e);
+    event = xcb_poll_for_event(c);
+    CHECK(event && 0 == event->response_type
+	  && ((xcb_generic_error_t *)event)->error_code == XCB_DRAWABLE);
+    free(event);
+
+    pixmap = xcb_appledri_create_pixmap_reply(c,
+	xcb_appledri_create_pixmap(c, 0, 0x500000), NULL);
+    snprintf(name, sizeof(name), "/appledri-pixmap-%x", 0x500000);
+    CHECK(pixmap && pixmap->width == 64 && pixmap->height == 32
+	  && pixmap->pitch == 256 && pixmap->bpp == 32
+	  && pixmap->size == 256 * 32
+	  && pixmap->string_length == strlen(name) + 1
+	  && !memcmp(xcb_appledri_create_pixmap_bufname(pixmap), name,
+		     pixmap->string_length));
+    free(pixmap);
+
+    for(i = 0; i < BATCH; ++i)
+	xcb_appledri_destroy_surface(c, 0, 0x400000 + i);
+    xcb_appledri_swap_buffers(c, 0, 0x400000);
+    xcb_appledri_destroy_pixmap(c, 0x500000);
+
+    /* A round trip, so the server has seen everything. */
+    free(xcb_appledri_query_version_reply(c, xcb_appledri_query_version(c),
+					  NULL));
+
+    counts = appledri_server_counts(server);
+    CHECK(counts.surfaces_created == BATCH);
+    CHECK(counts.surfaces_destroyed == BATCH);
+    CHECK(counts.pixmaps_created == 1);
+    CHECK(counts.pixmaps_destroyed == 1);
+    CHECK(counts.swaps == 1);
+    CHECK(counts.errors == 2);
+    CHECK(!xcb_connection_has_error(c));
+
+    xcb_disconnect(c);
+    appledri_server_stop(server);
+}
+
+static void test_latency(void) {
+    struct appledri_server *server;
+    xcb_connection_t *c;
+    xcb_appledri_create_surface_cookie_t cookies[TIMED];
+    double start, serial, pipelined;
+    unsigned int reads;
+    int i;
+
+    c = connect_server(&server, LATENCY);
+
+    reads = appledri_server_counts(server).reads;
+    start = now();
+
+    for(i = 0; i < TIMED; ++i)
+	free(xcb_appledri_create_surface_reply(c,
+	    xcb_appledri_create_surface(c, 0, 0x400000 + i, 7), NULL));
+
+    serial = now() - start;
+    printf("%d creates, one at a time: %8.0f us, %u server reads\n",
+	   TIMED, serial, appledri_server_counts(server).reads - reads);
+
+    reads = appledri_server_counts(server).reads;
+    start = now();
+
+    for(i = 0; i < TIMED; ++i)
+	cookies[i] = xcb_appledri_create_surface(c, 0, 0x400000 + i, 7);
+
+    for(i = 0; i < TIMED; ++i)
+	free(xcb_appledri_create_surface_reply(c, cookies[i], NULL));
+
+    pipelined = now() - start;
+    printf("%d creates, pipelined:     %8.0f us, %u server reads\n",
+	   TIMED, pipelined, appledri_server_counts(server).reads - reads);
+
+    CHECK(pipelined < serial);
+
+    xcb_disconnect(c);
+    appledri_server_stop(server);
+}
+
+int main() {
+    test_requests();
+    test_latency();
+
+    printf("%s\n", failures ? "FAILED" : "passed");
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
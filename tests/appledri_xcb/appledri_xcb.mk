@@ -0,0 +1,5 @@
+$(TEST_BUILD_DIR)/appledri_xcb: tests/appledri_xcb/appledri_xcb.c tests/appledri_xcb/appledri_server.c appledri_xcb.c appledri_xcb.h
+	$(CC) tests/appledri_xcb/appledri_xcb.c tests/appledri_xcb/appledri_server.c appledri_xcb.c $(INCLUDE) -Itests/appledri_xcb -o $(TEST_BUILD_DIR)/appledri_xcb -L$(X11_DIR)/lib -lxcb -lpthread
+
+$(TEST_BUILD_DIR)/shared_buffer: tests/appledri_xcb/shared_buffer.c tests/appledri_xcb/appledri_server.c apple_glx_shared_buffer.c apple_glx_shared_buffer.h appledri_xcb.c appledri_xcb.h
+	$(CC) tests/appledri_xcb/shared_buffer.c tests/appledri_xcb/appledri_server.c apple_glx_shared_buffer.c appledri_xcb.c $(INCLUDE) -Itests/appledri_xcb -o $(TEST_BUILD_DIR)/shared_buffer -L$(X11_DIR)/lib -lxcb -lpthread
@@ -0,0 +1,180 @@
+/*
+ * This tests the shared buffer present mode against the stand-in server:
+ * the images are swapped, a damaged swap, as by glXCopySubBufferMESA,
+ * only copies the damage from the GL and leaves the rest of the window
+ * unchanged, and a resize recreates the buffer.  It also compares the
+ * bytes copied from the GL by full swaps and by sub-buffer copies.
+ */
+#include <xcb/xcb.h>
+#include "appledri_xcb.h"
+#include "appledri_server.h"
+#include "apple_glx_shared_buffer.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FRAMES 100
+
+static int failures = 0;
+
+#define CHECK(cond) do {						\
+	if(!(cond)) {							\
+	    fprintf(stderr, "%s:%d: FAILED: %s\n", __FILE__, __LINE__,	\
+		    #cond);						\
+	    ++failures;							\
+	}								\
+    } while(0)
+
+/* What the last copy was asked for, and the value it filled with. */
+struct copy_state {
+    uint32_t value;
+    xcb_rectangle_t rect;
+    int copies;
+    size_t bytes;
+};
+
+static void copy(void *closure, void *dest, int row_bytes, int height,
+		 const xcb_rectangle_t *rect) {
+    struct copy_state *state = closure;
+    uint32_t *row;
+    int x, y;
+
+    for(y = rect->y; y < rect->y + rect->height; ++y) {
+	row = (uint32_t *)((char *)dest + (size_t)y * row_bytes);
+
+	for(x = rect->x; x < rect->x + rect->width; ++x)
+	    row[x] = state->value;
+    }
+
+    state->rect = *rect;
+    state->copies++;
+    state->bytes += (size_t)rect->width * rect->height * 4;
+}
+
+static int same_rect(const xcb_rectangle_t *r, int x, int y, int width,
+		     int height) {
+    return r->x == x && r->y == y && r->width == width && r->height == height;
+}
+
+static void round_trip(xcb_connection_t *c) {
+    free(xcb_appledri_query_version_reply(c, xcb_appledri_query_version(c),
+					  NULL));
+}
+
+static void swap(struct apple_glx_shared_buffer *sb,
+		 struct copy_state *state, uint32_t value,
+		 const xcb_rectangle_t *damage, int *resized) {
+    bool r;
+
+    state->value = value;
+    state->copies = 0;
+    CHECK(!apple_glx_shared_buffer_swap(sb, damage, copy, state, &r));
+    *resized = r;
+}
+
+int main() {
+    struct appledri_server *server;
+    struct apple_glx_shared_buffer sb;
+    struct copy_state state;
+    xcb_connection_t *c;
+    const xcb_query_extension_reply_t *ext;
+    xcb_rectangle_t a = { 8, 8, 4, 4 };
+    xcb_rectangle_t b = { 20, 4, 8, 8 };
+    xcb_rectangle_t edge = { 60, 30, 10, 10 };
+    xcb_rectangle_t small = { 10, 10, 8, 8 };
+    size_t full_bytes;
+    int fd, resized, i;
+
+    server = appledri_server_start(0, &fd);
+
+    if(NULL == server) {
+	fprintf(stderr, "error: unable to start the stand-in server!\n");
+	return EXIT_FAILURE;
+    }
+
+    c = xcb_connect_to_fd(fd, NULL);
+    ext = xcb_get_extension_data(c, &xcb_appledri_id);
+
+    if(xcb_connection_has_error(c) || NULL == ext || !ext->present) {
+	fprintf(stderr, "error: unable to connect to the stand-in server!\n");
+	return EXIT_FAILURE;
+    }
+
+    memset(&state, 0, sizeof(state));
+
+    CHECK(!apple_glx_shared_buffer_create(&sb, c, 0, 0x400000));
+    CHECK(sb.width == 64 && sb.height == 32 && sb.row_bytes == 256);
+    CHECK(sb.buffer != NULL && sb.buffer_length == 256 * 32 * 2);
+
+    /* A full swap copies everything. */
+    swap(&sb, &state, 1, NULL, &resized);
+    round_trip(c);
+    CHECK(1 == state.copies && same_rect(&state.rect, 0, 0, 64, 32));
+    CHECK(1 == appledri_server_presented_pixel(server, 0, 0));
+
+    /* Only the damage is copied, the rest is kept from the front image. */
+    swap(&sb, &state, 2, &a, &resized);
+    round_trip(c);
+    CHECK(same_rect(&state.rect, 8, 8, 4, 4));
+    CHECK(2 == appledri_server_presented_pixel(server, 9, 9));
+    CHECK(1 == appledri_server_presented_pixel(server, 0, 0));
+
+    /* The back image catches up with the damage of the last swap. */
+    swap(&sb, &state, 3, &b, &resized);
+    round_trip(c);
+    CHECK(same_rect(&state.rect, 20, 4, 8, 8));
+    CHECK(3 == appledri_server_presented_pixel(server, 21, 5));
+    CHECK(2 == appledri_server_presented_pixel(server, 9, 9));
+    CHECK(1 == appledri_server_presented_pixel(server, 10, 5));
+
+    /* Damage past the edge is clipped. */
+    swap(&sb, &state, 4, &edge, &resized);
+    round_trip(c);
+    CHECK(same_rect(&state.rect, 60, 30, 4, 2));
+    CHECK(4 == appledri_server_presented_pixel(server, 63, 31));
+    CHECK(3 == appledri_server_presented_pixel(server, 21, 5));
+    CHECK(2 == appledri_server_presented_pixel(server, 9, 9));
+
+    /* The size of the window is noticed one swap later. */
+    appledri_server_resize(server, 80, 40);
+    swap(&sb, &state, 5, NULL, &resized);
+    CHECK(!resized);
+    swap(&sb, &state, 6, NULL, &resized);
+    CHECK(resized && sb.width == 80 && sb.height == 40);
+    swap(&sb, &state, 7, &small, &resized);
+    round_trip(c);
+    CHECK(same_rect(&state.rect, 0, 0, 80, 40));
+    CHECK(7 == appledri_server_presented_pixel(server, 79, 39));
+
+    /* Compare the bytes copied by full swaps and sub-buffer copies. */
+    state.bytes = 0;
+
+    for(i = 0; i < FRAMES; ++i)
+	swap(&sb, &state, i, NULL, &resized);
+
+    full_bytes = state.bytes;
+    state.bytes = 0;
+
+    for(i = 0; i < FRAMES; ++i)
+	swap(&sb, &state, i, &small, &resized);
+
+    round_trip(c);
+    printf("%d full swaps copied        %8lu bytes\n", FRAMES,
+	   (unsigned long)full_bytes);
+    printf("%d sub-buffer copies copied %8lu bytes\n", FRAMES,
+	   (unsigned long)state.bytes);
+    CHECK(state.bytes < full_bytes);
+
+    CHECK(appledri_server_counts(server).shared_buffers_created == 2);
+    CHECK(appledri_server_counts(server).swaps == 7 + 2 * FRAMES);
+    CHECK(!xcb_connection_has_error(c));
+
+    apple_glx_shared_buffer_destroy(&sb);
+    xcb_disconnect(c);
+    appledri_server_stop(server);
+
+    printf("%s\n", failures ? "FAILED" : "passed");
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
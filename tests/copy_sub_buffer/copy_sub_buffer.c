@@ -0,0 +1,168 @@
+/*
+ * This tests GLX_MESA_copy_sub_buffer: the rectangle is copied to the
+ * front buffer, and the rest of the front buffer and the back buffer are
+ * unchanged.  It also compares the time of full swaps and of copying a
+ * small rectangle.  The shared buffer present mode is tested against the
+ * stand-in server by tests/appledri_xcb/shared_buffer.c.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <X11/Xlib.h>
+#define GLX_GLXEXT_PROTOTYPES
+#include <GL/glx.h>
+#include <GL/glxext.h>
+
+#define WIDTH 400
+#define HEIGHT 400
+#define FRAMES 300
+#define RECT 32
+
+static int failures = 0;
+
+static double now(void) {
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+
+    return tv.tv_sec * 1000000.0 + tv.tv_usec;
+}
+
+static void check_pixel(GLenum buffer, int x, int y, GLubyte r, GLubyte g,
+			const char *what) {
+    GLubyte pixel[4];
+
+    glReadBuffer(buffer);
+    glReadPixels(x, y, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+
+    if(pixel[0] != r || pixel[1] != g || pixel[2]) {
+	printf("FAILED: %s at %d,%d is %02x %02x %02x\n", what, x, y,
+	       pixel[0], pixel[1], pixel[2]);
+	++failures;
+    }
+}
+
+static void clear(GLfloat r, GLfloat g) {
+    glClearColor(r, g, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+}
+
+int main() {
+    Display *dpy;
+    int attrib[] = { GLX_RGBA,
+		     GLX_RED_SIZE, 8,
+		     GLX_GREEN_SIZE, 8,
+		     GLX_BLUE_SIZE, 8,
+		     GLX_DOUBLEBUFFER,
+		     None };
+    int screen, i;
+    Window root, win;
+    XVisualInfo *visinfo;
+    XSetWindowAttributes attr;
+    GLXContext ctx;
+    double start, swaptime, copytime;
+
+    dpy = XOpenDisplay(NULL);
+    
+    if(NULL == dpy) {
+        fprintf(stderr, "error: unable to open display!\n");
+        return EXIT_FAILURE;
+    }
+
+    screen = DefaultScreen(dpy);
+    root = RootWindow(dpy, screen);
+
+    if(NULL == strstr(glXQueryExtensionsString(dpy, screen),
+		      "GLX_MESA_copy_sub_buffer")) {
+	fprintf(stderr, "error: GLX_MESA_copy_sub_buffer isn't supported!\n");
+	return EXIT_FAILURE;
+    }
+
+    visinfo = glXChooseVisual(dpy, screen, attrib);
+
+    if(!visinfo) {
+	fprintf(stderr, "error: couldn't get an RGBA, double-buffered visual!\n");
+	return EXIT_FAILURE;
+    }
+
+    attr.background_pixel = 0;
+    attr.border_pixel = 0;
+    attr.colormap = XCreateColormap(dpy, root, visinfo->visual, AllocNone);
+    attr.event_mask = StructureNotifyMask | ExposureMask;
+
+    win = XCreateWindow(dpy, root, /*x*/ 0, /*y*/ 0, 
+			WIDTH, HEIGHT,
+			0, visinfo->depth, InputOutput,
+			visinfo->visual, 
+			CWBackPixel | CWBorderPixel | CWColormap | CWEventMask,
+			&attr);
+   
+    ctx = glXCreateContext(dpy, visinfo, NULL, True);
+
+    if(!ctx) {
+	fprintf(stderr, "error: glXCreateContext failed!\n");
+	return EXIT_FAILURE;
+    }
+    
+    XMapWindow(dpy, win);
+    XSync(dpy, False);
+
+    glXMakeCurrent(dpy, win, ctx);
+    glViewport(0, 0, WIDTH, HEIGHT);
+
+    /* Red in the front buffer, then green in the back buffer. */
+    clear(1.0f, 0.0f);
+    glXSwapBuffers(dpy, win);
+    clear(0.0f, 1.0f);
+
+    glXCopySubBufferMESA(dpy, win, 100, 50, 50, 20);
+
+    check_pixel(GL_FRONT, 100, 50, 0x00, 0xff, "the copied front");
+    check_pixel(GL_FRONT, 149, 69, 0x00, 0xff, "the copied front");
+    check_pixel(GL_FRONT, 99, 50, 0xff, 0x00, "the front");
+    check_pixel(GL_FRONT, 100, 70, 0xff, 0x00, "the front");
+    check_pixel(GL_FRONT, 10, 10, 0xff, 0x00, "the front");
+    check_pixel(GL_BACK, 10, 10, 0x00, 0xff, "the back");
+
+    /* A rectangle past the edge is clipped. */
+    clear(1.0f, 1.0f);
+    glXCopySubBufferMESA(dpy, win, WIDTH - 10, HEIGHT - 10, 100, 100);
+    check_pixel(GL_FRONT, WIDTH - 1, HEIGHT - 1, 0xff, 0xff, "the clipped front");
+    check_pixel(GL_FRONT, 10, 10, 0xff, 0x00, "the front");
+
+    glReadBuffer(GL_BACK);
+
+    start = now();
+
+    for(i = 0; i < FRAMES; ++i) {
+	clear(i & 1, 0.0f);
+	glXSwapBuffers(dpy, win);
+    }
+
+    glFinish();
+    swaptime = now() - start;
+    start = now();
+
+    for(i = 0; i < FRAMES; ++i) {
+	clear(i & 1, 0.0f);
+	glXCopySubBufferMESA(dpy, win, 0, 0, RECT, RECT);
+    }
+
+    glFinish();
+    copytime = now() - start;
+
+    printf("glXSwapBuffers average        %8.2f us over %d frames\n",
+	   swaptime / FRAMES, FRAMES);
+    printf("glXCopySubBufferMESA %dx%d average %8.2f us over %d frames\n",
+	   RECT, RECT, copytime / FRAMES, FRAMES);
+
+    glXMakeCurrent(dpy, None, NULL);
+    glXDestroyContext(dpy, ctx);
+    XDestroyWindow(dpy, win);
+    XCloseDisplay(dpy);
+
+    printf("%s\n", failures ? "FAILED" : "PASSED");
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
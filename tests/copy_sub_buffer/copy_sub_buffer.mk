@@ -0,0 +1,2 @@
+$(TEST_BUILD_DIR)/copy_sub_buffer: tests/copy_sub_buffer/copy_sub_buffer.c $(LIBGL)
+	$(CC) tests/copy_sub_buffer/copy_sub_buffer.c $(INCLUDE) -o $(TEST_BUILD_DIR)/copy_sub_buffer $(LINK_TEST)
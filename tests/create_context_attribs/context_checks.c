@@ -0,0 +1,362 @@
+/*
+ * This checks the context logic of apple_glx_context.c without a display:
+ * CGL, the drawables, the share groups, and the workers are stubbed.
+ * apple_glx_context.c is included, so that its static functions can be
+ * called.  The CGL calls are counted, to check the calls that are skipped.
+ */
+#include "apple_glx_context.c"
+
+static int failures = 0;
+
+#define CHECK(cond) do {						\
+	if(!(cond)) {							\
+	    fprintf(stderr, "%s:%d: FAILED: %s\n", __FILE__, __LINE__,	\
+		    #cond);						\
+	    ++failures;							\
+	}								\
+    } while(0)
+
+struct apple_cgl_api apple_cgl;
+
+static struct apple_glx_renderer renderer = { 0x00021c00 };
+static struct apple_glx_display display;
+static int share_group;
+
+static int set_current_calls, clear_drawable_calls;
+static int enable_calls, disable_calls;
+static GLint engine_available;
+static CGLError enable_error;
+
+/* These replace the parts of libGL that apple_glx_context.c uses. */
+void apple_glx_diagnostic(const char *fmt, ...) {
+}
+
+void apple_glx_wait_framework(void) {
+}
+
+void apple_glx_display_lock_contexts(struct apple_glx_display *gd) {
+}
+
+void apple_glx_display_unlock_contexts(struct apple_glx_display *gd) {
+}
+
+void apple_glx_display_defer_context(struct apple_glx_display *gd) {
+}
+
+void apple_glx_display_release_context(struct apple_glx_display *gd) {
+}
+
+struct apple_glx_display *apple_glx_display_find(Display *dpy) {
+    return &display;
+}
+
+void apple_glx_process_surface_changes(struct apple_glx_display *gd) {
+}
+
+const struct apple_glx_renderer *apple_glx_renderer_get(int index) {
+    return (0 == index) ? &renderer : NULL;
+}
+
+struct apple_glx_share_group *
+apple_glx_share_group_create(struct apple_glx_display *gd) {
+    return (struct apple_glx_share_group *) &share_group;
+}
+
+void apple_glx_share_group_join(struct apple_glx_share_group *g) {
+}
+
+void apple_glx_share_group_leave(struct apple_glx_share_group *g) {
+}
+
+void apple_glx_share_group_reference(struct apple_glx_share_group *g) {
+}
+
+void apple_glx_share_group_release(struct apple_glx_share_group *g) {
+}
+
+struct apple_glx_drawable *apple_glx_drawable_find(Display *dpy,
+						   GLXDrawable drawable,
+						   int flags) {
+    return NULL;
+}
+
+void apple_glx_garbage_collect_drawables(Display *dpy) {
+}
+
+void apple_glx_pbuffer_destroy_share_group(Display *dpy,
+					   struct apple_glx_share_group *g) {
+}
+
+bool apple_glx_surface_create(Display *dpy, int screen, GLXDrawable drawable,
+			      struct apple_glx_drawable **resultptr) {
+    return true;
+}
+
+bool apple_glx_surface_attach_shared(struct apple_glx_context *ac,
+				     struct apple_glx_drawable *d) {
+    return true;
+}
+
+bool apple_glx_worker_submit(struct apple_glx_job *job,
+			     void (*run)(void *arg), void *arg) {
+    /* There are no workers, so the caller runs the job. */
+    return true;
+}
+
+void apple_glx_worker_wait(struct apple_glx_job *job) {
+}
+
+bool apple_visual_create_pfobj(CGLPixelFormatObj *pfobj, const void *mode,
+			       bool *double_buffered, bool *uses_stereo,
+			       int offscreen_bpp, int profile,
+			       GLint renderer_id) {
+    *pfobj = (CGLPixelFormatObj) &renderer;
+
+    return false;
+}
+
+xp_error xp_update_gl_context(void *ctx) {
+    return 0;
+}
+
+GLAPI void APIENTRY glFlush(void) {
+}
+
+static CGLError create_context(CGLPixelFormatObj pix, CGLContextObj share,
+			       CGLContextObj *ctx) {
+    *ctx = (CGLContextObj) &renderer;
+
+    return kCGLNoError;
+}
+
+static CGLError set_current_context(CGLContextObj ctx) {
+    ++set_current_calls;
+
+    return kCGLNoError;
+}
+
+static CGLError clear_drawable(CGLContextObj ctx) {
+    ++clear_drawable_calls;
+
+    return kCGLNoError;
+}
+
+static CGLError enable(CGLContextObj ctx, CGLContextEnable pname) {
+    CHECK(kCGLCEMPEngine == pname);
+    ++enable_calls;
+
+    return enable_error;
+}
+
+static CGLError is_enabled(CGLContextObj ctx, CGLContextEnable pname,
+			   GLint *enabled) {
+    *enabled = engine_available;
+
+    return engine_available ? kCGLNoError : kCGLBadEnumeration;
+}
+
+static CGLError disable(CGLContextObj ctx, CGLContextEnable pname) {
+    ++disable_calls;
+
+    return kCGLNoError;
+}
+
+static const char *error_string(CGLError error) {
+    return "simulated error";
+}
+
+/* Parse attribs, and check the result or the error. */
+static void check_parse(const int *attribs, int expected_profile,
+			GLint expected_renderer_id, int expected_error,
+			bool expected_x11error) {
+    int profile = -1, error = Success;
+    GLint renderer_id = -1;
+    bool x11error = false, failed;
+
+    failed = parse_context_attributes(attribs, &profile, &renderer_id,
+				      &error, &x11error);
+
+    if(Success == expected_error) {
+	CHECK(!failed);
+	CHECK(expected_profile == profile);
+	CHECK(expected_renderer_id == renderer_id);
+    } else {
+	CHECK(failed);
+	CHECK(expected_error == error);
+	CHECK(expected_x11error == x11error);
+    }
+}
+
+static void check_attributes(void) {
+    const int legacy[] = { None };
+    const int gl21[] = { GLX_CONTEXT_MAJOR_VERSION_ARB, 2,
+			 GLX_CONTEXT_MINOR_VERSION_ARB, 1, None };
+    const int gl30[] = { GLX_CONTEXT_MAJOR_VERSION_ARB, 3, None };
+    const int gl30_fc[] = { GLX_CONTEXT_MAJOR_VERSION_ARB, 3,
+			    GLX_CONTEXT_FLAGS_ARB,
+			    GLX_CONTEXT_FORWARD_COMPATIBLE_BIT_ARB, None };
+    const int gl31_bad_mask[] = { GLX_CONTEXT_MAJOR_VERSION_ARB, 3,
+				  GLX_CONTEXT_MINOR_VERSION_ARB, 1,
+				  GLX_CONTEXT_PROFILE_MASK_ARB, 0x8, None };
+    const int gl32[] = { GLX_CONTEXT_MAJOR_VERSION_ARB, 3,
+			 GLX_CONTEXT_MINOR_VERSION_ARB, 2, None };
+    const int gl32_bad_mask[] = { GLX_CONTEXT_MAJOR_VERSION_ARB, 3,
+				  GLX_CONTEXT_MINOR_VERSION_ARB, 2,
+				  GLX_CONTEXT_PROFILE_MASK_ARB, 0x8, None };
+    const int gl32_compat[] = { GLX_CONTEXT_MAJOR_VERSION_ARB, 3,
+				GLX_CONTEXT_MINOR_VERSION_ARB, 2,
+				GLX_CONTEXT_PROFILE_MASK_ARB,
+				GLX_CONTEXT_COMPATIBILITY_PROFILE_BIT_ARB,
+				None };
+    const int gl41[] = { GLX_CONTEXT_MAJOR_VERSION_ARB, 4,
+			 GLX_CONTEXT_MINOR_VERSION_ARB, 1, None };
+    const int gl42[] = { GLX_CONTEXT_MAJOR_VERSION_ARB, 4,
+			 GLX_CONTEXT_MINOR_VERSION_ARB, 2, None };
+    const int bad_flags[] = { GLX_CONTEXT_FLAGS_ARB, 0x100, None };
+    const int unknown[] = { 0x7fff, 1, None };
+    const int color_index[] = { GLX_RENDER_TYPE, GLX_COLOR_INDEX_TYPE,
+				None };
+    const int renderer0[] = { GLX_RENDERER_ID_MESA, 0, None };
+    const int renderer1[] = { GLX_RENDERER_ID_MESA, 1, None };
+
+    check_parse(NULL, 0, 0, Success, false);
+    check_parse(legacy, 0, 0, Success, false);
+    check_parse(gl21, 0, 0, Success, false);
+
+    /* 3.0 needs its deprecated features, unless forward compatible. */
+    check_parse(gl30, 0, 0, BadMatch, true);
+    check_parse(gl30_fc, APPLE_CGL_PROFILE_3_2_CORE, 0, Success, false);
+
+    /* The profile mask is only checked for 3.2 and later. */
+    check_parse(gl31_bad_mask, APPLE_CGL_PROFILE_3_2_CORE, 0, Success,
+		false);
+    check_parse(gl32, APPLE_CGL_PROFILE_3_2_CORE, 0, Success, false);
+    check_parse(gl32_bad_mask, 0, 0, GLXBadProfileARB, false);
+    check_parse(gl32_compat, 0, 0, BadMatch, true);
+
+    check_parse(gl41, APPLE_CGL_PROFILE_GL4_CORE, 0, Success, false);
+    check_parse(gl42, 0, 0, BadMatch, true);
+
+    check_parse(bad_flags, 0, 0, BadValue, true);
+    check_parse(unknown, 0, 0, BadValue, true);
+    check_parse(color_index, 0, 0, BadMatch, true);
+
+    check_parse(renderer0, 0, renderer.id, Success, false);
+    check_parse(renderer1, 0, 0, BadValue, true);
+}
+
+static struct apple_glx_context *create(void) {
+    void *ptr;
+    int error = Success;
+    bool x11error = false;
+
+    CHECK(!apple_glx_create_context(&ptr, NULL, 0, NULL, NULL, NULL,
+				    &error, &x11error));
+
+    return ptr;
+}
+
+static void check_surfaceless(void) {
+    struct apple_glx_context *ac = create();
+
+    /* A context that was never attached has no drawable to clear. */
+    set_current_calls = clear_drawable_calls = 0;
+    CHECK(!apple_glx_make_current_context(NULL, NULL, ac, None));
+    CHECK(1 == set_current_calls);
+    CHECK(0 == clear_drawable_calls);
+    CHECK(ac->is_current);
+    CHECK(ac->detached);
+    CHECK(NULL == ac->drawable);
+
+    /* Binding it again without a drawable doesn't call CGL. */
+    set_current_calls = 0;
+    CHECK(!apple_glx_make_current_context(NULL, ac, ac, None));
+    CHECK(0 == set_current_calls);
+    CHECK(0 == clear_drawable_calls);
+
+    /* A context that was attached is cleared once, when it's detached. */
+    ac->detached = false;
+    ac->attached_surface = 1;
+    CHECK(!apple_glx_make_current_context(NULL, ac, ac, None));
+    CHECK(1 == set_current_calls);
+    CHECK(1 == clear_drawable_calls);
+    CHECK(ac->detached);
+    CHECK(0 == ac->attached_surface);
+
+    CHECK(!apple_glx_make_current_context(NULL, ac, ac, None));
+    CHECK(1 == clear_drawable_calls);
+
+    /* Releasing it leaves the context no longer current. */
+    CHECK(!apple_glx_make_current_context(NULL, ac, NULL, None));
+    CHECK(!ac->is_current);
+}
+
+/* Read LIBGL_MP_ENGINE again, with the setting given. */
+static void set_mp_engine(const char *value) {
+    static const pthread_once_t once_init = PTHREAD_ONCE_INIT;
+
+    if(value)
+	setenv("LIBGL_MP_ENGINE", value, 1);
+    else
+	unsetenv("LIBGL_MP_ENGINE");
+
+    options_once = once_init;
+    mp_engine_enabled = false;
+}
+
+static void check_mp_engine(void) {
+    struct apple_glx_context *ac;
+
+    /* The engine is only enabled on request. */
+    set_mp_engine(NULL);
+    enable_calls = disable_calls = 0;
+    ac = create();
+    CHECK(0 == enable_calls);
+    CHECK(!ac->mp_engine);
+
+    set_mp_engine("1");
+    engine_available = 1;
+    enable_error = kCGLNoError;
+    ac = create();
+    CHECK(1 == enable_calls);
+    CHECK(0 == disable_calls);
+    CHECK(ac->mp_engine);
+
+    /* A renderer without the engine is used without it. */
+    engine_available = 0;
+    ac = create();
+    CHECK(2 == enable_calls);
+    CHECK(1 == disable_calls);
+    CHECK(!ac->mp_engine);
+
+    enable_error = kCGLBadEnumeration;
+    ac = create();
+    CHECK(3 == enable_calls);
+    CHECK(1 == disable_calls);
+    CHECK(!ac->mp_engine);
+
+    set_mp_engine(NULL);
+}
+
+int main() {
+    apple_cgl.create_context = create_context;
+    apple_cgl.set_current_context = set_current_context;
+    apple_cgl.clear_drawable = clear_drawable;
+    apple_cgl.enable = enable;
+    apple_cgl.is_enabled = is_enabled;
+    apple_cgl.disable = disable;
+    apple_cgl.error_string = error_string;
+
+    check_attributes();
+    check_surfaceless();
+    check_mp_engine();
+
+    if(failures) {
+	fprintf(stderr, "%d failures\n", failures);
+	return EXIT_FAILURE;
+    }
+
+    printf("success\n");
+
+    return EXIT_SUCCESS;
+}
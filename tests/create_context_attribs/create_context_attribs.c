@@ -0,0 +1,128 @@
+/*
+ * This creates contexts with glXCreateContextAttribsARB for several
+ * versions, profiles, and flags, and checks which succeed, which fail
+ * with an error, and the GL_VERSION of each context created.
+ */
+#define GLX_GLXEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glx.h>
+#include <GL/glxext.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int last_error = Success;
+
+static int error_handler(Display *dpy, XErrorEvent *ev) {
+    last_error = ev->error_code;
+    return 0;
+}
+
+struct test {
+    const char *name;
+    int attribs[9];
+    /* The context is expected to be created. */
+    int created;
+    /* Or, the profile may be unsupported on an older system. */
+    int may_fail;
+};
+
+static const struct test tests[] = {
+    { "default", { None }, 1, 0 },
+    { "2.1", { GLX_CONTEXT_MAJOR_VERSION_ARB, 2,
+	       GLX_CONTEXT_MINOR_VERSION_ARB, 1, None }, 1, 0 },
+    { "2.1 debug", { GLX_CONTEXT_MAJOR_VERSION_ARB, 2,
+		     GLX_CONTEXT_MINOR_VERSION_ARB, 1,
+		     GLX_CONTEXT_FLAGS_ARB, GLX_CONTEXT_DEBUG_BIT_ARB,
+		     None }, 1, 0 },
+    { "3.2 core", { GLX_CONTEXT_MAJOR_VERSION_ARB, 3,
+		    GLX_CONTEXT_MINOR_VERSION_ARB, 2,
+		    GLX_CONTEXT_PROFILE_MASK_ARB,
+		    GLX_CONTEXT_CORE_PROFILE_BIT_ARB, None }, 1, 1 },
+    { "3.1 forward compatible", { GLX_CONTEXT_MAJOR_VERSION_ARB, 3,
+				  GLX_CONTEXT_MINOR_VERSION_ARB, 1,
+				  GLX_CONTEXT_FLAGS_ARB,
+				  GLX_CONTEXT_FORWARD_COMPATIBLE_BIT_ARB,
+				  None }, 1, 1 },
+    { "4.1 core", { GLX_CONTEXT_MAJOR_VERSION_ARB, 4,
+		    GLX_CONTEXT_MINOR_VERSION_ARB, 1, None }, 1, 1 },
+    { "3.0", { GLX_CONTEXT_MAJOR_VERSION_ARB, 3,
+	       GLX_CONTEXT_MINOR_VERSION_ARB, 0, None }, 0, 0 },
+    { "3.2 compatibility", { GLX_CONTEXT_MAJOR_VERSION_ARB, 3,
+			     GLX_CONTEXT_MINOR_VERSION_ARB, 2,
+			     GLX_CONTEXT_PROFILE_MASK_ARB,
+			     GLX_CONTEXT_COMPATIBILITY_PROFILE_BIT_ARB,
+			     None }, 0, 0 },
+    { "2.5", { GLX_CONTEXT_MAJOR_VERSION_ARB, 2,
+	       GLX_CONTEXT_MINOR_VERSION_ARB, 5, None }, 0, 0 },
+    { "bad profile mask", { GLX_CONTEXT_PROFILE_MASK_ARB, 0x10, None }, 0, 0 },
+    { "bad flags", { GLX_CONTEXT_FLAGS_ARB, 0x100, None }, 0, 0 },
+    { "bad attribute", { GLX_DOUBLEBUFFER, True, None }, 0, 0 },
+};
+
+int main() {
+    Display *dpy;
+    int fbattrib[] = { GLX_RENDER_TYPE, GLX_RGBA_BIT,
+		       GLX_RED_SIZE, 8,
+		       GLX_GREEN_SIZE, 8,
+		       GLX_BLUE_SIZE, 8,
+		       None };
+    GLXFBConfig *configs;
+    GLXContext ctx;
+    const char *extensions;
+    int nconfigs, i, failures = 0;
+
+    dpy = XOpenDisplay(NULL);
+
+    if(NULL == dpy) {
+        fprintf(stderr, "error: unable to open display!\n");
+        return EXIT_FAILURE;
+    }
+
+    extensions = glXQueryExtensionsString(dpy, DefaultScreen(dpy));
+
+    printf("GLX_ARB_create_context %s\n",
+	   strstr(extensions, "GLX_ARB_create_context") ? "yes" : "no");
+
+    configs = glXChooseFBConfig(dpy, DefaultScreen(dpy), fbattrib, &nconfigs);
+
+    if(NULL == configs || nconfigs < 1) {
+	fprintf(stderr, "error: no config!\n");
+	return EXIT_FAILURE;
+    }
+
+    XSetErrorHandler(error_handler);
+
+    for(i = 0; i < sizeof(tests) / sizeof(tests[0]); ++i) {
+	last_error = Success;
+	ctx = glXCreateContextAttribsARB(dpy, configs[0], NULL, True,
+					 tests[i].attribs);
+	XSync(dpy, False);
+
+	if(ctx) {
+	    /* A 3.0 and later context needs no drawable to be current. */
+	    glXMakeContextCurrent(dpy, None, None, ctx);
+	    printf("%-24s created, GL_VERSION %s\n", tests[i].name,
+		   (const char *)glGetString(GL_VERSION));
+	    glXMakeContextCurrent(dpy, None, None, NULL);
+	    glXDestroyContext(dpy, ctx);
+	} else {
+	    printf("%-24s failed with error %d\n", tests[i].name, last_error);
+	}
+
+	if((NULL != ctx) != tests[i].created && !tests[i].may_fail) {
+	    printf("%-24s FAILED\n", tests[i].name);
+	    ++failures;
+	}
+
+	if(NULL == ctx && Success == last_error) {
+	    printf("%-24s FAILED: no error was generated\n", tests[i].name);
+	    ++failures;
+	}
+    }
+
+    XFree(configs);
+    XCloseDisplay(dpy);
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
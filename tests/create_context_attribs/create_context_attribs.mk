@@ -0,0 +1,5 @@
+$(TEST_BUILD_DIR)/create_context_attribs: tests/create_context_attribs/create_context_attribs.c $(LIBGL)
+	$(CC) tests/create_context_attribs/create_context_attribs.c $(INCLUDE) -o $(TEST_BUILD_DIR)/create_context_attribs $(LINK_TEST)
+
+$(TEST_BUILD_DIR)/context_checks: tests/create_context_attribs/context_checks.c apple_glx_context.c apple_glx_context.h
+	$(CC) -DPTHREADS -DGLX_USE_APPLEGL tests/create_context_attribs/context_checks.c $(INCLUDE) -o $(TEST_BUILD_DIR)/context_checks -lpthread
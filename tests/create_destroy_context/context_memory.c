@@ -0,0 +1,82 @@
+/*
+ * This reports the heap memory used by each context that is created but
+ * never made current, next to the size of the GLX protocol buffer that
+ * every context used to allocate.  Run it with LIBGL_DIAGNOSTIC=1 to also
+ * see the report of each context.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <malloc/malloc.h>
+#include <X11/Xlib.h>
+#include <GL/gl.h>
+#include <GL/glx.h>
+
+#define CONTEXTS 256
+
+int main() {
+    Display *dpy;
+    int attrib[] = { GLX_RGBA,
+		     GLX_RED_SIZE, 8,
+		     GLX_GREEN_SIZE, 8,
+		     GLX_BLUE_SIZE, 8,
+		     GLX_DOUBLEBUFFER,
+		     None };
+    XVisualInfo *visinfo;
+    GLXContext ctx[CONTEXTS];
+    size_t before, created, destroyed;
+    long buffer;
+    int screen, i;
+
+    dpy = XOpenDisplay(NULL);
+    
+    if(NULL == dpy) {
+        fprintf(stderr, "error: unable to open display!\n");
+        return EXIT_FAILURE;
+    }
+
+    visinfo = glXChooseVisual(dpy, DefaultScreen(dpy), attrib);
+
+    if(!visinfo) {
+	fprintf(stderr, "error: couldn't get an RGB, Double-buffered visual!\n");
+	return EXIT_FAILURE;
+    }
+
+    /* The first context loads the framework, so it isn't counted. */
+    glXDestroyContext(dpy, glXCreateContext(dpy, visinfo, NULL, True));
+
+    before = mstats().bytes_used;
+
+    for(i = 0; i < CONTEXTS; ++i) {
+	ctx[i] = glXCreateContext(dpy, visinfo, NULL, True);
+
+	if(!ctx[i]) {
+	    fprintf(stderr, "error: glXCreateContext failed!\n");
+	    return EXIT_FAILURE;
+	}
+    }
+
+    /* Wait for any context created asynchronously. */
+    for(i = 0; i < CONTEXTS; ++i)
+	glXQueryContext(dpy, ctx[i], GLX_SCREEN, &screen);
+
+    created = mstats().bytes_used;
+
+    for(i = 0; i < CONTEXTS; ++i)
+	glXDestroyContext(dpy, ctx[i]);
+
+    destroyed = mstats().bytes_used;
+
+    buffer = XMaxRequestSize(dpy) * 4;
+
+    printf("%d contexts: %ld bytes each\n", CONTEXTS,
+	   (long)(created - before) / CONTEXTS);
+    printf("GLX protocol buffer no longer allocated: %ld bytes each, "
+	   "%ld bytes in all\n", buffer, buffer * CONTEXTS);
+    printf("after destroying them: %ld bytes still in use\n",
+	   (long)destroyed - (long)before);
+
+    XFree(visinfo);
+    XCloseDisplay(dpy);
+
+    return EXIT_SUCCESS;
+}
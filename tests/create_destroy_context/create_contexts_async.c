@@ -0,0 +1,104 @@
+/*
+ * This creates many contexts, half of them shared with the first, and
+ * times glXCreateContext, and making each context current for the first
+ * time.  Run it with and without LIBGL_ASYNC_CONTEXT to compare.  It also
+ * destroys a context that was never made current.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <X11/Xlib.h>
+#include <GL/gl.h>
+#include <GL/glx.h>
+
+#define CONTEXTS 32
+
+static double now(void) {
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+
+    return tv.tv_sec * 1000000.0 + tv.tv_usec;
+}
+
+int main() {
+    Display *dpy;
+    int attrib[] = { GLX_RGBA,
+		     GLX_RED_SIZE, 8,
+		     GLX_GREEN_SIZE, 8,
+		     GLX_BLUE_SIZE, 8,
+		     GLX_DEPTH_SIZE, 24,
+		     GLX_DOUBLEBUFFER,
+		     None };
+    XVisualInfo *visinfo;
+    GLXContext ctx[CONTEXTS], unused;
+    double start, createtime, currenttime;
+    const char *workers;
+    int i, failures = 0;
+
+    dpy = XOpenDisplay(NULL);
+    
+    if(NULL == dpy) {
+        fprintf(stderr, "error: unable to open display!\n");
+        return EXIT_FAILURE;
+    }
+
+    visinfo = glXChooseVisual(dpy, DefaultScreen(dpy), attrib);
+
+    if(!visinfo) {
+	fprintf(stderr, "error: couldn't get an RGBA, double-buffered visual!\n");
+	return EXIT_FAILURE;
+    }
+
+    workers = getenv("LIBGL_ASYNC_CONTEXT");
+    printf("LIBGL_ASYNC_CONTEXT %s\n", workers ? workers : "unset");
+
+    start = now();
+
+    for(i = 0; i < CONTEXTS; ++i) {
+	ctx[i] = glXCreateContext(dpy, visinfo, (i & 1) ? ctx[0] : NULL, True);
+
+	if(!ctx[i]) {
+	    fprintf(stderr, "error: glXCreateContext failed!\n");
+	    return EXIT_FAILURE;
+	}
+    }
+
+    createtime = now() - start;
+
+    unused = glXCreateContext(dpy, visinfo, NULL, True);
+    glXDestroyContext(dpy, unused);
+
+    start = now();
+
+    for(i = 0; i < CONTEXTS; ++i) {
+	if(!glXMakeCurrent(dpy, None, ctx[i])) {
+	    printf("context %d: FAILED to make current\n", i);
+	    ++failures;
+	    continue;
+	}
+
+	if(NULL == glGetString(GL_RENDERER)) {
+	    printf("context %d: FAILED, no GL_RENDERER\n", i);
+	    ++failures;
+	}
+    }
+
+    currenttime = now() - start;
+
+    glXMakeCurrent(dpy, None, NULL);
+
+    for(i = 0; i < CONTEXTS; ++i)
+	glXDestroyContext(dpy, ctx[i]);
+
+    printf("%d glXCreateContext           %10.0f us\n", CONTEXTS, createtime);
+    printf("%d first glXMakeCurrent       %10.0f us\n", CONTEXTS, currenttime);
+    printf("total                         %10.0f us\n", createtime + currenttime);
+
+    XFree(visinfo);
+    XCloseDisplay(dpy);
+
+    printf("%s\n", failures ? "FAILED" : "PASSED");
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -14,3 +14,11 @@ $(TEST_BUILD_DIR)/create_destroy_context_with_drawable_2: tests/create_destroy_c
 	$(CC) tests/create_destroy_context/create_destroy_context_with_drawable_2.c -Iinclude \
     -o $(TEST_BUILD_DIR)/create_destroy_context_with_drawable_2 $(LINK_TEST)
 
+
+$(TEST_BUILD_DIR)/create_contexts_async: tests/create_destroy_context/create_contexts_async.c $(LIBGL)
+	$(CC) tests/create_destroy_context/create_contexts_async.c -Iinclude \
+    -o $(TEST_BUILD_DIR)/create_contexts_async $(LINK_TEST)
+
+$(TEST_BUILD_DIR)/context_memory: tests/create_destroy_context/context_memory.c $(LIBGL)
+	$(CC) tests/create_destroy_context/context_memory.c -Iinclude \
+    -o $(TEST_BUILD_DIR)/context_memory $(LINK_TEST)
@@ -0,0 +1,2 @@
+$(TEST_BUILD_DIR)/glxhash: glxhash.c glxhash.h
+	$(CC) -O2 -DHASH_MAIN=1 glxhash.c $(INCLUDE) -o $(TEST_BUILD_DIR)/glxhash -lpthread
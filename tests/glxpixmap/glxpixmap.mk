@@ -6,3 +6,21 @@ $(TEST_BUILD_DIR)/glxpixmap_create_destroy: tests/glxpixmap/glxpixmap_create_des
 
 $(TEST_BUILD_DIR)/glxpixmap_destroy_invalid: tests/glxpixmap/glxpixmap_destroy_invalid.c $(LIBGL)
 	$(CC) tests/glxpixmap/glxpixmap_destroy_invalid.c $(INCLUDE) -o $(TEST_BUILD_DIR)/glxpixmap_destroy_invalid $(LINK_TEST)
+
+$(TEST_BUILD_DIR)/glxpixmap_wait: tests/glxpixmap/glxpixmap_wait.c $(LIBGL)
+	$(CC) tests/glxpixmap/glxpixmap_wait.c $(INCLUDE) -o $(TEST_BUILD_DIR)/glxpixmap_wait $(LINK_TEST)
+
+$(TEST_BUILD_DIR)/texture_from_pixmap: tests/glxpixmap/texture_from_pixmap.c $(LIBGL)
+	$(CC) tests/glxpixmap/texture_from_pixmap.c $(INCLUDE) -o $(TEST_BUILD_DIR)/texture_from_pixmap $(LINK_TEST)
+
+$(TEST_BUILD_DIR)/glxpixmap_depths: tests/glxpixmap/glxpixmap_depths.c $(LIBGL)
+	$(CC) tests/glxpixmap/glxpixmap_depths.c $(INCLUDE) -o $(TEST_BUILD_DIR)/glxpixmap_depths $(LINK_TEST)
+
+$(TEST_BUILD_DIR)/glxpixmap_batch: tests/glxpixmap/glxpixmap_batch.c $(LIBGL)
+	$(CC) tests/glxpixmap/glxpixmap_batch.c $(INCLUDE) -o $(TEST_BUILD_DIR)/glxpixmap_batch $(LINK_TEST)
+
+$(TEST_BUILD_DIR)/pixmap_formats: tests/glxpixmap/pixmap_formats.c apple_glx_pixmap.c apple_visual.c apple_glx_drawable.h
+	$(CC) -DPTHREADS -DGLX_USE_APPLEGL tests/glxpixmap/pixmap_formats.c apple_glx_pixmap.c apple_visual.c $(INCLUDE) -o $(TEST_BUILD_DIR)/pixmap_formats -lpthread
+
+$(TEST_BUILD_DIR)/wait_paths: tests/glxpixmap/wait_paths.c apple_glx.c apple_glx_context.h apple_glx_drawable.h
+	$(CC) -DPTHREADS -DGLX_USE_APPLEGL tests/glxpixmap/wait_paths.c $(INCLUDE) -o $(TEST_BUILD_DIR)/wait_paths -lpthread
@@ -0,0 +1,193 @@
+/*
+ * This compares the time of creating and destroying GLXPixmaps one at a
+ * time with GLX_APPLE_pixmap_batch, and checks that the pixmaps of a
+ * batch can be rendered to, and that a bad count is a BadValue error.
+ */
+#define GLX_GLXEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glx.h>
+#include <GL/glxext.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#define COUNT 500
+#define SIZE 64
+
+static double now(void) {
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+
+    return tv.tv_sec * 1000000.0 + tv.tv_usec;
+}
+
+static int last_error;
+
+static int error_handler(Display *dpy, XErrorEvent *event) {
+    last_error = event->error_code;
+
+    return 0;
+}
+
+/* Return 1 if a negative count isn't reported as a core BadValue. */
+static int check_bad_count(Display *dpy, GLXFBConfig config,
+			   Pixmap *pixmaps, GLXPixmap *glxpixmaps) {
+    int (*old_handler)(Display *, XErrorEvent *);
+    int created;
+
+    last_error = Success;
+    old_handler = XSetErrorHandler(error_handler);
+
+    created = glXCreatePixmapsAPPLE(dpy, config, -1, pixmaps, NULL,
+				    glxpixmaps);
+    XSync(dpy, False);
+
+    XSetErrorHandler(old_handler);
+
+    if(0 != created || BadValue != last_error) {
+	fprintf(stderr, "error: a count of -1 created %d and gave error %d,"
+		" rather than BadValue (%d)!\n", created, last_error, BadValue);
+	return 1;
+    }
+
+    return 0;
+}
+
+/* Return 1 if rendering to the GLXPixmap failed. */
+static int render(Display *dpy, Pixmap pixmap, GLXPixmap glxpixmap,
+		  GLXContext ctx) {
+    XImage *image;
+    unsigned long pixel, green;
+
+    if(!glXMakeContextCurrent(dpy, glxpixmap, glxpixmap, ctx)) {
+	fprintf(stderr, "error: unable to make the GLXPixmap current!\n");
+	return 1;
+    }
+
+    glClearColor(0.0f, 1.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glFinish();
+    glXMakeContextCurrent(dpy, None, None, NULL);
+
+    image = XGetImage(dpy, pixmap, SIZE / 2, SIZE / 2, 1, 1, AllPlanes,
+		      ZPixmap);
+
+    if(NULL == image) {
+	fprintf(stderr, "error: XGetImage failed!\n");
+	return 1;
+    }
+
+    pixel = XGetPixel(image, 0, 0);
+    green = image->green_mask;
+    XDestroyImage(image);
+
+    if((pixel & 0xffffff) != green) {
+	fprintf(stderr, "error: unexpected pixel 0x%lx\n", pixel);
+	return 1;
+    }
+
+    return 0;
+}
+
+int main() {
+    Display *dpy;
+    int fbattrib[] = { GLX_DRAWABLE_TYPE, GLX_PIXMAP_BIT,
+		       GLX_RENDER_TYPE, GLX_RGBA_BIT,
+		       GLX_RED_SIZE, 8,
+		       GLX_GREEN_SIZE, 8,
+		       GLX_BLUE_SIZE, 8,
+		       None };
+    GLXFBConfig *configs;
+    XVisualInfo *visinfo;
+    GLXContext ctx;
+    Pixmap pixmaps[COUNT];
+    GLXPixmap glxpixmaps[COUNT];
+    double start, single_create, single_destroy, batch_create, batch_destroy;
+    int nconfigs, created, i, failures = 0;
+
+    dpy = XOpenDisplay(NULL);
+
+    if(NULL == dpy) {
+        fprintf(stderr, "error: unable to open display!\n");
+        return EXIT_FAILURE;
+    }
+
+    if(NULL == strstr(glXQueryExtensionsString(dpy, DefaultScreen(dpy)),
+		      "GLX_APPLE_pixmap_batch")) {
+	fprintf(stderr, "error: GLX_APPLE_pixmap_batch isn't supported!\n");
+	return EXIT_FAILURE;
+    }
+
+    configs = glXChooseFBConfig(dpy, DefaultScreen(dpy), fbattrib, &nconfigs);
+
+    if(NULL == configs || nconfigs < 1) {
+	fprintf(stderr, "error: no config!\n");
+	return EXIT_FAILURE;
+    }
+
+    visinfo = glXGetVisualFromFBConfig(dpy, configs[0]);
+    ctx = glXCreateNewContext(dpy, configs[0], GLX_RGBA_TYPE, NULL, True);
+
+    if(NULL == visinfo || NULL == ctx) {
+	fprintf(stderr, "error: unable to create a context!\n");
+	return EXIT_FAILURE;
+    }
+
+    for(i = 0; i < COUNT; ++i)
+	pixmaps[i] = XCreatePixmap(dpy, DefaultRootWindow(dpy), SIZE, SIZE,
+				   visinfo->depth);
+
+    start = now();
+
+    for(i = 0; i < COUNT; ++i)
+	glxpixmaps[i] = glXCreatePixmap(dpy, configs[0], pixmaps[i], NULL);
+
+    single_create = now() - start;
+    start = now();
+
+    for(i = 0; i < COUNT; ++i)
+	glXDestroyPixmap(dpy, glxpixmaps[i]);
+
+    XSync(dpy, False);
+    single_destroy = now() - start;
+    start = now();
+
+    created = glXCreatePixmapsAPPLE(dpy, configs[0], COUNT, pixmaps, NULL,
+				    glxpixmaps);
+
+    batch_create = now() - start;
+
+    if(created != COUNT) {
+	fprintf(stderr, "error: %d of %d GLXPixmaps were created!\n",
+		created, COUNT);
+	++failures;
+    }
+
+    /* Each pixmap renders to its own memory. */
+    failures += render(dpy, pixmaps[0], glxpixmaps[0], ctx);
+    failures += render(dpy, pixmaps[COUNT - 1], glxpixmaps[COUNT - 1], ctx);
+
+    failures += check_bad_count(dpy, configs[0], pixmaps, glxpixmaps);
+
+    start = now();
+    glXDestroyPixmapsAPPLE(dpy, COUNT, glxpixmaps);
+    XSync(dpy, False);
+    batch_destroy = now() - start;
+
+    printf("%d pixmaps, one at a time: create %8.0f us destroy %8.0f us\n",
+	   COUNT, single_create, single_destroy);
+    printf("%d pixmaps, batched:       create %8.0f us destroy %8.0f us\n",
+	   COUNT, batch_create, batch_destroy);
+
+    for(i = 0; i < COUNT; ++i)
+	XFreePixmap(dpy, pixmaps[i]);
+
+    glXDestroyContext(dpy, ctx);
+    XFree(visinfo);
+    XFree(configs);
+    XCloseDisplay(dpy);
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
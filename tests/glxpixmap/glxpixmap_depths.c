@@ -0,0 +1,115 @@
+/*
+ * This renders to a GLXPixmap at every depth that has a GL visual, and
+ * checks the pixels X reads back, to verify that the offscreen pixel
+ * format matches the layout of the pixmap.
+ */
+#include <GL/gl.h>
+#include <GL/glx.h>
+#include <X11/Xutil.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define WIDTH 64
+#define HEIGHT 64
+
+/* Return 1 if the depth failed. */
+static int test_depth(Display *dpy, Window root, XVisualInfo *visinfo) {
+    GLXContext ctx;
+    Pixmap pixmap;
+    GLXPixmap glxpixmap;
+    XImage *image;
+    unsigned long pixel;
+    int failed = 0;
+
+    pixmap = XCreatePixmap(dpy, root, WIDTH, HEIGHT, visinfo->depth);
+    glxpixmap = glXCreateGLXPixmap(dpy, visinfo, pixmap);
+
+    if(None == glxpixmap) {
+	printf("depth %2d: glXCreateGLXPixmap failed\n", visinfo->depth);
+	XFreePixmap(dpy, pixmap);
+	return 1;
+    }
+
+    ctx = glXCreateContext(dpy, visinfo, NULL, True);
+
+    if(!ctx || !glXMakeCurrent(dpy, glxpixmap, ctx)) {
+	printf("depth %2d: glXMakeCurrent failed\n", visinfo->depth);
+	glXDestroyGLXPixmap(dpy, glxpixmap);
+	XFreePixmap(dpy, pixmap);
+	return 1;
+    }
+
+    glClearColor(1.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glXWaitGL();
+
+    image = XGetImage(dpy, pixmap, 0, 0, WIDTH, HEIGHT, AllPlanes, ZPixmap);
+
+    if(image) {
+	/* Check the last pixel, which is past the end of a 16 bit row
+	 * if the pixmap was rendered as 32 bits per pixel.
+	 */
+	pixel = XGetPixel(image, WIDTH - 1, HEIGHT - 1);
+
+	if((pixel & visinfo->red_mask) != visinfo->red_mask
+	   || (pixel & (visinfo->green_mask | visinfo->blue_mask))) {
+	    failed = 1;
+	}
+
+	printf("depth %2d: %d bits per pixel, pixel 0x%lx %s\n",
+	       visinfo->depth, image->bits_per_pixel, pixel,
+	       failed ? "FAILED" : "ok");
+
+	XDestroyImage(image);
+    } else {
+	printf("depth %2d: XGetImage failed\n", visinfo->depth);
+	failed = 1;
+    }
+
+    glXMakeCurrent(dpy, None, NULL);
+    glXDestroyContext(dpy, ctx);
+    glXDestroyGLXPixmap(dpy, glxpixmap);
+    XFreePixmap(dpy, pixmap);
+
+    return failed;
+}
+
+int main() {
+    Display *dpy;
+    XVisualInfo template, *visuals;
+    int screen, nvisuals, i, failures = 0;
+    int tested[33] = { 0 };
+    int use_gl, rgba;
+
+    dpy = XOpenDisplay(NULL);
+
+    if(NULL == dpy) {
+        fprintf(stderr, "error: unable to open display!\n");
+        return EXIT_FAILURE;
+    }
+
+    screen = DefaultScreen(dpy);
+    template.screen = screen;
+    visuals = XGetVisualInfo(dpy, VisualScreenMask, &template, &nvisuals);
+
+    for(i = 0; i < nvisuals; ++i) {
+	if(glXGetConfig(dpy, &visuals[i], GLX_USE_GL, &use_gl)
+	   || !use_gl)
+	    continue;
+
+	if(glXGetConfig(dpy, &visuals[i], GLX_RGBA, &rgba) || !rgba)
+	    continue;
+
+	/* Test each depth once. */
+	if(visuals[i].depth > 32 || tested[visuals[i].depth])
+	    continue;
+
+	tested[visuals[i].depth] = 1;
+	failures += test_depth(dpy, RootWindow(dpy, screen), &visuals[i]);
+    }
+
+    XFree(visuals);
+    XCloseDisplay(dpy);
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
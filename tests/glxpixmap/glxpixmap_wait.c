@@ -0,0 +1,167 @@
+/*
+ * This measures the latency of glXWaitGL and glXWaitX while compositing
+ * a GLXPixmap into a window every frame, and while rendering to the 
+ * window and a pbuffer directly.
+ */
+#include <GL/gl.h>
+#include <GL/glx.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#define WIDTH 300
+#define HEIGHT 300
+#define FRAMES 500
+
+static double now(void) {
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+
+    return tv.tv_sec * 1000000.0 + tv.tv_usec;
+}
+
+static void draw(void) {
+    glClear(GL_COLOR_BUFFER_BIT);
+    glColor3f(0.5f, 0.5f, 1.0f);
+    glBegin(GL_TRIANGLES);
+    glVertex2f( 0.0f, 1.0f);
+    glVertex2f(-1.0f,-1.0f);
+    glVertex2f( 1.0f,-1.0f);
+    glEnd();
+}
+
+/* 
+ * Render and wait FRAMES times.  If pixmap isn't None, it's copied 
+ * to the window with X after each glXWaitGL.
+ */
+static void measure(Display *dpy, const char *name, Window win, 
+		    Pixmap pixmap, GC gc) {
+    double waitgl = 0.0, waitx = 0.0, start;
+    int i;
+
+    for(i = 0; i < FRAMES; ++i) {
+	draw();
+
+	start = now();
+	glXWaitGL();
+	waitgl += now() - start;
+
+	if(None != pixmap)
+	    XCopyArea(dpy, pixmap, win, gc, 0, 0, WIDTH, HEIGHT, 0, 0);
+
+	start = now();
+	glXWaitX();
+	waitx += now() - start;
+    }
+
+    printf("%-10s glXWaitGL %8.2f us  glXWaitX %8.2f us (average of %d)\n",
+	   name, waitgl / FRAMES, waitx / FRAMES, FRAMES);
+}
+
+int main() {
+    Display *dpy;
+    int attrib[] = { GLX_RGBA,
+		     GLX_RED_SIZE, 8,
+		     GLX_GREEN_SIZE, 8,
+		     GLX_BLUE_SIZE, 8,
+		     None };
+    int fbattrib[] = { GLX_DRAWABLE_TYPE, GLX_PBUFFER_BIT,
+		       GLX_RENDER_TYPE, GLX_RGBA_BIT,
+		       GLX_RED_SIZE, 8,
+		       GLX_GREEN_SIZE, 8,
+		       GLX_BLUE_SIZE, 8,
+		       None };
+    int pbattrib[] = { GLX_PBUFFER_WIDTH, WIDTH,
+		       GLX_PBUFFER_HEIGHT, HEIGHT,
+		       None };
+    int screen, nconfigs;
+    Window root, win;
+    XVisualInfo *visinfo;
+    XSetWindowAttributes attr;
+    GLXContext ctx, pbctx;
+    GLXFBConfig *configs;
+    GLXPbuffer pbuffer;
+    Pixmap pixmap;
+    GLXPixmap glxpixmap;
+    GC gc;
+
+    dpy = XOpenDisplay(NULL);
+    
+    if(NULL == dpy) {
+        fprintf(stderr, "error: unable to open display!\n");
+        return EXIT_FAILURE;
+    }
+    
+    screen = DefaultScreen(dpy);
+    root = RootWindow(dpy, screen);
+
+    visinfo = glXChooseVisual(dpy, screen, attrib);
+
+    if(!visinfo) {
+	fprintf(stderr, "error: couldn't get an RGBA visual!\n");
+	return EXIT_FAILURE;
+    }
+
+    attr.background_pixel = 0;
+    attr.border_pixel = 0;
+    attr.colormap = XCreateColormap(dpy, root, visinfo->visual, AllocNone);
+    attr.event_mask = StructureNotifyMask | ExposureMask;
+
+    win = XCreateWindow(dpy, root, 0, 0, WIDTH, HEIGHT,
+			0, visinfo->depth, InputOutput,
+			visinfo->visual, 
+			CWBackPixel | CWBorderPixel | CWColormap | CWEventMask,
+			&attr);
+    XMapWindow(dpy, win);
+
+    gc = XCreateGC(dpy, win, 0, NULL);
+
+    ctx = glXCreateContext(dpy, visinfo, NULL, True);
+
+    if(!ctx) {
+	fprintf(stderr, "error: glXCreateContext failed!\n");
+	return EXIT_FAILURE;
+    }
+
+    pixmap = XCreatePixmap(dpy, win, WIDTH, HEIGHT, visinfo->depth);
+    glxpixmap = glXCreateGLXPixmap(dpy, visinfo, pixmap);
+
+    if(!glXMakeCurrent(dpy, glxpixmap, ctx)) {
+	fprintf(stderr, "error: glXMakeCurrent failed for the GLXPixmap!\n");
+	return EXIT_FAILURE;
+    }
+
+    measure(dpy, "GLXPixmap", win, pixmap, gc);
+
+    if(!glXMakeCurrent(dpy, win, ctx)) {
+	fprintf(stderr, "error: glXMakeCurrent failed for the window!\n");
+	return EXIT_FAILURE;
+    }
+
+    measure(dpy, "window", win, None, gc);
+
+    configs = glXChooseFBConfig(dpy, screen, fbattrib, &nconfigs);
+
+    if(configs && nconfigs > 0) {
+	pbuffer = glXCreatePbuffer(dpy, configs[0], pbattrib);
+	pbctx = glXCreateNewContext(dpy, configs[0], GLX_RGBA_TYPE, NULL, True);
+
+	if(pbctx && glXMakeContextCurrent(dpy, pbuffer, pbuffer, pbctx)) {
+	    measure(dpy, "pbuffer", win, None, gc);
+	    glXMakeCurrent(dpy, None, NULL);
+	    glXDestroyContext(dpy, pbctx);
+	}
+
+	glXDestroyPbuffer(dpy, pbuffer);
+	XFree(configs);
+    }
+
+    glXMakeCurrent(dpy, None, NULL);
+    glXDestroyGLXPixmap(dpy, glxpixmap);
+    XFreePixmap(dpy, pixmap);
+    glXDestroyContext(dpy, ctx);
+    XCloseDisplay(dpy);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,241 @@
+/*
+ * This checks the formats used for the memory of 16 and 32 bit pixmaps:
+ * the pixel format CGL renders to offscreen, and the format and type a
+ * pixmap is textured from with GLX_EXT_texture_from_pixmap.  The GL, CGL,
+ * and the drawables are stubbed, so no display is needed.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "glxclient.h"
+#include "apple_glx.h"
+#include "apple_cgl.h"
+#include "apple_visual.h"
+#include "apple_glx_drawable.h"
+#include "apple_xgl_api.h"
+#include "appledri.h"
+#include "glcontextmodes.h"
+
+static int failures = 0;
+
+#define CHECK(cond) do {						\
+	if(!(cond)) {							\
+	    fprintf(stderr, "%s:%d: FAILED: %s\n", __FILE__, __LINE__,	\
+		    #cond);						\
+	    ++failures;							\
+	}								\
+    } while(0)
+
+struct apple_xgl_api __gl_api;
+struct apple_cgl_api apple_cgl;
+
+static struct apple_glx_drawable drawable;
+static GLenum image_format, image_type;
+static GLint image_internal_format;
+static CGLPixelFormatAttribute chosen[60];
+
+/* These replace the parts of libGL the pixmaps and visuals use. */
+void apple_glx_diagnostic(const char *fmt, ...) {
+}
+
+void apple_glx_wait_framework(void) {
+}
+
+GLint apple_glx_renderer_default_id(void) {
+    return 0;
+}
+
+struct apple_glx_drawable *
+apple_glx_drawable_find_by_type(Display *dpy, GLXDrawable d, int type,
+				int flags) {
+    return &drawable;
+}
+
+bool apple_glx_drawable_create(Display *dpy, int screen, GLXDrawable d,
+			       struct apple_glx_drawable **agd,
+			       struct apple_glx_drawable_callbacks *callbacks) {
+    return true;
+}
+
+bool apple_glx_drawable_destroy_by_type(Display *dpy, GLXDrawable d,
+					int type) {
+    return false;
+}
+
+bool apple_glx_display_is_closed(struct apple_glx_display *gd) {
+    return false;
+}
+
+int XSync(Display *dpy, Bool discard) {
+    return 0;
+}
+
+XAppleDRICookie XAppleDRISendCreatePixmap(Display *dpy, int screen,
+					  Drawable drawable) {
+    XAppleDRICookie cookie;
+
+    memset(&cookie, 0, sizeof(cookie));
+
+    return cookie;
+}
+
+Bool XAppleDRICreatePixmapReply(Display *dpy, XAppleDRICookie cookie,
+				int *width, int *height, int *pitch,
+				int *bpp, size_t *size, char *path,
+				size_t pathmax) {
+    return False;
+}
+
+Bool XAppleDRIDestroyPixmap(Display *dpy, Pixmap pixmap) {
+    return True;
+}
+
+GLAPI void APIENTRY glViewport(GLint x, GLint y, GLsizei w, GLsizei h) {
+}
+
+GLAPI void APIENTRY glScissor(GLint x, GLint y, GLsizei w, GLsizei h) {
+}
+
+static void drawable_lock(struct apple_glx_drawable *d) {
+}
+
+static void drawable_reference(struct apple_glx_drawable *d) {
+}
+
+static bool drawable_destroy(struct apple_glx_drawable *d) {
+    return false;
+}
+
+static void tex_image_2d(GLenum target, GLint level, GLint internal_format,
+			 GLsizei width, GLsizei height, GLint border,
+			 GLenum format, GLenum type, const void *pixels) {
+    image_internal_format = internal_format;
+    image_format = format;
+    image_type = type;
+}
+
+static void gl_ignore_enum_int(GLenum pname, GLint param) {
+}
+
+static void gl_ignore_enum_enum_int(GLenum target, GLenum pname,
+				    GLint param) {
+}
+
+static void bind_texture(GLenum target, GLuint texture) {
+}
+
+static void gl_ignore_bitfield(GLbitfield mask) {
+}
+
+static void gl_ignore(void) {
+}
+
+static void get_integerv(GLenum pname, GLint *params) {
+    *params = 1;
+}
+
+static CGLError choose_pixel_format(const CGLPixelFormatAttribute *attribs,
+				    CGLPixelFormatObj *pix, GLint *npix) {
+    int i;
+
+    for(i = 0; attribs[i]; ++i)
+	chosen[i] = attribs[i];
+
+    chosen[i] = 0;
+    *pix = (CGLPixelFormatObj) chosen;
+    *npix = 1;
+
+    return kCGLNoError;
+}
+
+/* Return the value of attr in the attributes chosen, or -1. */
+static int chosen_value(CGLPixelFormatAttribute attr) {
+    int i;
+
+    for(i = 0; chosen[i]; ++i) {
+	if(attr == chosen[i])
+	    return chosen[i + 1];
+
+	if(kCGLPFAColorSize == chosen[i] || kCGLPFAAlphaSize == chosen[i]
+	   || kCGLPFADepthSize == chosen[i] || kCGLPFARendererID == chosen[i])
+	    ++i;
+    }
+
+    return -1;
+}
+
+static void check_offscreen(int bpp, int color_size, int alpha_size) {
+    __GLcontextModes mode;
+    CGLPixelFormatObj pfobj;
+    bool double_buffered, uses_stereo;
+
+    memset(&mode, 0, sizeof(mode));
+    mode.redBits = mode.greenBits = mode.blueBits = mode.alphaBits = 8;
+
+    CHECK(!apple_visual_create_pfobj(&pfobj, &mode, &double_buffered,
+				     &uses_stereo, bpp, 0, 0));
+    CHECK(color_size == chosen_value(kCGLPFAColorSize));
+    CHECK(alpha_size == chosen_value(kCGLPFAAlphaSize));
+}
+
+static void check_texture(int bpp, int texture_format, GLint internal_format,
+			  GLenum format, GLenum type) {
+    struct apple_glx_pixmap *p = &drawable.types.pixmap;
+    int errorcode = Success;
+
+    p->bpp = bpp;
+    p->pitch = 64 * bpp;
+    p->width = p->height = 64;
+    p->texture_format = texture_format;
+    p->texture_target = GLX_TEXTURE_2D_EXT;
+    p->bound = false;
+
+    image_format = image_type = 0;
+
+    CHECK(!apple_glx_pixmap_bind_tex_image(NULL, 1, GLX_FRONT_LEFT_EXT,
+					   &errorcode));
+    CHECK(internal_format == image_internal_format);
+    CHECK(format == image_format);
+    CHECK(type == image_type);
+
+    CHECK(!apple_glx_pixmap_release_tex_image(NULL, 1, GLX_FRONT_LEFT_EXT,
+					      &errorcode));
+}
+
+int main() {
+    drawable.lock = drawable_lock;
+    drawable.unlock = drawable_lock;
+    drawable.reference = drawable_reference;
+    drawable.destroy = drawable_destroy;
+
+    __gl_api.TexImage2D = tex_image_2d;
+    __gl_api.PixelStorei = gl_ignore_enum_int;
+    __gl_api.TexParameteri = gl_ignore_enum_enum_int;
+    __gl_api.PushClientAttrib = gl_ignore_bitfield;
+    __gl_api.PopClientAttrib = gl_ignore;
+    __gl_api.GetIntegerv = get_integerv;
+    __gl_api.BindTexture = bind_texture;
+
+    apple_cgl.choose_pixel_format = choose_pixel_format;
+
+    /* CGL renders 16 bits offscreen as x1-5-5-5, without alpha. */
+    check_offscreen(16, 16, 0);
+    check_offscreen(32, 32, 8);
+
+    /* The pixmap memory is textured from in the layout CGL renders. */
+    check_texture(2, GLX_TEXTURE_FORMAT_RGB_EXT, GL_RGB, GL_BGRA,
+		  GL_UNSIGNED_SHORT_1_5_5_5_REV);
+    check_texture(4, GLX_TEXTURE_FORMAT_RGB_EXT, GL_RGB, GL_BGRA,
+		  GL_UNSIGNED_INT_8_8_8_8_REV);
+    check_texture(4, GLX_TEXTURE_FORMAT_RGBA_EXT, GL_RGBA, GL_BGRA,
+		  GL_UNSIGNED_INT_8_8_8_8_REV);
+
+    if(failures) {
+	fprintf(stderr, "%d failures\n", failures);
+	return EXIT_FAILURE;
+    }
+
+    printf("success\n");
+
+    return EXIT_SUCCESS;
+}
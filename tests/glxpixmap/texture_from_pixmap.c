@@ -0,0 +1,191 @@
+/*
+ * This textures from a pixmap that X renders into with
+ * GLX_EXT_texture_from_pixmap, checks the result, and measures the
+ * average cost of a bind and release.
+ */
+#define GLX_GLXEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <GL/glx.h>
+#include <GL/glxext.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#define WIDTH 256
+#define HEIGHT 256
+#define FRAMES 500
+
+static double now(void) {
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+
+    return tv.tv_sec * 1000000.0 + tv.tv_usec;
+}
+
+static void draw(int y_inverted) {
+    float top = y_inverted ? 0.0f : 1.0f;
+    float bottom = 1.0f - top;
+
+    glClear(GL_COLOR_BUFFER_BIT);
+    glBegin(GL_QUADS);
+    glTexCoord2f(0.0f, bottom);
+    glVertex2f(-1.0f, -1.0f);
+    glTexCoord2f(1.0f, bottom);
+    glVertex2f( 1.0f, -1.0f);
+    glTexCoord2f(1.0f, top);
+    glVertex2f( 1.0f,  1.0f);
+    glTexCoord2f(0.0f, top);
+    glVertex2f(-1.0f,  1.0f);
+    glEnd();
+}
+
+int main() {
+    Display *dpy;
+    int fbattrib[] = { GLX_DRAWABLE_TYPE, GLX_PIXMAP_BIT | GLX_WINDOW_BIT,
+		       GLX_RENDER_TYPE, GLX_RGBA_BIT,
+		       GLX_BIND_TO_TEXTURE_RGB_EXT, True,
+		       GLX_DOUBLEBUFFER, True,
+		       GLX_RED_SIZE, 8,
+		       GLX_GREEN_SIZE, 8,
+		       GLX_BLUE_SIZE, 8,
+		       None };
+    int pixattrib[] = { GLX_TEXTURE_TARGET_EXT, GLX_TEXTURE_2D_EXT,
+			GLX_TEXTURE_FORMAT_EXT, GLX_TEXTURE_FORMAT_RGB_EXT,
+			None };
+    int screen, nconfigs, targets, y_inverted;
+    Window root, win;
+    XVisualInfo *visinfo;
+    XSetWindowAttributes attr;
+    GLXContext ctx;
+    GLXFBConfig *configs;
+    Pixmap pixmap;
+    GLXPixmap glxpixmap;
+    GLuint texture;
+    GLubyte pixel[4];
+    GC gc;
+    double bind = 0.0, release = 0.0, start;
+    int i, status = EXIT_SUCCESS;
+
+    dpy = XOpenDisplay(NULL);
+
+    if(NULL == dpy) {
+        fprintf(stderr, "error: unable to open display!\n");
+        return EXIT_FAILURE;
+    }
+
+    screen = DefaultScreen(dpy);
+    root = RootWindow(dpy, screen);
+
+    configs = glXChooseFBConfig(dpy, screen, fbattrib, &nconfigs);
+
+    if(NULL == configs || nconfigs < 1) {
+	fprintf(stderr, "error: no config can bind to a texture!\n");
+	return EXIT_FAILURE;
+    }
+
+    glXGetFBConfigAttrib(dpy, configs[0], GLX_BIND_TO_TEXTURE_TARGETS_EXT,
+			 &targets);
+    glXGetFBConfigAttrib(dpy, configs[0], GLX_Y_INVERTED_EXT, &y_inverted);
+
+    printf("targets 0x%x y inverted %d\n", targets, y_inverted);
+
+    if(!(targets & GLX_TEXTURE_2D_BIT_EXT)) {
+	fprintf(stderr, "error: GLX_TEXTURE_2D_BIT_EXT isn't supported!\n");
+	return EXIT_FAILURE;
+    }
+
+    visinfo = glXGetVisualFromFBConfig(dpy, configs[0]);
+
+    attr.background_pixel = 0;
+    attr.border_pixel = 0;
+    attr.colormap = XCreateColormap(dpy, root, visinfo->visual, AllocNone);
+    attr.event_mask = StructureNotifyMask | ExposureMask;
+
+    win = XCreateWindow(dpy, root, 0, 0, WIDTH, HEIGHT,
+			0, visinfo->depth, InputOutput,
+			visinfo->visual,
+			CWBackPixel | CWBorderPixel | CWColormap | CWEventMask,
+			&attr);
+    XMapWindow(dpy, win);
+
+    pixmap = XCreatePixmap(dpy, win, WIDTH, HEIGHT, visinfo->depth);
+    glxpixmap = glXCreatePixmap(dpy, configs[0], pixmap, pixattrib);
+
+    if(None == glxpixmap) {
+	fprintf(stderr, "error: glXCreatePixmap failed!\n");
+	return EXIT_FAILURE;
+    }
+
+    /* The top half is red, and the bottom half is green. */
+    gc = XCreateGC(dpy, pixmap, 0, NULL);
+    XSetForeground(dpy, gc, 0xff0000);
+    XFillRectangle(dpy, pixmap, gc, 0, 0, WIDTH, HEIGHT / 2);
+    XSetForeground(dpy, gc, 0x00ff00);
+    XFillRectangle(dpy, pixmap, gc, 0, HEIGHT / 2, WIDTH, HEIGHT / 2);
+
+    ctx = glXCreateNewContext(dpy, configs[0], GLX_RGBA_TYPE, NULL, True);
+
+    if(!ctx || !glXMakeCurrent(dpy, win, ctx)) {
+	fprintf(stderr, "error: unable to make a context current!\n");
+	return EXIT_FAILURE;
+    }
+
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glEnable(GL_TEXTURE_2D);
+
+    glXBindTexImageEXT(dpy, glxpixmap, GLX_FRONT_LEFT_EXT, NULL);
+    draw(y_inverted);
+    glXReleaseTexImageEXT(dpy, glxpixmap, GLX_FRONT_LEFT_EXT);
+
+    glReadPixels(WIDTH / 2, HEIGHT - 4, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+
+    if(pixel[0] < 0xf0 || pixel[1] > 0x10) {
+	fprintf(stderr, "error: the top isn't red: %02x %02x %02x\n",
+		pixel[0], pixel[1], pixel[2]);
+	status = EXIT_FAILURE;
+    }
+
+    glReadPixels(WIDTH / 2, 4, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+
+    if(pixel[1] < 0xf0 || pixel[0] > 0x10) {
+	fprintf(stderr, "error: the bottom isn't green: %02x %02x %02x\n",
+		pixel[0], pixel[1], pixel[2]);
+	status = EXIT_FAILURE;
+    }
+
+    for(i = 0; i < FRAMES; ++i) {
+	XSetForeground(dpy, gc, (i & 1) ? 0x0000ff : 0xff0000);
+	XFillRectangle(dpy, pixmap, gc, 0, 0, WIDTH, HEIGHT / 2);
+
+	start = now();
+	glXBindTexImageEXT(dpy, glxpixmap, GLX_FRONT_LEFT_EXT, NULL);
+	bind += now() - start;
+
+	draw(y_inverted);
+
+	start = now();
+	glXReleaseTexImageEXT(dpy, glxpixmap, GLX_FRONT_LEFT_EXT);
+	release += now() - start;
+
+	glXSwapBuffers(dpy, win);
+    }
+
+    printf("glXBindTexImageEXT %8.2f us  glXReleaseTexImageEXT %8.2f us "
+	   "(average of %d)\n", bind / FRAMES, release / FRAMES, FRAMES);
+
+    glDeleteTextures(1, &texture);
+    glXMakeCurrent(dpy, None, NULL);
+    glXDestroyPixmap(dpy, glxpixmap);
+    XFreeGC(dpy, gc);
+    XFreePixmap(dpy, pixmap);
+    glXDestroyContext(dpy, ctx);
+    XFree(configs);
+    XCloseDisplay(dpy);
+
+    return status;
+}
@@ -0,0 +1,245 @@
+/*
+ * This checks what glXWaitGL and glXWaitX wait for, as done by
+ * apple_glx_waitgl and apple_glx_waitx, with the GL and the AppleDRI
+ * extension stubbed.  Only a GLXPixmap, or a context with the
+ * multithreaded engine, needs a fence; the other drawables are flushed.
+ * apple_glx.c is included, so that its state can be checked.
+ */
+#include "apple_glx.c"
+
+static int failures = 0;
+
+#define CHECK(cond) do {						\
+	if(!(cond)) {							\
+	    fprintf(stderr, "%s:%d: FAILED: %s\n", __FILE__, __LINE__,	\
+		    #cond);						\
+	    ++failures;							\
+	}								\
+    } while(0)
+
+struct apple_xgl_api __gl_api;
+struct apple_cgl_api apple_cgl;
+
+static int flush_calls, finish_calls, gen_fences_calls, sync_calls;
+static GLuint fence_set, fence_finished;
+
+/* These replace the parts of libGL and libX11 that apple_glx.c uses. */
+void *XAppleDRIGetDisplayData(Display *dpy) {
+    return NULL;
+}
+
+Bool XAppleDRIQueryExtension(Display *dpy, int *event_base,
+			     int *error_base) {
+    return False;
+}
+
+Bool XAppleDRIQueryVersion(Display *dpy, int *majorVersion,
+			   int *minorVersion, int *patchVersion) {
+    return False;
+}
+
+void XAppleDRISetDisplayData(Display *dpy, void *data) {
+}
+
+void *XAppleDRISetSurfaceNotifyHandler(void (*fun)(Display *dpy,
+						   void *data,
+						   unsigned uid, int kind)) {
+    return NULL;
+}
+
+int XSync(Display *dpy, Bool discard) {
+    ++sync_calls;
+
+    return 0;
+}
+
+void apple_cgl_init(void) {
+}
+
+void apple_xgl_init_direct(void) {
+}
+
+int apple_glx_context_all_surfaces_changed(Display *dpy) {
+    return 0;
+}
+
+void apple_glx_context_apply_surface_changes(void *ptr) {
+}
+
+void apple_glx_context_destroy_all(Display *dpy) {
+}
+
+int apple_glx_context_surface_changed(Display *dpy, unsigned int uid) {
+    return 0;
+}
+
+void apple_glx_display_destroy(Display *dpy) {
+}
+
+struct apple_glx_display *apple_glx_display_get(Display *dpy,
+						int dri_event_base) {
+    return NULL;
+}
+
+void apple_glx_job_start(struct apple_glx_job *job,
+			 void (*run)(void *arg), void *arg) {
+}
+
+void apple_glx_worker_wait(struct apple_glx_job *job) {
+}
+
+void apple_glx_surface_destroy(Display *dpy, unsigned int uid) {
+}
+
+void apple_glx_surface_invalidate_all_geometry(Display *dpy) {
+}
+
+void apple_glx_surface_invalidate_geometry(Display *dpy, unsigned int uid) {
+}
+
+bool apple_glx_surface_swap_shared(struct apple_glx_context *ac,
+				   struct apple_glx_drawable *d,
+				   const xcb_rectangle_t *damage) {
+    return false;
+}
+
+void apple_glx_sync_swap_begin(struct apple_glx_drawable *d) {
+}
+
+void apple_glx_sync_swap_complete(struct apple_glx_drawable *d) {
+}
+
+xp_error xp_init(unsigned int options) {
+    return 0;
+}
+
+xp_error xp_get_client_id(xp_client_id *id) {
+    return 0;
+}
+
+GLAPI void APIENTRY glFlush(void) {
+    ++flush_calls;
+}
+
+GLAPI void APIENTRY glFinish(void) {
+    ++finish_calls;
+}
+
+static void gen_fences(GLsizei n, GLuint *fences) {
+    ++gen_fences_calls;
+    *fences = gen_fences_calls;
+}
+
+static void set_fence(GLuint fence) {
+    fence_set = fence;
+}
+
+static void finish_fence(GLuint fence) {
+    fence_finished = fence;
+}
+
+static void reset(void) {
+    flush_calls = finish_calls = sync_calls = 0;
+    fence_set = fence_finished = 0;
+}
+
+int main() {
+    struct apple_glx_context ac;
+    struct apple_glx_drawable surface, pixmap, pbuffer;
+
+    __gl_api.GenFencesAPPLE = gen_fences;
+    __gl_api.SetFenceAPPLE = set_fence;
+    __gl_api.FinishFenceAPPLE = finish_fence;
+
+    memset(&ac, 0, sizeof(ac));
+    memset(&surface, 0, sizeof(surface));
+    memset(&pixmap, 0, sizeof(pixmap));
+    memset(&pbuffer, 0, sizeof(pbuffer));
+    surface.type = APPLE_GLX_DRAWABLE_SURFACE;
+    pixmap.type = APPLE_GLX_DRAWABLE_PIXMAP;
+    pbuffer.type = APPLE_GLX_DRAWABLE_PBUFFER;
+
+    /* A surface is composited after a flush, so it isn't waited for. */
+    ac.drawable = &surface;
+    reset();
+    apple_glx_waitgl(NULL, &ac);
+    CHECK(1 == flush_calls);
+    CHECK(0 == finish_calls);
+    CHECK(0 == gen_fences_calls);
+    CHECK(0 == fence_finished);
+
+    ac.drawable = &pbuffer;
+    reset();
+    apple_glx_waitgl(NULL, &ac);
+    CHECK(1 == flush_calls);
+    CHECK(0 == fence_finished);
+
+    /* X reads the memory of a pixmap, so its own context is fenced. */
+    ac.drawable = &pixmap;
+    reset();
+    apple_glx_waitgl(NULL, &ac);
+    CHECK(1 == gen_fences_calls);
+    CHECK(pixmap.types.pixmap.has_fence);
+    CHECK(pixmap.types.pixmap.fence == fence_set);
+    CHECK(pixmap.types.pixmap.fence == fence_finished);
+    CHECK(!ac.has_fence);
+    CHECK(0 == finish_calls);
+
+    /* The fence is generated once, and reused. */
+    reset();
+    apple_glx_waitgl(NULL, &ac);
+    CHECK(1 == gen_fences_calls);
+    CHECK(pixmap.types.pixmap.fence == fence_finished);
+
+    /* The commands queued for the multithreaded engine are fenced. */
+    ac.drawable = &surface;
+    ac.mp_engine = true;
+    reset();
+    apple_glx_waitgl(NULL, &ac);
+    CHECK(2 == gen_fences_calls);
+    CHECK(ac.has_fence);
+    CHECK(ac.fence == fence_finished);
+    CHECK(ac.fence != pixmap.types.pixmap.fence);
+    CHECK(0 == finish_calls);
+
+    /* Without GL_APPLE_fence, glFinish is used. */
+    __gl_api.SetFenceAPPLE = NULL;
+    __gl_api.FinishFenceAPPLE = NULL;
+    reset();
+    apple_glx_waitgl(NULL, &ac);
+    CHECK(1 == finish_calls);
+    CHECK(0 == fence_finished);
+
+    ac.drawable = &pixmap;
+    ac.mp_engine = false;
+    reset();
+    apple_glx_waitgl(NULL, &ac);
+    CHECK(1 == finish_calls);
+
+    /* glXWaitX has nothing to wait for without a drawable X renders to. */
+    ac.drawable = NULL;
+    reset();
+    apple_glx_waitx(NULL, &ac);
+    CHECK(1 == flush_calls);
+    CHECK(0 == sync_calls);
+
+    ac.drawable = &pbuffer;
+    reset();
+    apple_glx_waitx(NULL, &ac);
+    CHECK(0 == sync_calls);
+
+    ac.drawable = &pixmap;
+    reset();
+    apple_glx_waitx(NULL, &ac);
+    CHECK(1 == flush_calls);
+    CHECK(1 == sync_calls);
+
+    if(failures) {
+	fprintf(stderr, "%d failures\n", failures);
+	return EXIT_FAILURE;
+    }
+
+    printf("success\n");
+
+    return EXIT_SUCCESS;
+}
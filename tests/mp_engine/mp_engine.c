@@ -0,0 +1,147 @@
+/*
+ * This checks that LIBGL_MP_ENGINE enables the multithreaded CGL engine
+ * of a context, and that glXWaitGL, glXWaitX, and glReadPixels see the
+ * rendering done through the engine.  Run it with and without
+ * LIBGL_MP_ENGINE set.
+ */
+#include <GL/gl.h>
+#include <GL/glx.h>
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SIZE 64
+#define FRAMES 100
+
+/* kCGLCEMPEngine, which isn't in the X11 headers. */
+#define MP_ENGINE 313
+
+typedef void *(*get_current_context_func)(void);
+typedef int (*is_enabled_func)(void *ctx, int pname, GLint *enable);
+
+static int failures = 0;
+
+static int mp_engine_enabled(void) {
+    get_current_context_func get_current_context;
+    is_enabled_func is_enabled;
+    GLint enabled = 0;
+
+    /* libGL loaded the OpenGL framework. */
+    get_current_context = (get_current_context_func)
+	dlsym(RTLD_DEFAULT, "CGLGetCurrentContext");
+    is_enabled = (is_enabled_func)dlsym(RTLD_DEFAULT, "CGLIsEnabled");
+
+    if(NULL == get_current_context || NULL == is_enabled) {
+	fprintf(stderr, "error: the CGL functions weren't found!\n");
+	exit(EXIT_FAILURE);
+    }
+
+    if(is_enabled(get_current_context(), MP_ENGINE, &enabled))
+	return 0;
+
+    return enabled;
+}
+
+static void check_color(const char *what, GLfloat r, GLfloat g, GLfloat b) {
+    GLubyte pixel[4];
+    GLubyte expected[3] = { r * 255, g * 255, b * 255 };
+
+    glReadPixels(SIZE / 2, SIZE / 2, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+
+    if(pixel[0] != expected[0] || pixel[1] != expected[1]
+       || pixel[2] != expected[2]) {
+	printf("%s: FAILED, read %d %d %d, expected %d %d %d\n", what,
+	       pixel[0], pixel[1], pixel[2],
+	       expected[0], expected[1], expected[2]);
+	++failures;
+    }
+}
+
+int main() {
+    Display *dpy;
+    int attrib[] = { GLX_DRAWABLE_TYPE, GLX_PBUFFER_BIT,
+		     GLX_RENDER_TYPE, GLX_RGBA_BIT,
+		     GLX_RED_SIZE, 8,
+		     GLX_GREEN_SIZE, 8,
+		     GLX_BLUE_SIZE, 8,
+		     None };
+    int pbattrib[] = { GLX_PBUFFER_WIDTH, SIZE,
+		       GLX_PBUFFER_HEIGHT, SIZE,
+		       None };
+    GLXFBConfig *configs;
+    GLXPbuffer pbuffer;
+    GLXContext ctx;
+    int nconfigs, requested, enabled, i;
+
+    dpy = XOpenDisplay(NULL);
+
+    if(NULL == dpy) {
+        fprintf(stderr, "error: unable to open display!\n");
+        return EXIT_FAILURE;
+    }
+
+    configs = glXChooseFBConfig(dpy, DefaultScreen(dpy), attrib, &nconfigs);
+
+    if(NULL == configs || nconfigs < 1) {
+	fprintf(stderr, "error: no pbuffer config!\n");
+	return EXIT_FAILURE;
+    }
+
+    pbuffer = glXCreatePbuffer(dpy, configs[0], pbattrib);
+    ctx = glXCreateNewContext(dpy, configs[0], GLX_RGBA_TYPE, NULL, True);
+
+    if(!pbuffer || !ctx) {
+	fprintf(stderr, "error: unable to create the pbuffer or context!\n");
+	return EXIT_FAILURE;
+    }
+
+    if(!glXMakeContextCurrent(dpy, pbuffer, pbuffer, ctx)) {
+	fprintf(stderr, "error: glXMakeContextCurrent failed!\n");
+	return EXIT_FAILURE;
+    }
+
+    requested = (getenv("LIBGL_MP_ENGINE") != NULL);
+    enabled = mp_engine_enabled();
+
+    printf("LIBGL_MP_ENGINE %s, the multithreaded engine is %s\n",
+	   requested ? "set" : "unset", enabled ? "enabled" : "not enabled");
+
+    if(enabled && !requested) {
+	printf("FAILED: the engine was enabled without LIBGL_MP_ENGINE\n");
+	++failures;
+    }
+
+    if(requested && !enabled)
+	printf("note: the renderer may not have the engine\n");
+
+    glViewport(0, 0, SIZE, SIZE);
+
+    /* Each frame is read back right after it was queued for the engine. */
+    for(i = 0; i < FRAMES; ++i) {
+	GLfloat r = (i & 1) ? 1.0f : 0.0f, g = (i & 2) ? 1.0f : 0.0f;
+
+	glClearColor(r, g, 1.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	check_color("glReadPixels", r, g, 1.0f);
+    }
+
+    glClearColor(1.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glXWaitGL();
+    check_color("glXWaitGL", 1.0f, 0.0f, 0.0f);
+
+    glXWaitX();
+    glClearColor(0.0f, 1.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    check_color("glXWaitX", 0.0f, 1.0f, 0.0f);
+
+    glXMakeContextCurrent(dpy, None, None, NULL);
+    glXDestroyContext(dpy, ctx);
+    glXDestroyPbuffer(dpy, pbuffer);
+    XFree(configs);
+    XCloseDisplay(dpy);
+
+    printf("%s\n", failures ? "FAILED" : "passed");
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
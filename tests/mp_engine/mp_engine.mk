@@ -0,0 +1,2 @@
+$(TEST_BUILD_DIR)/mp_engine: tests/mp_engine/mp_engine.c $(LIBGL)
+	$(CC) tests/mp_engine/mp_engine.c $(INCLUDE) -o $(TEST_BUILD_DIR)/mp_engine $(LINK_TEST)
@@ -0,0 +1,197 @@
+/* 
+ * This tests the timing of GLX_OML_sync_control.
+ * It checks that the SBC counts swaps, and that glXWaitForMscOML and
+ * glXSwapBuffersMscOML wait for the expected time based on the MSC rate.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <X11/Xlib.h>
+#define GLX_GLXEXT_PROTOTYPES
+#include <GL/glx.h>
+#include <GL/glxext.h>
+
+#define NUM_FRAMES 30
+#define DIVISOR 4
+
+/* This permits 2 ms of scheduling jitter. */
+#define TOLERANCE_US 2000
+
+static int failures = 0;
+
+static void check(int cond, const char *msg) {
+    if(!cond) {
+	fprintf(stderr, "FAIL: %s\n", msg);
+	++failures;
+    }
+}
+
+void draw(Display *dpy, Window w) {
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glLoadIdentity();   
+    glColor3f(0.5f, 0.5f, 1.0f);
+    glBegin(GL_TRIANGLES);
+    glVertex3f( 0.0f, 1.0f, 0.0f);
+    glVertex3f(-1.0f,-1.0f, 0.0f);
+    glVertex3f( 1.0f,-1.0f, 0.0f);
+    glEnd();    
+}
+
+int main() {
+    Display *dpy;
+    int attrib[] = { GLX_RGBA,
+		     GLX_RED_SIZE, 8,
+		     GLX_GREEN_SIZE, 8,
+		     GLX_BLUE_SIZE, 8,
+		     GLX_DEPTH_SIZE, 24,
+		     GLX_DOUBLEBUFFER,
+		     None };
+    int eventbase, errorbase;
+    int screen;
+    Window root, win;
+    XVisualInfo *visinfo;
+    XSetWindowAttributes attr;
+    GLXContext ctx;
+    int32_t numerator, denominator;
+    int64_t ust, msc, sbc, start_ust, start_msc, start_sbc, target;
+    double frame_us;
+    int i;
+
+    dpy = XOpenDisplay(NULL);
+    
+    if(NULL == dpy) {
+        fprintf(stderr, "error: unable to open display!\n");
+        return EXIT_FAILURE;
+    }
+    
+    if(!glXQueryExtension(dpy, &eventbase, &errorbase)) {
+        fprintf(stderr, "GLX is not available!\n");
+        return EXIT_FAILURE;
+    }
+    
+    screen = DefaultScreen(dpy);
+    root = RootWindow(dpy, screen);
+
+    if(!strstr(glXQueryExtensionsString(dpy, screen), "GLX_OML_sync_control")) {
+	fprintf(stderr, "GLX_OML_sync_control is not supported!\n");
+	return EXIT_FAILURE;
+    }
+
+    visinfo = glXChooseVisual(dpy, screen, attrib);
+
+    if(!visinfo) {
+	fprintf(stderr, "error: couldn't get an RGBA, double-buffered visual!\n");
+	return EXIT_FAILURE;
+    }
+
+    attr.background_pixel = 0;
+    attr.border_pixel = 0;
+    attr.colormap = XCreateColormap(dpy, root, visinfo->visual, AllocNone);
+    attr.event_mask = StructureNotifyMask | ExposureMask;
+
+    win = XCreateWindow(dpy, root, /*x*/ 0, /*y*/ 0, 
+			/*width*/ 400, /*height*/ 400,
+			0, visinfo->depth, InputOutput,
+			visinfo->visual, 
+			CWBackPixel | CWBorderPixel | CWColormap | CWEventMask,
+			&attr);
+   
+    ctx = glXCreateContext(dpy, visinfo, NULL, True);
+    if(!ctx) {
+	fprintf(stderr, "error: glXCreateContext failed!\n");
+	return EXIT_FAILURE;
+    }
+    
+    XMapWindow(dpy, win);
+    XSync(dpy, False);
+
+    glXMakeCurrent(dpy, win, ctx);
+
+    if(!glXGetMscRateOML(dpy, win, &numerator, &denominator)
+       || numerator <= 0 || denominator <= 0) {
+	fprintf(stderr, "error: glXGetMscRateOML failed!\n");
+	return EXIT_FAILURE;
+    }
+
+    frame_us = 1000000.0 * denominator / numerator;
+    printf("MSC rate %d/%d (%f us per frame)\n", numerator, denominator,
+	   frame_us);
+
+    if(!glXGetSyncValuesOML(dpy, win, &start_ust, &start_msc, &start_sbc)) {
+	fprintf(stderr, "error: glXGetSyncValuesOML failed!\n");
+	return EXIT_FAILURE;
+    }
+
+    /* The SBC should count each swap. */
+    for(i = 0; i < NUM_FRAMES; ++i) {
+	draw(dpy, win);
+	glXSwapBuffers(dpy, win);
+    }
+
+    glXGetSyncValuesOML(dpy, win, &ust, &msc, &sbc);
+    check(sbc == start_sbc + NUM_FRAMES, "SBC didn't count glXSwapBuffers");
+    check(ust >= start_ust, "UST went backwards");
+    check(msc >= start_msc, "MSC went backwards");
+
+    /* Waiting for NUM_FRAMES MSC should take about NUM_FRAMES frames. */
+    glXGetSyncValuesOML(dpy, win, &start_ust, &start_msc, &start_sbc);
+    target = start_msc + NUM_FRAMES;
+
+    if(!glXWaitForMscOML(dpy, win, target, 0, 0, &ust, &msc, &sbc)) {
+	check(0, "glXWaitForMscOML failed");
+    } else {
+	printf("waited %lld us for %d frames\n", 
+	       (long long)(ust - start_ust), NUM_FRAMES);
+	check(msc >= target, "glXWaitForMscOML returned before target MSC");
+	check(ust - start_ust <= (int64_t)(NUM_FRAMES * frame_us) + TOLERANCE_US,
+	      "glXWaitForMscOML waited too long");
+	check(ust - start_ust >= (int64_t)((NUM_FRAMES - 1) * frame_us),
+	      "glXWaitForMscOML didn't wait long enough");
+    }
+
+    /* A past target with a divisor should wait for the remainder. */
+    if(!glXWaitForMscOML(dpy, win, 0, DIVISOR, 1, &ust, &msc, &sbc)) {
+	check(0, "glXWaitForMscOML with a divisor failed");
+    } else {
+	check(msc % DIVISOR == 1, "glXWaitForMscOML ignored the remainder");
+    }
+
+    /* Invalid arguments should fail. */
+    check(!glXWaitForMscOML(dpy, win, 0, DIVISOR, DIVISOR, &ust, &msc, &sbc),
+	  "glXWaitForMscOML accepted remainder >= divisor");
+    check(glXSwapBuffersMscOML(dpy, win, -1, 0, 0) == -1,
+	  "glXSwapBuffersMscOML accepted a negative target");
+
+    /* Each swap should occur at the next MSC. */
+    glXGetSyncValuesOML(dpy, win, &start_ust, &start_msc, &start_sbc);
+
+    for(i = 1; i <= NUM_FRAMES; ++i) {
+	draw(dpy, win);
+	sbc = glXSwapBuffersMscOML(dpy, win, start_msc + i, 0, 0);
+	check(sbc == start_sbc + i, "glXSwapBuffersMscOML returned a bad SBC");
+    }
+
+    if(!glXWaitForSbcOML(dpy, win, start_sbc + NUM_FRAMES, &ust, &msc, &sbc)) {
+	check(0, "glXWaitForSbcOML failed");
+    } else {
+	printf("swapped %d frames in %lld us\n", NUM_FRAMES,
+	       (long long)(ust - start_ust));
+	check(msc >= start_msc + NUM_FRAMES, "swaps occurred before target MSC");
+	check(ust - start_ust >= (int64_t)((NUM_FRAMES - 1) * frame_us),
+	      "swaps didn't wait for the target MSC");
+    }
+
+    glXMakeCurrent(dpy, None, NULL);
+    glXDestroyContext(dpy, ctx);
+    XDestroyWindow(dpy, win);
+    XCloseDisplay(dpy);
+
+    if(failures) {
+	fprintf(stderr, "%d failures\n", failures);
+	return EXIT_FAILURE;
+    }
+
+    printf("PASSED\n");
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,5 @@
+$(TEST_BUILD_DIR)/oml_sync: tests/oml_sync/oml_sync.c $(LIBGL)
+	$(CC) tests/oml_sync/oml_sync.c $(INCLUDE) -o $(TEST_BUILD_DIR)/oml_sync $(LINK_TEST)
+
+$(TEST_BUILD_DIR)/sbc_wait: tests/oml_sync/sbc_wait.c apple_glx_sync.c apple_glx_sync.h apple_glx_drawable.h
+	$(CC) -DPTHREADS -DGLX_USE_APPLEGL tests/oml_sync/sbc_wait.c apple_glx_sync.c $(INCLUDE) -o $(TEST_BUILD_DIR)/sbc_wait -lpthread
@@ -0,0 +1,139 @@
+/*
+ * This checks glXWaitForSbcOML, as done by apple_glx_wait_for_sbc, with
+ * the drawable lookup stubbed.  The swaps are synchronous, so a wait must
+ * only block while a swap is pending in another thread.  It also checks
+ * the MSC counted from LIBGL_MSC_RATE, and the divisor and remainder of
+ * glXWaitForMscOML.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include "glxclient.h"
+#include "apple_glx.h"
+#include "apple_glx_drawable.h"
+#include "apple_glx_sync.h"
+
+static int failures = 0;
+
+#define CHECK(cond) do {						\
+	if(!(cond)) {							\
+	    fprintf(stderr, "%s:%d: FAILED: %s\n", __FILE__, __LINE__,	\
+		    #cond);						\
+	    ++failures;							\
+	}								\
+    } while(0)
+
+static struct apple_glx_drawable drawable;
+
+static void drawable_lock(struct apple_glx_drawable *d) {
+}
+
+static void drawable_unlock(struct apple_glx_drawable *d) {
+}
+
+static bool drawable_destroy(struct apple_glx_drawable *d) {
+    return false;
+}
+
+/* These replace the parts of libGL that apple_glx_sync.c uses. */
+struct apple_glx_drawable *apple_glx_drawable_find(Display *dpy,
+						   GLXDrawable d,
+						   int flags) {
+    return &drawable;
+}
+
+int __glXGetUST(int64_t *ust) {
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    *ust = (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+
+    return 0;
+}
+
+void apple_glx_diagnostic(const char *fmt, ...) {
+}
+
+void apple_glx_swap_begun(void *ptr) {
+}
+
+/* Complete a swap begun by the main thread, after a delay. */
+static void *swap_thread(void *arg) {
+    usleep(50000);
+    apple_glx_sync_swap_complete(&drawable);
+
+    return NULL;
+}
+
+int main() {
+    int64_t ust, msc, sbc, start_msc;
+    int32_t numerator, denominator;
+    pthread_t thread;
+
+    /* This rate keeps the MSC waits short, with room for jitter. */
+    setenv("LIBGL_MSC_RATE", "200/2", 1);
+
+    drawable.lock = drawable_lock;
+    drawable.unlock = drawable_unlock;
+    drawable.destroy = drawable_destroy;
+
+    /* Nothing is pending, so this must fail rather than block forever. */
+    CHECK(!apple_glx_wait_for_sbc(NULL, 1, 1, &ust, &msc, &sbc));
+
+    /* A target_sbc of 0 returns the current values. */
+    CHECK(apple_glx_wait_for_sbc(NULL, 1, 0, &ust, &msc, &sbc));
+    CHECK(0 == sbc);
+
+    /* This waits for a swap pending in another thread. */
+    apple_glx_sync_swap_begin(&drawable);
+    pthread_create(&thread, NULL, swap_thread, NULL);
+
+    CHECK(apple_glx_wait_for_sbc(NULL, 1, 1, &ust, &msc, &sbc));
+    CHECK(1 == sbc);
+    CHECK(0 == drawable.swaps_pending);
+
+    pthread_join(thread, NULL);
+
+    /* A swap that is already complete doesn't wait. */
+    CHECK(apple_glx_wait_for_sbc(NULL, 1, 1, &ust, &msc, &sbc));
+    CHECK(1 == sbc);
+
+    /* One pending swap can't reach an sbc two ahead. */
+    apple_glx_sync_swap_begin(&drawable);
+    CHECK(!apple_glx_wait_for_sbc(NULL, 1, 3, &ust, &msc, &sbc));
+    apple_glx_sync_swap_complete(&drawable);
+
+    CHECK(2 == drawable.sbc);
+
+    /* The SBC of the swaps is kept with the MSC they completed in. */
+    CHECK(apple_glx_wait_for_sbc(NULL, 1, 2, &ust, &msc, &sbc));
+    CHECK(drawable.swap_msc == msc);
+
+    CHECK(apple_glx_get_msc_rate(&numerator, &denominator));
+    CHECK(200 == numerator && 2 == denominator);
+
+    CHECK(apple_glx_get_sync_values(NULL, 1, &ust, &start_msc, &sbc));
+    CHECK(2 == sbc);
+
+    /* The MSC is 100 Hz, so 5 MSCs take 50 ms. */
+    CHECK(apple_glx_wait_for_msc(NULL, 1, start_msc + 5, 0, 0,
+				 &ust, &msc, &sbc));
+    CHECK(msc >= start_msc + 5);
+
+    /* A target in the past waits for the next msc % divisor == remainder. */
+    CHECK(apple_glx_wait_for_msc(NULL, 1, 0, 4, 3, &ust, &msc, &sbc));
+    CHECK(3 == msc % 4);
+
+    CHECK(!apple_glx_wait_for_msc(NULL, 1, 0, 4, 4, &ust, &msc, &sbc));
+
+    if(failures) {
+	fprintf(stderr, "%d failures\n", failures);
+	return EXIT_FAILURE;
+    }
+
+    printf("success\n");
+
+    return EXIT_SUCCESS;
+}
@@ -3,3 +3,6 @@ $(TEST_BUILD_DIR)/pbuffer: tests/pbuffer/pbuffer.c $(LIBGL)
 
 $(TEST_BUILD_DIR)/pbuffer_destroy: tests/pbuffer/pbuffer_destroy.c $(LIBGL)
 	$(CC) tests/pbuffer/pbuffer_destroy.c -Iinclude -o $(TEST_BUILD_DIR)/pbuffer_destroy $(LINK_TEST)
+
+$(TEST_BUILD_DIR)/pbuffer_clobber: tests/pbuffer/pbuffer_clobber.c $(LIBGL)
+	$(CC) tests/pbuffer/pbuffer_clobber.c -Iinclude -o $(TEST_BUILD_DIR)/pbuffer_clobber $(LINK_TEST)
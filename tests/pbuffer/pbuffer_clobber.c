@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <X11/Xlib.h>
+#include <GL/glx.h>
+
+/* 
+ * This creates more pbuffers that aren't preserved than fit the budget,
+ * and expects a clobber event for the least recently used.
+ */
+
+#define NUM_PBUFFERS 4
+
+/* The GLX event of GL/glxproto.h, which is added to the event base. */
+#define GLX_PbufferClobber 0
+
+GLXPbuffer pbufs[NUM_PBUFFERS];
+int event_base;
+
+void draw(Display *dpy, GLXPbuffer pbuf, GLXContext ctx) {
+    if(!glXMakeCurrent(dpy, pbuf, ctx)) {
+	fprintf(stderr, "glXMakeCurrent failed!\n");
+	exit(EXIT_FAILURE);
+    }
+
+    glClearColor(0.5f, 0.5f, 1.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glFinish();
+
+    if(GL_NO_ERROR != glGetError()) {
+	fprintf(stderr, "an unexpected error occurred!\n");
+	abort();
+    }
+}
+
+int count_clobbers(Display *dpy, GLXPbuffer pbuf) {
+    XEvent event;
+    GLXPbufferClobberEvent *clobber;
+    int count = 0;
+
+    XSync(dpy, False);
+
+    while(XPending(dpy)) {
+	XNextEvent(dpy, &event);
+
+	clobber = &((GLXEvent *)&event)->glxpbufferclobber;
+
+	if(event_base + GLX_PbufferClobber == event.type
+	   && pbuf == clobber->drawable) {
+	    printf("clobber event for pbuffer 0x%lx %dx%d\n", clobber->drawable,
+		   clobber->width, clobber->height);
+	    ++count;
+	}
+    }
+
+    return count;
+}
+
+int main() {
+    Display *dpy;
+    int attrib[] = { 
+	GLX_RED_SIZE, 8,
+	GLX_GREEN_SIZE, 8,
+	GLX_BLUE_SIZE, 8,
+	GLX_RENDER_TYPE, GLX_RGBA_BIT,
+	GLX_DRAWABLE_TYPE, GLX_PBUFFER_BIT,
+	None,
+    };
+    int pbattrib[] =  {
+	GLX_PBUFFER_WIDTH, 512,
+	GLX_PBUFFER_HEIGHT, 512,
+	GLX_PRESERVED_CONTENTS, False,
+	None
+    };
+    GLXContext ctx;
+    GLXFBConfig *fbconfig;
+    int i, numfbconfig, error_base;
+    unsigned int preserved = True;
+
+    /* Each pbuffer is 1 MB, so only 2 fit. */
+    setenv("LIBGL_PBUFFER_BUDGET", "2", 1);
+
+    dpy = XOpenDisplay(NULL);
+    
+    if(NULL == dpy) {
+        fprintf(stderr, "error: unable to open display!\n");
+        return EXIT_FAILURE;
+    }
+
+    if(!glXQueryExtension(dpy, &error_base, &event_base)) {
+	fprintf(stderr, "error: GLX isn't supported!\n");
+	return EXIT_FAILURE;
+    }
+
+    fbconfig = glXChooseFBConfig(dpy, DefaultScreen(dpy), attrib,
+				 &numfbconfig);
+
+    if(NULL == fbconfig) {
+	fprintf(stderr, "error: couldn't choose a GLXFBConfig!\n");
+	return EXIT_FAILURE;
+    }
+
+    ctx = glXCreateNewContext(dpy, fbconfig[0], GLX_RGBA_TYPE, NULL, True);
+
+    if(!ctx) {
+	fprintf(stderr, "error: glXCreateNewContext failed!\n");
+	return EXIT_FAILURE;
+    }
+
+    for(i = 0; i < NUM_PBUFFERS; ++i) {
+	pbufs[i] = glXCreatePbuffer(dpy, fbconfig[0], pbattrib);
+
+	if(None == pbufs[i]) {
+	    fprintf(stderr, "unable to create a GLXPbuffer!\n");
+	    return EXIT_FAILURE;
+	}
+
+	glXSelectEvent(dpy, pbufs[i], GLX_PBUFFER_CLOBBER_MASK);
+	draw(dpy, pbufs[i], ctx);
+    }
+
+    glXQueryDrawable(dpy, pbufs[0], GLX_PRESERVED_CONTENTS, &preserved);
+
+    if(preserved) {
+	fprintf(stderr, "error: GLX_PRESERVED_CONTENTS should be False!\n");
+	return EXIT_FAILURE;
+    }
+
+    if(0 == count_clobbers(dpy, pbufs[0])) {
+	fprintf(stderr, "error: expected a clobber event for pbuffer 0!\n");
+	return EXIT_FAILURE;
+    }
+
+    /* The storage of pbuffer 0 is reallocated. */
+    draw(dpy, pbufs[0], ctx);
+
+    glXMakeCurrent(dpy, None, NULL);
+
+    for(i = 0; i < NUM_PBUFFERS; ++i)
+	glXDestroyPbuffer(dpy, pbufs[i]);
+
+    glXDestroyContext(dpy, ctx);
+    XCloseDisplay(dpy);
+
+    puts("SUCCESS");
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,118 @@
+/*
+ * This lists the renderers with GLX_MESA_query_renderer, creates a
+ * context on each with GLX_RENDERER_ID_MESA, and checks that the
+ * current renderer is the one requested.
+ */
+#define GLX_GLXEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glx.h>
+#include <GL/glxext.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int error_handler(Display *dpy, XErrorEvent *ev) {
+    return 0;
+}
+
+int main() {
+    Display *dpy;
+    int fbattrib[] = { GLX_RENDER_TYPE, GLX_RGBA_BIT,
+		       GLX_RED_SIZE, 8,
+		       GLX_GREEN_SIZE, 8,
+		       GLX_BLUE_SIZE, 8,
+		       None };
+    int ctxattrib[] = { GLX_RENDERER_ID_MESA, 0, None };
+    GLXFBConfig *configs;
+    GLXContext ctx;
+    const char *extensions;
+    unsigned int value[3], accelerated, memory, vendor, current;
+    int screen, nconfigs, i, failures = 0;
+
+    dpy = XOpenDisplay(NULL);
+
+    if(NULL == dpy) {
+        fprintf(stderr, "error: unable to open display!\n");
+        return EXIT_FAILURE;
+    }
+
+    screen = DefaultScreen(dpy);
+    extensions = glXQueryExtensionsString(dpy, screen);
+
+    if(NULL == strstr(extensions, "GLX_MESA_query_renderer")) {
+	fprintf(stderr, "error: GLX_MESA_query_renderer isn't supported!\n");
+	return EXIT_FAILURE;
+    }
+
+    configs = glXChooseFBConfig(dpy, screen, fbattrib, &nconfigs);
+
+    if(NULL == configs || nconfigs < 1) {
+	fprintf(stderr, "error: no config!\n");
+	return EXIT_FAILURE;
+    }
+
+    for(i = 0; glXQueryRendererIntegerMESA(dpy, screen, i,
+					   GLX_RENDERER_VENDOR_ID_MESA,
+					   &vendor); ++i) {
+	glXQueryRendererIntegerMESA(dpy, screen, i,
+				    GLX_RENDERER_ACCELERATED_MESA,
+				    &accelerated);
+	glXQueryRendererIntegerMESA(dpy, screen, i,
+				    GLX_RENDERER_VIDEO_MEMORY_MESA, &memory);
+	glXQueryRendererIntegerMESA(dpy, screen, i,
+				    GLX_RENDERER_OPENGL_CORE_PROFILE_VERSION_MESA,
+				    value);
+
+	printf("renderer %d: %s %s vendor 0x%04x %s %u MB core %u.%u\n", i,
+	       glXQueryRendererStringMESA(dpy, screen, i,
+					  GLX_RENDERER_VENDOR_ID_MESA),
+	       glXQueryRendererStringMESA(dpy, screen, i,
+					  GLX_RENDERER_DEVICE_ID_MESA),
+	       vendor, accelerated ? "accelerated" : "software",
+	       memory, value[0], value[1]);
+
+	ctxattrib[1] = i;
+	ctx = glXCreateContextAttribsARB(dpy, configs[0], NULL, True,
+					 ctxattrib);
+
+	if(NULL == ctx) {
+	    printf("renderer %d: FAILED to create a context\n", i);
+	    ++failures;
+	    continue;
+	}
+
+	glXMakeContextCurrent(dpy, None, None, ctx);
+
+	printf("renderer %d: GL_RENDERER %s\n", i,
+	       (const char *)glGetString(GL_RENDERER));
+
+	if(!glXQueryCurrentRendererIntegerMESA(GLX_RENDERER_VENDOR_ID_MESA,
+					       &current) || current != vendor) {
+	    printf("renderer %d: FAILED, the current vendor is 0x%04x\n",
+		   i, current);
+	    ++failures;
+	}
+
+	glXMakeContextCurrent(dpy, None, None, NULL);
+	glXDestroyContext(dpy, ctx);
+    }
+
+    if(0 == i) {
+	fprintf(stderr, "error: no renderers!\n");
+	++failures;
+    }
+
+    /* A renderer past the end is an error. */
+    XSetErrorHandler(error_handler);
+    ctxattrib[1] = i;
+
+    if(glXCreateContextAttribsARB(dpy, configs[0], NULL, True, ctxattrib)) {
+	printf("renderer %d: FAILED, a context was created\n", i);
+	++failures;
+    }
+
+    XFree(configs);
+    XCloseDisplay(dpy);
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,5 @@
+$(TEST_BUILD_DIR)/query_renderer: tests/query_renderer/query_renderer.c $(LIBGL)
+	$(CC) tests/query_renderer/query_renderer.c $(INCLUDE) -o $(TEST_BUILD_DIR)/query_renderer $(LINK_TEST)
+
+$(TEST_BUILD_DIR)/renderer_order: tests/query_renderer/renderer_order.c apple_glx_renderer.c apple_glx_renderer.h apple_visual.c apple_visual.h
+	$(CC) -DPTHREADS -DGLX_USE_APPLEGL tests/query_renderer/renderer_order.c apple_visual.c $(INCLUDE) -o $(TEST_BUILD_DIR)/renderer_order -lpthread
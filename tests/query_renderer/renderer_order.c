@@ -0,0 +1,263 @@
+/*
+ * This checks the order of the renderers and the pixel format attributes
+ * of apple_visual_create_pfobj, with a table of simulated renderers in
+ * place of CGL.  apple_glx_renderer.c is included, so that its state can
+ * be reset for each setting of LIBGL_GPU_PREFERENCE and LIBGL_RENDERER_ID.
+ */
+#include "apple_glx_renderer.c"
+#include "apple_visual.h"
+#include "glcontextmodes.h"
+#include <OpenGL/CGLRenderers.h>
+
+static int failures = 0;
+
+#define CHECK(cond) do {						\
+	if(!(cond)) {							\
+	    fprintf(stderr, "%s:%d: FAILED: %s\n", __FILE__, __LINE__,	\
+		    #cond);						\
+	    ++failures;							\
+	}								\
+    } while(0)
+
+#define SOFTWARE_ID 0x00020400
+#define INTEL_ID 0x00024200
+#define AMD_ID 0x00021c00
+
+static const struct {
+    GLint id, accelerated, online, video_memory, major_gl_version;
+} simulated[] = {
+    /* CGL lists the software renderer first. */
+    { SOFTWARE_ID, 0, 1, 0, 4 },
+    { INTEL_ID, 1, 1, 512 << 20, 4 },
+    /* The discrete GPU is listed offline, then online for a 2nd display. */
+    { AMD_ID, 1, 0, 1024 << 20, 4 },
+    { AMD_ID, 1, 1, 1024 << 20, 4 }
+};
+
+#define SIMULATED_COUNT ((GLint)(sizeof(simulated) / sizeof(simulated[0])))
+
+struct apple_cgl_api apple_cgl;
+
+static CGLPixelFormatAttribute chosen[60];
+
+void apple_glx_wait_framework(void) {
+}
+
+void apple_glx_diagnostic(const char *fmt, ...) {
+}
+
+static CGLError query_renderer_info(GLuint display_mask,
+				    CGLRendererInfoObj *rend, GLint *nrend) {
+    *rend = (CGLRendererInfoObj) simulated;
+    *nrend = SIMULATED_COUNT;
+
+    return kCGLNoError;
+}
+
+static CGLError destroy_renderer_info(CGLRendererInfoObj rend) {
+    return kCGLNoError;
+}
+
+static CGLError describe_renderer(CGLRendererInfoObj rend, GLint i,
+				  CGLRendererProperty prop, GLint *value) {
+    if(i < 0 || i >= SIMULATED_COUNT)
+	return kCGLBadRendererInfo;
+
+    switch((int) prop) {
+    case kCGLRPRendererID:
+	*value = simulated[i].id;
+	break;
+    case kCGLRPAccelerated:
+	*value = simulated[i].accelerated;
+	break;
+    case kCGLRPOnline:
+	*value = simulated[i].online;
+	break;
+    case kCGLRPVideoMemory:
+	*value = simulated[i].video_memory;
+	break;
+    case APPLE_CGL_RP_MAJOR_GL_VERSION:
+	*value = simulated[i].major_gl_version;
+	break;
+    default:
+	return kCGLBadProperty;
+    }
+
+    return kCGLNoError;
+}
+
+/* This records the attributes, and returns a non-NULL pixel format. */
+static CGLError choose_pixel_format(const CGLPixelFormatAttribute *attribs,
+				    CGLPixelFormatObj *pix, GLint *npix) {
+    int i;
+
+    for(i = 0; attribs[i]; ++i)
+	chosen[i] = attribs[i];
+
+    chosen[i] = 0;
+    *pix = (CGLPixelFormatObj) chosen;
+    *npix = 1;
+
+    return kCGLNoError;
+}
+
+static const char *error_string(CGLError error) {
+    return "simulated error";
+}
+
+/* Return 1 if attr is one of the attributes chosen. */
+static int chose(CGLPixelFormatAttribute attr) {
+    int i;
+
+    for(i = 0; chosen[i]; ++i) {
+	if(attr == chosen[i])
+	    return 1;
+
+	/* Skip the value of the attributes that have one. */
+	if(kCGLPFARendererID == chosen[i] || kCGLPFAColorSize == chosen[i]
+	   || kCGLPFAAlphaSize == chosen[i])
+	    ++i;
+    }
+
+    return 0;
+}
+
+static GLint chosen_renderer_id(void) {
+    int i;
+
+    for(i = 0; chosen[i]; ++i)
+	if(kCGLPFARendererID == chosen[i])
+	    return chosen[i + 1];
+
+    return 0;
+}
+
+/* Reset the renderers, and list them again with the settings given. */
+static void reload(const char *gpu_preference, const char *renderer_id) {
+    static const pthread_once_t once_init = PTHREAD_ONCE_INIT;
+
+    if(gpu_preference)
+	setenv("LIBGL_GPU_PREFERENCE", gpu_preference, 1);
+    else
+	unsetenv("LIBGL_GPU_PREFERENCE");
+
+    if(renderer_id)
+	setenv("LIBGL_RENDERER_ID", renderer_id, 1);
+    else
+	unsetenv("LIBGL_RENDERER_ID");
+
+    renderers_once = once_init;
+    renderer_count = 0;
+    default_id = 0;
+    preference = 0;
+
+    (void) apple_glx_renderer_count();
+}
+
+static void create_pfobj(GLint renderer_id) {
+    __GLcontextModes mode;
+    CGLPixelFormatObj pfobj;
+    bool double_buffered, uses_stereo;
+
+    memset(&mode, 0, sizeof(mode));
+    mode.redBits = mode.greenBits = mode.blueBits = 8;
+    mode.doubleBufferMode = 1;
+
+    chosen[0] = 0;
+
+    CHECK(!apple_visual_create_pfobj(&pfobj, &mode, &double_buffered,
+				     &uses_stereo, 0, 0, renderer_id));
+}
+
+int main() {
+    apple_cgl.query_renderer_info = query_renderer_info;
+    apple_cgl.destroy_renderer_info = destroy_renderer_info;
+    apple_cgl.describe_renderer = describe_renderer;
+    apple_cgl.choose_pixel_format = choose_pixel_format;
+    apple_cgl.error_string = error_string;
+
+    unsetenv("LIBGL_ALWAYS_SOFTWARE");
+    unsetenv("LIBGL_ALLOW_SOFTWARE");
+
+    /*
+     * Without a preference the accelerated renderers keep the order of
+     * CGL, and CGL chooses the renderer.
+     */
+    reload(NULL, NULL);
+    CHECK(3 == renderer_count);
+    CHECK(INTEL_ID == renderers[0].id);
+    CHECK(AMD_ID == renderers[1].id);
+    CHECK(SOFTWARE_ID == renderers[2].id);
+    CHECK(renderers[1].online);
+    CHECK(1024 == renderers[1].video_memory);
+    CHECK(0 == apple_glx_renderer_default_id());
+
+    reload("high-performance", NULL);
+    CHECK(AMD_ID == renderers[0].id);
+    CHECK(INTEL_ID == renderers[1].id);
+    CHECK(SOFTWARE_ID == renderers[2].id);
+    CHECK(AMD_ID == apple_glx_renderer_default_id());
+
+    reload("low-power", NULL);
+    CHECK(INTEL_ID == renderers[0].id);
+    CHECK(AMD_ID == renderers[1].id);
+    CHECK(INTEL_ID == apple_glx_renderer_default_id());
+
+    /* A pinned renderer is moved to the front, even over a preference. */
+    reload("high-performance", "0x00024200");
+    CHECK(INTEL_ID == renderers[0].id);
+    CHECK(AMD_ID == renderers[1].id);
+    CHECK(INTEL_ID == apple_glx_renderer_default_id());
+
+    /* An unknown renderer ID is ignored. */
+    reload(NULL, "0x12345");
+    CHECK(INTEL_ID == renderers[0].id);
+    CHECK(0 == apple_glx_renderer_default_id());
+
+    /* The sort is stable for renderers that are equal. */
+    renderers[0].accelerated = renderers[1].accelerated = true;
+    renderers[0].online = renderers[1].online = true;
+    renderers[0].video_memory = renderers[1].video_memory = 256;
+    sort_renderers();
+    CHECK(INTEL_ID == renderers[0].id);
+    CHECK(AMD_ID == renderers[1].id);
+
+    /* Without a default renderer, only accelerated renderers are chosen. */
+    reload(NULL, NULL);
+    create_pfobj(0);
+    CHECK(chose(kCGLPFAAccelerated));
+    CHECK(0 == chosen_renderer_id());
+
+    /* The renderer ID only narrows the choice. */
+    reload("high-performance", NULL);
+    create_pfobj(0);
+    CHECK(AMD_ID == chosen_renderer_id());
+    CHECK(chose(kCGLPFAAccelerated));
+    CHECK(chose(kCGLPFAAllowOfflineRenderers));
+
+    create_pfobj(INTEL_ID);
+    CHECK(INTEL_ID == chosen_renderer_id());
+    CHECK(chose(kCGLPFAAccelerated));
+
+    /* The software renderer must be allowed explicitly. */
+    setenv("LIBGL_ALLOW_SOFTWARE", "1", 1);
+    create_pfobj(SOFTWARE_ID);
+    CHECK(SOFTWARE_ID == chosen_renderer_id());
+    CHECK(!chose(kCGLPFAAccelerated));
+    unsetenv("LIBGL_ALLOW_SOFTWARE");
+
+    setenv("LIBGL_ALWAYS_SOFTWARE", "1", 1);
+    create_pfobj(AMD_ID);
+    CHECK(kCGLRendererGenericFloatID == chosen_renderer_id());
+    CHECK(!chose(kCGLPFAAccelerated));
+    unsetenv("LIBGL_ALWAYS_SOFTWARE");
+
+    if(failures) {
+	fprintf(stderr, "%d failures\n", failures);
+	return EXIT_FAILURE;
+    }
+
+    printf("success\n");
+
+    return EXIT_SUCCESS;
+}
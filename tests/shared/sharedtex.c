@@ -34,6 +34,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <sys/time.h>
 #include <X11/keysym.h>
 
 
@@ -253,6 +254,93 @@ Redraw(void)
 }
 
 
+static double
+Now(void)
+{
+   struct timeval tv;
+
+   gettimeofday(&tv, NULL);
+
+   return tv.tv_sec * 1000000.0 + tv.tv_usec;
+}
+
+
+/**
+ * Time the creation of many contexts sharing with Contexts[0], the
+ * creation of shared objects in each, their destruction, and the
+ * teardown of the remaining contexts when the display is closed.
+ * Run with LIBGL_DIAGNOSTIC=1 to see the share group accounting.
+ */
+static void
+Benchmark(int count)
+{
+   GLXContext *ctx;
+   GLuint tex, list;
+   double start, create, objects, destroy, teardown;
+   int i;
+
+   ctx = malloc(count * sizeof *ctx);
+   if (!ctx) {
+      Error("out of memory");
+   }
+
+   start = Now();
+
+   for (i = 0; i < count; i++) {
+      ctx[i] = glXCreateContext(Dpy, VisInfo, Contexts[0], True);
+      if (!ctx[i]) {
+         Error("Unable to create shared GLX context");
+      }
+   }
+
+   create = Now();
+
+   for (i = 0; i < count; i++) {
+      if (!glXMakeCurrent(Dpy, Win, ctx[i])) {
+         Error("glXMakeCurrent failed");
+      }
+
+      glGenTextures(1, &tex);
+      glBindTexture(GL_TEXTURE_2D, tex);
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, TEX_SIZE, TEX_SIZE, 0,
+                   GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+      list = glGenLists(1);
+      glNewList(list, GL_COMPILE);
+      glBindTexture(GL_TEXTURE_2D, tex);
+      glEndList();
+   }
+
+   glFinish();
+   glXMakeCurrent(Dpy, None, NULL);
+
+   objects = Now();
+
+   /* Destroy half of the contexts, and leave the rest to XCloseDisplay. */
+   for (i = 0; i < count / 2; i++) {
+      glXDestroyContext(Dpy, ctx[i]);
+   }
+
+   destroy = Now();
+
+   XCloseDisplay(Dpy);
+
+   teardown = Now();
+
+   printf("%d shared contexts:\n", count);
+   printf("  create   %10.1f us/context\n", (create - start) / count);
+   printf("  objects  %10.1f us/context\n", (objects - create) / count);
+   if (count / 2) {
+      printf("  destroy  %10.1f us/context\n",
+             (destroy - objects) / (count / 2));
+   }
+   printf("  teardown %10.1f us (XCloseDisplay with %d contexts)\n",
+          teardown - destroy, count - count / 2 + MAX_CONTEXTS);
+
+   free(ctx);
+}
+
+
 static void
 EventLoop(void)
 {
@@ -305,17 +393,26 @@ EventLoop(void)
 int
 main(int argc, char *argv[])
 {
-   int i;
+   int i, bench = 0;
 
    for (i = 1; i < argc; i++) {
       if (strcmp(argv[i], "-display") == 0 && i < argc) {
          DisplayName = argv[i+1];
          i++;
       }
+      else if (strcmp(argv[i], "-bench") == 0 && i + 1 < argc) {
+         bench = atoi(argv[i+1]);
+         i++;
+      }
    }
 
    Setup();
 
+   if (bench > 0) {
+      Benchmark(bench);
+      return 0;
+   }
+
    printf("Press 't' to change texture image/colors\n");
 
    EventLoop();
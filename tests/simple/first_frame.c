@@ -0,0 +1,104 @@
+/*
+ * This times the first frame of a GLXWindow, from glXCreateWindow to the
+ * first glXSwapBuffers.  Compare the results with and without
+ * LIBGL_EAGER_SURFACES set.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <X11/Xlib.h>
+#include <GL/glx.h>
+
+static double now(void) {
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+
+    return tv.tv_sec * 1000000.0 + tv.tv_usec;
+}
+
+int main() {
+    Display *dpy;
+    int attrib[] = { GLX_DRAWABLE_TYPE, GLX_WINDOW_BIT,
+		     GLX_RENDER_TYPE, GLX_RGBA_BIT,
+		     GLX_RED_SIZE, 8,
+		     GLX_GREEN_SIZE, 8,
+		     GLX_BLUE_SIZE, 8,
+		     GLX_DOUBLEBUFFER, True,
+		     None };
+    int screen, nconfigs;
+    Window root, win;
+    XVisualInfo *visinfo;
+    XSetWindowAttributes attr;
+    GLXFBConfig *configs;
+    GLXWindow glxwin;
+    GLXContext ctx;
+    double start, created, current;
+
+    dpy = XOpenDisplay(NULL);
+    
+    if(NULL == dpy) {
+        fprintf(stderr, "error: unable to open display!\n");
+        return EXIT_FAILURE;
+    }
+
+    screen = DefaultScreen(dpy);
+    root = RootWindow(dpy, screen);
+
+    configs = glXChooseFBConfig(dpy, screen, attrib, &nconfigs);
+
+    if(NULL == configs || nconfigs < 1) {
+	fprintf(stderr, "error: no matching GLXFBConfig!\n");
+	return EXIT_FAILURE;
+    }
+
+    visinfo = glXGetVisualFromFBConfig(dpy, configs[0]);
+
+    attr.background_pixel = 0;
+    attr.border_pixel = 0;
+    attr.colormap = XCreateColormap(dpy, root, visinfo->visual, AllocNone);
+    attr.event_mask = StructureNotifyMask | ExposureMask;
+
+    win = XCreateWindow(dpy, root, 0, 0, 300, 300,
+			0, visinfo->depth, InputOutput,
+			visinfo->visual, 
+			CWBackPixel | CWBorderPixel | CWColormap | CWEventMask,
+			&attr);
+    XMapWindow(dpy, win);
+    XSync(dpy, False);
+
+    ctx = glXCreateNewContext(dpy, configs[0], GLX_RGBA_TYPE, NULL, True);
+
+    if(!ctx) {
+	fprintf(stderr, "error: glXCreateNewContext failed!\n");
+	return EXIT_FAILURE;
+    }
+
+    start = now();
+    glxwin = glXCreateWindow(dpy, configs[0], win, NULL);
+    created = now();
+
+    glXMakeContextCurrent(dpy, glxwin, glxwin, ctx);
+    current = now();
+
+    glClearColor(0.0f, 0.5f, 1.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glXSwapBuffers(dpy, glxwin);
+
+    printf("LIBGL_EAGER_SURFACES is %s\n", 
+	   getenv("LIBGL_EAGER_SURFACES") ? "set" : "not set");
+    printf("glXCreateWindow: %f us\n", created - start);
+    printf("glXMakeContextCurrent: %f us\n", current - created);
+    printf("first frame: %f us\n", now() - start);
+
+    glXMakeContextCurrent(dpy, None, None, NULL);
+    glXDestroyContext(dpy, ctx);
+    glXDestroyWindow(dpy, glxwin);
+    XDestroyWindow(dpy, win);
+    XFree(visinfo);
+    XFree(configs);
+    XCloseDisplay(dpy);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,122 @@
+/*
+ * This times glXMakeCurrent when alternating two contexts on one window,
+ * and one context across two windows.  Rebinding a context to the
+ * surface it's already attached to shouldn't reattach it.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <X11/Xlib.h>
+#include <GL/glx.h>
+
+#define SWITCHES 1000
+
+static double now(void) {
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+
+    return tv.tv_sec * 1000000.0 + tv.tv_usec;
+}
+
+static Window create_window(Display *dpy, XVisualInfo *visinfo, int x) {
+    XSetWindowAttributes attr;
+    Window root = RootWindow(dpy, DefaultScreen(dpy));
+    Window win;
+
+    attr.background_pixel = 0;
+    attr.border_pixel = 0;
+    attr.colormap = XCreateColormap(dpy, root, visinfo->visual, AllocNone);
+    attr.event_mask = StructureNotifyMask | ExposureMask;
+
+    win = XCreateWindow(dpy, root, x, 0, 200, 200,
+			0, visinfo->depth, InputOutput,
+			visinfo->visual, 
+			CWBackPixel | CWBorderPixel | CWColormap | CWEventMask,
+			&attr);
+    XMapWindow(dpy, win);
+
+    return win;
+}
+
+static void clear(float r) {
+    glClearColor(r, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+}
+
+int main() {
+    Display *dpy;
+    int attrib[] = { GLX_RGBA,
+		     GLX_RED_SIZE, 8,
+		     GLX_GREEN_SIZE, 8,
+		     GLX_BLUE_SIZE, 8,
+		     GLX_DOUBLEBUFFER,
+		     None };
+    XVisualInfo *visinfo;
+    Window win1, win2;
+    GLXContext ctx1, ctx2;
+    double start;
+    int i;
+
+    dpy = XOpenDisplay(NULL);
+    
+    if(NULL == dpy) {
+        fprintf(stderr, "error: unable to open display!\n");
+        return EXIT_FAILURE;
+    }
+
+    visinfo = glXChooseVisual(dpy, DefaultScreen(dpy), attrib);
+
+    if(!visinfo) {
+	fprintf(stderr, "error: couldn't get an RGBA, double-buffered visual!\n");
+	return EXIT_FAILURE;
+    }
+
+    win1 = create_window(dpy, visinfo, 0);
+    win2 = create_window(dpy, visinfo, 220);
+    XSync(dpy, False);
+
+    ctx1 = glXCreateContext(dpy, visinfo, NULL, True);
+    ctx2 = glXCreateContext(dpy, visinfo, NULL, True);
+
+    if(!ctx1 || !ctx2) {
+	fprintf(stderr, "error: glXCreateContext failed!\n");
+	return EXIT_FAILURE;
+    }
+
+    /* Two contexts alternating on one window. */
+    start = now();
+
+    for(i = 0; i < SWITCHES; ++i) {
+	glXMakeCurrent(dpy, win1, (i & 1) ? ctx2 : ctx1);
+	clear((i & 1) ? 1.0f : 0.5f);
+    }
+
+    printf("2 contexts, 1 window: %f us per switch\n",
+	   (now() - start) / SWITCHES);
+
+    /* One context alternating across two windows. */
+    start = now();
+
+    for(i = 0; i < SWITCHES; ++i) {
+	glXMakeCurrent(dpy, (i & 1) ? win2 : win1, ctx1);
+	clear((i & 1) ? 1.0f : 0.5f);
+    }
+
+    printf("1 context, 2 windows: %f us per switch\n",
+	   (now() - start) / SWITCHES);
+
+    glXMakeCurrent(dpy, win1, ctx1);
+    glXSwapBuffers(dpy, win1);
+    glXMakeCurrent(dpy, win2, ctx2);
+    glXSwapBuffers(dpy, win2);
+
+    glXMakeCurrent(dpy, None, NULL);
+    glXDestroyContext(dpy, ctx1);
+    glXDestroyContext(dpy, ctx2);
+    XDestroyWindow(dpy, win1);
+    XDestroyWindow(dpy, win2);
+    XCloseDisplay(dpy);
+
+    return EXIT_SUCCESS;
+}
@@ -15,3 +15,12 @@ $(TEST_BUILD_DIR)/glthreads: tests/simple/glthreads.c $(LIBGL)
 
 $(TEST_BUILD_DIR)/query_drawable: tests/simple/query_drawable.c $(LIBGL)
 	$(CC) tests/simple/query_drawable.c $(INCLUDE) -o $@ $(LINK_TEST)
+
+$(TEST_BUILD_DIR)/make_current_switch: tests/simple/make_current_switch.c $(LIBGL)
+	$(CC) tests/simple/make_current_switch.c $(INCLUDE) -o $(TEST_BUILD_DIR)/make_current_switch $(LINK_TEST)
+
+$(TEST_BUILD_DIR)/first_frame: tests/simple/first_frame.c $(LIBGL)
+	$(CC) tests/simple/first_frame.c $(INCLUDE) -o $(TEST_BUILD_DIR)/first_frame $(LINK_TEST)
+
+$(TEST_BUILD_DIR)/surface_attach: tests/simple/surface_attach.c apple_glx_surface.c apple_glx_context.h
+	$(CC) -DPTHREADS -DGLX_USE_APPLEGL tests/simple/surface_attach.c $(INCLUDE) -o $(TEST_BUILD_DIR)/surface_attach -lpthread
@@ -0,0 +1,223 @@
+/*
+ * This checks when a context is attached to a surface, as done by
+ * surface_make_current, with Xplugin and the drawables stubbed.  A context
+ * is only attached again if its attachment was changed or reset.
+ * apple_glx_surface.c is included, so that surface_make_current can be
+ * called.
+ */
+#include "apple_glx_surface.c"
+
+static int failures = 0;
+
+#define CHECK(cond) do {						\
+	if(!(cond)) {							\
+	    fprintf(stderr, "%s:%d: FAILED: %s\n", __FILE__, __LINE__,	\
+		    #cond);						\
+	    ++failures;							\
+	}								\
+    } while(0)
+
+struct apple_xgl_api __gl_api;
+struct apple_cgl_api apple_cgl;
+
+static int attach_calls, set_pbuffer_calls;
+static xp_error attach_error;
+
+/* These replace the parts of libGL that apple_glx_surface.c uses. */
+void apple_glx_diagnostic(const char *fmt, ...) {
+}
+
+xp_client_id apple_glx_get_client_id(void) {
+    return 1;
+}
+
+struct apple_glx_display *apple_glx_display_find(Display *dpy) {
+    return NULL;
+}
+
+bool apple_glx_display_is_closed(struct apple_glx_display *gd) {
+    return false;
+}
+
+void apple_glx_process_surface_changes(struct apple_glx_display *gd) {
+}
+
+void apple_glx_context_surface_destroyed(Display *dpy,
+					 xp_surface_id surface_id) {
+}
+
+bool apple_glx_drawable_create(Display *dpy, int screen, GLXDrawable d,
+			       struct apple_glx_drawable **agd,
+			       struct apple_glx_drawable_callbacks *callbacks) {
+    return true;
+}
+
+struct apple_glx_drawable *apple_glx_drawable_find(Display *dpy,
+						   GLXDrawable drawable,
+						   int flags) {
+    return NULL;
+}
+
+struct apple_glx_drawable *
+apple_glx_drawable_find_by_type(Display *dpy, GLXDrawable drawable, int type,
+				int flags) {
+    return NULL;
+}
+
+struct apple_glx_drawable *
+apple_glx_drawable_find_by_uid(Display *dpy, unsigned int uid, int flags) {
+    return NULL;
+}
+
+bool apple_glx_shared_buffer_create(struct apple_glx_shared_buffer *sb,
+				    xcb_connection_t *c, int screen,
+				    xcb_drawable_t drawable) {
+    return true;
+}
+
+void apple_glx_shared_buffer_destroy(struct apple_glx_shared_buffer *sb) {
+}
+
+bool apple_glx_shared_buffer_swap(struct apple_glx_shared_buffer *sb,
+				  const xcb_rectangle_t *damage,
+				  apple_glx_shared_buffer_copy_func copy,
+				  void *closure, bool *resized) {
+    return true;
+}
+
+Bool XAppleDRICreateSurfaceWithGeometry(Display *dpy, int screen,
+					Drawable drawable,
+					unsigned int client_id,
+					unsigned int key[2],
+					unsigned int *uid,
+					unsigned int *width,
+					unsigned int *height,
+					Bool *geometry_valid) {
+    return False;
+}
+
+Bool XAppleDRIDestroySurface(Display *dpy, int screen, Drawable drawable) {
+    return True;
+}
+
+Status XGetGeometry(Display *dpy, Drawable d, Window *root, int *x, int *y,
+		    unsigned int *width, unsigned int *height,
+		    unsigned int *border_width, unsigned int *depth) {
+    return 0;
+}
+
+xcb_connection_t *XGetXCBConnection(Display *dpy) {
+    return NULL;
+}
+
+xp_error xp_attach_gl_context(void *context, xp_surface_id id) {
+    ++attach_calls;
+
+    return attach_error;
+}
+
+xp_error xp_import_surface(const unsigned int key[2], xp_surface_id *id) {
+    return 0;
+}
+
+xp_error xp_destroy_surface(xp_surface_id id) {
+    return 0;
+}
+
+GLAPI void APIENTRY glViewport(GLint x, GLint y, GLsizei w, GLsizei h) {
+}
+
+GLAPI void APIENTRY glScissor(GLint x, GLint y, GLsizei w, GLsizei h) {
+}
+
+static void drawable_lock(struct apple_glx_drawable *d) {
+}
+
+static CGLError set_pbuffer(CGLContextObj ctx, CGLPBufferObj pbuffer,
+			    GLenum face, GLint level, GLint screen) {
+    ++set_pbuffer_calls;
+
+    return kCGLNoError;
+}
+
+static void init_surface(struct apple_glx_drawable *d,
+			 xp_surface_id surface_id) {
+    struct apple_glx_surface *s = &d->types.surface;
+
+    memset(d, 0, sizeof(*d));
+    d->type = APPLE_GLX_DRAWABLE_SURFACE;
+    d->lock = drawable_lock;
+    d->unlock = drawable_lock;
+
+    s->surface_id = surface_id;
+    s->geometry_valid = true;
+    s->width = s->height = 64;
+}
+
+int main() {
+    struct apple_glx_context ac;
+    struct apple_glx_drawable first, second;
+
+    apple_cgl.set_pbuffer = set_pbuffer;
+
+    memset(&ac, 0, sizeof(ac));
+    ac.context_obj = (CGLContextObj) &ac;
+
+    init_surface(&first, 1);
+    init_surface(&second, 2);
+
+    /* A new context is attached. */
+    CHECK(!surface_make_current(&ac, &first));
+    CHECK(1 == attach_calls);
+    CHECK(1 == ac.attached_surface);
+    CHECK(ac.made_current);
+
+    /* Rebinding the surface it's attached to doesn't attach it again. */
+    CHECK(!surface_make_current(&ac, &first));
+    CHECK(1 == attach_calls);
+
+    /* Switching the surfaces attaches each of them. */
+    CHECK(!surface_make_current(&ac, &second));
+    CHECK(2 == attach_calls);
+    CHECK(2 == ac.attached_surface);
+
+    CHECK(!surface_make_current(&ac, &first));
+    CHECK(3 == attach_calls);
+    CHECK(1 == ac.attached_surface);
+
+    /* A reset attachment, as after a surface change, is attached again. */
+    ac.attached_surface = 0;
+    CHECK(!surface_make_current(&ac, &first));
+    CHECK(4 == attach_calls);
+
+    /* A failed attach isn't remembered, so it's tried again. */
+    attach_error = 1;
+    CHECK(surface_make_current(&ac, &second));
+    CHECK(5 == attach_calls);
+    CHECK(0 == ac.attached_surface);
+
+    attach_error = 0;
+    CHECK(!surface_make_current(&ac, &second));
+    CHECK(6 == attach_calls);
+    CHECK(2 == ac.attached_surface);
+
+    /* A shared buffer replaces the attachment with its pbuffer. */
+    second.types.surface.shared = true;
+    CHECK(!surface_make_current(&ac, &second));
+    CHECK(6 == attach_calls);
+    CHECK(1 == set_pbuffer_calls);
+    CHECK(0 == ac.attached_surface);
+
+    second.types.surface.shared = false;
+    CHECK(!surface_make_current(&ac, &second));
+    CHECK(7 == attach_calls);
+
+    if(failures) {
+	fprintf(stderr, "%d failures\n", failures);
+	return EXIT_FAILURE;
+    }
+
+    printf("success\n");
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,151 @@
+/*
+ * This makes a context current without a drawable, renders to a
+ * framebuffer object, and checks the result.  It also compares the cost
+ * of making a context current surfaceless, and with a placeholder pbuffer.
+ */
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <GL/glx.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#define WIDTH 64
+#define HEIGHT 64
+#define ITERATIONS 1000
+
+static double now(void) {
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+
+    return tv.tv_sec * 1000000.0 + tv.tv_usec;
+}
+
+static double measure(Display *dpy, GLXDrawable drawable, GLXContext ctx) {
+    double start = now();
+    int i;
+
+    for(i = 0; i < ITERATIONS; ++i) {
+	glXMakeContextCurrent(dpy, drawable, drawable, ctx);
+	glXMakeContextCurrent(dpy, None, None, NULL);
+    }
+
+    return (now() - start) / ITERATIONS;
+}
+
+/* Return 1 if rendering to the FBO failed. */
+static int render_fbo(void) {
+    GLuint fbo, rb;
+    GLubyte pixel[4];
+    GLenum status;
+    int failed = 0;
+
+    glGenFramebuffersEXT(1, &fbo);
+    glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, fbo);
+    glGenRenderbuffersEXT(1, &rb);
+    glBindRenderbufferEXT(GL_RENDERBUFFER_EXT, rb);
+    glRenderbufferStorageEXT(GL_RENDERBUFFER_EXT, GL_RGBA8, WIDTH, HEIGHT);
+    glFramebufferRenderbufferEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT,
+				 GL_RENDERBUFFER_EXT, rb);
+
+    status = glCheckFramebufferStatusEXT(GL_FRAMEBUFFER_EXT);
+
+    if(GL_FRAMEBUFFER_COMPLETE_EXT != status) {
+	fprintf(stderr, "error: the FBO is incomplete: 0x%x\n", status);
+	return 1;
+    }
+
+    glViewport(0, 0, WIDTH, HEIGHT);
+    glClearColor(1.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glReadPixels(WIDTH / 2, HEIGHT / 2, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+
+    if(pixel[0] != 0xff || pixel[1] || pixel[2]) {
+	fprintf(stderr, "error: unexpected pixel: %02x %02x %02x\n",
+		pixel[0], pixel[1], pixel[2]);
+	failed = 1;
+    }
+
+    glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, 0);
+    glDeleteRenderbuffersEXT(1, &rb);
+    glDeleteFramebuffersEXT(1, &fbo);
+
+    return failed;
+}
+
+int main() {
+    Display *dpy;
+    int fbattrib[] = { GLX_DRAWABLE_TYPE, GLX_PBUFFER_BIT,
+		       GLX_RENDER_TYPE, GLX_RGBA_BIT,
+		       GLX_RED_SIZE, 8,
+		       GLX_GREEN_SIZE, 8,
+		       GLX_BLUE_SIZE, 8,
+		       None };
+    int pbattrib[] = { GLX_PBUFFER_WIDTH, 1,
+		       GLX_PBUFFER_HEIGHT, 1,
+		       None };
+    int nconfigs, status = EXIT_SUCCESS;
+    GLXFBConfig *configs;
+    GLXContext ctx;
+    GLXPbuffer pbuffer;
+
+    dpy = XOpenDisplay(NULL);
+
+    if(NULL == dpy) {
+        fprintf(stderr, "error: unable to open display!\n");
+        return EXIT_FAILURE;
+    }
+
+    configs = glXChooseFBConfig(dpy, DefaultScreen(dpy), fbattrib, &nconfigs);
+
+    if(NULL == configs || nconfigs < 1) {
+	fprintf(stderr, "error: no config!\n");
+	return EXIT_FAILURE;
+    }
+
+    ctx = glXCreateNewContext(dpy, configs[0], GLX_RGBA_TYPE, NULL, True);
+
+    if(NULL == ctx) {
+	fprintf(stderr, "error: glXCreateNewContext failed!\n");
+	return EXIT_FAILURE;
+    }
+
+    if(!glXMakeContextCurrent(dpy, None, None, ctx)) {
+	fprintf(stderr, "error: unable to make the context current "
+		"without a drawable!\n");
+	return EXIT_FAILURE;
+    }
+
+    if(glXGetCurrentContext() != ctx || glXGetCurrentDrawable() != None) {
+	fprintf(stderr, "error: the current context or drawable is wrong!\n");
+	status = EXIT_FAILURE;
+    }
+
+    printf("GL_RENDERER %s\n", (const char *)glGetString(GL_RENDERER));
+
+    if(render_fbo())
+	status = EXIT_FAILURE;
+
+    glXMakeContextCurrent(dpy, None, None, NULL);
+
+    pbuffer = glXCreatePbuffer(dpy, configs[0], pbattrib);
+
+    printf("surfaceless make current %8.2f us\n", measure(dpy, None, ctx));
+    printf("pbuffer make current     %8.2f us\n", measure(dpy, pbuffer, ctx));
+
+    /* The context must still render surfaceless after using a drawable. */
+    glXMakeContextCurrent(dpy, None, None, ctx);
+
+    if(render_fbo())
+	status = EXIT_FAILURE;
+
+    glXMakeContextCurrent(dpy, None, None, NULL);
+    glXDestroyPbuffer(dpy, pbuffer);
+    glXDestroyContext(dpy, ctx);
+    XFree(configs);
+    XCloseDisplay(dpy);
+
+    return status;
+}
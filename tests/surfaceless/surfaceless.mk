@@ -0,0 +1,2 @@
+$(TEST_BUILD_DIR)/surfaceless: tests/surfaceless/surfaceless.c $(LIBGL)
+	$(CC) tests/surfaceless/surfaceless.c $(INCLUDE) -o $(TEST_BUILD_DIR)/surfaceless $(LINK_TEST)
@@ -16,25 +16,57 @@ include tests/engine/engine.mk
 include tests/glxpixmap/glxpixmap.mk
 include tests/triangle_glx_single/triangle_glx.mk
 include tests/shared/shared.mk
+include tests/oml_sync/oml_sync.mk
+include tests/surfaceless/surfaceless.mk
+include tests/create_context_attribs/create_context_attribs.mk
+include tests/query_renderer/query_renderer.mk
+include tests/glxhash/glxhash.mk
+include tests/appledri_xcb/appledri_xcb.mk
+include tests/copy_sub_buffer/copy_sub_buffer.mk
+include tests/mp_engine/mp_engine.mk
 
 tests: $(TEST_BUILD_DIR)/simple $(TEST_BUILD_DIR)/fbconfigs $(TEST_BUILD_DIR)/triangle_glx \
   $(TEST_BUILD_DIR)/create_destroy_context $(TEST_BUILD_DIR)/glxgears $(TEST_BUILD_DIR)/glxinfo \
   $(TEST_BUILD_DIR)/pbuffer $(TEST_BUILD_DIR)/pbuffer_destroy \
+  $(TEST_BUILD_DIR)/pbuffer_clobber \
   $(TEST_BUILD_DIR)/glxpixmap \
   $(TEST_BUILD_DIR)/triangle_glx_single \
   $(TEST_BUILD_DIR)/create_destroy_context_alone \
   $(TEST_BUILD_DIR)/create_destroy_context_with_drawable \
   $(TEST_BUILD_DIR)/create_destroy_context_with_drawable_2 \
+  $(TEST_BUILD_DIR)/create_contexts_async \
+  $(TEST_BUILD_DIR)/context_memory \
   $(TEST_BUILD_DIR)/render_types \
   $(TEST_BUILD_DIR)/glxpixmap_create_destroy \
   $(TEST_BUILD_DIR)/sharedtex \
   $(TEST_BUILD_DIR)/drawable_types \
   $(TEST_BUILD_DIR)/glxpixmap_destroy_invalid \
+  $(TEST_BUILD_DIR)/glxpixmap_wait \
+  $(TEST_BUILD_DIR)/wait_paths \
+  $(TEST_BUILD_DIR)/texture_from_pixmap \
+  $(TEST_BUILD_DIR)/glxpixmap_depths \
+  $(TEST_BUILD_DIR)/pixmap_formats \
+  $(TEST_BUILD_DIR)/glxpixmap_batch \
   $(TEST_BUILD_DIR)/multisample_glx \
   $(TEST_BUILD_DIR)/glthreads \
   $(TEST_BUILD_DIR)/triangle_glx_surface \
   $(TEST_BUILD_DIR)/triangle_glx_surface-2 \
   $(TEST_BUILD_DIR)/triangle_glx_withdraw_remap \
   $(TEST_BUILD_DIR)/triangle_glx_destroy_relation \
-  $(TEST_BUILD_DIR)/query_drawable
+  $(TEST_BUILD_DIR)/query_drawable \
+  $(TEST_BUILD_DIR)/make_current_switch \
+  $(TEST_BUILD_DIR)/surface_attach \
+  $(TEST_BUILD_DIR)/first_frame \
+  $(TEST_BUILD_DIR)/oml_sync \
+  $(TEST_BUILD_DIR)/sbc_wait \
+  $(TEST_BUILD_DIR)/surfaceless \
+  $(TEST_BUILD_DIR)/create_context_attribs \
+  $(TEST_BUILD_DIR)/context_checks \
+  $(TEST_BUILD_DIR)/query_renderer \
+  $(TEST_BUILD_DIR)/renderer_order \
+  $(TEST_BUILD_DIR)/glxhash \
+  $(TEST_BUILD_DIR)/appledri_xcb \
+  $(TEST_BUILD_DIR)/shared_buffer \
+  $(TEST_BUILD_DIR)/copy_sub_buffer \
+  $(TEST_BUILD_DIR)/mp_engine
 